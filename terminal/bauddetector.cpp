@@ -0,0 +1,186 @@
+#include "bauddetector.h"
+#include "baudrate.h"
+#include "monotonicclock.h"
+#include "serialiothread.h"
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+//A sample this clean and printable is taken without trying the rest.
+static const int EARLY_CHARACTERS = 32;
+static const double EARLY_PRINTABLE = 0.9;
+//Best scores below this are no detection.
+static const double MIN_SCORE = 0.5;
+
+QVector<qint32>
+BaudDetector::defaultCandidates() {
+    return QVector<qint32>() << 115200 << 9600 << 921600 << 57600 << 19200 << 38400
+                             << 230400 << 460800 << 1000000 << 1500000 << 2000000 << 3000000 << 4800;
+}
+
+static bool
+isPrintable(uchar c) {
+    return (c >= 0x20 && c < 0x7F) || c == '\r' || c == '\n' || c == '\t';
+}
+
+BaudDetector::Result
+BaudDetector::score(qint32 baudRate, const char *data, qint64 size) {
+    Result result;
+    result.baudRate = baudRate;
+
+    //PARMRK: \377\377 is a 0xFF, \377\0 X an error on X, \377\0\0 a break.
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    for (qint64 x = 0; x < size; x++) {
+        if (p[x] == 0xFF) {
+            if (x + 1 >= size) { break; }
+            if (p[x + 1] == 0xFF) {
+                result.characters++;
+                x++;
+                continue;
+            }
+            if (x + 2 >= size) { break; }
+            result.characters++;
+            result.errors++;
+            x += 2;
+            continue;
+        }
+        result.characters++;
+        if (isPrintable(p[x])) { result.printable++; }
+    }
+
+    if (result.characters >= MIN_CHARACTERS) {
+        const double clean = 1.0 - static_cast<double>(result.errors) / result.characters;
+        const double printable = static_cast<double>(result.printable) / result.characters;
+        //Binary protocols are not printable; errors weigh more.
+        result.score = clean * (0.5 + 0.5 * printable);
+    }
+    return result;
+}
+
+BaudDetector::BaudDetector(QObject *parent) :
+    QObject(parent),
+    _running(false),
+    _cancel(false)
+{
+}
+
+BaudDetector::~BaudDetector() {
+    cancel();
+}
+
+BaudDetector::Result
+BaudDetector::best() const {
+    Result best;
+    for (const Result &result : _results) {
+        if (result.score > best.score) { best = result; }
+    }
+    return best;
+}
+
+#ifdef Q_OS_LINUX
+
+bool
+BaudDetector::start(const SettingsDialog::Settings &settings, const QVector<qint32> &candidates) {
+    cancel();
+
+    //Listen regardless of handshaking, the device may not be waiting for it.
+    SettingsDialog::Settings listen = settings;
+    listen.flowControl = QSerialPort::NoFlowControl;
+    listen.baudRate = candidates.isEmpty() ? 9600 : candidates.first();
+    _fd = SerialIoThread::openDevice(listen, _errorString);
+    if (_fd < 0) { return false; }
+
+    termios tio;
+    if (::tcgetattr(_fd, &tio) == 0) {
+        tio.c_iflag &= ~(IGNPAR | IGNBRK | BRKINT | ISTRIP);
+        tio.c_iflag |= PARMRK | INPCK;
+        ::tcsetattr(_fd, TCSANOW, &tio);
+    }
+
+    _candidates = candidates;
+    _results.clear();
+    _cancel.store(false);
+    _running.store(true);
+    _thread = std::thread(&BaudDetector::_run, this);
+    return true;
+}
+
+void
+BaudDetector::cancel() {
+    _cancel.store(true);
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void
+BaudDetector::_run() {
+    char buffer[4096];
+    QByteArray sample;
+
+    for (qint32 baudRate : _candidates) {
+        if (_cancel.load()) { break; }
+        if (!setCustomBaudRate(_fd, baudRate)) { continue; }
+        //Whatever was received at the previous rate, or while switching.
+        ::tcflush(_fd, TCIFLUSH);
+
+        sample.resize(0);
+        const quint64 deadlineNs = monotonicNowNs() + WINDOW_MS * 1000000ull;
+        for (quint64 nowNs = monotonicNowNs(); nowNs < deadlineNs && !_cancel.load(); nowNs = monotonicNowNs()) {
+            pollfd pfd;
+            pfd.fd = _fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (::poll(&pfd, 1, static_cast<int>((deadlineNs - nowNs + 999999) / 1000000)) <= 0) { continue; }
+
+            const ssize_t count = ::read(_fd, buffer, sizeof(buffer));
+            if (count > 0) {
+                sample.append(buffer, static_cast<int>(count));
+            }
+            else if (count == 0 || (errno != EAGAIN && errno != EINTR)) {
+                break;
+            }
+        }
+
+        const Result result = score(baudRate, sample.constData(), sample.size());
+        _results.append(result);
+        if (result.characters >= EARLY_CHARACTERS && result.errors == 0
+            && result.printable >= EARLY_PRINTABLE * result.characters) {
+            break;
+        }
+    }
+
+    ::close(_fd);
+    _fd = -1;
+
+    const Result found = best();
+    _running.store(false);
+    if (!_cancel.load()) {
+        emit finished(found.score >= MIN_SCORE ? found.baudRate : 0);
+    }
+}
+
+#else
+
+bool
+BaudDetector::start(const SettingsDialog::Settings &settings, const QVector<qint32> &candidates) {
+    Q_UNUSED(settings);
+    Q_UNUSED(candidates);
+    _errorString = tr("Baud rate detection is only available on Linux");
+    return false;
+}
+
+void
+BaudDetector::cancel() {
+}
+
+void
+BaudDetector::_run() {
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef BAUDDETECTOR_H
+#define BAUDDETECTOR_H
+
+#include "settingsdialog.h"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <thread>
+
+//Finds the baud rate of a device that is sending (Linux). The port is opened
+//with the configured data bits, parity and stop bits, then listened to at
+//each candidate rate for a short window, with framing and parity errors
+//marked in the data (PARMRK). A rate scores by the share of characters that
+//arrived without error and, to a lesser degree, by how much of them is
+//printable. A clean, printable sample ends the search early; a full sweep of
+//the default candidates takes under a second.
+class BaudDetector : public QObject
+{
+    Q_OBJECT
+
+signals:
+    //baudRate is 0 when no candidate was convincing.
+    void finished(qint32 baudRate);
+
+public:
+    struct Result {
+        qint32 baudRate = 0;
+        qint64 characters = 0;
+        qint64 errors = 0;      //characters with a framing or parity error, and breaks
+        qint64 printable = 0;
+        double score = 0;
+    };
+
+    static const int WINDOW_MS = 60;
+    //Below this a sample says nothing.
+    static const int MIN_CHARACTERS = 16;
+
+    //Most likely first, so the early exit usually comes early.
+    static QVector<qint32> defaultCandidates();
+    //Scores a sample read with PARMRK set.
+    static Result score(qint32 baudRate, const char *data, qint64 size);
+
+    explicit BaudDetector(QObject *parent = nullptr);
+    ~BaudDetector();
+
+    //The port must not be open elsewhere. settings.baudRate is ignored.
+    bool start(const SettingsDialog::Settings &settings, const QVector<qint32> &candidates = defaultCandidates());
+    void cancel();
+    bool isRunning() const { return _running.load(); }
+    QString errorString() const { return _errorString; }
+
+    //After finished(): one per candidate tried, and the best of them.
+    const QVector<Result> &results() const { return _results; }
+    Result best() const;
+
+private:
+    void _run();
+
+    int _fd = -1;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<bool> _cancel;
+    QVector<qint32> _candidates;
+    QVector<Result> _results;
+    QString _errorString;
+};
+
+#endif // BAUDDETECTOR_H
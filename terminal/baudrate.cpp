@@ -0,0 +1,52 @@
+#include "baudrate.h"
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+// termios2 comes from the kernel headers, which clash with glibc's
+// <termios.h>; that is why this lives in its own file.
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifdef Q_OS_LINUX
+
+bool
+setCustomBaudRate(int fd, qint32 baudRate) {
+    if (baudRate <= 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    struct termios2 tio;
+    if (::ioctl(fd, TCGETS2, &tio) != 0) { return false; }
+
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = static_cast<speed_t>(baudRate);
+    tio.c_ospeed = static_cast<speed_t>(baudRate);
+    return ::ioctl(fd, TCSETS2, &tio) == 0;
+}
+
+qint32
+actualBaudRate(int fd) {
+    struct termios2 tio;
+    if (::ioctl(fd, TCGETS2, &tio) != 0) { return 0; }
+    return static_cast<qint32>(tio.c_ospeed);
+}
+
+#else
+
+bool
+setCustomBaudRate(int fd, qint32 baudRate) {
+    Q_UNUSED(fd);
+    Q_UNUSED(baudRate);
+    return false;
+}
+
+qint32
+actualBaudRate(int fd) {
+    Q_UNUSED(fd);
+    return 0;
+}
+
+#endif
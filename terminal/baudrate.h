@@ -0,0 +1,16 @@
+#ifndef BAUDRATE_H
+#define BAUDRATE_H
+
+#include <QtGlobal>
+
+// Sets any line speed on an open tty (Linux) with termios2 and BOTHER, the
+// way to get rates the B* constants do not have (1843200, 12000000, ...).
+// The rest of the termios settings are left alone. Returns false with errno
+// set when the driver refuses.
+bool setCustomBaudRate(int fd, qint32 baudRate);
+
+// The speed the driver actually runs at, after rounding to what its clock
+// divider can do; 0 when it cannot be read.
+qint32 actualBaudRate(int fd);
+
+#endif // BAUDRATE_H
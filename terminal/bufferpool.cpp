@@ -0,0 +1,73 @@
+#include "bufferpool.h"
+
+BufferPool::BufferPool(int blockCount, qint64 blockSize) :
+    _blockCount(blockCount),
+    _blockSize(blockSize),
+    _storage(new char[static_cast<size_t>(blockCount) * static_cast<size_t>(blockSize)]),
+    _blocks(new Block[static_cast<size_t>(blockCount)]),
+    _head(0),
+    _inUse(0),
+    _exhausted(0)
+{
+    for (int x = blockCount - 1; x >= 0; x--) {
+        Block &block = _blocks[x];
+        block._data = _storage.get() + static_cast<size_t>(x) * static_cast<size_t>(blockSize);
+        block._capacity = blockSize;
+        block._index = static_cast<quint32>(x);
+        block._refs.store(0, std::memory_order_relaxed);
+        block._next.store(0, std::memory_order_relaxed);
+        _push(&block);
+    }
+}
+
+BufferPool::~BufferPool() {
+    Q_ASSERT(_inUse.load() == 0);
+}
+
+BufferPool::Block *
+BufferPool::acquire() {
+    quint64 head = _head.load(std::memory_order_acquire);
+    for (;;) {
+        const quint32 top = static_cast<quint32>(head);
+        if (top == 0) {
+            _exhausted.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Block *block = &_blocks[top - 1];
+        const quint64 next = ((head & 0xFFFFFFFF00000000ull) + (1ull << 32))
+                | block->_next.load(std::memory_order_relaxed);
+        if (_head.compare_exchange_weak(head, next, std::memory_order_acq_rel,
+                                        std::memory_order_acquire)) {
+            block->_refs.store(1, std::memory_order_relaxed);
+            _inUse.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+    }
+}
+
+void
+BufferPool::retain(Block *block) {
+    block->_refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+BufferPool::release(Block *block) {
+    if (block->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        _inUse.fetch_sub(1, std::memory_order_relaxed);
+        _push(block);
+    }
+}
+
+void
+BufferPool::_push(Block *block) {
+    quint64 head = _head.load(std::memory_order_relaxed);
+    for (;;) {
+        block->_next.store(static_cast<quint32>(head), std::memory_order_relaxed);
+        const quint64 next = ((head & 0xFFFFFFFF00000000ull) + (1ull << 32)) | (block->_index + 1);
+        if (_head.compare_exchange_weak(head, next, std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+// Non-owning view over bytes that live in someone else's buffer, typically a
+// BufferPool block. Views are what travels downstream of the port; whoever
+// needs the bytes beyond the call has to copy them or retain the block.
+struct ByteView
+{
+    ByteView() = default;
+    ByteView(const char *d, qint64 s) : data(d), size(s) {}
+
+    const char *begin() const { return data; }
+    const char *end() const { return data + size; }
+    bool isEmpty() const { return size <= 0; }
+    ByteView mid(qint64 pos, qint64 len) const { return ByteView(data + pos, len); }
+
+    const char *data = nullptr;
+    qint64 size = 0;
+};
+
+// Fixed pool of equally sized receive buffers carved out of one allocation made
+// up front. acquire()/release() never touch the heap, so the steady-state
+// receive path is allocation free. Blocks are reference counted: a consumer
+// that keeps views past the call retains the block and releases it when done,
+// and the block goes back to the pool when the last reference is dropped.
+//
+// The free list is a lock-free stack with a tagged head, so blocks may be
+// acquired and released from different threads.
+class BufferPool
+{
+public:
+    class Block
+    {
+    public:
+        char *data() const { return _data; }
+        qint64 capacity() const { return _capacity; }
+        ByteView view(qint64 size) const { return ByteView(_data, size); }
+
+    private:
+        friend class BufferPool;
+
+        char *_data = nullptr;
+        qint64 _capacity = 0;
+        quint32 _index = 0;
+        std::atomic<int> _refs;
+        std::atomic<quint32> _next;
+    };
+
+    BufferPool(int blockCount, qint64 blockSize);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // Returns a block with one reference, or nullptr when every block is in use.
+    Block *acquire();
+    void retain(Block *block);
+    void release(Block *block);
+
+    int blockCount() const { return _blockCount; }
+    qint64 blockSize() const { return _blockSize; }
+    int blocksInUse() const { return _inUse.load(std::memory_order_relaxed); }
+    quint64 exhaustedCount() const { return _exhausted.load(std::memory_order_relaxed); }
+
+private:
+    void _push(Block *block);
+
+    const int _blockCount;
+    const qint64 _blockSize;
+    std::unique_ptr<char[]> _storage;
+    std::unique_ptr<Block[]> _blocks;
+
+    // Low 32 bits: index + 1 of the top block (0 = empty); high 32 bits: ABA tag.
+    std::atomic<quint64> _head;
+    std::atomic<int> _inUse;
+    std::atomic<quint64> _exhausted;
+};
+
+#endif // BUFFERPOOL_H
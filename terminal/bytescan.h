@@ -0,0 +1,96 @@
+#ifndef BYTESCAN_H
+#define BYTESCAN_H
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Byte scans used by the framing decoders and the scrollback search. All
+// return end when nothing is found.
+namespace ByteScan {
+
+inline const char *
+find(const char *p, const char *end, char c) {
+    // libc's memchr is already vectorized on every platform we ship.
+    const void *hit = std::memchr(p, c, static_cast<size_t>(end - p));
+    return hit ? static_cast<const char *>(hit) : end;
+}
+
+// First occurrence of either byte, in a single pass (memchr only takes one).
+inline const char *
+findEither(const char *p, const char *end, char a, char b) {
+#ifdef __SSE2__
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+        if (mask) { return p + __builtin_ctz(static_cast<unsigned>(mask)); }
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == a || *p == b) { return p; }
+    }
+    return end;
+}
+
+// ASCII only; the store holds raw device bytes, not decoded text.
+inline char
+foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+inline bool
+equal(const char *p, const char *needle, size_t size, bool ignoreCase) {
+    if (!ignoreCase) { return std::memcmp(p, needle, size) == 0; }
+    for (size_t x = 0; x < size; x++) {
+        if (foldCase(p[x]) != needle[x]) { return false; }
+    }
+    return true;
+}
+
+// First occurrence of needle. With ignoreCase the needle must already be
+// folded with foldCase().
+inline const char *
+findSubstring(const char *p, const char *end, const char *needle, size_t size, bool ignoreCase) {
+    if (size == 0) { return p; }
+    if (static_cast<size_t>(end - p) < size) { return end; }
+    if (size == 1 && !ignoreCase) { return find(p, end, needle[0]); }
+
+    const char *last = end - size;
+#ifdef __SSE2__
+    // Test the first and the last byte of the needle at 16 positions at once
+    // and only compare the whole needle where both match; on real text that
+    // rejects nearly every position without a branch.
+    const char head = needle[0];
+    const char tail = needle[size - 1];
+    const __m128i headLower = _mm_set1_epi8(head);
+    const __m128i tailLower = _mm_set1_epi8(tail);
+    const __m128i headUpper = _mm_set1_epi8(ignoreCase && head >= 'a' && head <= 'z' ? static_cast<char>(head - ('a' - 'A')) : head);
+    const __m128i tailUpper = _mm_set1_epi8(ignoreCase && tail >= 'a' && tail <= 'z' ? static_cast<char>(tail - ('a' - 'A')) : tail);
+    while (last - p >= 15) {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i final = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + size - 1));
+        const __m128i firstHit = _mm_or_si128(_mm_cmpeq_epi8(first, headLower), _mm_cmpeq_epi8(first, headUpper));
+        const __m128i finalHit = _mm_or_si128(_mm_cmpeq_epi8(final, tailLower), _mm_cmpeq_epi8(final, tailUpper));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(firstHit, finalHit)));
+        while (mask) {
+            const int bit = __builtin_ctz(mask);
+            if (size <= 2 || equal(p + bit + 1, needle + 1, size - 2, ignoreCase)) { return p + bit; }
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+#endif
+    for (; p <= last; ++p) {
+        if (equal(p, needle, size, ignoreCase)) { return p; }
+    }
+    return end;
+}
+
+} // namespace ByteScan
+
+#endif // BYTESCAN_H
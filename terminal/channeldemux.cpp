@@ -0,0 +1,267 @@
+#include "channeldemux.h"
+#include "linestore.h"
+
+#include <QTimer>
+
+#include <algorithm>
+#include <cstring>
+
+ChannelIndex::ChannelIndex(const LineStore &store, const QByteArray &key, const QString &name, QObject *parent) :
+    LineIndex(parent),
+    _store(store),
+    _key(key),
+    _name(name)
+{
+}
+
+ChannelIndex::~ChannelIndex() {
+    emit aboutToReset();
+}
+
+void
+ChannelIndex::_clear() {
+    emit aboutToReset();
+    _rows.clear();
+    _bytes = 0;
+    _lastTimestampNs = 0;
+    _announced = 0;
+    emit rowsChanged(0);
+}
+
+ChannelDemux::ChannelDemux(const LineStore &store, QObject *parent) :
+    QObject(parent),
+    _store(store)
+{
+    std::fill(_byByte, _byByte + 256, -1);
+    _text.reserve(MAX_TAG_SCAN);
+}
+
+bool
+ChannelDemux::setRule(Mode mode, const QString &pattern) {
+    QRegularExpression regex;
+    if (mode == Regex) {
+        regex.setPattern(pattern);
+        if (pattern.isEmpty() || !regex.isValid()) {
+            _errorString = pattern.isEmpty() ? tr("No pattern") : regex.errorString();
+            return false;
+        }
+        regex.optimize();
+    }
+    if (mode == Bracket && !pattern.isEmpty() && pattern.size() != 2) {
+        _errorString = tr("Two characters, the opening and the closing one");
+        return false;
+    }
+    _errorString.clear();
+
+    emit channelsRemoved();
+    qDeleteAll(_channels);
+    _channels.clear();
+    std::fill(_byByte, _byByte + 256, -1);
+    _untagged = -1;
+    _last = -1;
+    _routed = 0;
+
+    _mode = mode;
+    _pattern = pattern;
+    _regex = regex;
+    const QByteArray bytes = pattern.toLatin1();
+    _open = bytes.size() == 2 ? bytes.at(0) : '[';
+    _close = bytes.size() == 2 ? bytes.at(1) : ']';
+    _separator = bytes.isEmpty() ? QByteArray(":") : bytes;
+    return true;
+}
+
+void
+ChannelDemux::setTxTemplate(const QString &txTemplate) {
+    _txTemplate = txTemplate;
+    for (ChannelIndex *index : _channels) {
+        index->_txLineStart = true;
+        index->_txLast = 0;
+    }
+}
+
+QString
+ChannelDemux::defaultTxTemplate(Mode mode, const QString &pattern) {
+    switch (mode) {
+    case Bracket:
+        return pattern.size() == 2 ? pattern.at(0) + QStringLiteral("%1") + pattern.at(1) + QLatin1Char(' ')
+                                   : QStringLiteral("[%1] ");
+    case Separator:
+        return QStringLiteral("%1") + (pattern.isEmpty() ? QStringLiteral(":") : pattern) + QLatin1Char(' ');
+    case Byte:
+        return QStringLiteral("%1");
+    default:
+        return QString();
+    }
+}
+
+void
+ChannelDemux::update() {
+    if (_mode == Off) { return; }
+
+    const qint64 completed = _store.completedLineCount();
+    if (_routed == completed) { return; }
+
+    const qint64 end = std::min(completed, _routed + ROUTE_BUDGET);
+    _route(end);
+    if (end < completed && !_continuePending) {
+        _continuePending = true;
+        QTimer::singleShot(0, this, &ChannelDemux::_slot_continue);
+    }
+}
+
+void
+ChannelDemux::reset() {
+    _routed = 0;
+    _last = -1;
+    for (ChannelIndex *index : _channels) {
+        index->_clear();
+    }
+}
+
+QByteArray
+ChannelDemux::frame(int channel, const QByteArray &data) {
+    ChannelIndex *index = _channels.value(channel);
+    if (!index || index->_key.isNull() || _txTemplate.isEmpty()) {
+        return data;
+    }
+
+    QByteArray prefix = _txTemplate.toLatin1();
+    prefix.replace("%1", index->_key);
+
+    QByteArray framed;
+    framed.reserve(data.size() + prefix.size());
+    for (const char c : data) {
+        //"\r\n" ends one line, the '\n' does not start another.
+        if (index->_txLineStart && !(c == '\n' && index->_txLast == '\r')) {
+            framed.append(prefix);
+            index->_txLineStart = false;
+        }
+        framed.append(c);
+        index->_txLast = c;
+        if (c == '\r' || c == '\n') {
+            index->_txLineStart = true;
+        }
+    }
+    return framed;
+}
+
+void
+ChannelDemux::_slot_continue() {
+    _continuePending = false;
+    update();
+}
+
+bool
+ChannelDemux::_tag(const ByteView &text, ByteView &key) {
+    const qint64 scan = std::min<qint64>(text.size, MAX_TAG_SCAN);
+    if (scan <= 0) { return false; }
+
+    switch (_mode) {
+    case Bracket: {
+        if (text.data[0] != _open) { return false; }
+        const char *close = static_cast<const char *>(std::memchr(text.data + 1, _close, static_cast<size_t>(scan - 1)));
+        if (!close || close == text.data + 1) { return false; }
+        key = ByteView(text.data + 1, close - text.data - 1);
+        return true;
+    }
+    case Separator: {
+        const char *end = text.data + scan;
+        const char *found = std::search(text.data + 1, end, _separator.constBegin(), _separator.constEnd());
+        if (found == end) { return false; }
+        //A tag is one word; "see: x" after some text is not one.
+        for (const char *c = text.data; c != found; c++) {
+            if (*c == ' ' || *c == '\t') { return false; }
+        }
+        key = ByteView(text.data, found - text.data);
+        return true;
+    }
+    case Regex: {
+        //Reuses one QString rather than allocating with fromLatin1().
+        _text.resize(static_cast<int>(scan));
+        QChar *out = _text.data();
+        for (qint64 x = 0; x < scan; x++) {
+            out[x] = QChar(static_cast<uchar>(text.data[x]));
+        }
+        const QRegularExpressionMatch match = _regex.match(_text);
+        if (!match.hasMatch()) { return false; }
+        const int group = match.lastCapturedIndex() >= 1 ? 1 : 0;
+        //Latin-1, so characters are bytes.
+        if (match.capturedLength(group) <= 0) { return false; }
+        key = ByteView(text.data + match.capturedStart(group), match.capturedLength(group));
+        return true;
+    }
+    case Byte:
+        key = ByteView(text.data, 1);
+        return true;
+    default:
+        return false;
+    }
+}
+
+int
+ChannelDemux::_channel(const ByteView &key) {
+    if (_mode == Byte) {
+        int &channel = _byByte[static_cast<uchar>(*key.data)];
+        if (channel < 0) {
+            channel = _addChannel(QByteArray(key.data, 1), QStringLiteral("0x%1").arg(static_cast<uchar>(*key.data), 2, 16, QLatin1Char('0')));
+        }
+        return channel;
+    }
+
+    auto matches = [&key](const ChannelIndex *index) {
+        return index->_key.size() == key.size && std::memcmp(index->_key.constData(), key.data, static_cast<size_t>(key.size)) == 0;
+    };
+    if (_last >= 0 && matches(_channels.at(_last))) {
+        return _last;
+    }
+    for (int x = 0; x < _channels.size(); x++) {
+        if (matches(_channels.at(x))) { return x; }
+    }
+    return _addChannel(QByteArray(key.data, static_cast<int>(key.size)),
+                       QString::fromLatin1(key.data, static_cast<int>(key.size)));
+}
+
+int
+ChannelDemux::_addChannel(const QByteArray &key, const QString &name) {
+    if (!key.isNull() && _channels.size() >= MAX_CHANNELS) {
+        //A rule that tags every line differently; the rest is not split.
+        return _untaggedChannel();
+    }
+    _channels.append(new ChannelIndex(_store, key, name, this));
+    emit channelAdded(_channels.size() - 1);
+    return _channels.size() - 1;
+}
+
+int
+ChannelDemux::_untaggedChannel() {
+    if (_untagged < 0) {
+        _untagged = _addChannel(QByteArray(), tr("Untagged"));
+    }
+    return _untagged;
+}
+
+void
+ChannelDemux::_route(qint64 end) {
+    ByteView key;
+    for (qint64 line = _routed; line < end; line++) {
+        const ByteView text = _store.text(line);
+        const int channel = _tag(text, key) ? _channel(key) : _untaggedChannel();
+        _last = channel;
+
+        ChannelIndex *index = _channels.at(channel);
+        index->_rows.append(line);
+        index->_bytes += static_cast<quint64>(text.size);
+        index->_lastTimestampNs = _store.timestamp(line);
+    }
+    _routed = end;
+
+    for (ChannelIndex *index : _channels) {
+        const qint64 rows = index->_rows.size();
+        if (rows != index->_announced) {
+            const qint64 first = index->_announced;
+            index->_announced = rows;
+            emit index->rowsChanged(first);
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef CHANNELDEMUX_H
+#define CHANNELDEMUX_H
+
+#include "bufferpool.h"
+#include "lineindex.h"
+#include "segmentedvector.h"
+
+#include <QRegularExpression>
+#include <QVector>
+
+//The lines of one channel of a ChannelDemux, as line numbers into the shared
+//store, with the channel's counters.
+class ChannelIndex : public LineIndex
+{
+    Q_OBJECT
+
+    friend class ChannelDemux;
+
+public:
+    ChannelIndex(const LineStore &store, const QByteArray &key, const QString &name, QObject *parent = nullptr);
+    ~ChannelIndex();
+
+    const LineStore &store() const override { return _store; }
+    qint64 rowCount() const override { return _rows.size(); }
+    qint64 line(qint64 row) const override { return _rows.at(row); }
+    qint64 ownedBytes() const override { return _rows.ownedBytes(); }
+
+    //The tag as received; null for the channel of untagged lines.
+    const QByteArray &key() const { return _key; }
+    const QString &name() const { return _name; }
+    quint64 bytes() const { return _bytes; }
+    quint64 lastTimestamp() const { return _lastTimestampNs; }
+
+private:
+    void _clear();
+
+    const LineStore &_store;
+    const QByteArray _key;
+    const QString _name;
+    SegmentedVector<qint64> _rows;
+    quint64 _bytes = 0;
+    quint64 _lastTimestampNs = 0;
+    //Rows announced with rowsChanged().
+    qint64 _announced = 0;
+    //Outgoing framing state, see ChannelDemux::frame().
+    bool _txLineStart = true;
+    char _txLast = 0;
+};
+
+//Splits the lines of one LineStore into channels by a tag at the start of
+//each line: "[cpu1] ...", "cpu1: ...", a regex capture, or the line's first
+//byte as a channel number. Only lines are routed; frames of a FrameDecoder
+//are not split by channel. Every channel is a ChannelIndex of line numbers, so the channels share
+//the store's text and each costs eight bytes a line.
+//
+//A tag is looked for in the first MAX_TAG_SCAN bytes only and the channel is
+//found by comparing it with the previous line's channel first and then the
+//others (a table lookup in Byte mode), so routing a line does not
+//allocate and costs the same with dozens of channels.
+class ChannelDemux : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void channelAdded(int channel);
+    //Before setRule() deletes the channels.
+    void channelsRemoved();
+
+public:
+    enum Mode {
+        Off,
+        Bracket,        //pattern: the opening and closing character, "[]"
+        Separator,      //pattern: what ends the tag, ":"
+        Regex,          //pattern: capture group 1, or the whole match
+        Byte            //the first byte of the line
+    };
+
+    static const int MAX_CHANNELS = 256;
+    static const int MAX_TAG_SCAN = 64;
+    //Lines routed per call; the rest follows from the event loop so a new
+    //rule over a long scrollback does not stall the GUI.
+    static const qint64 ROUTE_BUDGET = 200000;
+
+    explicit ChannelDemux(const LineStore &store, QObject *parent = nullptr);
+
+    //Drops all channels; update() routes the store again. Returns false (see
+    //errorString()) for an invalid pattern.
+    bool setRule(Mode mode, const QString &pattern);
+    Mode mode() const { return _mode; }
+    QString pattern() const { return _pattern; }
+    QString errorString() const { return _errorString; }
+
+    //Prefix put before every line written to a channel, "%1" being the tag;
+    //empty sends writes as they are.
+    void setTxTemplate(const QString &txTemplate);
+    QString txTemplate() const { return _txTemplate; }
+    static QString defaultTxTemplate(Mode mode, const QString &pattern);
+
+    //GUI thread, after lines were appended to the store.
+    void update();
+    //GUI thread, before the store is cleared. The channels stay, empty.
+    void reset();
+    bool isRouting() const { return _mode != Off && _routed < _store.completedLineCount(); }
+
+    int channelCount() const { return _channels.size(); }
+    ChannelIndex *channel(int channel) const { return _channels.value(channel); }
+    qint64 routedLines() const { return _routed; }
+
+    //data as written to channel, with the channel's prefix at the start of
+    //every line. Keys arrive one at a time, so where a line starts is kept
+    //per channel between calls.
+    QByteArray frame(int channel, const QByteArray &data);
+
+private slots:
+    void _slot_continue();
+
+private:
+    bool _tag(const ByteView &text, ByteView &key);
+    int _channel(const ByteView &key);
+    int _addChannel(const QByteArray &key, const QString &name);
+    int _untaggedChannel();
+    void _route(qint64 end);
+
+    const LineStore &_store;
+    Mode _mode = Off;
+    QString _pattern;
+    char _open = '[';
+    char _close = ']';
+    QByteArray _separator;
+    QRegularExpression _regex;
+    //The scanned start of a line for _regex, reused.
+    QString _text;
+    QString _txTemplate;
+    QVector<ChannelIndex *> _channels;
+    int _byByte[256];
+    int _untagged = -1;
+    int _last = -1;
+    //Lines below this have been routed.
+    qint64 _routed = 0;
+    bool _continuePending = false;
+    QString _errorString;
+};
+
+#endif // CHANNELDEMUX_H
@@ -0,0 +1,223 @@
+#include "channelview.h"
+#include "channeldemux.h"
+#include "console.h"
+#include "monotonicclock.h"
+
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTabWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+ChannelView::ChannelView(Console *source, QWidget *parent) :
+    QWidget(parent),
+    _demux(new ChannelDemux(source->lineStore(), this)),
+    _mode(new QComboBox),
+    _pattern(new QLineEdit),
+    _txTemplate(new QLineEdit),
+    _status(new QLabel),
+    _tabs(new QTabWidget),
+    _refreshTimer(new QTimer(this))
+{
+    _mode->addItem(tr("Off"), ChannelDemux::Off);
+    _mode->addItem(tr("[tag]"), ChannelDemux::Bracket);
+    _mode->addItem(tr("tag:"), ChannelDemux::Separator);
+    _mode->addItem(tr("Regex"), ChannelDemux::Regex);
+    _mode->addItem(tr("First byte"), ChannelDemux::Byte);
+    _mode->setToolTip(tr("How the channel of a line is found at its start"));
+    _pattern->setClearButtonEnabled(true);
+    _txTemplate->setPlaceholderText(tr("TX prefix"));
+    _txTemplate->setToolTip(tr("Put before every line typed into a channel, %1 being the channel's tag"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_mode);
+    bar->addWidget(_pattern, 1);
+    bar->addWidget(_txTemplate);
+    bar->addWidget(_status);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_tabs, 1);
+
+    _refreshTimer->setInterval(500);
+    connect(_refreshTimer, &QTimer::timeout, this, &ChannelView::_slot_stats);
+    connect(_mode, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, &ChannelView::_slot_mode);
+    connect(_pattern, &QLineEdit::editingFinished, this, &ChannelView::_slot_apply);
+    connect(_txTemplate, &QLineEdit::textChanged, this, &ChannelView::_slot_txTemplate);
+    connect(_demux, &ChannelDemux::channelAdded, this, &ChannelView::_slot_channelAdded);
+    //Direct: the consoles hold the indexes about to be deleted.
+    connect(_demux, &ChannelDemux::channelsRemoved, this, &ChannelView::_slot_channelsRemoved, Qt::DirectConnection);
+    connect(source, &Console::aboutToClear, this, &ChannelView::_slot_cleared, Qt::DirectConnection);
+
+    _slot_mode(_mode->currentIndex());
+}
+
+void
+ChannelView::setActive(bool active) {
+    _active = active;
+    if (active) {
+        _demux->update();
+        _lastStatsNs = monotonicNowNs();
+        _refreshTimer->start();
+        _slot_stats();
+    }
+    else {
+        _refreshTimer->stop();
+    }
+}
+
+void
+ChannelView::refresh() {
+    if (_active) {
+        _demux->update();
+    }
+}
+
+void
+ChannelView::setReadOnly(bool readOnly) {
+    _readOnly = readOnly;
+    for (const Tab &tab : _channels) {
+        tab.console->setReadOnly(readOnly);
+    }
+}
+
+void
+ChannelView::setHighlightRules(const QVector<HighlightRule> &rules) {
+    _rules = rules;
+    for (const Tab &tab : _channels) {
+        tab.console->setHighlightRules(rules);
+    }
+}
+
+void
+ChannelView::_slot_mode(int index) {
+    const ChannelDemux::Mode mode = static_cast<ChannelDemux::Mode>(_mode->itemData(index).toInt());
+    switch (mode) {
+    case ChannelDemux::Bracket:
+        _pattern->setText(QStringLiteral("[]"));
+        _pattern->setPlaceholderText(tr("Opening and closing character"));
+        break;
+    case ChannelDemux::Separator:
+        _pattern->setText(QStringLiteral(":"));
+        _pattern->setPlaceholderText(tr("End of the tag"));
+        break;
+    case ChannelDemux::Regex:
+        _pattern->setText(QStringLiteral("^(\\w+)>"));
+        _pattern->setPlaceholderText(tr("Capture 1 is the channel"));
+        break;
+    default:
+        _pattern->clear();
+        _pattern->setPlaceholderText(QString());
+        break;
+    }
+    _pattern->setEnabled(mode == ChannelDemux::Bracket || mode == ChannelDemux::Separator || mode == ChannelDemux::Regex);
+    _txTemplate->setEnabled(mode != ChannelDemux::Off);
+    _txTemplate->setText(ChannelDemux::defaultTxTemplate(mode, _pattern->text()));
+    _slot_apply();
+}
+
+void
+ChannelView::_slot_apply() {
+    const ChannelDemux::Mode mode = static_cast<ChannelDemux::Mode>(_mode->currentData().toInt());
+    //editingFinished also comes when the field just loses focus.
+    if (mode == _demux->mode() && _pattern->text() == _demux->pattern() && _demux->channelCount()) { return; }
+
+    if (!_demux->setRule(mode, _pattern->text())) {
+        _status->setText(_demux->errorString());
+        return;
+    }
+    //Otherwise routed when shown.
+    if (_active) {
+        _demux->update();
+    }
+    _slot_stats();
+}
+
+void
+ChannelView::_slot_txTemplate(const QString &text) {
+    _demux->setTxTemplate(text);
+}
+
+void
+ChannelView::_slot_channelAdded(int channel) {
+    ChannelIndex *index = _demux->channel(channel);
+
+    Tab tab;
+    tab.stats = new QLabel;
+    tab.console = new Console;
+    tab.console->setHighlightRules(_rules);
+    tab.console->setFilter(index);
+    tab.console->setReadOnly(_readOnly);
+
+    QWidget *page = new QWidget;
+    QVBoxLayout *layout = new QVBoxLayout(page);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(tab.stats);
+    layout->addWidget(tab.console, 1);
+    _tabs->addTab(page, index->name());
+    _channels.append(tab);
+
+    connect(tab.console, &Console::getData, this, [this, channel](const QByteArray &data) {
+        emit getData(_demux->frame(channel, data));
+    });
+}
+
+void
+ChannelView::_slot_channelsRemoved() {
+    while (_tabs->count()) {
+        QWidget *page = _tabs->widget(0);
+        _tabs->removeTab(0);
+        delete page;
+    }
+    _channels.clear();
+}
+
+void
+ChannelView::_slot_cleared() {
+    _demux->reset();
+    for (Tab &tab : _channels) {
+        tab.lastRows = 0;
+    }
+}
+
+qint64
+ChannelView::indexBytes() const {
+    qint64 bytes = 0;
+    for (int x = 0; x < _demux->channelCount(); x++) {
+        bytes += _demux->channel(x)->ownedBytes();
+    }
+    return bytes;
+}
+
+void
+ChannelView::_slot_stats() {
+    const quint64 now = monotonicNowNs();
+    const double seconds = now > _lastStatsNs ? (now - _lastStatsNs) / 1e9 : 0;
+    _lastStatsNs = now;
+
+    const qint64 routed = _demux->routedLines();
+    for (int x = 0; x < _channels.size(); x++) {
+        Tab &tab = _channels[x];
+        const ChannelIndex *index = _demux->channel(x);
+        const qint64 rows = index->rowCount();
+        const double rate = seconds > 0 ? (rows - tab.lastRows) / seconds : 0;
+        tab.lastRows = rows;
+        tab.stats->setText(tr("%1 lines (%2%), %3 bytes, %4 lines/s")
+                           .arg(rows)
+                           .arg(routed ? 100.0 * rows / routed : 0, 0, 'f', 1)
+                           .arg(index->bytes())
+                           .arg(rate, 0, 'f', 0));
+    }
+
+    if (_demux->mode() == ChannelDemux::Off) {
+        _status->clear();
+    }
+    else {
+        _status->setText(_demux->isRouting() ? tr("%1 channels, routing...").arg(_demux->channelCount())
+                                             : tr("%1 channels").arg(_demux->channelCount()));
+    }
+}
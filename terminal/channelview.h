@@ -0,0 +1,78 @@
+#ifndef CHANNELVIEW_H
+#define CHANNELVIEW_H
+
+#include "highlighter.h"
+
+#include <QVector>
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QTabWidget;
+class QTimer;
+
+QT_END_NAMESPACE
+
+class ChannelDemux;
+class Console;
+
+//Dockable panel with one console per channel of the source console's lines,
+//split by a ChannelDemux. The channel consoles show line numbers into the
+//source's store and keep their own scroll position; typing into one sends
+//through getData() with the channel's TX prefix.
+class ChannelView : public QWidget
+{
+    Q_OBJECT
+
+signals:
+    void getData(const QByteArray &data);
+
+public:
+    explicit ChannelView(Console *source, QWidget *parent = nullptr);
+
+    //Lines are only routed while the view is shown; showing it catches up.
+    void setActive(bool active);
+    bool isActive() const { return _active; }
+
+    //After new data was shown in the source console.
+    void refresh();
+    //Whether the channel consoles send keys.
+    void setReadOnly(bool readOnly);
+    void setHighlightRules(const QVector<HighlightRule> &rules);
+    //Heap held by the channel indexes.
+    qint64 indexBytes() const;
+
+private slots:
+    void _slot_mode(int index);
+    void _slot_apply();
+    void _slot_txTemplate(const QString &text);
+    void _slot_channelAdded(int channel);
+    void _slot_channelsRemoved();
+    void _slot_cleared();
+    void _slot_stats();
+
+private:
+    struct Tab {
+        QLabel *stats = nullptr;
+        Console *console = nullptr;
+        qint64 lastRows = 0;
+    };
+
+    ChannelDemux *_demux = nullptr;
+    QComboBox *_mode = nullptr;
+    QLineEdit *_pattern = nullptr;
+    QLineEdit *_txTemplate = nullptr;
+    QLabel *_status = nullptr;
+    QTabWidget *_tabs = nullptr;
+    QTimer *_refreshTimer = nullptr;
+    quint64 _lastStatsNs = 0;
+    QVector<Tab> _channels;
+    QVector<HighlightRule> _rules;
+    bool _readOnly = true;
+    bool _active = false;
+};
+
+#endif // CHANNELVIEW_H
@@ -0,0 +1,282 @@
+#include "commandscheduler.h"
+#include "monotonicclock.h"
+#include "serialiothread.h"
+#include "triggerengine.h"
+
+#include <QMutexLocker>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+CommandScheduler::CommandScheduler(QObject *parent) :
+    QObject(parent),
+    _running(false)
+{
+}
+
+CommandScheduler::~CommandScheduler() {
+    stop();
+}
+
+void
+CommandScheduler::configure(const QVector<ScheduledCommand> &commands, SerialIoThread *io) {
+    Q_ASSERT(!isRunning());
+    _commands = commands;
+    _io = io;
+
+    QMutexLocker lock(&_mutex);
+    _states.clear();
+    _states.resize(_commands.size());
+    for (int x = 0; x < _commands.size(); x++) {
+        const ScheduledCommand &command = _commands.at(x);
+        State &state = _states[x];
+        state.periodNs = static_cast<quint64>(qMax<quint32>(command.intervalMs, 1)) * 1000000ull;
+        state.timeoutNs = (command.timeoutMs == 0 || command.timeoutMs > command.intervalMs)
+                ? state.periodNs : static_cast<quint64>(command.timeoutMs) * 1000000ull;
+        if (command.regex) {
+            state.pattern.setPattern(command.response);
+            state.pattern.optimize();
+        }
+        else {
+            state.literal = TriggerEngine::unescape(command.response);
+        }
+    }
+}
+
+void
+CommandScheduler::recordSend(int command, quint64 dueNs, quint64 sentNs) {
+    QMutexLocker lock(&_mutex);
+    if (command >= 0 && command < _states.size()) {
+        _record(_states[command], dueNs, sentNs);
+    }
+}
+
+void
+CommandScheduler::_record(State &state, quint64 dueNs, quint64 sentNs) {
+    state.stats.sent++;
+    state.stats.jitter.add(sentNs > dueNs ? sentNs - dueNs : 0);
+    if (!state.literal.isEmpty() || !state.pattern.pattern().isEmpty()) {
+        //An unanswered request is written off when the next one goes out.
+        if (state.pending) { state.stats.timeouts++; }
+        state.pending = true;
+        state.sentNs = sentNs;
+        state.received.clear();
+    }
+}
+
+void
+CommandScheduler::feed(const ByteView &data, quint64 timestampNs) {
+    QMutexLocker lock(&_mutex);
+    for (State &state : _states) {
+        if (!state.pending || timestampNs < state.sentNs) { continue; }
+
+        state.received.append(data.data, static_cast<int>(data.size));
+        if (state.received.size() > MAX_RESPONSE) {
+            state.received.remove(0, state.received.size() - MAX_RESPONSE);
+        }
+
+        const bool matched = state.literal.isEmpty()
+                ? state.pattern.match(QString::fromLatin1(state.received)).hasMatch()
+                : state.received.contains(state.literal);
+        const quint64 latencyNs = timestampNs - state.sentNs;
+        if (matched && latencyNs <= state.timeoutNs) {
+            state.stats.answered++;
+            state.stats.latency.add(latencyNs);
+            state.pending = false;
+        }
+        else if (latencyNs > state.timeoutNs) {
+            state.stats.timeouts++;
+            state.pending = false;
+        }
+    }
+}
+
+QVector<ScheduledCommandStats>
+CommandScheduler::stats() const {
+    QVector<ScheduledCommandStats> out;
+    QMutexLocker lock(&_mutex);
+    out.reserve(_states.size());
+    for (const State &state : _states) {
+        out.append(state.stats);
+    }
+    return out;
+}
+
+void
+CommandScheduler::resetStats() {
+    QMutexLocker lock(&_mutex);
+    for (State &state : _states) {
+        state.stats = ScheduledCommandStats();
+        state.pending = false;
+    }
+}
+
+#ifdef Q_OS_LINUX
+
+bool
+CommandScheduler::start() {
+    if (isRunning()) { return true; }
+    if (_commands.isEmpty()) {
+        _errorString = tr("No scheduled commands configured");
+        return false;
+    }
+
+    _timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    _wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_timerFd < 0 || _wakeFd < 0) {
+        _errorString = QStringLiteral("timerfd: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        stop();
+        return false;
+    }
+
+    {
+        QMutexLocker lock(&_mutex);
+        const quint64 nowNs = monotonicNowNs();
+        for (State &state : _states) {
+            state.dueNs = nowNs;
+            state.pending = false;
+        }
+    }
+
+    _running.store(true);
+    _thread = std::thread(&CommandScheduler::_run, this);
+    emit runningChanged(true);
+    return true;
+}
+
+void
+CommandScheduler::stop() {
+    const bool wasRunning = _thread.joinable();
+    if (wasRunning) {
+        _running.store(false);
+        _wake();
+        _thread.join();
+    }
+
+    if (_timerFd >= 0) { ::close(_timerFd); }
+    if (_wakeFd >= 0) { ::close(_wakeFd); }
+    _timerFd = -1;
+    _wakeFd = -1;
+
+    if (wasRunning) {
+        emit runningChanged(false);
+    }
+}
+
+void
+CommandScheduler::_run() {
+    //The default 50 us of timer slack would show up as jitter.
+    ::prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+
+    pollfd fds[2];
+    fds[0].fd = _timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = _wakeFd;
+    fds[1].events = POLLIN;
+
+    while (_running.load(std::memory_order_relaxed)) {
+        quint64 nextNs = 0;
+        {
+            QMutexLocker lock(&_mutex);
+            for (const State &state : _states) {
+                if (nextNs == 0 || state.dueNs < nextNs) { nextNs = state.dueNs; }
+            }
+        }
+
+        //Absolute deadlines: a late wake-up does not push later sends back.
+        itimerspec spec;
+        std::memset(&spec, 0, sizeof(spec));
+        spec.it_value.tv_sec = static_cast<time_t>(nextNs / 1000000000ull);
+        spec.it_value.tv_nsec = static_cast<long>(nextNs % 1000000000ull);
+        ::timerfd_settime(_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) { continue; }
+            qWarning("CommandScheduler: poll: %s", strerror(errno));
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            eventfd_t value;
+            ::eventfd_read(_wakeFd, &value);
+            continue;
+        }
+
+        quint64 expirations;
+        if (::read(_timerFd, &expirations, sizeof(expirations)) < 0) { continue; }
+
+        const quint64 nowNs = monotonicNowNs();
+        for (int x = 0; x < _commands.size(); x++) {
+            quint64 dueNs;
+            {
+                QMutexLocker lock(&_mutex);
+                State &state = _states[x];
+                if (state.dueNs > nowNs) { continue; }
+
+                //Periods missed entirely are counted, not sent in a burst.
+                const quint64 missed = (nowNs - state.dueNs) / state.periodNs;
+                state.stats.skipped += missed;
+                dueNs = state.dueNs + missed * state.periodNs;
+                state.dueNs = dueNs + state.periodNs;
+            }
+            _send(x, dueNs);
+        }
+    }
+}
+
+void
+CommandScheduler::_send(int command, quint64 dueNs) {
+    const QByteArray &payload = _commands.at(command).payload;
+    if (!_io) {
+        emit sendRequested(command, payload, dueNs);
+        return;
+    }
+
+    const quint64 sentNs = monotonicNowNs();
+    _io->write(payload);
+    recordSend(command, dueNs, sentNs);
+    emit sent(payload, sentNs);
+}
+
+void
+CommandScheduler::_wake() {
+    if (_wakeFd >= 0) {
+        ::eventfd_write(_wakeFd, 1);
+    }
+}
+
+#else
+
+bool
+CommandScheduler::start() {
+    _errorString = tr("The command scheduler is only available on Linux");
+    return false;
+}
+
+void
+CommandScheduler::stop() {
+}
+
+void
+CommandScheduler::_run() {
+}
+
+void
+CommandScheduler::_send(int command, quint64 dueNs) {
+    Q_UNUSED(command);
+    Q_UNUSED(dueNs);
+}
+
+void
+CommandScheduler::_wake() {
+}
+
+#endif
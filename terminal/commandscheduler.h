@@ -0,0 +1,113 @@
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include "bufferpool.h"
+#include "latencyhistogram.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <thread>
+
+class SerialIoThread;
+
+struct ScheduledCommand {
+    QString name;
+    QByteArray payload;
+    quint32 intervalMs = 1000;
+    //Text or regex that identifies the response; empty sends blind.
+    QString response;
+    bool regex = false;
+    //0 (or more than the interval) waits until the next send.
+    quint32 timeoutMs = 0;
+};
+
+struct ScheduledCommandStats {
+    quint64 sent = 0;
+    quint64 answered = 0;
+    quint64 timeouts = 0;
+    //Periods that passed without a send because the host was too late.
+    quint64 skipped = 0;
+    LatencyHistogram latency;   //send to the end of the matching response
+    LatencyHistogram jitter;    //scheduled to actual send time
+};
+
+//Sends commands at fixed intervals from a dedicated thread that sleeps on an
+//absolute CLOCK_MONOTONIC timerfd, so sends stay on their period no matter how
+//busy the GUI is and never drift. Every send is timed against its scheduled
+//time (jitter, i.e. host noise) and against the response that matches the
+//command's pattern (latency, i.e. the device). In low latency mode commands are
+//written straight from the timer thread; otherwise sendRequested() asks the
+//owner of the port to write and report back with recordSend().
+class CommandScheduler : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void sendRequested(int command, const QByteArray &data, quint64 dueNs);
+    //Written by the timer thread, for the TX side of the taps and analyzers.
+    void sent(const QByteArray &data, quint64 timestampNs);
+    void runningChanged(bool running);
+
+public:
+    explicit CommandScheduler(QObject *parent = nullptr);
+    ~CommandScheduler();
+
+    //GUI thread, while stopped. io may be null.
+    void configure(const QVector<ScheduledCommand> &commands, SerialIoThread *io);
+    const QVector<ScheduledCommand> &commands() const { return _commands; }
+
+    bool start();
+    void stop();
+    bool isRunning() const { return _thread.joinable(); }
+    QString errorString() const { return _errorString; }
+
+    //Any thread.
+    void recordSend(int command, quint64 dueNs, quint64 sentNs);
+    //GUI thread, with every received chunk.
+    void feed(const ByteView &data, quint64 timestampNs);
+
+    QVector<ScheduledCommandStats> stats() const;
+    void resetStats();
+
+private:
+    static const int MAX_RESPONSE = 4096;
+
+    struct State {
+        QRegularExpression pattern;
+        QByteArray literal;
+        quint64 periodNs = 0;
+        quint64 timeoutNs = 0;
+        quint64 dueNs = 0;
+        //Outstanding request
+        bool pending = false;
+        quint64 sentNs = 0;
+        QByteArray received;
+        ScheduledCommandStats stats;
+    };
+
+    void _run();
+    void _send(int command, quint64 dueNs);
+    void _record(State &state, quint64 dueNs, quint64 sentNs);
+    void _wake();
+
+    QVector<ScheduledCommand> _commands;
+    SerialIoThread *_io = nullptr;
+
+    mutable QMutex _mutex;
+    QVector<State> _states;
+
+    int _timerFd = -1;
+    int _wakeFd = -1;
+    std::thread _thread;
+    std::atomic<bool> _running;
+
+    QString _errorString;
+};
+
+#endif // COMMANDSCHEDULER_H
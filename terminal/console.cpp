@@ -50,36 +50,77 @@
 ****************************************************************************/
 
 #include "console.h"
-
+#include "sessionfile.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QProgressBar>
 #include <QScrollBar>
+#include <QTimer>
+#include <QToolButton>
 #include <QDebug>
 
-Console::Console(QWidget *parent) : QPlainTextEdit(parent) {
-    document()->setMaximumBlockCount(5000);
+//Smaller selections are copied right away.
+static const qint64 COPY_INLINE_LINES = 10000;
+
+Console::Console(QWidget *parent) : QAbstractScrollArea(parent) {
     QPalette p = palette();
     p.setColor(QPalette::Base, Qt::black);
     p.setColor(QPalette::Text, Qt::green);
     setPalette(p);
+
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setFocusPolicy(Qt::StrongFocus);
+
+    //paintEvent() repaints every row it is asked for, so Qt does not need to
+    //clear the background first.
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+
+    _store.setHighlighter(&_highlighter);
+
+    rebuildAtlas();
+    rebuildColors();
+    updateScrollBars();
+
+    connect(&_export, &LineExport::progress, this, &Console::showExportProgress);
+    connect(&_export, &LineExport::finished, this, &Console::finishExport);
+}
+
+Console::~Console() {
+    emit aboutToClear();
 }
 
 void
-Console::putData(const QByteArray &data) {
+Console::putData(const ByteView &data, quint64 timestampNs) {
 
-    //the QPlainTextEdit doesn't like delete char sent to us.
-    //We intercept and manually delete the char.
-    for(auto c : data) {
-        if(c == char(8)) {
-            this->textCursor().deletePreviousChar();
-        }
-        else {
-            insertPlainText(QString(c));
-        }
-    }
+    //The open last line is the only existing line the data can change; the rest is new.
+    const qint64 firstChanged = qMax<qint64>(0, _store.lineCount() - 1);
 
-    qDebug() << "Data: " << data;
+    //Control characters (backspace included) are interpreted by the store.
+    const bool wasFull = _store.isFull();
+    _store.append(data, timestampNs);
+    if(!wasFull && _store.isFull()) {
+        qWarning() << "Console: the scrollback is full," << _store.lineCount() << "lines; clear it to keep receiving";
+    }
 
     QScrollBar *bar = verticalScrollBar();
-    bar->setValue(bar->maximum());
+    const bool followTail = bar->value() >= bar->maximum();
+    updateScrollBars();
+    if(followTail) {
+        //Blits the rows already on screen, see scrollContentsBy().
+        bar->setValue(bar->maximum());
+    }
+
+    updateLines(firstChanged, _store.lineCount() - 1);
 }
 
 void
@@ -87,8 +128,228 @@ Console::setLocalEchoEnabled(bool set) {
     m_localEchoEnabled = set;
 }
 
+void
+Console::setHighlightRules(const QVector<HighlightRule> &rules) {
+    _highlighter.setRules(rules);
+    rebuildColors();
+}
+
+void
+Console::clear() {
+    emit aboutToClear();
+    _export.cancel();
+    _store.clear();
+    _selectionAnchor = -1;
+    _selectionEnd = -1;
+    updateScrollBars();
+    viewport()->update();
+}
+
+void
+Console::restoreSession(SessionFile &session) {
+    if(_store.lineCount() != 0) { return; }
+
+    session.restore(_store);
+    _selectionAnchor = -1;
+    _selectionEnd = -1;
+    updateScrollBars();
+    verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    viewport()->update();
+}
+
+qint64
+Console::spillToSession(SessionFile &session) {
+    return session.spill(_store);
+}
+
+qint64
+Console::trimCaches() {
+    const qint64 bytes = _atlas.bytes();
+    _atlas.trim();
+    return bytes;
+}
+
+void
+Console::showLine(qint64 line, int column) {
+    if(line < 0 || line >= rowCount()) { return; }
+
+    _selectionAnchor = line;
+    _selectionEnd = line;
+
+    //Line numbers are scroll positions; only scroll when the line is off screen.
+    QScrollBar *bar = verticalScrollBar();
+    const int rows = visibleRows();
+    if(line < bar->value() || line >= bar->value() + rows) {
+        bar->setValue(static_cast<int>(qMax<qint64>(0, line - rows / 2)));
+    }
+    QScrollBar *columns = horizontalScrollBar();
+    if(column < columns->value() || column >= columns->value() + visibleColumns()) {
+        columns->setValue(qMax(0, column - visibleColumns() / 4));
+    }
+    viewport()->update();
+}
+
+void
+Console::setFilter(LineIndex *filter) {
+    _filter = filter;
+    _readOnly = true;
+    connect(_filter, &LineIndex::rowsChanged, this, &Console::filterRowsChanged);
+    connect(_filter, &LineIndex::aboutToReset, this, &Console::cancelExport);
+    filterRowsChanged(0);
+}
+
+void
+Console::filterRowsChanged(qint64 firstRow) {
+    QScrollBar *bar = verticalScrollBar();
+    const bool followTail = bar->value() >= bar->maximum();
+    if(firstRow == 0) {
+        //Rebuilt; the old rows mean nothing any more.
+        _selectionAnchor = -1;
+        _selectionEnd = -1;
+        viewport()->update();
+    }
+    updateScrollBars();
+    if(followTail) {
+        bar->setValue(bar->maximum());
+    }
+    updateLines(firstRow, rowCount() - 1);
+}
+
+void
+Console::copy() {
+    if(_selectionAnchor < 0) { return; }
+
+    const qint64 first = qMin(_selectionAnchor, _selectionEnd);
+    const qint64 last = qMin(qMax(_selectionAnchor, _selectionEnd), rowCount() - 1);
+    if(last - first >= COPY_INLINE_LINES) {
+        startExport(LineExport::PlainText, QString());
+        return;
+    }
+
+    QByteArray text;
+    for(qint64 line = first; line <= last; line++) {
+        const ByteView view = lines().text(lineForRow(line));
+        text.append(view.data, static_cast<int>(view.size));
+        if(line != last) { text.append('\n'); }
+    }
+    QApplication::clipboard()->setText(QString::fromLatin1(text));
+}
+
+void
+Console::exportLines() {
+    if(rowCount() == 0) { return; }
+
+    const QString text = tr("Text (*.txt)");
+    const QString timestamps = tr("Text with timestamps (*.log)");
+    const QString latin1 = tr("Latin-1 text, bytes as stored (*.txt)");
+    QString filter = text;
+    const QString path = QFileDialog::getSaveFileName(this, tr("Export"), QString(),
+                                                      QStringList({ text, timestamps, latin1 }).join(QStringLiteral(";;")),
+                                                      &filter);
+    if(path.isEmpty()) { return; }
+
+    startExport(filter == timestamps ? LineExport::Timestamps
+                : filter == latin1 ? LineExport::Latin1Text : LineExport::PlainText, path);
+}
+
+void
+Console::cancelExport() {
+    _export.cancel();
+}
+
+void
+Console::startExport(LineExport::Format format, const QString &path) {
+    if(rowCount() == 0) { return; }
+
+    qint64 first = 0;
+    qint64 last = rowCount() - 1;
+    if(_selectionAnchor >= 0) {
+        first = qMin(_selectionAnchor, _selectionEnd);
+        last = qMin(qMax(_selectionAnchor, _selectionEnd), last);
+    }
+    //The worker only reads completed lines; the open last one is copied now.
+    QByteArray tail;
+    if(!_filter && last >= _store.completedLineCount()) {
+        const ByteView open = _store.text(last);
+        tail = QByteArray(open.data, static_cast<int>(open.size));
+        last--;
+    }
+
+    if(!_exportBar) {
+        _exportBar = new QWidget(this);
+        _exportProgress = new QProgressBar;
+        _exportCancel = new QToolButton;
+        _exportCancel->setText(tr("Cancel"));
+        QHBoxLayout *layout = new QHBoxLayout(_exportBar);
+        layout->setContentsMargins(4, 4, 4, 4);
+        layout->addWidget(_exportProgress, 1);
+        layout->addWidget(_exportCancel);
+        _exportBar->setAutoFillBackground(true);
+        connect(_exportCancel, &QToolButton::clicked, this, &Console::cancelExport);
+    }
+    _exportToClipboard = path.isEmpty();
+    _exportProgress->setRange(0, 100);
+    _exportProgress->setValue(0);
+    _exportProgress->setFormat(_exportToClipboard ? tr("Copying %p%") : tr("Exporting %p%"));
+    _exportCancel->show();
+    placeExportBar();
+    _exportBar->show();
+
+    _export.start(lines(), _filter, first, last, tail, format, path);
+}
+
+void
+Console::placeExportBar() {
+    if(!_exportBar) { return; }
+    const QRect area = viewport()->geometry();
+    const QSize size(qMin(area.width(), 320), _exportBar->sizeHint().height());
+    _exportBar->setGeometry(area.right() - size.width() + 1, area.bottom() - size.height() + 1,
+                            size.width(), size.height());
+}
+
+void
+Console::showExportProgress(qint64 rows, qint64 total) {
+    if(_exportProgress && total > 0) {
+        _exportProgress->setValue(static_cast<int>(rows * 100 / total));
+    }
+}
+
+void
+Console::finishExport(bool ok, const QString &message) {
+    //A newer export has replaced the one this is about.
+    if(_export.isRunning()) { return; }
+
+    if(ok && _exportToClipboard) {
+        QApplication::clipboard()->setText(_export.takeText());
+    }
+    if(_exportBar) {
+        _exportProgress->setValue(100);
+        _exportProgress->setFormat(message);
+        _exportCancel->hide();
+        QTimer::singleShot(3000, _exportBar, [this]() {
+            if(!_export.isRunning()) { _exportBar->hide(); }
+        });
+    }
+    emit exportFinished(ok, message);
+}
+
+void
+Console::selectAll() {
+    if(rowCount() == 0) { return; }
+
+    _selectionAnchor = 0;
+    _selectionEnd = rowCount() - 1;
+    viewport()->update();
+}
+
 void Console::keyPressEvent(QKeyEvent *e)
 {
+    if(_readOnly) {
+        //Filtered views, and a console that is not connected, only display.
+        QAbstractScrollArea::keyPressEvent(e);
+        return;
+    }
+
     QByteArray a;
 
     switch (e->key()) {
@@ -218,8 +479,226 @@ void Console::keyPressEvent(QKeyEvent *e)
 
 void
 Console::backspace(size_t count) {
-    for(size_t x = 0; x < count; x++) {
-        this->textCursor().deletePreviousChar();
+    const QByteArray erase(static_cast<int>(count), char(8));
+    putData(ByteView(erase.constData(), erase.size()), 0);
+}
+
+void
+Console::paintEvent(QPaintEvent *e) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QPainter painter(viewport());
+    const QRect dirty = e->rect();
+    painter.fillRect(dirty, _background);
+
+    const int cellHeight = _atlas.cellSize().height();
+    const int firstRow = qMax(0, dirty.top() / cellHeight);
+    const int lastRow = dirty.bottom() / cellHeight;
+    const qint64 topLine = verticalScrollBar()->value();
+    for(int row = firstRow; row <= lastRow; row++) {
+        const qint64 line = topLine + row;
+        if(line >= rowCount()) { break; }
+        paintRow(painter, row, line);
     }
+
+    const qint64 nsecs = timer.nsecsElapsed();
+    _frameStats.frames++;
+    _frameStats.lastNsecs = nsecs;
+    _frameStats.maxNsecs = qMax(_frameStats.maxNsecs, nsecs);
+    _frameStats.totalNsecs += static_cast<quint64>(nsecs);
 }
 
+void
+Console::paintRow(QPainter &painter, int row, qint64 line) {
+    const QSize cell = _atlas.cellSize();
+    const int y = row * cell.height();
+
+    const qint64 selectionFirst = qMin(_selectionAnchor, _selectionEnd);
+    const qint64 selectionLast = qMax(_selectionAnchor, _selectionEnd);
+    if(_selectionAnchor >= 0 && line >= selectionFirst && line <= selectionLast) {
+        painter.fillRect(QRect(0, y, viewport()->width(), cell.height()), _selectionBackground);
+    }
+
+    const LineStore::Line text = lines().line(lineForRow(line));
+    const int firstColumn = horizontalScrollBar()->value();
+    const int lastColumn = static_cast<int>(qMin<qint64>(text.text.size, firstColumn + visibleColumns() + 1));
+    if(firstColumn >= lastColumn) { return; }
+
+    //Resolve the color of every visible cell; later spans paint over earlier ones.
+    _fragmentColors.fill(0, lastColumn - firstColumn);
+    for(int x = 0; x < text.spanCount; x++) {
+        const FormatSpan &span = text.spans[x];
+        const int from = qMax(span.start, firstColumn);
+        const int to = qMin(span.start + span.length, lastColumn);
+        //Restored sessions can hold spans of rules that are gone.
+        const int color = span.format + 1 < _colors.size() ? span.format + 1 : 0;
+        for(int column = from; column < to; column++) {
+            _fragmentColors[column - firstColumn] = color;
+        }
+    }
+
+    //Blit glyphs in runs of one color, one drawPixmapFragments() call per run.
+    const qreal scale = 1.0 / _atlas.devicePixelRatio();
+    const qreal centerY = y + cell.height() / 2.0;
+    _fragments.resize(0);
+    int runColor = _fragmentColors.at(0);
+    for(int column = firstColumn; column < lastColumn; column++) {
+        const int color = _fragmentColors.at(column - firstColumn);
+        if(color != runColor && !_fragments.isEmpty()) {
+            painter.drawPixmapFragments(_fragments.constData(), _fragments.size(), _atlas.pixmap(_colors.at(runColor)));
+            _fragments.resize(0);
+        }
+        runColor = color;
+
+        const char c = text.text.data[column];
+        if(_atlas.isBlank(c)) { continue; }
+
+        const QPointF center((column - firstColumn) * cell.width() + cell.width() / 2.0, centerY);
+        _fragments.append(QPainter::PixmapFragment::create(center, _atlas.source(c), scale, scale));
+    }
+    if(!_fragments.isEmpty()) {
+        painter.drawPixmapFragments(_fragments.constData(), _fragments.size(), _atlas.pixmap(_colors.at(runColor)));
+    }
+}
+
+void
+Console::resizeEvent(QResizeEvent *e) {
+    QAbstractScrollArea::resizeEvent(e);
+    updateScrollBars();
+    placeExportBar();
+}
+
+void
+Console::changeEvent(QEvent *e) {
+    if(e->type() == QEvent::FontChange) {
+        rebuildAtlas();
+        updateScrollBars();
+        viewport()->update();
+    }
+    else if(e->type() == QEvent::PaletteChange) {
+        rebuildColors();
+        viewport()->update();
+    }
+    QAbstractScrollArea::changeEvent(e);
+}
+
+void
+Console::scrollContentsBy(int dx, int dy) {
+    //Move the pixels that stay visible instead of repainting them; Qt sends a
+    //paint event for the strip that is uncovered.
+    if(qAbs(dy) >= visibleRows() || qAbs(dx) >= visibleColumns()) {
+        viewport()->update();
+    }
+    else {
+        viewport()->scroll(dx * _atlas.cellSize().width(), dy * _atlas.cellSize().height());
+    }
+}
+
+void
+Console::mousePressEvent(QMouseEvent *e) {
+    if(e->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(e);
+        return;
+    }
+
+    _selectionAnchor = lineAt(e->pos());
+    _selectionEnd = _selectionAnchor;
+    viewport()->update();
+}
+
+void
+Console::mouseMoveEvent(QMouseEvent *e) {
+    if(!(e->buttons() & Qt::LeftButton) || _selectionAnchor < 0) { return; }
+
+    const qint64 line = lineAt(e->pos());
+    if(line >= 0 && line != _selectionEnd) {
+        _selectionEnd = line;
+        viewport()->update();
+    }
+}
+
+void
+Console::contextMenuEvent(QContextMenuEvent *e) {
+    QMenu menu(this);
+    QAction *copyAction = menu.addAction(tr("&Copy"), this, &Console::copy);
+    copyAction->setEnabled(_selectionAnchor >= 0);
+    menu.addAction(tr("Select &All"), this, &Console::selectAll);
+    menu.addSeparator();
+    menu.addAction(_selectionAnchor >= 0 ? tr("&Export Selection...") : tr("&Export..."), this, &Console::exportLines);
+    QAction *cancelAction = menu.addAction(tr("Cancel E&xport"), this, &Console::cancelExport);
+    cancelAction->setEnabled(_export.isRunning());
+    menu.addSeparator();
+    menu.addAction(tr("C&lear"), this, &Console::clear);
+    menu.exec(e->globalPos());
+}
+
+bool
+Console::focusNextPrevChild(bool next) {
+    //Tab belongs to the device, not to focus navigation.
+    Q_UNUSED(next);
+    return false;
+}
+
+void
+Console::rebuildAtlas() {
+    _atlas.setFont(font(), devicePixelRatioF());
+    verticalScrollBar()->setSingleStep(1);
+    horizontalScrollBar()->setSingleStep(1);
+}
+
+void
+Console::rebuildColors() {
+    _background = palette().color(QPalette::Base);
+    _selectionBackground = palette().color(QPalette::Highlight).darker(200);
+
+    _colors.resize(0);
+    _colors.append(palette().color(QPalette::Text));
+    for(int x = 0; x < _highlighter.ruleCount(); x++) {
+        _colors.append(_highlighter.color(x));
+    }
+}
+
+void
+Console::updateScrollBars() {
+    const int visible = visibleRows();
+    const int columns = visibleColumns();
+    const qint64 rows = rowCount();
+    //The open last line can be longer than any completed one; filters only hold completed lines.
+    const qint64 openLine = (rows && !_filter) ? _store.text(rows - 1).size : 0;
+
+    verticalScrollBar()->setPageStep(visible);
+    verticalScrollBar()->setRange(0, static_cast<int>(qMax<qint64>(0, rows - visible)));
+    horizontalScrollBar()->setPageStep(columns);
+    horizontalScrollBar()->setRange(0, static_cast<int>(qMax<qint64>(0, qMax(lines().longestLine(), openLine) - columns)));
+}
+
+void
+Console::updateLines(qint64 first, qint64 last) {
+    const qint64 top = verticalScrollBar()->value();
+    const qint64 firstRow = qMax<qint64>(first - top, 0);
+    const qint64 lastRow = qMin<qint64>(last - top, visibleRows());
+    if(firstRow > lastRow) { return; }
+
+    const int cellHeight = _atlas.cellSize().height();
+    viewport()->update(QRect(0, static_cast<int>(firstRow) * cellHeight, viewport()->width(),
+                             static_cast<int>(lastRow - firstRow + 1) * cellHeight));
+}
+
+int
+Console::visibleRows() const {
+    return qMax(1, viewport()->height() / _atlas.cellSize().height());
+}
+
+int
+Console::visibleColumns() const {
+    return qMax(1, viewport()->width() / _atlas.cellSize().width());
+}
+
+qint64
+Console::lineAt(const QPoint &pos) const {
+    if(rowCount() == 0) { return -1; }
+
+    const qint64 line = verticalScrollBar()->value() + qMax(0, pos.y()) / _atlas.cellSize().height();
+    return qMin(line, rowCount() - 1);
+}
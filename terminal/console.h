@@ -52,28 +52,145 @@
 #ifndef CONSOLE_H
 #define CONSOLE_H
 
-#include <QPlainTextEdit>
+#include "bufferpool.h"
+#include "glyphatlas.h"
+#include "highlighter.h"
+#include "lineexport.h"
+#include "lineindex.h"
+#include "linestore.h"
 
-class Console : public QPlainTextEdit
+#include <QAbstractScrollArea>
+#include <QPainter>
+
+QT_BEGIN_NAMESPACE
+
+class QProgressBar;
+class QToolButton;
+
+QT_END_NAMESPACE
+
+class SessionFile;
+
+//Fixed-pitch terminal view. Text is kept in a LineStore and drawn as a grid of
+//cells from a GlyphAtlas; there is no text layout or shaping anywhere. Only
+//rows that changed are repainted, and following the tail scrolls by blitting
+//the pixels already on screen, so the cost of a frame depends on the number
+//of dirty rows and never on the size of the scrollback.
+class Console : public QAbstractScrollArea
 {
     Q_OBJECT
 
 signals:
     void getData(const QByteArray &data);
+    //Emitted before the line store is cleared; readers on other threads must
+    //stop touching it before returning.
+    void aboutToClear();
+    void exportFinished(bool ok, const QString &message);
 
 public:
+    struct FrameStats {
+        quint64 frames = 0;
+        qint64 lastNsecs = 0;
+        qint64 maxNsecs = 0;
+        quint64 totalNsecs = 0;
+    };
+
     explicit Console(QWidget *parent = nullptr);
+    ~Console();
 
-    void putData(const QByteArray &data);
+    void putData(const ByteView &data, quint64 timestampNs);
     void setLocalEchoEnabled(bool set);
+    //Keys are not sent, but the scrollback can still be browsed.
+    void setReadOnly(bool set) { _readOnly = set; }
+    bool isReadOnly() const { return _readOnly; }
+    void setHighlightRules(const QVector<HighlightRule> &rules);
+    const LineHighlighter &highlighter() const { return _highlighter; }
+
+    const LineStore &lineStore() const { return _store; }
+    //Makes the lines saved in session the start of the scrollback, on an
+    //empty console, and shows the end of them.
+    void restoreSession(SessionFile &session);
+    //Frees the heap copies of the lines session has saved, see
+    //SessionFile::spill(). session must be the one the store is synced to.
+    qint64 spillToSession(SessionFile &session);
+    //The rasterized glyphs, and dropping them; returns the bytes freed.
+    qint64 cacheBytes() const { return _atlas.bytes(); }
+    qint64 trimCaches();
+    //Selects line and scrolls it (and column) into view.
+    void showLine(qint64 line, int column = 0);
+    //Shows the rows of filter, lines of another console's store, instead of
+    //this console's own lines. The console becomes read only; setReadOnly()
+    //can make it send keys again.
+    void setFilter(LineIndex *filter);
+    FrameStats frameStats() const { return _frameStats; }
+
+public slots:
+    void clear();
+    //Large selections are copied on a worker thread, see exportLines().
+    void copy();
+    void selectAll();
+    //Asks for a file and format and writes the selection, or all lines when
+    //there is none, on a worker thread while the console carries on.
+    void exportLines();
+    void cancelExport();
+
+private slots:
+    void filterRowsChanged(qint64 firstRow);
+    void showExportProgress(qint64 rows, qint64 total);
+    void finishExport(bool ok, const QString &message);
 
 protected:
     void keyPressEvent(QKeyEvent *e) override;
+    void paintEvent(QPaintEvent *e) override;
+    void resizeEvent(QResizeEvent *e) override;
+    void changeEvent(QEvent *e) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void mousePressEvent(QMouseEvent *e) override;
+    void mouseMoveEvent(QMouseEvent *e) override;
+    void contextMenuEvent(QContextMenuEvent *e) override;
+    bool focusNextPrevChild(bool next) override;
 
 private:
     void backspace(size_t count);
+    void rebuildAtlas();
+    void rebuildColors();
+    void updateScrollBars();
+    void updateLines(qint64 first, qint64 last);
+    //Rows are lines, or the filter's rows.
+    qint64 rowCount() const { return _filter ? _filter->rowCount() : _store.lineCount(); }
+    qint64 lineForRow(qint64 row) const { return _filter ? _filter->line(row) : row; }
+    const LineStore &lines() const { return _filter ? _filter->store() : _store; }
+    int visibleRows() const;
+    int visibleColumns() const;
+    qint64 lineAt(const QPoint &pos) const;
+    void paintRow(QPainter &painter, int row, qint64 line);
+    void startExport(LineExport::Format format, const QString &path);
+    void placeExportBar();
 
     bool m_localEchoEnabled = false;
+    bool _readOnly = false;
+
+    LineStore _store;
+    LineHighlighter _highlighter;
+    LineIndex *_filter = nullptr;
+
+    GlyphAtlas _atlas;
+    QColor _background;
+    QColor _selectionBackground;
+    QVector<QColor> _colors;             //0: default text, n + 1: highlight format n
+    QVector<QPainter::PixmapFragment> _fragments;
+    QVector<int> _fragmentColors;
+
+    qint64 _selectionAnchor = -1;
+    qint64 _selectionEnd = -1;
+
+    FrameStats _frameStats;
+
+    LineExport _export;
+    QWidget *_exportBar = nullptr;
+    QProgressBar *_exportProgress = nullptr;
+    QToolButton *_exportCancel = nullptr;
+    bool _exportToClipboard = false;
 
     QByteArray _buffer;
     int _bufferIndex;
@@ -0,0 +1,45 @@
+#include "crc16.h"
+
+namespace {
+
+struct Tables
+{
+    quint16 t[8][256];
+
+    Tables() {
+        for (int i = 0; i < 256; i++) {
+            quint16 crc = static_cast<quint16>(i);
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? static_cast<quint16>((crc >> 1) ^ 0xA001) : static_cast<quint16>(crc >> 1);
+            }
+            t[0][i] = crc;
+        }
+        //t[k][i]: CRC of byte i followed by k zero bytes.
+        for (int k = 1; k < 8; k++) {
+            for (int i = 0; i < 256; i++) {
+                t[k][i] = static_cast<quint16>((t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF]);
+            }
+        }
+    }
+};
+
+const Tables tables;
+
+} // namespace
+
+quint16
+Crc16::modbus(const char *data, qint64 size, quint16 crc) {
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    const quint16 (*t)[256] = tables.t;
+
+    while (size >= 8) {
+        crc = static_cast<quint16>(t[7][(p[0] ^ crc) & 0xFF] ^ t[6][(p[1] ^ (crc >> 8)) & 0xFF]
+                ^ t[5][p[2]] ^ t[4][p[3]] ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]]);
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = static_cast<quint16>((crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF]);
+    }
+    return crc;
+}
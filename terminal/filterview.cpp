@@ -0,0 +1,96 @@
+#include "filterview.h"
+#include "console.h"
+#include "linefilter.h"
+
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTimer>
+#include <QVBoxLayout>
+
+FilterView::FilterView(Console *source, const QString &pattern, QWidget *parent) :
+    QWidget(parent),
+    _filter(new LineFilter(source->lineStore(), this)),
+    _console(new Console),
+    _pattern(new QLineEdit(pattern)),
+    _regex(new QCheckBox(tr("Regex"))),
+    _caseSensitive(new QCheckBox(tr("Match case"))),
+    _status(new QLabel),
+    _debounce(new QTimer(this))
+{
+    _pattern->setPlaceholderText(tr("Show lines containing"));
+    _pattern->setClearButtonEnabled(true);
+    _console->setFilter(_filter);
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_pattern, 1);
+    bar->addWidget(_regex);
+    bar->addWidget(_caseSensitive);
+    bar->addWidget(_status);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_console);
+
+    _debounce->setSingleShot(true);
+    _debounce->setInterval(150);
+    connect(_debounce, &QTimer::timeout, this, &FilterView::_slot_apply);
+    connect(_pattern, &QLineEdit::textChanged, _debounce, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(_regex, &QCheckBox::toggled, this, &FilterView::_slot_apply);
+    connect(_caseSensitive, &QCheckBox::toggled, this, &FilterView::_slot_apply);
+    connect(_filter, &LineFilter::rowsChanged, this, &FilterView::_slot_rows);
+    //Direct: the rebuild worker has to let go of the store before it is cleared.
+    connect(source, &Console::aboutToClear, this, &FilterView::_slot_cleared, Qt::DirectConnection);
+
+    _slot_apply();
+}
+
+void
+FilterView::setHighlightRules(const QVector<HighlightRule> &rules) {
+    //Only the colors are used; the spans come with the source's lines.
+    _console->setHighlightRules(rules);
+}
+
+void
+FilterView::refresh() {
+    _filter->update();
+}
+
+QString
+FilterView::title() const {
+    return _pattern->text().isEmpty() ? tr("Filter") : tr("Filter: %1").arg(_pattern->text());
+}
+
+qint64
+FilterView::indexBytes() const {
+    return _filter->ownedBytes();
+}
+
+void
+FilterView::_slot_apply() {
+    _debounce->stop();
+
+    SearchQuery query;
+    query.pattern = _pattern->text();
+    query.regex = _regex->isChecked();
+    query.caseSensitive = _caseSensitive->isChecked();
+    if (!_filter->setQuery(query)) {
+        _status->setText(_filter->errorString());
+        return;
+    }
+    emit titleChanged(title());
+    _slot_rows();
+}
+
+void
+FilterView::_slot_rows() {
+    _status->setText(_filter->isBuilding() ? tr("%1 lines, filtering...").arg(_filter->rowCount())
+                                           : tr("%1 lines").arg(_filter->rowCount()));
+}
+
+void
+FilterView::_slot_cleared() {
+    _filter->reset();
+}
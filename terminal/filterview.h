@@ -0,0 +1,55 @@
+#ifndef FILTERVIEW_H
+#define FILTERVIEW_H
+
+#include "highlighter.h"
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QTimer;
+
+QT_END_NAMESPACE
+
+class Console;
+class LineFilter;
+
+//Second pane over a console's scrollback that shows only the lines matching a
+//query. Rows are line numbers into the source console's store, so each view
+//costs its index and the matching, not a copy of the text.
+class FilterView : public QWidget
+{
+    Q_OBJECT
+
+signals:
+    void titleChanged(const QString &title);
+
+public:
+    FilterView(Console *source, const QString &pattern, QWidget *parent = nullptr);
+
+    void setHighlightRules(const QVector<HighlightRule> &rules);
+    //After new data was shown in the source console.
+    void refresh();
+    QString title() const;
+    //Heap held by the view's index of matching lines.
+    qint64 indexBytes() const;
+
+private slots:
+    void _slot_apply();
+    void _slot_rows();
+    void _slot_cleared();
+
+private:
+    LineFilter *_filter = nullptr;
+    Console *_console = nullptr;
+    QLineEdit *_pattern = nullptr;
+    QCheckBox *_regex = nullptr;
+    QCheckBox *_caseSensitive = nullptr;
+    QLabel *_status = nullptr;
+    QTimer *_debounce = nullptr;
+};
+
+#endif // FILTERVIEW_H
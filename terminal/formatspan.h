@@ -0,0 +1,12 @@
+#ifndef FORMATSPAN_H
+#define FORMATSPAN_H
+
+//Colored range within one line. format indexes LineHighlighter::color().
+struct FormatSpan
+{
+    int start;
+    int length;
+    int format;
+};
+
+#endif // FORMATSPAN_H
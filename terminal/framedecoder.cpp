@@ -0,0 +1,315 @@
+#include "framedecoder.h"
+#include "bytescan.h"
+#include "crc16.h"
+
+#include <cstring>
+
+namespace {
+
+//RFC 1055
+class SlipDecoder : public FrameDecoder
+{
+public:
+    SlipDecoder() : FrameDecoder(Slip) {}
+
+protected:
+    static const char END = static_cast<char>(0xC0);
+    static const char ESC = static_cast<char>(0xDB);
+    static const char ESC_END = static_cast<char>(0xDC);
+    static const char ESC_ESC = static_cast<char>(0xDD);
+
+    void _scan(const char *p, const char *end) override {
+        const char *start = p;
+        if (_skipFirst) {
+            //The escaped byte of an ESC that ended the previous chunk.
+            _skipFirst = false;
+            p++;
+        }
+
+        for (;;) {
+            const char *q = ByteScan::findEither(p, end, END, ESC);
+            if (q == end) { break; }
+
+            if (*q == ESC) {
+                _escaped = true;
+                if (q + 1 == end) {
+                    _skipFirst = true;
+                    break;
+                }
+                p = q + 2;
+                continue;
+            }
+
+            _complete(start, q - start, _escaped);
+            _escaped = false;
+            p = start = q + 1;
+        }
+
+        if (start < end) {
+            _carry(start, end - start);
+        }
+    }
+
+    qint64 _decode(char *raw, qint64 size) const override {
+        const char *in = raw;
+        const char *end = raw + size;
+        char *out = raw;
+        while (in < end) {
+            char c = *in++;
+            if (c == ESC) {
+                if (in == end) { return -1; }
+                c = *in++;
+                if (c == ESC_END) { c = END; }
+                else if (c == ESC_ESC) { c = ESC; }
+                else { return -1; }
+            }
+            *out++ = c;
+        }
+        return out - raw;
+    }
+
+    void _resetState() override {
+        _escaped = false;
+        _skipFirst = false;
+    }
+
+private:
+    bool _escaped = false;
+    bool _skipFirst = false;
+};
+
+//Consistent Overhead Byte Stuffing with a zero delimiter.
+class CobsDecoder : public FrameDecoder
+{
+public:
+    CobsDecoder() : FrameDecoder(Cobs) {}
+
+protected:
+    void _scan(const char *p, const char *end) override {
+        for (;;) {
+            const char *q = ByteScan::find(p, end, 0);
+            if (q == end) { break; }
+
+            const qint64 size = q - p;
+            //A single code block means the frame has no zeros and the
+            //payload is everything after the code byte.
+            if (!_isCarrying() && size > 0 && static_cast<uchar>(*p) == size) {
+                _complete(p + 1, size - 1, false);
+            }
+            else {
+                _complete(p, size, true);
+            }
+            p = q + 1;
+        }
+
+        if (p < end) {
+            _carry(p, end - p);
+        }
+    }
+
+    qint64 _decode(char *raw, qint64 size) const override {
+        const char *in = raw;
+        const char *end = raw + size;
+        char *out = raw;
+        while (in < end) {
+            const int code = static_cast<uchar>(*in++);
+            if (code == 0 || code - 1 > end - in) { return -1; }
+            //Output trails input by at least one byte, so this stays in place.
+            std::memmove(out, in, static_cast<size_t>(code - 1));
+            out += code - 1;
+            in += code - 1;
+            if (code < 0xFF && in < end) { *out++ = 0; }
+        }
+        return out - raw;
+    }
+};
+
+//Two-byte little-endian length followed by that many payload bytes.
+class LengthPrefixedDecoder : public FrameDecoder
+{
+public:
+    LengthPrefixedDecoder() : FrameDecoder(LengthPrefixed) {}
+
+protected:
+    void _scan(const char *p, const char *end) override {
+        while (p < end) {
+            if (_remaining == 0) {
+                qint64 length;
+                if (_headerBytes == 0 && end - p >= 2) {
+                    length = static_cast<uchar>(p[0]) | (static_cast<uchar>(p[1]) << 8);
+                    p += 2;
+                    if (length == 0 || length > _maxFrame) {
+                        //Lost sync: retry one byte further on.
+                        _stats.resyncs++;
+                        p--;
+                        continue;
+                    }
+                }
+                else {
+                    _header[_headerBytes++] = static_cast<uchar>(*p++);
+                    if (_headerBytes < 2) { continue; }
+                    length = _header[0] | (_header[1] << 8);
+                    _headerBytes = 0;
+                    if (length == 0 || length > _maxFrame) {
+                        _stats.resyncs++;
+                        _header[0] = _header[1];
+                        _headerBytes = 1;
+                        continue;
+                    }
+                }
+                _remaining = length;
+            }
+
+            if (end - p >= _remaining) {
+                _complete(p, _remaining, false);
+                p += _remaining;
+                _remaining = 0;
+            }
+            else {
+                _carry(p, end - p);
+                _remaining -= end - p;
+                p = end;
+            }
+        }
+    }
+
+    void _resetState() override {
+        _remaining = 0;
+        _headerBytes = 0;
+    }
+
+private:
+    qint64 _remaining = 0;
+    int _headerBytes = 0;
+    uchar _header[2] = {0, 0};
+};
+
+} // namespace
+
+FrameDecoder *
+FrameDecoder::create(Type type) {
+    switch (type) {
+    case Slip: return new SlipDecoder;
+    case Cobs: return new CobsDecoder;
+    case LengthPrefixed: return new LengthPrefixedDecoder;
+    default: return nullptr;
+    }
+}
+
+QString
+FrameDecoder::typeName(Type type) {
+    switch (type) {
+    case Slip: return QStringLiteral("SLIP");
+    case Cobs: return QStringLiteral("COBS");
+    case LengthPrefixed: return QStringLiteral("Length-prefixed");
+    default: return QStringLiteral("None");
+    }
+}
+
+void
+FrameDecoder::feed(const ByteView &data, quint64 timestampNs, QVector<DecodedFrame> &frames) {
+    if (data.isEmpty()) { return; }
+
+    //Decoding never grows a frame, so this is all the arena a chunk can use
+    //and payload views handed out below can not be invalidated by a resize.
+    const qint64 needed = _partial.size() + data.size;
+    if (_arena.size() < needed) {
+        _arena.resize(static_cast<int>(needed));
+    }
+    _arenaUsed = 0;
+    _out = &frames;
+    _timestampNs = timestampNs;
+
+    _scan(data.begin(), data.end());
+
+    _out = nullptr;
+}
+
+void
+FrameDecoder::reset() {
+    _carrying = false;
+    _overflow = false;
+    _partial.resize(0);
+    _resetState();
+}
+
+void
+FrameDecoder::_complete(const char *raw, qint64 size, bool needsDecode) {
+    if (!_carrying) {
+        if (size > _maxFrame) {
+            _stats.resyncs++;
+            return;
+        }
+        if (!needsDecode) {
+            _publish(raw, size, false);
+            return;
+        }
+        char *dst = _arena.data() + _arenaUsed;
+        std::memcpy(dst, raw, static_cast<size_t>(size));
+        _finish(dst, size, true);
+        return;
+    }
+
+    _carrying = false;
+    if (_overflow || _partial.size() + size > _maxFrame) {
+        if (!_overflow) { _stats.resyncs++; }
+        _overflow = false;
+        _partial.resize(0);
+        return;
+    }
+
+    char *dst = _arena.data() + _arenaUsed;
+    std::memcpy(dst, _partial.constData(), static_cast<size_t>(_partial.size()));
+    std::memcpy(dst + _partial.size(), raw, static_cast<size_t>(size));
+    size += _partial.size();
+    _partial.resize(0);
+    _finish(dst, size, needsDecode);
+}
+
+void
+FrameDecoder::_carry(const char *raw, qint64 size) {
+    _carrying = true;
+    if (_overflow) { return; }
+
+    if (_partial.size() + size > _maxFrame) {
+        //Drop everything up to the end of this frame.
+        _stats.resyncs++;
+        _overflow = true;
+        _partial.resize(0);
+        return;
+    }
+    _partial.append(raw, static_cast<int>(size));
+}
+
+void
+FrameDecoder::_finish(char *raw, qint64 size, bool needsDecode) {
+    const qint64 decoded = needsDecode ? _decode(raw, size) : size;
+    if (decoded < 0) {
+        _stats.resyncs++;
+        return;
+    }
+    _arenaUsed += decoded;
+    _publish(raw, decoded, true);
+}
+
+void
+FrameDecoder::_publish(const char *payload, qint64 size, bool copied) {
+    //Back to back delimiters are idle fill, not frames.
+    if (size <= 0) { return; }
+
+    DecodedFrame frame;
+    frame.timestampNs = _timestampNs;
+    frame.copied = copied;
+    if (_crc) {
+        //Running the CRC over the payload and its CRC leaves zero.
+        frame.crcOk = size > 2 && Crc16::modbus(payload, size) == 0;
+        size = size >= 2 ? size - 2 : 0;
+        if (!frame.crcOk) { _stats.crcErrors++; }
+    }
+    frame.payload = ByteView(payload, size);
+
+    _stats.frames++;
+    _stats.bytes += static_cast<quint64>(size);
+    if (copied) { _stats.copied++; }
+    _out->append(frame);
+}
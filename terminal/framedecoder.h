@@ -0,0 +1,101 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include "bufferpool.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+struct DecodedFrame
+{
+    ByteView payload;          //without the CRC
+    quint64 timestampNs = 0;   //of the chunk that completed the frame
+    bool crcOk = true;         //always true when no CRC is configured
+    bool copied = false;       //payload had to be assembled or unescaped
+};
+
+//Pipeline stage between the port and the views that turns the byte stream
+//into frames. Whenever a frame lies in a single chunk and its encoding does
+//not change the bytes, the payload is a view straight into the receive
+//buffer. Frames that straddle chunks or need unescaping are assembled in a
+//decoder-owned arena sized up front, so no payload moves while a chunk is
+//being decoded. Payloads are only valid until the next feed().
+class FrameDecoder
+{
+public:
+    enum Type {
+        None,
+        Slip,
+        Cobs,
+        LengthPrefixed
+    };
+
+    struct Stats {
+        quint64 frames = 0;
+        quint64 bytes = 0;
+        quint64 copied = 0;
+        quint64 crcErrors = 0;
+        quint64 resyncs = 0;
+    };
+
+    static const qint64 DEFAULT_MAX_FRAME = 4096;
+
+    //nullptr for None.
+    static FrameDecoder *create(Type type);
+    static QString typeName(Type type);
+
+    virtual ~FrameDecoder() {}
+
+    Type type() const { return _type; }
+
+    //Last two payload bytes are a little-endian CRC-16/MODBUS.
+    void setCrcEnabled(bool enabled) { _crc = enabled; }
+    void setMaxFrame(qint64 maxFrame) {
+        _maxFrame = maxFrame;
+        _partial.reserve(static_cast<int>(maxFrame));
+    }
+
+    void feed(const ByteView &data, quint64 timestampNs, QVector<DecodedFrame> &frames);
+    void reset();
+
+    const Stats &stats() const { return _stats; }
+
+protected:
+    explicit FrameDecoder(Type type) : _type(type) {
+        //Reserved, so resize(0) after every frame keeps the buffer.
+        _partial.reserve(static_cast<int>(_maxFrame));
+    }
+
+    virtual void _scan(const char *p, const char *end) = 0;
+
+    //Decodes a complete raw frame in place, returns the payload size or -1.
+    virtual qint64 _decode(char *raw, qint64 size) const { Q_UNUSED(raw); return size; }
+    virtual void _resetState() {}
+
+    //Called by _scan with the raw bytes of a frame that ends in this chunk.
+    //Without needsDecode and carried bytes the frame is published as a view.
+    void _complete(const char *raw, qint64 size, bool needsDecode);
+    //Called by _scan with the raw bytes of a frame that continues in the next chunk.
+    void _carry(const char *raw, qint64 size);
+    bool _isCarrying() const { return _carrying; }
+
+    Stats _stats;
+    qint64 _maxFrame = DEFAULT_MAX_FRAME;
+
+private:
+    void _finish(char *raw, qint64 size, bool needsDecode);
+    void _publish(const char *payload, qint64 size, bool copied);
+
+    Type _type;
+    bool _crc = false;
+    bool _carrying = false;
+    bool _overflow = false;
+    QByteArray _partial;
+    QByteArray _arena;
+    qint64 _arenaUsed = 0;
+    QVector<DecodedFrame> *_out = nullptr;
+    quint64 _timestampNs = 0;
+};
+
+#endif // FRAMEDECODER_H
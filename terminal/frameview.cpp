@@ -0,0 +1,228 @@
+#include "frameview.h"
+#include "monotonicclock.h"
+
+#include <QCheckBox>
+#include <QColor>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableView>
+#include <QTimer>
+#include <QVBoxLayout>
+
+FrameModel::FrameModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+}
+
+void
+FrameModel::append(QVector<Row> &rows) {
+    if (rows.isEmpty()) { return; }
+
+    if (_rows.size() + rows.size() > MAX_ROWS) {
+        _removeFront(qMin(_rows.size(), _rows.size() + rows.size() - MAX_ROWS + MAX_ROWS / 10));
+    }
+
+    if (_rows.isEmpty() && _originNs == 0) {
+        _originNs = rows.first().timestampNs;
+    }
+
+    beginInsertRows(QModelIndex(), _rows.size(), _rows.size() + rows.size() - 1);
+    for (const Row &row : rows) {
+        _bytes += static_cast<qint64>(sizeof(Row)) + row.head.size();
+    }
+    _rows += rows;
+    endInsertRows();
+
+    rows.resize(0);
+}
+
+void
+FrameModel::clear() {
+    beginResetModel();
+    _rows.clear();
+    _originNs = 0;
+    _bytes = 0;
+    endResetModel();
+}
+
+qint64
+FrameModel::trim(qint64 bytes) {
+    const qint64 before = _bytes;
+    int count = 0;
+    qint64 freed = 0;
+    while (count < _rows.size() && freed < bytes) {
+        freed += static_cast<qint64>(sizeof(Row)) + _rows.at(count).head.size();
+        count++;
+    }
+    _removeFront(count);
+    _rows.squeeze();
+    return before - _bytes;
+}
+
+void
+FrameModel::_removeFront(int count) {
+    if (count <= 0) { return; }
+
+    beginRemoveRows(QModelIndex(), 0, count - 1);
+    for (int x = 0; x < count; x++) {
+        _bytes -= static_cast<qint64>(sizeof(Row)) + _rows.at(x).head.size();
+    }
+    _rows.remove(0, count);
+    endRemoveRows();
+}
+
+int
+FrameModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : _rows.size();
+}
+
+int
+FrameModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant
+FrameModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= _rows.size()) { return QVariant(); }
+
+    const Row &row = _rows.at(index.row());
+
+    if (role == Qt::ForegroundRole && !row.crcOk) {
+        return QColor(Qt::red);
+    }
+    if (role != Qt::DisplayRole) { return QVariant(); }
+
+    switch (index.column()) {
+    case TimeColumn:
+        return QString::number((row.timestampNs - _originNs) / 1e9, 'f', 6);
+    case LengthColumn:
+        return row.size;
+    case CrcColumn:
+        return row.crcOk ? tr("OK") : tr("BAD");
+    case DataColumn: {
+        QString hex = QString::fromLatin1(row.head.toHex(' '));
+        if (row.size > row.head.size()) { hex += QStringLiteral(" ..."); }
+        return hex;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant
+FrameModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) { return QVariant(); }
+
+    switch (section) {
+    case TimeColumn: return tr("Time (s)");
+    case LengthColumn: return tr("Length");
+    case CrcColumn: return tr("CRC");
+    case DataColumn: return tr("Data");
+    default: return QVariant();
+    }
+}
+
+FrameView::FrameView(QWidget *parent) :
+    QWidget(parent),
+    _model(new FrameModel(this)),
+    _table(new QTableView),
+    _stats(new QLabel),
+    _follow(new QCheckBox(tr("Follow"))),
+    _flushTimer(new QTimer(this))
+{
+    _table->setModel(_model);
+    _table->verticalHeader()->hide();
+    _table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    _table->verticalHeader()->setDefaultSectionSize(_table->fontMetrics().height() + 4);
+    _table->horizontalHeader()->setSectionResizeMode(FrameModel::DataColumn, QHeaderView::Stretch);
+    _table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _follow->setChecked(true);
+
+    QPushButton *clear = new QPushButton(tr("Clear"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_stats, 1);
+    bar->addWidget(_follow);
+    bar->addWidget(clear);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_table);
+
+    //Rows are handed to the model in batches instead of once per frame.
+    _flushTimer->setInterval(100);
+    connect(_flushTimer, &QTimer::timeout, this, &FrameView::_slot_flush);
+    connect(clear, &QPushButton::clicked, this, &FrameView::_slot_clear);
+
+    _slot_flush();
+}
+
+void
+FrameView::setDecoder(const FrameDecoder *decoder) {
+    _decoder = decoder;
+    _lastFrames = 0;
+    _lastFlushNs = monotonicNowNs();
+    _slot_flush();
+}
+
+void
+FrameView::setActive(bool active) {
+    _active = active;
+    if (active) {
+        _flushTimer->start();
+    }
+    else {
+        _flushTimer->stop();
+        _pending.clear();
+    }
+}
+
+void
+FrameView::append(const QVector<DecodedFrame> &frames) {
+    //The payloads are views into the receive buffers, copy what is shown.
+    for (const DecodedFrame &frame : frames) {
+        if (_pending.size() >= FrameModel::MAX_ROWS) { return; }
+
+        FrameModel::Row row;
+        row.timestampNs = frame.timestampNs;
+        row.size = frame.payload.size;
+        row.crcOk = frame.crcOk;
+        row.head = QByteArray(frame.payload.data, static_cast<int>(qMin<qint64>(frame.payload.size, FrameModel::HEAD_BYTES)));
+        _pending.append(row);
+    }
+}
+
+void
+FrameView::_slot_flush() {
+    if (!_pending.isEmpty()) {
+        _model->append(_pending);
+        if (_follow->isChecked()) {
+            _table->scrollToBottom();
+        }
+    }
+
+    if (!_decoder) {
+        _stats->setText(tr("No framing decoder, select one in the settings"));
+        return;
+    }
+
+    const FrameDecoder::Stats &stats = _decoder->stats();
+    const quint64 nowNs = monotonicNowNs();
+    const double seconds = (nowNs - _lastFlushNs) / 1e9;
+    const double rate = seconds > 0 ? (stats.frames - _lastFrames) / seconds : 0;
+    _lastFrames = stats.frames;
+    _lastFlushNs = nowNs;
+
+    _stats->setText(tr("%1: %2 frames/s  frames: %3  copied: %4  CRC errors: %5  resyncs: %6")
+                    .arg(FrameDecoder::typeName(_decoder->type()))
+                    .arg(rate, 0, 'f', 0).arg(stats.frames).arg(stats.copied)
+                    .arg(stats.crcErrors).arg(stats.resyncs));
+}
+
+void
+FrameView::_slot_clear() {
+    _model->clear();
+}
@@ -0,0 +1,100 @@
+#ifndef FRAMEVIEW_H
+#define FRAMEVIEW_H
+
+#include "framedecoder.h"
+
+#include <QAbstractTableModel>
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QCheckBox;
+class QLabel;
+class QTableView;
+class QTimer;
+
+QT_END_NAMESPACE
+
+//Decoded frames. Only the head of each payload is kept for display, so memory
+//stays bounded regardless of frame size.
+class FrameModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        TimeColumn,
+        LengthColumn,
+        CrcColumn,
+        DataColumn,
+        ColumnCount
+    };
+
+    struct Row {
+        quint64 timestampNs = 0;
+        qint64 size = 0;
+        bool crcOk = true;
+        QByteArray head;
+    };
+
+    static const int MAX_ROWS = 100000;
+    static const int HEAD_BYTES = 64;
+
+    explicit FrameModel(QObject *parent = nullptr);
+
+    void append(QVector<Row> &rows);
+    void clear();
+    //Drops the oldest rows until about bytes are freed; returns what was.
+    qint64 trim(qint64 bytes);
+    qint64 bytes() const { return _bytes; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    void _removeFront(int count);
+
+    QVector<Row> _rows;
+    quint64 _originNs = 0;
+    qint64 _bytes = 0;
+};
+
+//Dockable list of the frames produced by the framing decoder, with the
+//decoder's statistics.
+class FrameView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit FrameView(QWidget *parent = nullptr);
+
+    void setDecoder(const FrameDecoder *decoder);
+    void setActive(bool active);
+    bool isActive() const { return _active; }
+
+    void append(const QVector<DecodedFrame> &frames);
+
+    //Memory held by the list, and giving some of it back, oldest frames first.
+    qint64 cacheBytes() const { return _model->bytes(); }
+    qint64 trim(qint64 bytes) { return _model->trim(bytes); }
+
+private slots:
+    void _slot_flush();
+    void _slot_clear();
+
+private:
+    const FrameDecoder *_decoder = nullptr;
+    FrameModel *_model = nullptr;
+    QTableView *_table = nullptr;
+    QLabel *_stats = nullptr;
+    QCheckBox *_follow = nullptr;
+    QTimer *_flushTimer = nullptr;
+    QVector<FrameModel::Row> _pending;
+    quint64 _lastFrames = 0;
+    quint64 _lastFlushNs = 0;
+    bool _active = false;
+};
+
+#endif // FRAMEVIEW_H
@@ -0,0 +1,64 @@
+#include "glyphatlas.h"
+
+#include <QFontMetrics>
+#include <QImage>
+#include <QPainter>
+#include <QtMath>
+
+void
+GlyphAtlas::setFont(const QFont &font, qreal devicePixelRatio) {
+    _font = font;
+    _devicePixelRatio = devicePixelRatio;
+    _strips.clear();
+
+    const QFontMetrics metrics(_font);
+    _cellSize = QSize(qMax(1, metrics.horizontalAdvance(QLatin1Char('M'))), qMax(1, metrics.height()));
+    _ascent = metrics.ascent();
+
+    //Cell 0 is blank; printable ASCII and Latin-1 follow.
+    _glyphCount = 1;
+    for(int c = 0; c < 256; c++) {
+        const bool printable = (c >= 0x20 && c < 0x7F) || c >= 0xA0;
+        _glyphIndex[c] = (printable && c != ' ') ? _glyphCount++ : 0;
+    }
+}
+
+const QPixmap &
+GlyphAtlas::pixmap(const QColor &color) {
+    QHash<QRgb, QPixmap>::const_iterator it = _strips.constFind(color.rgba());
+    if(it == _strips.constEnd()) {
+        _rasterize(color);
+        it = _strips.constFind(color.rgba());
+    }
+    return it.value();
+}
+
+qint64
+GlyphAtlas::bytes() const {
+    qint64 total = 0;
+    for(const QPixmap &strip : _strips) {
+        total += static_cast<qint64>(strip.width()) * strip.height() * strip.depth() / 8;
+    }
+    return total;
+}
+
+void
+GlyphAtlas::_rasterize(const QColor &color) {
+    QImage strip(qCeil(_glyphCount * _cellSize.width() * _devicePixelRatio),
+                 qCeil(_cellSize.height() * _devicePixelRatio),
+                 QImage::Format_ARGB32_Premultiplied);
+    strip.setDevicePixelRatio(_devicePixelRatio);
+    strip.fill(Qt::transparent);
+
+    QPainter painter(&strip);
+    painter.setFont(_font);
+    painter.setPen(color);
+    for(int c = 0; c < 256; c++) {
+        const int index = _glyphIndex[c];
+        if(index == 0) { continue; }
+        painter.drawText(QPointF(index * _cellSize.width(), _ascent), QString(QChar(c)));
+    }
+    painter.end();
+
+    _strips.insert(color.rgba(), QPixmap::fromImage(strip));
+}
@@ -0,0 +1,51 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QPixmap>
+#include <QRect>
+#include <QSize>
+
+//Pre-rasterized glyphs of a monospace font, one strip per color. Every Latin-1
+//byte maps to a cell of the strip (control characters map to a blank cell),
+//so drawing text is a sequence of pixmap blits with no shaping or layout.
+class GlyphAtlas
+{
+public:
+    void setFont(const QFont &font, qreal devicePixelRatio);
+
+    QSize cellSize() const { return _cellSize; }
+    int ascent() const { return _ascent; }
+
+    qreal devicePixelRatio() const { return _devicePixelRatio; }
+    bool isBlank(char c) const { return _glyphIndex[static_cast<uchar>(c)] == 0; }
+
+    //Source rectangle of the glyph for byte c, in pixmap (device) pixels.
+    QRectF source(char c) const {
+        return QRectF(_glyphIndex[static_cast<uchar>(c)] * _cellSize.width() * _devicePixelRatio, 0,
+                      _cellSize.width() * _devicePixelRatio, _cellSize.height() * _devicePixelRatio);
+    }
+
+    //Strip of all glyphs in color, rasterized on first use.
+    const QPixmap &pixmap(const QColor &color);
+
+    //Memory held by the strips, and dropping them; they are rasterized
+    //again as they are drawn.
+    qint64 bytes() const;
+    void trim() { _strips.clear(); }
+
+private:
+    void _rasterize(const QColor &color);
+
+    QFont _font;
+    qreal _devicePixelRatio = 1.0;
+    QSize _cellSize = QSize(1, 1);
+    int _ascent = 0;
+    int _glyphCount = 0;
+    int _glyphIndex[256] = {};
+    QHash<QRgb, QPixmap> _strips;
+};
+
+#endif // GLYPHATLAS_H
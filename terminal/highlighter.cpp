@@ -0,0 +1,102 @@
+#include "highlighter.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+QVector<HighlightRule>
+LineHighlighter::defaultRules() {
+    QVector<HighlightRule> rules;
+
+    HighlightRule error;
+    error.pattern = QStringLiteral("\\bERROR\\b");
+    error.color = QColor(0xff, 0x55, 0x55);
+    error.wholeLine = true;
+    rules.append(error);
+
+    HighlightRule warn;
+    warn.pattern = QStringLiteral("\\bWARN(?:ING)?\\b");
+    warn.color = QColor(0xff, 0xd7, 0x00);
+    warn.wholeLine = true;
+    rules.append(warn);
+
+    HighlightRule hex;
+    hex.pattern = QStringLiteral("\\b0[xX][0-9A-Fa-f]+\\b");
+    hex.color = QColor(0x00, 0xd7, 0xff);
+    rules.append(hex);
+
+    HighlightRule tag;
+    tag.pattern = QStringLiteral("\\[[A-Za-z][A-Za-z0-9_.-]*\\]");
+    tag.color = QColor(0xd7, 0x87, 0xff);
+    rules.append(tag);
+
+    return rules;
+}
+
+void
+LineHighlighter::setRules(const QVector<HighlightRule> &rules) {
+    _rules.clear();
+    _patterns.clear();
+    _linesHighlighted = 0;
+    _nsecsSpent = 0;
+
+    for(const HighlightRule &rule : rules) {
+        QRegularExpression re(rule.pattern);
+        if(!re.isValid()) {
+            qWarning() << "Ignoring invalid highlight rule" << rule.pattern << ":" << re.errorString();
+            continue;
+        }
+        //Compiled and JITed here rather than on the first line.
+        re.optimize();
+
+        _rules.append(rule);
+        _patterns.append(re);
+    }
+}
+
+void
+LineHighlighter::highlight(const ByteView &line, QVector<FormatSpan> &spans) {
+    if(_rules.isEmpty() || line.isEmpty()) { return; }
+
+    _lineText.resize(static_cast<int>(line.size));
+    QChar *out = _lineText.data();
+    for(const char c : line) {
+        *out++ = QLatin1Char(c);
+    }
+    highlight(_lineText, spans);
+}
+
+void
+LineHighlighter::highlight(const QString &line, QVector<FormatSpan> &spans) {
+    if(_rules.isEmpty() || line.isEmpty()) { return; }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int base = spans.size();
+    int wholeLineRule = -1;
+
+    //Last rule first: later spans paint over earlier ones, so the earlier
+    //rule wins where two overlap.
+    for(int x = _rules.size() - 1; x >= 0; x--) {
+        if(_rules.at(x).wholeLine) {
+            //First whole-line rule wins; one match anywhere is enough.
+            if(_patterns.at(x).match(line).hasMatch()) { wholeLineRule = x; }
+            continue;
+        }
+
+        QRegularExpressionMatchIterator it = _patterns.at(x).globalMatch(line);
+        while(it.hasNext()) {
+            const QRegularExpressionMatch match = it.next();
+            if(match.capturedLength() == 0) { continue; }
+            spans.append(FormatSpan{match.capturedStart(), match.capturedLength(), x});
+        }
+    }
+
+    //Underneath the tokens.
+    if(wholeLineRule >= 0) {
+        spans.insert(base, FormatSpan{0, line.size(), wholeLineRule});
+    }
+
+    _linesHighlighted++;
+    _nsecsSpent += timer.nsecsElapsed();
+}
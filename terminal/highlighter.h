@@ -0,0 +1,55 @@
+#ifndef HIGHLIGHTER_H
+#define HIGHLIGHTER_H
+
+#include "bufferpool.h"
+#include "formatspan.h"
+
+#include <QColor>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+struct HighlightRule
+{
+    QString pattern;
+    QColor color;
+    bool wholeLine = false;   //color the entire line when the pattern matches anywhere
+};
+
+//Rule-based colorizer for received lines. Every rule is compiled once, with
+//the JIT, and matched on its own. One alternation of all rules was tried and
+//is slower under PCRE2: it defeats the start-of-match optimizations each rule
+//gets alone, and it breaks backreferences and repeated group names. It is
+//meant to run exactly once per completed line on the ingest side; the
+//resulting spans are kept with the line and never recomputed.
+class LineHighlighter
+{
+public:
+    void setRules(const QVector<HighlightRule> &rules);
+    bool isEmpty() const { return _rules.isEmpty(); }
+    int ruleCount() const { return _rules.size(); }
+
+    //Appends the spans for line to spans. Whole-line spans come first so
+    //token spans can be painted on top of them; where token spans of two
+    //rules overlap, the earlier rule's come last.
+    void highlight(const QString &line, QVector<FormatSpan> &spans);
+    void highlight(const ByteView &line, QVector<FormatSpan> &spans);
+
+    QColor color(int format) const { return _rules.at(format).color; }
+
+    //Since the last setRules(); shown in the status bar.
+    quint64 linesHighlighted() const { return _linesHighlighted; }
+    quint64 nsecsSpent() const { return _nsecsSpent; }
+
+    static QVector<HighlightRule> defaultRules();
+
+private:
+    QVector<HighlightRule> _rules;
+    QVector<QRegularExpression> _patterns;
+    QString _lineText;          //reused for Latin-1 conversion of raw lines
+
+    quint64 _linesHighlighted = 0;
+    quint64 _nsecsSpent = 0;
+};
+
+#endif // HIGHLIGHTER_H
@@ -0,0 +1,155 @@
+#include "jitterprobe.h"
+#include "monotonicclock.h"
+
+#include <QMutexLocker>
+
+#ifdef Q_OS_LINUX
+#include <cstring>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+JitterProbe::JitterProbe() :
+    _running(false)
+{
+}
+
+JitterProbe::~JitterProbe() {
+    stop();
+    close();
+}
+
+bool
+JitterProbe::start(quint64 periodNs, bool realTime, int cpu) {
+    stop();
+
+    //The scheduling is applied and the timer armed on the new thread; wait for
+    //both so the first wake-ups are already measured under the final policy.
+    std::promise<bool> opened;
+    std::future<bool> result = opened.get_future();
+    _running.store(true);
+    _thread = std::thread(&JitterProbe::_run, this, std::move(opened), periodNs, realTime, cpu);
+    if (!result.get()) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void
+JitterProbe::stop() {
+    if (_thread.joinable()) {
+        _running.store(false);
+        _thread.join();
+    }
+}
+
+LatencyHistogram
+JitterProbe::histogram() const {
+    QMutexLocker lock(&_mutex);
+    return _histogram;
+}
+
+quint64
+JitterProbe::missed() const {
+    QMutexLocker lock(&_mutex);
+    return _missed;
+}
+
+void
+JitterProbe::reset() {
+    QMutexLocker lock(&_mutex);
+    _histogram.reset();
+    _missed = 0;
+}
+
+#ifdef Q_OS_LINUX
+
+bool
+JitterProbe::open(quint64 periodNs) {
+    close();
+
+    _fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (_fd < 0) { return false; }
+
+    //Absolute expiries, so every wake-up can be compared with the exact time
+    //it was due.
+    _periodNs = periodNs;
+    _firstNs = monotonicNowNs() + periodNs;
+    _expiries = 0;
+    itimerspec spec;
+    std::memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = static_cast<time_t>(_firstNs / 1000000000ull);
+    spec.it_value.tv_nsec = static_cast<long>(_firstNs % 1000000000ull);
+    spec.it_interval.tv_sec = static_cast<time_t>(periodNs / 1000000000ull);
+    spec.it_interval.tv_nsec = static_cast<long>(periodNs % 1000000000ull);
+    if (::timerfd_settime(_fd, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void
+JitterProbe::close() {
+    if (_fd >= 0) { ::close(_fd); }
+    _fd = -1;
+}
+
+void
+JitterProbe::expired() {
+    const quint64 nowNs = monotonicNowNs();
+    uint64_t count = 0;
+    if (::read(_fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count)) || count == 0) { return; }
+
+    //Measured from the latest expiry the read accounts for.
+    _expiries += count;
+    const quint64 dueNs = _firstNs + (_expiries - 1) * _periodNs;
+    QMutexLocker lock(&_mutex);
+    _histogram.add(nowNs > dueNs ? nowNs - dueNs : 0);
+    _missed += count - 1;
+}
+
+void
+JitterProbe::_run(std::promise<bool> opened, quint64 periodNs, bool realTime, int cpu) {
+    _scheduling = ThreadScheduling::apply(realTime, cpu);
+    const bool armed = open(periodNs);
+    opened.set_value(armed);
+    if (!armed) { return; }
+
+    pollfd fd;
+    fd.fd = _fd;
+    fd.events = POLLIN;
+    while (_running.load(std::memory_order_relaxed)) {
+        //The timeout only bounds how long stop() waits for a long period.
+        if (::poll(&fd, 1, 100) > 0) {
+            expired();
+        }
+    }
+    close();
+}
+
+#else
+
+bool
+JitterProbe::open(quint64 periodNs) {
+    Q_UNUSED(periodNs);
+    return false;
+}
+
+void
+JitterProbe::close() {
+}
+
+void
+JitterProbe::expired() {
+}
+
+void
+JitterProbe::_run(std::promise<bool> opened, quint64 periodNs, bool realTime, int cpu) {
+    _scheduling = ThreadScheduling::apply(realTime, cpu);
+    opened.set_value(open(periodNs));
+}
+
+#endif
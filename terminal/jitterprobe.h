@@ -0,0 +1,62 @@
+#ifndef JITTERPROBE_H
+#define JITTERPROBE_H
+
+#include "latencyhistogram.h"
+#include "threadscheduling.h"
+
+#include <QMutex>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+//Wake-up latency of a thread (Linux): a periodic timerfd on the monotonic
+//clock, and for every wake-up how long after the expiry the thread got to run.
+//Either part of another thread's epoll set through open(), handle() and
+//expired(), or on a thread of its own with start(), with the scheduling to
+//compare against. The histogram can be read from any thread.
+class JitterProbe
+{
+public:
+    static const quint64 DEFAULT_PERIOD_NS = 1000000;
+
+    JitterProbe();
+    ~JitterProbe();
+
+    //Arms the timer; the owning thread waits on handle() and calls expired().
+    bool open(quint64 periodNs);
+    void close();
+    bool isOpen() const { return _fd >= 0; }
+    int handle() const { return _fd; }
+    void expired();
+
+    //Runs the probe on its own thread with the given scheduling.
+    bool start(quint64 periodNs, bool realTime, int cpu);
+    void stop();
+    bool isRunning() const { return _thread.joinable(); }
+    //What start() got, once it returns.
+    ThreadScheduling::Result scheduling() const { return _scheduling; }
+
+    LatencyHistogram histogram() const;
+    //Expiries the thread slept through entirely, more than a period late.
+    quint64 missed() const;
+    void reset();
+
+private:
+    void _run(std::promise<bool> opened, quint64 periodNs, bool realTime, int cpu);
+
+    int _fd = -1;
+    quint64 _periodNs = DEFAULT_PERIOD_NS;
+    quint64 _firstNs = 0;
+    quint64 _expiries = 0;
+
+    std::thread _thread;
+    std::atomic<bool> _running;
+    ThreadScheduling::Result _scheduling;
+
+    mutable QMutex _mutex;
+    LatencyHistogram _histogram;
+    quint64 _missed = 0;
+};
+
+#endif // JITTERPROBE_H
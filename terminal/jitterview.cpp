@@ -0,0 +1,169 @@
+#include "jitterview.h"
+#include "serialiothread.h"
+
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+static QString
+microseconds(quint64 ns) {
+    return QString::number(ns / 1e3, 'f', 1);
+}
+
+JitterView::JitterView(QWidget *parent) :
+    QWidget(parent),
+    _table(new QTableWidget(RowCount, ColumnCount)),
+    _period(new QComboBox),
+    _start(new QPushButton(tr("Start"))),
+    _status(new QLabel),
+    _refreshTimer(new QTimer(this))
+{
+    _table->setHorizontalHeaderLabels(QStringList()
+                                      << tr("Thread") << tr("Scheduling") << tr("Wake-ups") << tr("Missed")
+                                      << tr("p50 (us)") << tr("p99 (us)") << tr("p99.9 (us)") << tr("Max (us)"));
+    _table->verticalHeader()->hide();
+    _table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    _table->horizontalHeader()->setStretchLastSection(true);
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    for (int row = 0; row < RowCount; row++) {
+        for (int column = 0; column < ColumnCount; column++) {
+            QTableWidgetItem *item = new QTableWidgetItem;
+            if (column > SchedulingColumn) {
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            _table->setItem(row, column, item);
+        }
+    }
+    _table->item(IoRow, ThreadColumn)->setText(tr("Port I/O thread"));
+    _table->item(DefaultRow, ThreadColumn)->setText(tr("Probe thread"));
+    _table->horizontalHeaderItem(MissedColumn)->setToolTip(tr("Timer periods slept through entirely"));
+
+    _period->addItem(tr("250 us"), 250000);
+    _period->addItem(tr("1 ms"), 1000000);
+    _period->addItem(tr("10 ms"), 10000000);
+    _period->setCurrentIndex(1);
+    _period->setToolTip(tr("How often the probes wake up"));
+
+    _start->setCheckable(true);
+    QPushButton *reset = new QPushButton(tr("Reset"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_status, 1);
+    bar->addWidget(_period);
+    bar->addWidget(_start);
+    bar->addWidget(reset);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_table);
+
+    //Only the display is on a timer; the probes run on their threads.
+    _refreshTimer->setInterval(500);
+    connect(_refreshTimer, &QTimer::timeout, this, &JitterView::_slot_refresh);
+    connect(_start, &QPushButton::toggled, this, &JitterView::_slot_startStop);
+    connect(reset, &QPushButton::clicked, this, &JitterView::_slot_reset);
+
+    _slot_refresh();
+}
+
+void
+JitterView::setActive(bool active) {
+    if (active) {
+        _slot_refresh();
+    }
+    else {
+        //The probes wake up to 4000 times a second; not left running unseen.
+        _start->setChecked(false);
+    }
+}
+
+void
+JitterView::setIoThread(SerialIoThread *io) {
+    if (_io) {
+        _io->setProbePeriod(0);
+    }
+    _io = io;
+    if (_io && _start->isChecked()) {
+        _io->setProbePeriod(_periodNs());
+    }
+    _slot_refresh();
+}
+
+void
+JitterView::_slot_startStop(bool on) {
+    _period->setEnabled(!on);
+    _start->setText(on ? tr("Stop") : tr("Start"));
+    if (on) {
+        //Default scheduling, no affinity: what any thread of the process gets.
+        _baseline.reset();
+        _baseline.start(_periodNs(), false, -1);
+        if (_io) {
+            _io->probe().reset();
+            _io->setProbePeriod(_periodNs());
+        }
+        _refreshTimer->start();
+    }
+    else {
+        _baseline.stop();
+        if (_io) {
+            _io->setProbePeriod(0);
+        }
+        _refreshTimer->stop();
+    }
+    _slot_refresh();
+}
+
+void
+JitterView::_slot_reset() {
+    _baseline.reset();
+    if (_io) {
+        _io->probe().reset();
+    }
+    _slot_refresh();
+}
+
+void
+JitterView::_slot_refresh() {
+    if (_io) {
+        const ThreadScheduling::Result scheduling = _io->scheduling();
+        _setRow(IoRow, scheduling.describe(), _io->probe().histogram(), _io->probe().missed());
+        _table->item(IoRow, SchedulingColumn)->setToolTip(scheduling.error);
+        _status->setText(scheduling.error.isEmpty() ? QString()
+                                                    : tr("Real-time mode fell back: %1").arg(scheduling.error));
+    }
+    else {
+        _setRow(IoRow, tr("No I/O thread (low latency mode is off or the port is closed)"),
+                LatencyHistogram(), 0);
+        _table->item(IoRow, SchedulingColumn)->setToolTip(QString());
+        _status->clear();
+    }
+    _setRow(DefaultRow, ThreadScheduling::Result().describe(), _baseline.histogram(), _baseline.missed());
+
+    if (_start->isChecked() && !_baseline.isRunning()) {
+        _status->setText(tr("The jitter probe is only available on Linux"));
+    }
+}
+
+quint64
+JitterView::_periodNs() const {
+    return _period->currentData().toULongLong();
+}
+
+void
+JitterView::_setRow(Row row, const QString &scheduling, const LatencyHistogram &histogram, quint64 missed) {
+    const bool empty = histogram.count() == 0;
+    _table->item(row, SchedulingColumn)->setText(scheduling);
+    _table->item(row, WakeupsColumn)->setText(QString::number(histogram.count()));
+    _table->item(row, MissedColumn)->setText(QString::number(missed));
+    _table->item(row, P50Column)->setText(empty ? QStringLiteral("-") : microseconds(histogram.percentileNs(50)));
+    _table->item(row, P99Column)->setText(empty ? QStringLiteral("-") : microseconds(histogram.percentileNs(99)));
+    _table->item(row, P999Column)->setText(empty ? QStringLiteral("-") : microseconds(histogram.percentileNs(99.9)));
+    _table->item(row, MaxColumn)->setText(empty ? QStringLiteral("-") : microseconds(histogram.maxNs()));
+}
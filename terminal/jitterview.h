@@ -0,0 +1,71 @@
+#ifndef JITTERVIEW_H
+#define JITTERVIEW_H
+
+#include "jitterprobe.h"
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QComboBox;
+class QLabel;
+class QPushButton;
+class QTableWidget;
+class QTimer;
+
+QT_END_NAMESPACE
+
+class SerialIoThread;
+
+//Dockable wake-up latency comparison: the low latency I/O thread, measured by
+//its own probe, next to a probe thread under default scheduling. Both run at
+//the same period at the same time, so they see the same load. The probes only
+//run while started and the view is shown.
+class JitterView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Row {
+        IoRow,
+        DefaultRow,
+        RowCount
+    };
+
+    enum Column {
+        ThreadColumn,
+        SchedulingColumn,
+        WakeupsColumn,
+        MissedColumn,
+        P50Column,
+        P99Column,
+        P999Column,
+        MaxColumn,
+        ColumnCount
+    };
+
+    explicit JitterView(QWidget *parent = nullptr);
+
+    void setActive(bool active);
+    //When a port opens or closes; null without a low latency I/O thread.
+    void setIoThread(SerialIoThread *io);
+
+private slots:
+    void _slot_startStop(bool on);
+    void _slot_reset();
+    void _slot_refresh();
+
+private:
+    quint64 _periodNs() const;
+    void _setRow(Row row, const QString &scheduling, const LatencyHistogram &histogram, quint64 missed);
+
+    SerialIoThread *_io = nullptr;
+    JitterProbe _baseline;
+    QTableWidget *_table = nullptr;
+    QComboBox *_period = nullptr;
+    QPushButton *_start = nullptr;
+    QLabel *_status = nullptr;
+    QTimer *_refreshTimer = nullptr;
+};
+
+#endif // JITTERVIEW_H
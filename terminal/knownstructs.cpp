@@ -0,0 +1,120 @@
+#include "knownstructs.h"
+#include "monotonicclock.h"
+#include "structparser.h"
+
+#include <QCoreApplication>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace StructParser;
+
+//Sensor board telemetry, 21 bytes packed.
+typedef Layout<
+    Field<quint16, 0, Big>,                         //sequence
+    Field<quint32, 2>,                              //uptime, ms
+    Field<qint16, 6, Little, 0, 0, 1, 100>,         //temperature, 0.01 C
+    Field<quint16, 8, Little, 0, 0, 1, 1000>,       //supply, mV
+    Field<quint8, 10, Little, 0, 3>,                //mode
+    Field<quint8, 10, Little, 3, 1>,                //fault flag
+    Field<quint8, 10, Little, 4, 4>,                //retry count
+    Field<qint16, 11, Big>,                         //acceleration x, y, z
+    Field<qint16, 13, Big>,
+    Field<qint16, 15, Big>,
+    Field<float, 17>                                //pressure, hPa
+> Telemetry;
+
+static const char *const telemetryNames[] = {
+    "seq", "uptime", "temp", "supply", "mode", "fault", "retries", "accelX", "accelY", "accelZ", "pressure"
+};
+static_assert(Telemetry::COUNT == sizeof(telemetryNames) / sizeof(*telemetryNames), "telemetry field names");
+
+static const KnownStructs::Entry entries[] = {
+    { QT_TRANSLATE_NOOP("KnownStructs", "Sensor telemetry"), telemetryNames, Telemetry::END,
+      &Telemetry::parse, &Telemetry::describe }
+};
+
+int
+KnownStructs::count() {
+    return int(sizeof(entries) / sizeof(*entries));
+}
+
+const KnownStructs::Entry &
+KnownStructs::entry(int index) {
+    return entries[index];
+}
+
+StructSchema
+KnownStructs::Entry::schema() const {
+    StructSchema schema;
+    schema.name = QCoreApplication::translate("KnownStructs", name);
+    schema.size = size;
+    describe(schema.fields);
+    for (int x = 0; x < schema.fields.size(); x++) {
+        schema.fields[x].name = QLatin1String(fieldNames[x]);
+    }
+    return schema;
+}
+
+//Frames cycle through a block small enough to stay in cache, so the numbers
+//are the cost of decoding and not of memory.
+static const int BENCHMARK_VARIANTS = 256;
+
+template <typename Decode>
+static double
+timeDecode(const std::vector<char> &block, int size, int fieldCount, quint64 frames, Decode decode) {
+    std::vector<double> values(static_cast<size_t>(fieldCount));
+    double sum = 0;
+    volatile double sink;
+    const quint64 startNs = monotonicNowNs();
+    for (quint64 n = 0; n < frames; n++) {
+        decode(block.data() + (n % BENCHMARK_VARIANTS) * size, values.data());
+        //Keeps the compiler from dropping the decode.
+        sum += values[n % fieldCount];
+    }
+    const quint64 elapsedNs = monotonicNowNs() - startNs;
+    sink = sum;
+    return elapsedNs ? frames * 1e9 / elapsedNs : 0;
+}
+
+KnownStructs::Benchmark
+KnownStructs::benchmark(const StructSchema &schema, ParseFunction parse, quint64 frames) {
+    Benchmark result;
+    if (schema.fields.isEmpty() || schema.size <= 0 || frames == 0) { return result; }
+
+    std::vector<char> block(static_cast<size_t>(schema.size) * BENCHMARK_VARIANTS);
+    std::mt19937 random(1);
+    for (char &c : block) {
+        c = static_cast<char>(random());
+    }
+
+    result.frames = frames;
+    const int fieldCount = schema.fields.size();
+    if (parse) {
+        //Field by field and bit for bit: random bytes make NaNs and infinities
+        //of the float fields, which comparing values would let through.
+        std::vector<double> specialized(static_cast<size_t>(fieldCount));
+        std::vector<double> generic(static_cast<size_t>(fieldCount));
+        for (int frame = 0; frame < BENCHMARK_VARIANTS; frame++) {
+            const char *data = block.data() + frame * schema.size;
+            parse(data, specialized.data());
+            schema.decode(data, generic.data());
+            for (int field = 0; field < fieldCount; field++) {
+                if (std::memcmp(&specialized[field], &generic[field], sizeof(double)) != 0) {
+                    result.agree = false;
+                    result.mismatchField = field;
+                    result.mismatchFrame = frame;
+                    return result;
+                }
+            }
+        }
+    }
+
+    result.genericPerSecond = timeDecode(block, schema.size, fieldCount, frames,
+                                         [&schema](const char *data, double *values) { schema.decode(data, values); });
+    if (parse) {
+        result.specializedPerSecond = timeDecode(block, schema.size, fieldCount, frames, parse);
+    }
+    return result;
+}
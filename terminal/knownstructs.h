@@ -0,0 +1,46 @@
+#ifndef KNOWNSTRUCTS_H
+#define KNOWNSTRUCTS_H
+
+#include "structschema.h"
+
+//The struct layouts compiled into the application, each a StructParser
+//layout (structparser.h) with its field names. parse() has every offset,
+//byte order and bit range resolved at compile time; schema() describes the
+//same layout for the table and for the generic path.
+class KnownStructs
+{
+public:
+    typedef void (*ParseFunction)(const char *data, double *values);
+    typedef void (*DescribeFunction)(QVector<StructField> &fields);
+
+    struct Entry {
+        const char *name;
+        const char *const *fieldNames;
+        int size;
+        ParseFunction parse;
+        DescribeFunction describe;
+
+        StructSchema schema() const;
+    };
+
+    struct Benchmark {
+        quint64 frames = 0;
+        double specializedPerSecond = 0;    //0 without a compiled parser
+        double genericPerSecond = 0;
+        //Both paths decoded every field of every frame to the same bits.
+        //Otherwise the first field and frame that differ, and nothing is timed.
+        bool agree = true;
+        int mismatchField = -1;
+        int mismatchFrame = -1;
+    };
+
+    static int count();
+    static const Entry &entry(int index);
+
+    //Decodes frames synthetic frames with parse, when given, and with
+    //schema.decode(), and times both once their results are checked to be
+    //identical. Runs on the calling thread.
+    static Benchmark benchmark(const StructSchema &schema, ParseFunction parse, quint64 frames);
+};
+
+#endif // KNOWNSTRUCTS_H
@@ -0,0 +1,81 @@
+#include "latencyhistogram.h"
+
+#include <cstring>
+
+static int
+highestBit(quint64 value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) { bit++; }
+    return bit;
+#endif
+}
+
+void
+LatencyHistogram::reset() {
+    std::memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+    _sum = 0;
+    _min = ~0ull;
+    _max = 0;
+}
+
+void
+LatencyHistogram::add(quint64 valueNs) {
+    _buckets[_bucket(valueNs)]++;
+    _count++;
+    _sum += valueNs;
+    _min = qMin(_min, valueNs);
+    _max = qMax(_max, valueNs);
+}
+
+int
+LatencyHistogram::_bucket(quint64 valueNs) {
+    if (valueNs < static_cast<quint64>(SUB_BUCKETS)) {
+        return static_cast<int>(valueNs);
+    }
+
+    const int exponent = highestBit(valueNs);
+    if (exponent > MAX_EXPONENT) {
+        return BUCKETS - 1;
+    }
+    //The top SUB_BITS below the leading one pick the linear bucket.
+    const int sub = static_cast<int>((valueNs >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+    return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+quint64
+LatencyHistogram::_upperBound(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return static_cast<quint64>(bucket);
+    }
+    const int exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+    const quint64 sub = static_cast<quint64>(bucket % SUB_BUCKETS);
+    return ((static_cast<quint64>(SUB_BUCKETS) + sub + 1) << (exponent - SUB_BITS)) - 1;
+}
+
+quint64
+LatencyHistogram::percentileNs(double p) const {
+    if (_count == 0) { return 0; }
+
+    const quint64 rank = qMax<quint64>(1, static_cast<quint64>(p / 100.0 * static_cast<double>(_count) + 0.5));
+    quint64 seen = 0;
+    for (int x = 0; x < BUCKETS; x++) {
+        seen += _buckets[x];
+        if (seen >= rank) {
+            return qMin(_upperBound(x), _max);
+        }
+    }
+    return _max;
+}
+
+QString
+LatencyHistogram::summary() const {
+    if (_count == 0) { return QStringLiteral("-"); }
+    return QStringLiteral("%1/%2/%3")
+            .arg(percentileNs(50) / 1e3, 0, 'f', 0)
+            .arg(percentileNs(99) / 1e3, 0, 'f', 0)
+            .arg(_max / 1e3, 0, 'f', 0);
+}
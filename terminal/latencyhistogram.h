@@ -0,0 +1,44 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <QtGlobal>
+
+//Log-linear histogram of nanosecond durations: every power of two is split
+//into SUB_BUCKETS linear buckets, so the relative error stays under 1/8 from
+//nanoseconds to minutes in a fixed 2.5 KB with no allocation. Not thread safe.
+class LatencyHistogram
+{
+public:
+    static const int SUB_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int MAX_EXPONENT = 40;     //~18 minutes, larger values are clamped
+    static const int BUCKETS = (MAX_EXPONENT - SUB_BITS + 2) * SUB_BUCKETS;
+
+    LatencyHistogram() { reset(); }
+
+    void reset();
+    void add(quint64 valueNs);
+
+    quint64 count() const { return _count; }
+    quint64 minNs() const { return _count ? _min : 0; }
+    quint64 maxNs() const { return _max; }
+    quint64 meanNs() const { return _count ? _sum / _count : 0; }
+    //Upper bound of the bucket holding the p-th percentile (0..100).
+    quint64 percentileNs(double p) const;
+
+    //"p50/p99/max" in microseconds, or "-" when empty.
+    QString summary() const;
+
+private:
+    static int _bucket(quint64 valueNs);
+    static quint64 _upperBound(int bucket);
+
+    quint64 _buckets[BUCKETS];
+    quint64 _count;
+    quint64 _sum;
+    quint64 _min;
+    quint64 _max;
+};
+
+#endif // LATENCYHISTOGRAM_H
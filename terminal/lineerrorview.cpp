@@ -0,0 +1,119 @@
+#include "lineerrorview.h"
+#include "uartcounters.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+LineErrorView::LineErrorView(const UartCounters *counters, QWidget *parent) :
+    QWidget(parent),
+    _counters(counters),
+    _table(new QTableWidget(UartCounters::COUNTER_COUNT, 2)),
+    _overruns(new QTableWidget(0, OverrunColumnCount)),
+    _status(new QLabel),
+    _refreshTimer(new QTimer(this))
+{
+    _table->setHorizontalHeaderLabels(QStringList() << tr("Counter") << tr("Count"));
+    _table->verticalHeader()->hide();
+    _table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    _table->horizontalHeader()->setStretchLastSection(true);
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    for (int row = 0; row < UartCounters::COUNTER_COUNT; row++) {
+        _table->setItem(row, 0, new QTableWidgetItem(UartCounters::name(static_cast<UartCounters::Counter>(row))));
+        QTableWidgetItem *item = new QTableWidgetItem;
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        _table->setItem(row, 1, item);
+    }
+
+    _overruns->setHorizontalHeaderLabels(QStringList() << tr("Overrun at byte") << tr("Read size") << tr("Time (s)"));
+    _overruns->verticalHeader()->hide();
+    _overruns->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    _overruns->horizontalHeader()->setStretchLastSection(true);
+    _overruns->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _overruns->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    QPushButton *copy = new QPushButton(tr("Copy as JSON"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_status, 1);
+    bar->addWidget(copy);
+
+    QHBoxLayout *tables = new QHBoxLayout;
+    tables->addWidget(_table);
+    tables->addWidget(_overruns);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addLayout(tables);
+
+    _refreshTimer->setInterval(500);
+    connect(_refreshTimer, &QTimer::timeout, this, &LineErrorView::_slot_refresh);
+    connect(copy, &QPushButton::clicked, this, &LineErrorView::_slot_copy);
+}
+
+void
+LineErrorView::setActive(bool active) {
+    if (active) {
+        _refreshTimer->start();
+        _slot_refresh();
+    }
+    else {
+        _refreshTimer->stop();
+    }
+}
+
+void
+LineErrorView::reset(quint64 originNs, bool marking) {
+    _originNs = originNs;
+    _marking = marking;
+    _overruns->setRowCount(0);
+    _slot_refresh();
+}
+
+void
+LineErrorView::_slot_refresh() {
+    const bool driver = _counters->hasDriverCounters();
+    for (int row = 0; row < UartCounters::COUNTER_COUNT; row++) {
+        const bool shown = driver || row >= UartCounters::DRIVER_COUNTERS;
+        _table->item(row, 1)->setText(shown ? QString::number(_counters->value(static_cast<UartCounters::Counter>(row)))
+                                            : tr("n/a"));
+    }
+
+    if (!driver) {
+        _status->setText(tr("The driver keeps no error counters, only the port's own reports are counted"));
+    }
+    else if (!_marking) {
+        _status->setText(tr("Overrun offsets are not marked (see the settings)"));
+    }
+    else {
+        _status->clear();
+    }
+
+    //The list only grows between resets, until it is capped and rotates.
+    const QVector<UartCounters::Overrun> &overruns = _counters->overruns();
+    if (overruns.size() < _overruns->rowCount()
+        || (!overruns.isEmpty() && overruns.size() == _overruns->rowCount()
+            && _overruns->item(0, OffsetColumn)->text() != QString::number(overruns.first().offset))) {
+        _overruns->setRowCount(0);
+    }
+    for (int row = _overruns->rowCount(); row < overruns.size(); row++) {
+        const UartCounters::Overrun &overrun = overruns.at(row);
+        _overruns->insertRow(row);
+        _overruns->setItem(row, OffsetColumn, new QTableWidgetItem(QString::number(overrun.offset)));
+        _overruns->setItem(row, SizeColumn, new QTableWidgetItem(QString::number(overrun.size)));
+        _overruns->setItem(row, TimeColumn, new QTableWidgetItem(
+                               QString::number((overrun.timestampNs - _originNs) / 1e9, 'f', 6)));
+    }
+}
+
+void
+LineErrorView::_slot_copy() {
+    QApplication::clipboard()->setText(QString::fromUtf8(_counters->toJson()));
+}
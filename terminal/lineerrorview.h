@@ -0,0 +1,51 @@
+#ifndef LINEERRORVIEW_H
+#define LINEERRORVIEW_H
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QLabel;
+class QTableWidget;
+class QTimer;
+
+QT_END_NAMESPACE
+
+class UartCounters;
+
+//Dockable line error statistics: the driver and port counters, the marked
+//overruns with their stream offsets, and a JSON copy of it all.
+class LineErrorView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum OverrunColumn {
+        OffsetColumn,
+        SizeColumn,
+        TimeColumn,
+        OverrunColumnCount
+    };
+
+    //counters is only read once the view is shown.
+    explicit LineErrorView(const UartCounters *counters, QWidget *parent = nullptr);
+
+    void setActive(bool active);
+    //When a port opens; overrun times are shown relative to originNs.
+    void reset(quint64 originNs, bool marking);
+
+private slots:
+    void _slot_refresh();
+    void _slot_copy();
+
+private:
+    const UartCounters *_counters = nullptr;
+    QTableWidget *_table = nullptr;
+    QTableWidget *_overruns = nullptr;
+    QLabel *_status = nullptr;
+    QTimer *_refreshTimer = nullptr;
+    quint64 _originNs = 0;
+    bool _marking = false;
+};
+
+#endif // LINEERRORVIEW_H
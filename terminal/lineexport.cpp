@@ -0,0 +1,166 @@
+#include "lineexport.h"
+#include "lineindex.h"
+#include "linestore.h"
+#include "monotonicclock.h"
+
+#include <QFile>
+
+#include <cstdio>
+
+//Lines between checks for cancel() and progress.
+static const qint64 CHECK_LINES = 1024;
+
+LineExport::LineExport(QObject *parent) :
+    QObject(parent),
+    _running(false),
+    _cancel(false)
+{
+}
+
+LineExport::~LineExport() {
+    cancel();
+}
+
+void
+LineExport::start(const LineStore &store, const LineIndex *rows, qint64 firstRow, qint64 lastRow,
+                  const QByteArray &tail, Format format, const QString &path) {
+    cancel();
+
+    Job job;
+    job.store = &store;
+    job.rows = rows;
+    job.firstRow = firstRow;
+    job.lastRow = lastRow;
+    job.tail = tail;
+    job.format = format;
+    job.path = path;
+
+    _text.clear();
+    _cancel.store(false);
+    _running.store(true);
+    //The worker unregisters once it is done reading.
+    store.addReader();
+    _thread = std::thread(&LineExport::_run, this, job);
+}
+
+void
+LineExport::cancel() {
+    _cancel.store(true);
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+QString
+LineExport::takeText() {
+    //The worker is past its last write to _text once it has finished.
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    QString text;
+    text.swap(_text);
+    return text;
+}
+
+void
+LineExport::_run(Job job) {
+    const bool toFile = !job.path.isEmpty();
+    const bool utf8 = toFile && job.format != Latin1Text;
+    const LineStore &store = *job.store;
+    const qint64 total = job.lastRow - job.firstRow + 1;
+    const quint64 originNs = store.completedLineCount() ? store.timestamp(0) : 0;
+
+    QFile file(job.path);
+    QString error;
+    if (toFile && !file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error = tr("Cannot write %1: %2").arg(job.path, file.errorString());
+    }
+
+    QByteArray chunk;
+    chunk.reserve(static_cast<int>(CHUNK_SIZE + LineStore::MAX_LINE_LENGTH * 2 + 32));
+    auto flush = [&]() {
+        if (chunk.isEmpty()) { return true; }
+        if (toFile) {
+            if (file.write(chunk) != chunk.size()) {
+                error = tr("Cannot write %1: %2").arg(job.path, file.errorString());
+                return false;
+            }
+        }
+        else {
+            if (_text.size() + chunk.size() > MAX_CLIPBOARD_SIZE) {
+                error = tr("Too much for the clipboard, export to a file instead");
+                return false;
+            }
+            _text += QString::fromLatin1(chunk);
+        }
+        chunk.resize(0);
+        return true;
+    };
+    auto append = [&](const ByteView &text) {
+        if (!utf8) {
+            chunk.append(text.data, static_cast<int>(text.size));
+            return;
+        }
+        //The console shows bytes as Latin-1.
+        for (const char c : text) {
+            const uchar u = static_cast<uchar>(c);
+            if (u < 0x80) {
+                chunk.append(c);
+            }
+            else {
+                chunk.append(static_cast<char>(0xC0 | (u >> 6)));
+                chunk.append(static_cast<char>(0x80 | (u & 0x3F)));
+            }
+        }
+    };
+
+    quint64 reportedNs = monotonicNowNs();
+    for (qint64 row = job.firstRow; row <= job.lastRow && error.isEmpty(); row++) {
+        if ((row - job.firstRow) % CHECK_LINES == 0) {
+            if (_cancel.load(std::memory_order_relaxed)) {
+                error = tr("Export cancelled");
+                break;
+            }
+            const quint64 nowNs = monotonicNowNs();
+            if (nowNs - reportedNs >= PROGRESS_MS * 1000000ull) {
+                reportedNs = nowNs;
+                emit progress(row - job.firstRow, total);
+            }
+        }
+
+        const qint64 line = job.rows ? job.rows->line(row) : row;
+        if (job.format == Timestamps) {
+            char stamp[32];
+            const int length = std::snprintf(stamp, sizeof(stamp), "[%12.6f] ",
+                                             static_cast<qint64>(store.timestamp(line) - originNs) / 1e9);
+            chunk.append(stamp, length);
+        }
+        append(store.text(line));
+        chunk.append('\n');
+        if (chunk.size() >= CHUNK_SIZE && !flush()) { break; }
+    }
+    store.removeReader();
+    if (error.isEmpty() && !job.tail.isEmpty()) {
+        append(ByteView(job.tail.constData(), job.tail.size()));
+    }
+    if (error.isEmpty()) {
+        flush();
+    }
+
+    if (toFile && file.isOpen()) {
+        file.close();
+        if (!error.isEmpty()) {
+            //Half a file is easily taken for all of it.
+            file.remove();
+        }
+    }
+    if (!error.isEmpty()) {
+        _text.clear();
+    }
+
+    const QString message = !error.isEmpty() ? error
+                            : toFile ? tr("Exported %1 lines to %2").arg(total).arg(job.path)
+                                     : tr("Copied %1 lines").arg(total);
+    _running.store(false, std::memory_order_release);
+    emit finished(error.isEmpty(), message);
+}
@@ -0,0 +1,80 @@
+#ifndef LINEEXPORT_H
+#define LINEEXPORT_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <thread>
+
+class LineIndex;
+class LineStore;
+
+//Writes a range of completed lines of a LineStore to a file or to text for
+//the clipboard on a worker thread. The lines are streamed from the store in
+//CHUNK_SIZE pieces, so a file export takes the same memory whatever its size;
+//clipboard text has to be held whole and stops at MAX_CLIPBOARD_SIZE.
+//
+//Like LineSearch, it reads the store while running: cancel() before the store
+//is cleared or, when exporting rows of a LineIndex, before those change.
+class LineExport : public QObject
+{
+    Q_OBJECT
+
+signals:
+    //Queued to the GUI thread, at most every PROGRESS_MS.
+    void progress(qint64 rows, qint64 total);
+    //Also after cancel(). For the clipboard, call takeText().
+    void finished(bool ok, const QString &message);
+
+public:
+    enum Format {
+        PlainText,      //as shown, UTF-8
+        Timestamps,     //seconds since the first line in front of every line
+        //The stored bytes of every line, one per character and not converted
+        //to UTF-8. Not a capture of the wire: LineStore has already dropped
+        //'\r', applied backspaces and broken lines at MAX_LINE_LENGTH.
+        Latin1Text
+    };
+
+    static const qint64 CHUNK_SIZE = 1 << 20;
+    static const qint64 MAX_CLIPBOARD_SIZE = qint64(256) << 20;
+    static const int PROGRESS_MS = 100;
+
+    explicit LineExport(QObject *parent = nullptr);
+    ~LineExport();
+
+    //GUI thread. Rows firstRow to lastRow of rows, or lines of store when rows
+    //is null; tail (the open last line) goes after them. path empty exports
+    //for the clipboard.
+    void start(const LineStore &store, const LineIndex *rows, qint64 firstRow, qint64 lastRow,
+               const QByteArray &tail, Format format, const QString &path);
+    //Returns once the worker has stopped reading the store.
+    void cancel();
+    bool isRunning() const { return _running.load(std::memory_order_acquire); }
+
+    //GUI thread, after a clipboard export finished.
+    QString takeText();
+
+private:
+    struct Job {
+        const LineStore *store = nullptr;
+        const LineIndex *rows = nullptr;
+        qint64 firstRow = 0;
+        qint64 lastRow = -1;
+        QByteArray tail;
+        Format format = PlainText;
+        QString path;
+    };
+
+    void _run(Job job);
+
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<bool> _cancel;
+    //Clipboard text, the worker's until it has finished.
+    QString _text;
+};
+
+#endif // LINEEXPORT_H
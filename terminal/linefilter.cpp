@@ -0,0 +1,106 @@
+#include "linefilter.h"
+#include "linestore.h"
+
+#include <limits>
+
+LineFilter::LineFilter(const LineStore &store, QObject *parent) :
+    LineIndex(parent),
+    _store(store),
+    _search(new LineSearch(store, this))
+{
+    _search->setMaxHits(std::numeric_limits<qint64>::max());
+    connect(_search, &LineSearch::hitsReady, this, &LineFilter::_slot_hits);
+    connect(_search, &LineSearch::finished, this, &LineFilter::_slot_finished);
+}
+
+LineFilter::~LineFilter() {
+    emit aboutToReset();
+}
+
+bool
+LineFilter::setQuery(const SearchQuery &query) {
+    LineMatcher matcher;
+    if (!matcher.compile(query, _errorString)) {
+        return false;
+    }
+    _errorString.clear();
+    _matcher = matcher;
+
+    emit aboutToReset();
+    _search->cancel();
+    _rows.clear();
+    _matched = 0;
+    _building = !_matcher.isEmpty() && _store.completedLineCount() > 0;
+    if (_building) {
+        _search->start(query);
+    }
+    emit rowsChanged(0);
+    update();
+    return true;
+}
+
+void
+LineFilter::update() {
+    //The worker catches up with new lines itself before it finishes.
+    if (_building) { return; }
+
+    const qint64 completed = _store.completedLineCount();
+    if (_matched == completed) { return; }
+
+    const qint64 firstRow = _rows.size();
+    if (_matcher.isEmpty()) {
+        //No query shows everything.
+        for (qint64 line = _matched; line < completed; line++) {
+            _rows.append(line);
+        }
+    }
+    else {
+        SearchHit hit;
+        for (qint64 line = _matched; line < completed; line++) {
+            if (_matcher.match(_store.text(line), hit)) {
+                _rows.append(line);
+            }
+        }
+    }
+    _matched = completed;
+
+    if (_rows.size() != firstRow) {
+        emit rowsChanged(firstRow);
+    }
+}
+
+void
+LineFilter::reset() {
+    emit aboutToReset();
+    _search->cancel();
+    _rows.clear();
+    _matched = 0;
+    _building = false;
+    emit rowsChanged(0);
+}
+
+void
+LineFilter::_slot_hits() {
+    _hits.resize(0);
+    _search->takeHits(_hits);
+    if (_hits.isEmpty()) { return; }
+
+    const qint64 firstRow = _rows.size();
+    for (const SearchHit &hit : _hits) {
+        _rows.append(hit.line);
+    }
+    emit rowsChanged(firstRow);
+}
+
+void
+LineFilter::_slot_finished(quint64 generation, qint64 lines, qint64 elapsedNs) {
+    Q_UNUSED(elapsedNs);
+    if (generation != _search->generation()) { return; }
+
+    _slot_hits();
+    _building = false;
+    _matched = lines;
+    update();
+    //Nothing new, but no longer building.
+    emit rowsChanged(_rows.size());
+}
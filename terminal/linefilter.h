@@ -0,0 +1,56 @@
+#ifndef LINEFILTER_H
+#define LINEFILTER_H
+
+#include "lineindex.h"
+#include "linesearch.h"
+#include "segmentedvector.h"
+
+//The lines of a LineStore that match a query, kept as an index of line
+//numbers; no text is copied. New lines are matched as they complete with
+//update(). Changing the query rebuilds the index on a LineSearch worker while
+//the rows found so far stream in, after which update() carries on from where
+//the worker stopped.
+class LineFilter : public LineIndex
+{
+    Q_OBJECT
+
+public:
+    explicit LineFilter(const LineStore &store, QObject *parent = nullptr);
+    ~LineFilter();
+
+    const LineStore &store() const override { return _store; }
+
+    //GUI thread. Returns false (see errorString()) for an invalid regex.
+    bool setQuery(const SearchQuery &query);
+    const SearchQuery &query() const { return _matcher.query(); }
+    QString errorString() const { return _errorString; }
+    bool isBuilding() const { return _building; }
+
+    //GUI thread, after lines were appended to the store.
+    void update();
+    //GUI thread, before the store is cleared.
+    void reset();
+
+    qint64 rowCount() const override { return _rows.size(); }
+    qint64 line(qint64 row) const override { return _rows.at(row); }
+    qint64 ownedBytes() const override {
+        return _rows.ownedBytes() + _hits.capacity() * qint64(sizeof(SearchHit));
+    }
+
+private slots:
+    void _slot_hits();
+    void _slot_finished(quint64 generation, qint64 lines, qint64 elapsedNs);
+
+private:
+    const LineStore &_store;
+    LineSearch *_search = nullptr;
+    LineMatcher _matcher;
+    SegmentedVector<qint64> _rows;
+    QVector<SearchHit> _hits;
+    //Lines below this have been matched.
+    qint64 _matched = 0;
+    bool _building = false;
+    QString _errorString;
+};
+
+#endif // LINEFILTER_H
@@ -0,0 +1,6 @@
+#include "lineindex.h"
+
+LineIndex::LineIndex(QObject *parent) :
+    QObject(parent)
+{
+}
@@ -0,0 +1,33 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <QObject>
+
+class LineStore;
+
+//Rows of a view over a LineStore it does not own: each row is a line number
+//into store(), so the view costs its index and never a copy of the text.
+//Console::setFilter() displays one.
+class LineIndex : public QObject
+{
+    Q_OBJECT
+
+signals:
+    //Rows from firstRow on are new (possibly none); firstRow 0 also covers a
+    //rebuild.
+    void rowsChanged(qint64 firstRow);
+    //Before rows are dropped, and from the destructor; readers on other
+    //threads must stop touching them before returning.
+    void aboutToReset();
+
+public:
+    explicit LineIndex(QObject *parent = nullptr);
+
+    virtual const LineStore &store() const = 0;
+    virtual qint64 rowCount() const = 0;
+    virtual qint64 line(qint64 row) const = 0;
+    //Heap held by the index itself, not counting the store.
+    virtual qint64 ownedBytes() const = 0;
+};
+
+#endif // LINEINDEX_H
@@ -0,0 +1,245 @@
+#include "linesearch.h"
+#include "bytescan.h"
+#include "linestore.h"
+#include "monotonicclock.h"
+
+#include <QMutexLocker>
+
+//How often the worker looks for a cancel and hands hits over.
+static const qint64 CHECK_LINES = 4096;
+static const quint64 PUBLISH_NS = 50 * 1000 * 1000;
+
+LineSearch::LineSearch(const LineStore &store, QObject *parent) :
+    QObject(parent),
+    _store(store),
+    _generation(0)
+{
+    _thread = std::thread(&LineSearch::_run, this);
+}
+
+LineSearch::~LineSearch() {
+    cancel();
+    {
+        QMutexLocker lock(&_jobMutex);
+        _quit = true;
+    }
+    _jobReady.wakeOne();
+    _thread.join();
+}
+
+bool
+LineMatcher::compile(const SearchQuery &query, QString &errorString) {
+    _query = query;
+    _regex = QRegularExpression();
+    _literal.clear();
+
+    if (query.regex) {
+        _regex.setPattern(query.pattern);
+        if (!query.caseSensitive) {
+            _regex.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+        }
+        if (!_regex.isValid()) {
+            errorString = _regex.errorString();
+            _query = SearchQuery();
+            return false;
+        }
+        _regex.optimize();
+        return true;
+    }
+
+    _literal = query.pattern.toLatin1();
+    if (!query.caseSensitive) {
+        for (int x = 0; x < _literal.size(); x++) {
+            _literal[x] = ByteScan::foldCase(_literal.at(x));
+        }
+    }
+    return true;
+}
+
+bool
+LineMatcher::match(const ByteView &text, SearchHit &hit) {
+    if (_query.regex) {
+        //Reuses one QString rather than allocating with fromLatin1().
+        _text.resize(static_cast<int>(text.size));
+        QChar *out = _text.data();
+        for (qint64 x = 0; x < text.size; x++) {
+            out[x] = QChar(static_cast<uchar>(text.data[x]));
+        }
+        const QRegularExpressionMatch match = _regex.match(_text);
+        if (!match.hasMatch()) { return false; }
+        hit.column = match.capturedStart();
+        hit.length = match.capturedLength();
+        return true;
+    }
+
+    const char *end = text.data + text.size;
+    const char *at = ByteScan::findSubstring(text.data, end, _literal.constData(),
+                                             static_cast<size_t>(_literal.size()), !_query.caseSensitive);
+    if (at == end) { return false; }
+    hit.column = static_cast<int>(at - text.data);
+    hit.length = _literal.size();
+    return true;
+}
+
+bool
+LineSearch::start(const Query &query) {
+    Job job;
+    if (!job.matcher.compile(query, _errorString)) {
+        cancel();
+        return false;
+    }
+    job.maxHits = _maxHits;
+
+    _errorString.clear();
+    cancel();
+    if (query.pattern.isEmpty()) { return true; }
+
+    QMutexLocker lock(&_jobMutex);
+    job.generation = _generation.load();
+    _job = job;
+    _hasJob = true;
+    //Until the worker is done with the job.
+    _store.addReader();
+    _jobReady.wakeOne();
+    return true;
+}
+
+void
+LineSearch::cancel() {
+    _generation.fetch_add(1);
+    {
+        QMutexLocker lock(&_jobMutex);
+        if (_hasJob) {
+            //Never picked up by the worker.
+            _hasJob = false;
+            _store.removeReader();
+        }
+    }
+    {
+        //The worker checks the generation every CHECK_LINES lines, so this
+        //waits for at most that many.
+        QMutexLocker lock(&_scanMutex);
+    }
+
+    QMutexLocker lock(&_hitMutex);
+    _hits.clear();
+    _notifyPending = false;
+}
+
+void
+LineSearch::takeHits(QVector<SearchHit> &hits) {
+    QMutexLocker lock(&_hitMutex);
+    hits += _hits;
+    _hits.resize(0);
+    _notifyPending = false;
+}
+
+void
+LineSearch::_run() {
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker lock(&_jobMutex);
+            while (!_hasJob && !_quit) {
+                _jobReady.wait(&_jobMutex);
+            }
+            if (_quit) { return; }
+            job = _job;
+            _hasJob = false;
+        }
+
+        QMutexLocker scan(&_scanMutex);
+        if (job.generation == _generation.load()) {
+            _scan(job);
+        }
+        _store.removeReader();
+    }
+}
+
+void
+LineSearch::_scan(Job &job) {
+    const quint64 startNs = monotonicNowNs();
+    quint64 publishedNs = startNs;
+    LineMatcher &matcher = job.matcher;
+    const char *needle = matcher.literal().constData();
+    const size_t needleSize = static_cast<size_t>(matcher.literal().size());
+
+    QVector<SearchHit> batch;
+    qint64 found = 0;
+    qint64 line = 0;
+    qint64 end = _store.completedLineCount();
+
+    while (line < end && found < job.maxHits) {
+        while (line < end && found < job.maxHits) {
+            if (job.generation != _generation.load(std::memory_order_relaxed)) { return; }
+            const quint64 nowNs = monotonicNowNs();
+            if (!batch.isEmpty() && nowNs - publishedNs >= PUBLISH_NS) {
+                if (!_publish(batch, job.generation)) { return; }
+                publishedNs = nowNs;
+            }
+
+            qint64 count = qMin(CHECK_LINES, end - line);
+            if (!matcher.isLiteral()) {
+                for (qint64 x = line; x < line + count && found < job.maxHits; x++) {
+                    SearchHit hit;
+                    if (matcher.match(_store.text(x), hit)) {
+                        hit.line = x;
+                        batch.append(hit);
+                        found++;
+                    }
+                }
+            }
+            else {
+                //Scan the packed text of many lines in one go and map each hit
+                //back to its line through the offset index.
+                const ByteView run = _store.textRun(line, count);
+                const char *p = run.data;
+                const char *runEnd = run.data + run.size;
+                while (p < runEnd && found < job.maxHits) {
+                    const char *at = ByteScan::findSubstring(p, runEnd, needle, needleSize, matcher.ignoreCase());
+                    if (at == runEnd) { break; }
+
+                    const qint64 hitLine = _store.lineInRun(line, count, at - run.data);
+                    const ByteView view = _store.text(hitLine);
+                    if (at + needleSize > view.data + view.size) {
+                        //Spans two lines.
+                        p = at + 1;
+                        continue;
+                    }
+                    SearchHit hit;
+                    hit.line = hitLine;
+                    hit.column = static_cast<int>(at - view.data);
+                    hit.length = static_cast<int>(needleSize);
+                    batch.append(hit);
+                    found++;
+                    p = view.data + view.size;
+                }
+            }
+            line += count;
+        }
+
+        //Take in the lines that completed while we were searching.
+        end = _store.completedLineCount();
+    }
+
+    if (_publish(batch, job.generation)) {
+        emit finished(job.generation, line, static_cast<qint64>(monotonicNowNs() - startNs));
+    }
+}
+
+bool
+LineSearch::_publish(QVector<SearchHit> &batch, quint64 generation) {
+    bool notify = false;
+    {
+        QMutexLocker lock(&_hitMutex);
+        if (generation != _generation.load()) { return false; }
+        _hits += batch;
+        notify = !_notifyPending && !_hits.isEmpty();
+        _notifyPending = _notifyPending || notify;
+    }
+    batch.resize(0);
+    if (notify) {
+        emit hitsReady();
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+#ifndef LINESEARCH_H
+#define LINESEARCH_H
+
+#include "bufferpool.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <thread>
+
+class LineStore;
+
+struct SearchHit {
+    qint64 line = 0;
+    int column = 0;
+    int length = 0;
+};
+
+struct SearchQuery {
+    QString pattern;
+    bool regex = false;
+    bool caseSensitive = false;
+};
+
+//A compiled SearchQuery, for the search worker and the filtered views.
+//Literal patterns use the vectorized ByteScan::findSubstring().
+class LineMatcher
+{
+public:
+    bool compile(const SearchQuery &query, QString &errorString);
+
+    const SearchQuery &query() const { return _query; }
+    bool isEmpty() const { return _query.pattern.isEmpty(); }
+    bool isLiteral() const { return !_query.regex; }
+    bool ignoreCase() const { return !_query.caseSensitive; }
+    //Case folded when ignoreCase().
+    const QByteArray &literal() const { return _literal; }
+
+    //Not thread safe: regex matching reuses one QString.
+    bool match(const ByteView &text, SearchHit &hit);
+
+private:
+    SearchQuery _query;
+    QRegularExpression _regex;
+    QByteArray _literal;
+    QString _text;
+};
+
+//Searches the completed lines of a LineStore on a worker thread. Hits are
+//line numbers, which are also Console scroll positions, and are handed over
+//in batches as they are found. Starting a new search cancels the running one;
+//cancel() returns only once the worker has stopped reading the store, so it
+//must be called before the store is cleared.
+class LineSearch : public QObject
+{
+    Q_OBJECT
+
+signals:
+    //Queued to the GUI thread; call takeHits().
+    void hitsReady();
+    void finished(quint64 generation, qint64 lines, qint64 elapsedNs);
+
+public:
+    typedef SearchQuery Query;
+
+    //Searches stop after this many hits by default.
+    static const qint64 MAX_HITS = 1000000;
+
+    explicit LineSearch(const LineStore &store, QObject *parent = nullptr);
+    ~LineSearch();
+
+    //GUI thread. Returns false (see errorString()) for an invalid regex.
+    bool start(const Query &query);
+    void cancel();
+    //GUI thread, for searches started after the call.
+    void setMaxHits(qint64 maxHits) { _maxHits = maxHits; }
+    quint64 generation() const { return _generation.load(std::memory_order_relaxed); }
+    QString errorString() const { return _errorString; }
+
+    //GUI thread. Appends the hits of the current search found since the last
+    //call, in line order.
+    void takeHits(QVector<SearchHit> &hits);
+
+private:
+    struct Job {
+        LineMatcher matcher;
+        qint64 maxHits = 0;
+        quint64 generation = 0;
+    };
+
+    void _run();
+    void _scan(Job &job);
+    bool _publish(QVector<SearchHit> &batch, quint64 generation);
+
+    const LineStore &_store;
+    std::thread _thread;
+
+    //Held by the worker while it reads the store.
+    QMutex _scanMutex;
+
+    QMutex _jobMutex;
+    QWaitCondition _jobReady;
+    Job _job;
+    bool _hasJob = false;
+    bool _quit = false;
+
+    QMutex _hitMutex;
+    QVector<SearchHit> _hits;
+    bool _notifyPending = false;
+
+    std::atomic<quint64> _generation;
+
+    qint64 _maxHits = MAX_HITS;
+    QString _errorString;
+};
+
+#endif // LINESEARCH_H
@@ -0,0 +1,253 @@
+#include "linestore.h"
+#include "highlighter.h"
+
+#include <cstring>
+
+LineStore::LineStore() :
+    _completed(0),
+    _readers(0)
+{
+    _textBlocks.reserve(MAX_BLOCKS);
+}
+
+qint64
+LineStore::append(const ByteView &data, quint64 timestampNs) {
+    qint64 completed = 0;
+
+    for (const char c : data) {
+        switch (c) {
+        case '\n':
+            if (!_hasOpenLine && !_openLine(timestampNs)) { _full = true; return completed; }
+            _completeLine();
+            completed++;
+            break;
+
+        case '\r':
+            break;
+
+        case char(8):
+            //the device erases the previous character of the current line
+            if (_hasOpenLine) {
+                Record &record = _records.at(_completed.load(std::memory_order_relaxed));
+                if (record.length > 0) {
+                    record.length--;
+                    _textEnd--;
+                    _textBytes--;
+                }
+            }
+            break;
+
+        default:
+            if (!_hasOpenLine && !_openLine(timestampNs)) { _full = true; return completed; }
+            if (_records.at(_completed.load(std::memory_order_relaxed)).length >= MAX_LINE_LENGTH) {
+                _completeLine();
+                completed++;
+                if (!_openLine(timestampNs)) { _full = true; return completed; }
+            }
+            if (!_appendChar(c)) { _full = true; return completed; }
+            break;
+        }
+    }
+
+    return completed;
+}
+
+void
+LineStore::clear() {
+    _records.clear();
+    _spans.clear();
+    _textBlocks.clear();
+    _ownedBlocks.clear();
+    //After the views into it are gone.
+    _adopted.reset();
+    _spilled.reset();
+    _completed.store(0, std::memory_order_release);
+    _adoptedLines = 0;
+    _adoptedTextEnd = 0;
+    _adoptedSpans = 0;
+    _hasOpenLine = false;
+    _full = false;
+    _textEnd = 0;
+    _longestLine = 0;
+    _textBytes = 0;
+}
+
+LineStore::Line
+LineStore::line(qint64 index) const {
+    const Record &record = _records.at(index);
+    Line line;
+    line.text = _text(index, record);
+    line.timestampNs = record.timestampNs;
+    if (record.spanCount && (index >= _adoptedLines
+            || (record.spanBegin >= 0 && record.spanBegin + record.spanCount <= _adoptedSpans))) {
+        line.spans = &_spans.at(record.spanBegin);
+        line.spanCount = static_cast<int>(record.spanCount);
+    }
+    return line;
+}
+
+ByteView
+LineStore::text(qint64 index) const {
+    return _text(index, _records.at(index));
+}
+
+ByteView
+LineStore::_text(qint64 index, const Record &record) const {
+    //A session file is mapped without reading it through, so a damaged
+    //record is only noticed here; it reads as an empty line.
+    if (index < _adoptedLines && (record.offset > _adoptedTextEnd || record.length > _adoptedTextEnd - record.offset
+            || (record.offset & (BLOCK_SIZE - 1)) + record.length > BLOCK_SIZE)) {
+        return ByteView();
+    }
+    return ByteView(record.length ? _textAt(record.offset) : nullptr, record.length);
+}
+
+ByteView
+LineStore::textRun(qint64 first, qint64 &count) const {
+    const quint64 begin = _records.at(first).offset;
+    const quint64 block = begin >> BLOCK_BITS;
+
+    //Offsets only grow, so the lines in first's block are a prefix.
+    if ((_records.at(first + count - 1).offset >> BLOCK_BITS) != block) {
+        qint64 low = first;
+        qint64 high = first + count - 1;
+        while (high - low > 1) {
+            const qint64 middle = low + (high - low) / 2;
+            if ((_records.at(middle).offset >> BLOCK_BITS) == block) { low = middle; }
+            else { high = middle; }
+        }
+        count = low - first + 1;
+    }
+
+    const Record &last = _records.at(first + count - 1);
+    const quint64 end = last.offset + last.length;
+    if (first < _adoptedLines && (last.offset > _adoptedTextEnd || end > _adoptedTextEnd || end < begin
+            || (begin & (BLOCK_SIZE - 1)) + (end - begin) > BLOCK_SIZE)) {
+        //Damaged adopted records, see _text(): line by line instead.
+        count = 1;
+        return _text(first, _records.at(first));
+    }
+    const quint64 size = end - begin;
+    return ByteView(size ? _textAt(begin) : nullptr, static_cast<qint64>(size));
+}
+
+qint64
+LineStore::lineInRun(qint64 first, qint64 count, qint64 offset) const {
+    const quint64 target = _records.at(first).offset + static_cast<quint64>(offset);
+    qint64 low = first;
+    qint64 high = first + count;
+    while (high - low > 1) {
+        const qint64 middle = low + (high - low) / 2;
+        if (_records.at(middle).offset <= target) { low = middle; }
+        else { high = middle; }
+    }
+    return low;
+}
+
+void
+LineStore::_adopt(const Storage &storage) {
+    _adopted = storage.owner;
+    _textBlocks.assign(storage.textBlocks.begin(), storage.textBlocks.end());
+    _records.adopt(storage.records, storage.lineCount);
+    _spans.adopt(storage.spans, storage.spanCount);
+    _hasOpenLine = false;
+    _textEnd = storage.textEnd;
+    _longestLine = storage.longestLine;
+    _textBytes = storage.textBytes;
+    _adoptedLines = storage.lineCount;
+    _adoptedTextEnd = storage.textEnd;
+    _adoptedSpans = storage.spanCount;
+    _completed.store(storage.lineCount, std::memory_order_release);
+}
+
+qint64
+LineStore::_relocate(const Storage &storage) {
+    qint64 freed = 0;
+    for (size_t x = 0; x < storage.textBlocks.size() && x < _textBlocks.size(); x++) {
+        char *const old = _textBlocks[x];
+        _textBlocks[x] = storage.textBlocks[x];
+        for (auto owned = _ownedBlocks.begin(); owned != _ownedBlocks.end(); ++owned) {
+            if (owned->get() == old) {
+                _ownedBlocks.erase(owned);
+                freed += static_cast<qint64>(BLOCK_SIZE);
+                break;
+            }
+        }
+    }
+    freed += _records.relocate(storage.records);
+    freed += _spans.relocate(storage.spans);
+    //Chunks moved by an earlier call point into the new mapping as well.
+    _spilled = storage.owner;
+    return freed;
+}
+
+qint64
+LineStore::ownedBytes() const {
+    return static_cast<qint64>(_ownedBlocks.size() * BLOCK_SIZE) + _records.ownedBytes() + _spans.ownedBytes();
+}
+
+bool
+LineStore::_openLine(quint64 timestampNs) {
+    Record record;
+    record.offset = _textEnd;
+    record.timestampNs = timestampNs;
+    record.spanBegin = 0;
+    record.length = 0;
+    record.spanCount = 0;
+    if (!_records.append(record)) {
+        return false;
+    }
+    _hasOpenLine = true;
+    return true;
+}
+
+bool
+LineStore::_appendChar(char c) {
+    Record &record = _records.at(_completed.load(std::memory_order_relaxed));
+
+    if ((_textEnd >> BLOCK_BITS) >= _textBlocks.size()) {
+        //The current block is full (or there is none yet).
+        if (_textBlocks.size() >= static_cast<size_t>(MAX_BLOCKS)) {
+            return false;
+        }
+        _ownedBlocks.emplace_back(new char[BLOCK_SIZE]);
+        _textBlocks.push_back(_ownedBlocks.back().get());
+    }
+
+    if (record.length > 0 && (_textEnd >> BLOCK_BITS) != (record.offset >> BLOCK_BITS)) {
+        //Move the start of the open line along so it stays contiguous.
+        std::memcpy(_textAt(_textEnd), _textAt(record.offset), record.length);
+        record.offset = _textEnd;
+        _textEnd += record.length;
+    }
+
+    *_textAt(_textEnd++) = c;
+    record.length++;
+    _textBytes++;
+    return true;
+}
+
+void
+LineStore::_completeLine() {
+    const qint64 index = _completed.load(std::memory_order_relaxed);
+    Record &record = _records.at(index);
+
+    if (_highlighter && record.length > 0) {
+        _spanScratch.resize(0);
+        _highlighter->highlight(ByteView(_textAt(record.offset), record.length), _spanScratch);
+        if (!_spanScratch.isEmpty()) {
+            const qint64 begin = _spans.appendRange(_spanScratch.constData(), _spanScratch.size());
+            if (begin >= 0) {
+                record.spanBegin = begin;
+                record.spanCount = static_cast<quint32>(_spanScratch.size());
+            }
+        }
+    }
+
+    if (record.length > _longestLine) {
+        _longestLine = record.length;
+    }
+
+    _hasOpenLine = false;
+    _completed.store(index + 1, std::memory_order_release);
+}
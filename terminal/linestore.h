@@ -0,0 +1,167 @@
+#ifndef LINESTORE_H
+#define LINESTORE_H
+
+#include "bufferpool.h"
+#include "formatspan.h"
+#include "segmentedvector.h"
+
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class LineHighlighter;
+
+// Append-only store of received lines: the raw text, a line-offset index, the
+// receive timestamp of every line and the highlight spans computed when the
+// line completed. Views, search and export all read from here instead of
+// keeping copies of their own.
+//
+// Text lives in 1 MiB blocks and a line never straddles two blocks, so each
+// line is one contiguous ByteView. Line numbers are absolute and stable.
+//
+// There is no line limit: nothing is evicted, the store keeps everything up
+// to its capacity (64 GiB of text). The heap it takes is bounded instead by
+// moving whole chunks onto a file, see SessionFile::spill(), which the memory
+// governor's Scrollback shrinker does with or without a session.
+//
+// One thread appends. Completed lines (below completedLineCount()) are
+// immutable, so other threads may read them without locking; only the open
+// last line is private to the writer.
+//
+// The blocks and index segments have the same layout in a SessionFile, which
+// writes them out and can map them back in as the start of an empty store.
+class LineStore
+{
+    friend class SessionFile;
+
+public:
+    static const int MAX_LINE_LENGTH = 4096;
+
+    struct Line
+    {
+        ByteView text;
+        quint64 timestampNs = 0;
+        const FormatSpan *spans = nullptr;
+        int spanCount = 0;
+    };
+
+    LineStore();
+
+    LineStore(const LineStore &) = delete;
+    LineStore &operator=(const LineStore &) = delete;
+
+    // Highlighter run once on every line as it completes; may be null.
+    void setHighlighter(LineHighlighter *highlighter) { _highlighter = highlighter; }
+
+    // Splits data into lines. '\n' ends a line, '\r' is dropped and backspace
+    // removes the previous character of the open line. Lines longer than
+    // MAX_LINE_LENGTH are broken. Returns the number of lines completed.
+    qint64 append(const ByteView &data, quint64 timestampNs);
+    // Out of text or index capacity; append() drops data until clear().
+    bool isFull() const { return _full; }
+
+    void clear();
+
+    // Number of lines, including the open (unterminated) last line.
+    qint64 lineCount() const { return _records.size(); }
+    qint64 completedLineCount() const { return _completed.load(std::memory_order_acquire); }
+
+    Line line(qint64 index) const;
+    ByteView text(qint64 index) const;
+    quint64 timestamp(qint64 index) const { return _records.at(index).timestampNs; }
+
+    // Lines are packed back to back within a block, so consecutive lines can be
+    // scanned as one range. Returns the text of lines [first, first + count),
+    // with count reduced to the lines that share first's block.
+    ByteView textRun(qint64 first, qint64 &count) const;
+    // The line of such a run that holds the byte at offset into the run.
+    qint64 lineInRun(qint64 first, qint64 count, qint64 offset) const;
+
+    qint64 longestLine() const { return _longestLine; }
+    qint64 textBytes() const { return _textBytes; }
+    // Heap held for text, index and spans. Chunks that live in a mapped
+    // session file are not counted; the kernel can drop those pages.
+    qint64 ownedBytes() const;
+
+    // Readers on other threads (search, export) are registered from the GUI
+    // thread before they start and unregister when they are done, so the
+    // writer knows when chunks may be moved, see SessionFile::spill().
+    void addReader() const { _readers.fetch_add(1, std::memory_order_acq_rel); }
+    void removeReader() const { _readers.fetch_sub(1, std::memory_order_acq_rel); }
+    bool hasReaders() const { return _readers.load(std::memory_order_acquire) != 0; }
+
+private:
+    struct Record
+    {
+        quint64 offset;
+        quint64 timestampNs;
+        qint64 spanBegin;
+        quint32 length;
+        quint32 spanCount;
+    };
+
+    // What SessionFile hands to _adopt(): blocks and segments it has mapped,
+    // and owner, which keeps the mapping alive for as long as they are used.
+    struct Storage
+    {
+        std::vector<char *> textBlocks;
+        std::vector<Record *> records;
+        qint64 lineCount = 0;
+        std::vector<FormatSpan *> spans;
+        qint64 spanCount = 0;
+        quint64 textEnd = 0;
+        qint64 textBytes = 0;
+        qint64 longestLine = 0;
+        std::shared_ptr<void> owner;
+    };
+
+    static const int BLOCK_BITS = 20;
+    static const quint64 BLOCK_SIZE = quint64(1) << BLOCK_BITS;
+    static const int MAX_BLOCKS = 65536;
+
+    char *_textAt(quint64 offset) const {
+        return _textBlocks[static_cast<size_t>(offset >> BLOCK_BITS)] + (offset & (BLOCK_SIZE - 1));
+    }
+
+    // The text of record, or nothing when it is an adopted one that points
+    // outside the text it was saved with.
+    ByteView _text(qint64 index, const Record &record) const;
+
+    // Writer only, on an empty store.
+    void _adopt(const Storage &storage);
+    // Writer only, without readers. Points the leading whole chunks at the
+    // copies in storage and frees the heap ones; returns the bytes freed.
+    qint64 _relocate(const Storage &storage);
+
+    bool _openLine(quint64 timestampNs);
+    bool _appendChar(char c);
+    void _completeLine();
+
+    std::vector<char *> _textBlocks;
+    std::vector<std::unique_ptr<char[]>> _ownedBlocks;
+    std::shared_ptr<void> _adopted;
+    std::shared_ptr<void> _spilled;
+    //A segment of records is 1 MiB, the size of a text block.
+    SegmentedVector<Record, 15, 131072> _records;
+    SegmentedVector<FormatSpan> _spans;
+    std::atomic<qint64> _completed;
+    mutable std::atomic<int> _readers;
+
+    LineHighlighter *_highlighter = nullptr;
+    QVector<FormatSpan> _spanScratch;
+
+    // What _adopt() took over unchecked; its records are checked as they are read.
+    qint64 _adoptedLines = 0;
+    quint64 _adoptedTextEnd = 0;
+    qint64 _adoptedSpans = 0;
+
+    bool _hasOpenLine = false;
+    bool _full = false;
+    quint64 _textEnd = 0;
+    qint64 _longestLine = 0;
+    qint64 _textBytes = 0;
+};
+
+#endif // LINESTORE_H
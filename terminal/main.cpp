@@ -50,11 +50,116 @@
 ****************************************************************************/
 
 #include "mainwindow.h"
+#include "script.h"
+#include "scriptrunner.h"
+#include "serialiothread.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QHash>
+#include <QTextStream>
+
+#include <cstring>
+
+//terminal --script FILE --port DEVICE [--port DEVICE ...] [--baud RATE]
+//runs one session of the script per device without a GUI and prints a timing
+//report per session. Exits non-zero if any session failed.
+static int
+runHeadless(QCoreApplication &app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Serial terminal"));
+    parser.addHelpOption();
+    const QCommandLineOption scriptOption(QStringLiteral("script"), QStringLiteral("Script to run."), QStringLiteral("file"));
+    const QCommandLineOption portOption(QStringLiteral("port"), QStringLiteral("Device, repeat for more sessions."), QStringLiteral("device"));
+    const QCommandLineOption baudOption(QStringLiteral("baud"), QStringLiteral("Baud rate (115200)."), QStringLiteral("rate"), QStringLiteral("115200"));
+    parser.addOption(scriptOption);
+    parser.addOption(portOption);
+    parser.addOption(baudOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    Script script;
+    if (!script.load(parser.value(scriptOption))) {
+        err << script.errorString() << endl;
+        return 2;
+    }
+    const QStringList ports = parser.values(portOption);
+    if (ports.isEmpty()) {
+        err << "No --port given" << endl;
+        return 2;
+    }
+
+    ScriptRunner runner;
+    if (!runner.start()) {
+        err << runner.errorString() << endl;
+        return 2;
+    }
+
+    SettingsDialog::Settings settings = SettingsDialog::Settings();
+    settings.baudRate = parser.value(baudOption).toInt();
+    settings.dataBits = QSerialPort::Data8;
+    settings.parity = QSerialPort::NoParity;
+    settings.stopBits = QSerialPort::OneStop;
+    settings.flowControl = QSerialPort::NoFlowControl;
+
+    int failed = 0;
+    int pending = 0;
+    QHash<int, QString> names;
+    //Connected before the first session is added: a short script can finish
+    //on the runner thread before the loop below is done. With app as the
+    //context both are queued to this thread and only run inside exec(), once
+    //every session is counted.
+    QObject::connect(&runner, &ScriptRunner::logged, &app, [&](int session, const QString &text) {
+        out << names.value(session) << ": " << text << endl;
+    });
+    QObject::connect(&runner, &ScriptRunner::finished, &app, [&](int session, bool passed, const QString &report) {
+        Q_UNUSED(session);
+        out << report << endl;
+        if (!passed) { failed++; }
+        if (--pending == 0) { app.quit(); }
+    });
+
+    for (const QString &port : ports) {
+        settings.name = port;
+        QString errorString;
+        const int fd = SerialIoThread::openDevice(settings, errorString);
+        if (fd < 0) {
+            err << port << ": " << errorString << endl;
+            failed++;
+            continue;
+        }
+        names.insert(runner.addSession(script, port, fd), port);
+        pending++;
+    }
+    if (pending == 0) { return 1; }
+
+    app.exec();
+    return failed ? 1 : 0;
+}
+
+//Whether the command line asks for runHeadless(), decided before there is an
+//application to parse it with: "--script FILE" or "--script=FILE", as
+//QCommandLineParser takes them, up to a "--" that ends the options.
+static bool
+isHeadless(int argc, char *argv[]) {
+    for (int x = 1; x < argc; x++) {
+        if (std::strcmp(argv[x], "--") == 0) { return false; }
+        if (std::strcmp(argv[x], "--script") == 0 || std::strncmp(argv[x], "--script=", 9) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
 int main(int argc, char *argv[])
 {
+    if (isHeadless(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return runHeadless(app);
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -51,40 +51,250 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "channelview.h"
+#include "commandscheduler.h"
 #include "console.h"
+#include "filterview.h"
+#include "frameview.h"
+#include "jitterview.h"
+#include "lineerrorview.h"
+#include "memorygovernor.h"
+#include "memoryview.h"
+#include "mergedview.h"
+#include "modbusview.h"
+#include "modemlinemonitor.h"
+#include "modemlineview.h"
+#include "monotonicclock.h"
+#include "schedulerview.h"
+#include "script.h"
+#include "scriptrunner.h"
+#include "searchbar.h"
+#include "serialiothread.h"
 #include "settingsdialog.h"
+#include "structview.h"
 
+#include <QDebug>
+#include <QDateTime>
+#include <QDockWidget>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QLabel>
 #include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QStandardPaths>
+#include <QTimer>
+
+static const int RX_POOL_BLOCKS = 32;
+static const qint64 RX_BLOCK_SIZE = 16 * 1024;
+static const int SESSION_SYNC_MS = 1000;
+
+static QString
+defaultSessionPath() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + QStringLiteral("/session.tsession");
+}
+
+//For the unnamed files the scrollback is spilled to without a session: next
+//to where the session would be, since the temp directory may well be a tmpfs.
+static QString
+spillDirectory() {
+    return QFileInfo(defaultSessionPath()).absolutePath();
+}
 
 //! [0]
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     _ui(new Ui::MainWindow),
     _status(new QLabel),
+    _latency(new QLabel),
+    _triggerStatus(new QLabel),
+    _memoryStatus(new QLabel),
+    _paintStatus(new QLabel),
+    _latencyTimer(new QTimer(this)),
     _console(new Console),
+    _modbus(new ModbusView),
+    _modbusDock(new QDockWidget(tr("Modbus Analyzer"), this)),
+    _frameView(new FrameView),
+    _frameDock(new QDockWidget(tr("Frames"), this)),
+    _scheduler(new CommandScheduler(this)),
+    _schedulerView(new SchedulerView(_scheduler)),
+    _schedulerDock(new QDockWidget(tr("Scheduler"), this)),
+    _searchBar(new SearchBar(_console)),
+    _searchDock(new QDockWidget(tr("Search"), this)),
+    _modemMonitor(new ModemLineMonitor(this)),
+    _modemView(new ModemLineView),
+    _modemDock(new QDockWidget(tr("Modem Lines"), this)),
+    _lineErrorView(new LineErrorView(&_lineErrors)),
+    _lineErrorDock(new QDockWidget(tr("Line Errors"), this)),
+    _channelView(new ChannelView(_console)),
+    _channelDock(new QDockWidget(tr("Channels"), this)),
+    _mergedView(new MergedView(_console)),
+    _mergedDock(new QDockWidget(tr("Merged Ports"), this)),
+    _structView(new StructView),
+    _structDock(new QDockWidget(tr("Structs"), this)),
+    _memory(new MemoryGovernor(this)),
+    _memoryView(new MemoryView(_memory)),
+    _memoryDock(new QDockWidget(tr("Memory"), this)),
+    _jitterView(new JitterView),
+    _jitterDock(new QDockWidget(tr("Jitter Probe"), this)),
+    _scriptLog(new QPlainTextEdit),
+    _scriptDock(new QDockWidget(tr("Script"), this)),
+    _scripts(new ScriptRunner(this)),
     _settings(new SettingsDialog),
-    _serial(new QSerialPort(this))
+    _serial(new QSerialPort(this)),
+    _rxPool(RX_POOL_BLOCKS, RX_BLOCK_SIZE),
+    _sessionTimer(new QTimer(this))
 {
     _ui->setupUi(this);
-    _console->setEnabled(false);
+    //Read only rather than disabled, so a restored session can be browsed.
+    _console->setReadOnly(true);
     setCentralWidget(_console);
 
+    _modbusDock->setObjectName(QStringLiteral("modbusDock"));
+    _modbusDock->setWidget(_modbus);
+    _modbusDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _modbusDock);
+
+    _frameDock->setObjectName(QStringLiteral("frameDock"));
+    _frameDock->setWidget(_frameView);
+    _frameDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _frameDock);
+
+    _schedulerDock->setObjectName(QStringLiteral("schedulerDock"));
+    _schedulerDock->setWidget(_schedulerView);
+    _schedulerDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _schedulerDock);
+
+    _searchDock->setObjectName(QStringLiteral("searchDock"));
+    _searchDock->setWidget(_searchBar);
+    _searchDock->setFeatures(QDockWidget::DockWidgetClosable | QDockWidget::DockWidgetMovable);
+    _searchDock->hide();
+    addDockWidget(Qt::TopDockWidgetArea, _searchDock);
+
+    _modemDock->setObjectName(QStringLiteral("modemDock"));
+    _modemDock->setWidget(_modemView);
+    _modemDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _modemDock);
+
+    _lineErrorDock->setObjectName(QStringLiteral("lineErrorDock"));
+    _lineErrorDock->setWidget(_lineErrorView);
+    _lineErrorDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _lineErrorDock);
+
+    _channelDock->setObjectName(QStringLiteral("channelDock"));
+    _channelDock->setWidget(_channelView);
+    _channelDock->hide();
+    addDockWidget(Qt::RightDockWidgetArea, _channelDock);
+
+    _mergedDock->setObjectName(QStringLiteral("mergedDock"));
+    _mergedDock->setWidget(_mergedView);
+    _mergedDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _mergedDock);
+
+    _structDock->setObjectName(QStringLiteral("structDock"));
+    _structDock->setWidget(_structView);
+    _structDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _structDock);
+
+    _memoryDock->setObjectName(QStringLiteral("memoryDock"));
+    _memoryDock->setWidget(_memoryView);
+    _memoryDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _memoryDock);
+
+    _jitterDock->setObjectName(QStringLiteral("jitterDock"));
+    _jitterDock->setWidget(_jitterView);
+    _jitterDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _jitterDock);
+
+    _scriptLog->setReadOnly(true);
+    _scriptLog->setMaximumBlockCount(10000);
+    _scriptDock->setObjectName(QStringLiteral("scriptDock"));
+    _scriptDock->setWidget(_scriptLog);
+    _scriptDock->hide();
+    addDockWidget(Qt::BottomDockWidgetArea, _scriptDock);
+
     _ui->actionConnect->setEnabled(true);
     _ui->actionDisconnect->setEnabled(false);
     _ui->actionQuit->setEnabled(true);
     _ui->actionConfigure->setEnabled(true);
+    _ui->actionOpenSession->setEnabled(true);
+    _ui->actionRunScript->setEnabled(false);
+    _ui->actionStopScript->setEnabled(false);
 
     _ui->statusBar->addWidget(_status);
+    _ui->statusBar->addWidget(_latency);
+    _ui->statusBar->addWidget(_triggerStatus);
+    _ui->statusBar->addPermanentWidget(_paintStatus);
+    _ui->statusBar->addPermanentWidget(_memoryStatus);
+    _latencyTimer->setInterval(250);
 
     initActionsConnections();
+    openMemoryAccounts();
 
     connect(_serial, &QSerialPort::errorOccurred, this, &MainWindow::handleError);
     connect(_serial, &QSerialPort::readyRead, this, &MainWindow::readData);
     connect(_console, &Console::getData, this, &MainWindow::writeData);
+    connect(_channelView, &ChannelView::getData, this, &MainWindow::writeData);
+    connect(_latencyTimer, &QTimer::timeout, this, &MainWindow::updateLatency);
+    connect(_latencyTimer, &QTimer::timeout, this, &MainWindow::sampleLineErrors);
+    connect(_modbusDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleModbusAnalyzer);
+    connect(_frameDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleFrameView);
+    connect(_schedulerDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleSchedulerView);
+    connect(_searchDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleSearchBar);
+    connect(_modemDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleModemLines);
+    connect(_lineErrorDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleLineErrors);
+    connect(_channelDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleChannels);
+    connect(_mergedDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleMergedView);
+    connect(_mergedView, &MergedView::errorOccurred, this, &MainWindow::showStatusMessage);
+    connect(_structDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleStructView);
+    connect(_memoryDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleMemoryView);
+    connect(_memory, &MemoryGovernor::sampled, this, &MainWindow::updateMemoryStatus);
+    connect(_memory, &MemoryGovernor::sampled, this, &MainWindow::updatePaintStatus);
+    connect(_jitterDock, &QDockWidget::visibilityChanged, this, &MainWindow::toggleJitterView);
+    connect(_modemMonitor, &ModemLineMonitor::edgesReady, this, &MainWindow::readModemEdges);
+    connect(_modemMonitor, &ModemLineMonitor::errorOccurred, this, &MainWindow::handleModemError);
+    connect(_modemView, &ModemLineView::lineChangeRequested, this, &MainWindow::setModemLine);
+    connect(_modemView, &ModemLineView::pulseRequested, this, &MainWindow::pulseModemLine);
+    connect(_scheduler, &CommandScheduler::sendRequested, this, &MainWindow::scheduledSend);
+    connect(_scheduler, &CommandScheduler::sent, this, &MainWindow::scheduledSent);
+    connect(_scripts, &ScriptRunner::sendRequested, this, &MainWindow::scriptSend);
+    connect(_scripts, &ScriptRunner::lineRequested, this, &MainWindow::scriptLine);
+    connect(_scripts, &ScriptRunner::logged, this, &MainWindow::scriptLogged);
+    connect(_scripts, &ScriptRunner::finished, this, &MainWindow::scriptFinished);
+    connect(_console, &Console::aboutToClear, this, &MainWindow::sessionCleared);
+    connect(_console, &Console::exportFinished, this, [this](bool ok, const QString &message) {
+        Q_UNUSED(ok);
+        showStatusMessage(message);
+    });
+    connect(_sessionTimer, &QTimer::timeout, this, &MainWindow::syncSession);
+    connect(_sessionTimer, &QTimer::timeout, this, &MainWindow::syncSpillFile);
+    connect(_sessionTimer, &QTimer::timeout, _mergedView, &MergedView::syncPorts);
+
+    //Pick up where the last run left off; a file that cannot be read is
+    //replaced by a new one.
+    if(_settings->settings().keepSession) {
+        const QString path = defaultSessionPath();
+        if(_session.open(path)) {
+            restoreSession();
+        }
+        else {
+            if(QFile::exists(path)) {
+                qWarning() << "Session:" << _session.errorString();
+            }
+            _session.create(path);
+        }
+    }
+    _sessionTimer->start(SESSION_SYNC_MS);
 }
 
 MainWindow::~MainWindow() {
+    //~Console clears the store; that must not start a new session file.
+    disconnect(_console, &Console::aboutToClear, this, &MainWindow::sessionCleared);
+    syncSession();
+    _session.close();
+    delete _framing;
     delete _settings;
     delete _ui;
 }
@@ -93,12 +303,33 @@ void
 MainWindow::openSerialPort() {
 
     const SettingsDialog::Settings p = _settings->settings();
-    _serial->setPortName(p.name);
-    _serial->setBaudRate(p.baudRate);
-    _serial->setDataBits(p.dataBits);
-    _serial->setParity(p.parity);
-    _serial->setStopBits(p.stopBits);
-    _serial->setFlowControl(p.flowControl);
+    bool opened = false;
+    QString errorString;
+
+    //Not touched again until the port is closed; in low latency mode it is
+    //driven from the I/O thread.
+    _triggers.setRules(p.triggerRules);
+
+    if (p.lowLatency) {
+        //termios + epoll reader thread instead of QSerialPort's notifier.
+        _io = new SerialIoThread(_rxPool, _roundTrip, _triggers, this);
+        connect(_io, &SerialIoThread::readyRead, this, &MainWindow::readIoData);
+        connect(_io, &SerialIoThread::triggered, this, &MainWindow::readTriggerHits);
+        connect(_io, &SerialIoThread::errorOccurred, this, &MainWindow::handleIoError);
+        opened = _io->open(p);
+        if (!opened) {
+            errorString = _io->errorString();
+            delete _io;
+            _io = nullptr;
+        }
+    }
+    else {
+        _serial->setPortName(p.name);
+        _serial->setBaudRate(p.baudRate);
+        _serial->setDataBits(p.dataBits);
+        _serial->setParity(p.parity);
+        _serial->setStopBits(p.stopBits);
+        _serial->setFlowControl(p.flowControl);
 
 //    m_serial->setPortName("/dev/tty.usbserial-14213220");
 //    m_serial->setBaudRate(QSerialPort::Baud115200);
@@ -106,32 +337,148 @@ MainWindow::openSerialPort() {
 //    m_serial->setParity(QSerialPort::NoParity);
 //    m_serial->setStopBits(QSerialPort::OneStop);
 //    m_serial->setFlowControl(QSerialPort::NoFlowControl);
-    if (_serial->open(QIODevice::ReadWrite)) {
-        _console->setEnabled(true);
+        opened = _serial->open(QIODevice::ReadWrite);
+        if (!opened) {
+            errorString = _serial->errorString();
+        }
+    }
+
+    if (opened) {
+        _console->setReadOnly(false);
         _console->setLocalEchoEnabled(p.localEchoEnabled);
+        _console->setHighlightRules(p.highlightRules);
+        for(FilterView *view : _filterViews) {
+            view->setHighlightRules(p.highlightRules);
+        }
+        _channelView->setReadOnly(false);
+        _channelView->setHighlightRules(p.highlightRules);
+        _mergedView->setMainName(p.name);
+        _modbus->configure(p);
+
+        delete _framing;
+        _framing = FrameDecoder::create(p.framing);
+        if (_framing) {
+            _framing->setCrcEnabled(p.framingCrc);
+        }
+        _frameView->setDecoder(_framing);
+        _scheduler->configure(p.scheduledCommands, _io);
+        _schedulerView->reload();
+        _schedulerView->setStartEnabled(true);
         _ui->actionConnect->setEnabled(false);
         _ui->actionDisconnect->setEnabled(true);
         _ui->actionConfigure->setEnabled(false);
+        _ui->actionOpenSession->setEnabled(false);
+        _ui->actionRunScript->setEnabled(_scriptSession == 0);
+
+        //Turning the session on starts a new file: the lines already in the
+        //console are written out from the start.
+        if(p.keepSession && !_session.isOpen()) {
+            //The next spill moves the store onto the session file.
+            _spillFile.close();
+            _session.create(defaultSessionPath());
+        }
+        else if(!p.keepSession && _session.isOpen()) {
+            const QString path = _session.fileName();
+            _session.close();
+            if(path == defaultSessionPath()) {
+                QFile::remove(path);
+            }
+        }
+        if(_session.isOpen()) {
+            _session.setProfile(_settings->profile());
+        }
+
+        QString modeStatus;
+        if (_io) {
+            modeStatus = _io->lowLatencyApplied() ? tr(" [low latency]")
+                                                  : tr(" [low latency, no ASYNC_LOW_LATENCY]");
+            //What the real-time options got; default scheduling when refused.
+            if (p.realTime || p.ioCpu >= 0) {
+                modeStatus += tr(" [%1]").arg(_io->scheduling().describe());
+            }
+        }
+        _jitterView->setIoThread(_io);
+
+        QString tapStatus;
+        if (p.shmTapEnabled) {
+            if (_tap.open(ShmTap::nameForPort(p.name))) {
+                tapStatus = tr(" [tap: %1]").arg(_tap.name());
+            }
+            else {
+                tapStatus = tr(" [tap failed: %1]").arg(_tap.errorString());
+            }
+        }
+
         showStatusMessage(tr("Connected to %1 : %2, %3, %4, %5, %6")
                           .arg(p.name).arg(p.stringBaudRate).arg(p.stringDataBits)
-                          .arg(p.stringParity).arg(p.stringStopBits).arg(p.stringFlowControl));
+                          .arg(p.stringParity).arg(p.stringStopBits).arg(p.stringFlowControl)
+                          + modeStatus + tapStatus);
+
+        //For the modem line monitor and the driver's error counters.
+#ifdef Q_OS_LINUX
+        const int fd = _io ? _io->handle() : _serial->handle();
+#else
+        const int fd = -1;
+#endif
+        //Edges are timestamped on the monitor's own thread, the receive
+        //path does not see it.
+        if(_modemMonitor->start(fd)) {
+            _modemView->reset(true, _modemMonitor->lines());
+        }
+        else {
+            _modemView->reset(false, 0, _modemMonitor->errorString());
+        }
+
+        _roundTrip.reset();
+        _lastMark.clear();
+        _connectedNs = monotonicNowNs();
+        _rxBytes = 0;
+        _lineErrors.start(fd);
+        //The low latency reader marks overruns itself.
+        _markOverruns = p.markOverruns && !_io && _lineErrors.hasDriverCounters();
+        _lineErrorView->reset(_connectedNs, p.markOverruns && _lineErrors.hasDriverCounters());
+        updateLatency();
+        _latencyTimer->start();
     }
     else {
-        QMessageBox::critical(this, tr("Error"), _serial->errorString());
+        QMessageBox::critical(this, tr("Error"), errorString);
         showStatusMessage(tr("Open error"));
     }
 }
 
 void
 MainWindow::closeSerialPort() {
+    stopScript();
+    //Before the port goes away, the scheduler may be writing to it.
+    _scheduler->stop();
+    _schedulerView->setStartEnabled(false);
+    _modemMonitor->stop();
+    _modemView->reset(false, 0);
+    _lineErrors.stop();
     if(_serial->isOpen()) {
         _serial->close();
     }
+    if(_io) {
+        _jitterView->setIoThread(nullptr);
+        _io->close();
+        _io->deleteLater();
+        _io = nullptr;
+    }
+    _tap.close();
+    _capture.close();
+    _frameView->setDecoder(nullptr);
+    delete _framing;
+    _framing = nullptr;
+    _latencyTimer->stop();
 
-    _console->setEnabled(false);
+    _console->setReadOnly(true);
+    _channelView->setReadOnly(true);
     _ui->actionConnect->setEnabled(true);
     _ui->actionDisconnect->setEnabled(false);
     _ui->actionConfigure->setEnabled(true);
+    _ui->actionOpenSession->setEnabled(true);
+    _ui->actionRunScript->setEnabled(false);
+    syncSession();
     showStatusMessage(tr("Disconnected"));
 }
 
@@ -145,30 +492,633 @@ MainWindow::about() {
 
 void
 MainWindow::writeData(const QByteArray &data) {
-    _serial->write(data);
+    if(_io) {
+        _io->write(data);
+    }
+    else {
+        _roundTrip.markSent(monotonicNowNs());
+        _serial->write(data);
+    }
+    dispatchTx(data, monotonicNowNs());
 }
 
 void
 MainWindow::readData() {
-    const QByteArray data = _serial->readAll();
-    _console->putData(data);
+    //read() straight into pooled blocks instead of readAll(), which would
+    //allocate a new QByteArray on every readyRead.
+    while(_serial->bytesAvailable() > 0) {
+        BufferPool::Block *block = _rxPool.acquire();
+        if(!block) {
+            //Every block is still held downstream; pick the rest up on the next readyRead.
+            qWarning() << "Receive buffer pool exhausted";
+            return;
+        }
+
+        const qint64 count = _serial->read(block->data(), block->capacity());
+        if(count > 0) {
+            const quint64 timestampNs = monotonicNowNs();
+            _roundTrip.markReceived(timestampNs);
+            if(_markOverruns && _lineErrors.checkOverrun()) {
+                markOverrun(count, timestampNs);
+            }
+            if(!_triggers.isEmpty()) {
+                fireTriggers(block->view(count), timestampNs);
+            }
+            dispatchRx(block->view(count), timestampNs);
+        }
+        _rxPool.release(block);
+
+        if(count <= 0) { return; }
+    }
+}
+
+void
+MainWindow::readIoData() {
+    SerialIoThread::Chunk chunk;
+    while(_io && _io->takeChunk(chunk)) {
+        if(chunk.overrun) {
+            markOverrun(chunk.size, chunk.timestampNs);
+        }
+        dispatchRx(chunk.block->view(chunk.size), chunk.timestampNs);
+        _rxPool.release(chunk.block);
+    }
+}
+
+void
+MainWindow::readTriggerHits() {
+    TriggerHit hit;
+    while(_io && _io->takeTriggerHit(hit)) {
+        handleTriggerHit(hit);
+    }
+}
+
+void
+MainWindow::fireTriggers(const ByteView &data, quint64 timestampNs) {
+    //QSerialPort mode only: here the GUI thread is the reader, so the
+    //response goes out as soon as this chunk has been read.
+    _triggerHits.resize(0);
+    if(_triggers.scan(data, timestampNs, _triggerHits) == 0) { return; }
+
+    for(TriggerHit &hit : _triggerHits) {
+        const TriggerRule &rule = _triggers.rule(hit.rule);
+        if(rule.action == TriggerRule::Send && !rule.payload.isEmpty()) {
+            _serial->write(rule.payload);
+            _serial->flush();
+            _triggers.recordSend(hit, monotonicNowNs());
+        }
+        handleTriggerHit(hit);
+    }
+}
+
+void
+MainWindow::handleTriggerHit(const TriggerHit &hit) {
+    const TriggerRule &rule = _triggers.rule(hit.rule);
+    switch(rule.action) {
+    case TriggerRule::Send:
+        //Already written by the reader, only recorded here.
+        dispatchTx(rule.payload, hit.timestampNs + hit.latencyNs);
+        break;
+    case TriggerRule::Capture:
+        startCapture(QString::fromUtf8(rule.payload));
+        break;
+    case TriggerRule::Mark:
+        _lastMark = tr("%1 @ %2 s").arg(rule.pattern)
+                .arg((hit.timestampNs - _connectedNs) / 1e9, 0, 'f', 6);
+        qDebug() << "Trigger mark:" << _lastMark;
+        break;
+    case TriggerRule::Beep:
+        QApplication::beep();
+        break;
+    }
+}
+
+void
+MainWindow::startCapture(const QString &path) {
+    if(_capture.isOpen()) { return; }
+
+    _capture.setFileName(!path.isEmpty() ? path
+                         : QStringLiteral("capture-%1.bin")
+                           .arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-hhmmss"))));
+    if(!_capture.open(QIODevice::WriteOnly)) {
+        qWarning() << "Capture:" << _capture.errorString();
+        return;
+    }
+    qDebug() << "Capturing to" << _capture.fileName();
+}
+
+void
+MainWindow::dispatchTx(const QByteArray &data, quint64 timestampNs) {
+    _tap.publish(ShmTapLayout::Tx, data.constData(), data.size());
+    if(_modbus->isActive()) {
+        _modbus->feed(ByteView(data.constData(), data.size()), timestampNs, true);
+    }
+}
+
+void
+MainWindow::dispatchRx(const ByteView &data, quint64 timestampNs) {
+    _rxBytes += data.size;
+    _tap.publish(ShmTapLayout::Rx, data.data, data.size);
+    if(_capture.isOpen()) {
+        _capture.write(data.data, data.size);
+    }
+    _console->putData(data, timestampNs);
+    for(FilterView *view : _filterViews) {
+        view->refresh();
+    }
+    _channelView->refresh();
+    _mergedView->refresh();
+    if(_scheduler->isRunning()) {
+        _scheduler->feed(data, timestampNs);
+    }
+    if(_scriptSession) {
+        _scripts->feed(_scriptSession, data);
+    }
+    if(_modbus->isActive()) {
+        _modbus->feed(data, timestampNs, false);
+    }
+
+    if(_framing) {
+        //Frame payloads point into this chunk and are only valid until it is released.
+        _frames.resize(0);
+        _framing->feed(data, timestampNs, _frames);
+        for(const DecodedFrame &frame : _frames) {
+            _tap.publish(ShmTapLayout::Frame, frame.payload.data, frame.payload.size);
+        }
+        if(_frameView->isActive()) {
+            _frameView->append(_frames);
+        }
+        if(_structView->isActive()) {
+            _structView->append(_frames);
+        }
+    }
+}
+
+void
+MainWindow::updateLatency() {
+    if(_triggers.isEmpty()) {
+        _triggerStatus->clear();
+    }
+    else {
+        QString text = tr("Triggers: %1").arg(_triggers.fired());
+        if(_triggers.sent() > 0) {
+            text += tr(", match to write %1/%2/%3 us (last/avg/max)")
+                    .arg(_triggers.lastLatencyNs() / 1000).arg(_triggers.averageLatencyNs() / 1000)
+                    .arg(_triggers.maxLatencyNs() / 1000);
+        }
+        if(!_lastMark.isEmpty()) {
+            text += tr(", mark: %1").arg(_lastMark);
+        }
+        _triggerStatus->setText(text);
+    }
+
+    if(_roundTrip.samples() == 0) {
+        _latency->setText(tr("RTT: -"));
+        _latency->setToolTip(QString());
+        return;
+    }
+    const LatencyHistogram rtt = _roundTrip.histogram();
+    _latency->setText(tr("RTT p50 %1 ms, p99 %2 ms")
+                      .arg(rtt.percentileNs(50) / 1e6, 0, 'f', 2)
+                      .arg(rtt.percentileNs(99) / 1e6, 0, 'f', 2));
+    _latency->setToolTip(tr("%1 round trips since connecting; last %2 ms, max %3 ms")
+                         .arg(rtt.count())
+                         .arg(_roundTrip.lastNsecs() / 1e6, 0, 'f', 2)
+                         .arg(rtt.maxNs() / 1e6, 0, 'f', 2));
+}
+
+void
+MainWindow::toggleModbusAnalyzer(bool visible) {
+    //Frames are only collected while the dock is on screen.
+    _modbus->setActive(visible);
+    _ui->actionModbusAnalyzer->setChecked(visible);
+}
+
+void
+MainWindow::toggleFrameView(bool visible) {
+    _frameView->setActive(visible);
+    _ui->actionFrames->setChecked(visible);
+}
+
+void
+MainWindow::toggleStructView(bool visible) {
+    _structView->setActive(visible);
+    _ui->actionStructs->setChecked(visible);
+}
+
+void
+MainWindow::toggleSchedulerView(bool visible) {
+    _schedulerView->setActive(visible);
+    _ui->actionScheduler->setChecked(visible);
+}
+
+void
+MainWindow::toggleSearchBar(bool visible) {
+    if(visible) {
+        _searchBar->activate();
+    }
+    _ui->actionFind->setChecked(visible);
+}
+
+void
+MainWindow::toggleModemLines(bool visible) {
+    _modemView->setActive(visible);
+    _ui->actionModemLines->setChecked(visible);
+}
+
+void
+MainWindow::readModemEdges() {
+    ModemLineEvent event;
+    while(_modemMonitor->takeEvent(event)) {
+        recordModemEdge(event);
+    }
+    _modemView->setDropped(_modemMonitor->droppedEdges());
+}
+
+void
+MainWindow::setModemLine(quint32 line, bool on) {
+    if(!_modemMonitor->isRunning()) { return; }
+
+    ModemLineEvent event;
+    if(!_modemMonitor->setLine(static_cast<ModemLineMonitor::Line>(line), on, event)) {
+        showStatusMessage(_modemMonitor->errorString());
+        return;
+    }
+    if(event.changed) {
+        recordModemEdge(event);
+    }
+}
+
+void
+MainWindow::pulseModemLine(quint32 line, int widthMs) {
+    if(!_modemMonitor->isRunning()) { return; }
+
+    //Away from the level the line is at now, then back to it.
+    const bool asserted = (_modemMonitor->lines() & line) != 0;
+    setModemLine(line, !asserted);
+    QTimer::singleShot(widthMs, Qt::PreciseTimer, this, [this, line, asserted]() { setModemLine(line, asserted); });
+}
+
+void
+MainWindow::handleModemError(const QString &message) {
+    //DTR and RTS can still be driven.
+    _modemView->reset(true, _modemMonitor->lines(), message);
+}
+
+void
+MainWindow::recordModemEdge(const ModemLineEvent &event) {
+    _modemView->append(event);
+
+    ShmTapLayout::ModemLinesPayload payload;
+    payload.lines = event.lines;
+    payload.changed = event.changed;
+    _tap.publish(ShmTapLayout::ModemLines, reinterpret_cast<const char *>(&payload), sizeof(payload),
+                 event.timestampNs);
+}
+
+void
+MainWindow::toggleLineErrors(bool visible) {
+    _lineErrorView->setActive(visible);
+    _ui->actionLineErrors->setChecked(visible);
+}
+
+void
+MainWindow::toggleChannels(bool visible) {
+    _channelView->setActive(visible);
+    _ui->actionChannels->setChecked(visible);
+}
+
+void
+MainWindow::toggleMergedView(bool visible) {
+    _mergedView->setActive(visible);
+    _ui->actionMergedView->setChecked(visible);
+}
+
+void
+MainWindow::toggleMemoryView(bool visible) {
+    _memoryView->setActive(visible);
+    _ui->actionMemory->setChecked(visible);
+}
+
+void
+MainWindow::toggleJitterView(bool visible) {
+    _jitterView->setActive(visible);
+    _ui->actionJitter->setChecked(visible);
+}
+
+void
+MainWindow::updateMemoryStatus() {
+    _memoryStatus->setText(tr("Mem: %1 / %2").arg(MemoryGovernor::formatBytes(_memory->total()),
+                                                   MemoryGovernor::formatBytes(_memory->budget())));
+}
+
+void
+MainWindow::updatePaintStatus() {
+    //Only the visible rows are painted, so this should not grow with the scrollback.
+    const Console::FrameStats stats = _console->frameStats();
+    const LineHighlighter &highlighter = _console->highlighter();
+    QString text;
+    QString toolTip;
+    if(stats.frames > 0) {
+        text = tr("Paint: %1/%2/%3 us")
+               .arg(stats.lastNsecs / 1000)
+               .arg(stats.totalNsecs / stats.frames / 1000)
+               .arg(stats.maxNsecs / 1000);
+        toolTip = tr("Console repaint time, last/avg/max over %1 frames").arg(stats.frames);
+    }
+    //Spent on the receive path, once per line as it is appended.
+    if(highlighter.linesHighlighted() > 0) {
+        if(!text.isEmpty()) {
+            text += QStringLiteral("  ");
+            toolTip += QLatin1Char('\n');
+        }
+        text += tr("Highlight: %1 ns/line").arg(highlighter.nsecsSpent() / highlighter.linesHighlighted());
+        toolTip += tr("Average highlighting time of %1 lines with %2 rules")
+                   .arg(highlighter.linesHighlighted()).arg(highlighter.ruleCount());
+    }
+    _paintStatus->setText(text);
+    _paintStatus->setToolTip(toolTip);
+}
+
+void
+MainWindow::sampleLineErrors() {
+    if(_lineErrors.sample()) {
+        publishLineErrors(0);
+    }
+}
+
+void
+MainWindow::markOverrun(qint64 size, quint64 timestampNs) {
+    //Called before the chunk is dispatched, _rxBytes is where it starts.
+    _lineErrors.addOverrun(_rxBytes, size, timestampNs);
+    _lineErrors.sample();
+    publishLineErrors(size);
+    qDebug() << "Overrun in RX bytes" << _rxBytes << "to" << _rxBytes + size;
+}
+
+void
+MainWindow::publishLineErrors(qint64 rxLength) {
+    ShmTapLayout::LineErrorsPayload payload;
+    payload.rxOffset = _rxBytes;
+    payload.rxLength = static_cast<quint32>(rxLength);
+    payload.frame = static_cast<quint32>(_lineErrors.value(UartCounters::FrameErrors));
+    payload.parity = static_cast<quint32>(_lineErrors.value(UartCounters::ParityErrors));
+    payload.breaks = static_cast<quint32>(_lineErrors.value(UartCounters::Breaks));
+    payload.overrun = static_cast<quint32>(_lineErrors.value(UartCounters::Overruns));
+    payload.bufferOverrun = static_cast<quint32>(_lineErrors.value(UartCounters::BufferOverruns));
+    _tap.publish(ShmTapLayout::LineErrors, reinterpret_cast<const char *>(&payload), sizeof(payload));
+}
+
+void
+MainWindow::openMemoryAccounts() {
+    //Shrinkers are tried in category order, so the scrollback is only spilled
+    //once dropping the caches was not enough.
+    _memory->add(MemoryGovernor::Caches, tr("Console glyphs"), [this]() { return _console->cacheBytes(); },
+                 [this](qint64 bytes) { Q_UNUSED(bytes); return _console->trimCaches(); });
+    _memory->add(MemoryGovernor::Caches, tr("Frame list"), [this]() { return _frameView->cacheBytes(); },
+                 [this](qint64 bytes) { return _frameView->trim(bytes); });
+    _memory->add(MemoryGovernor::Indexes, tr("Search hits"), [this]() { return _searchBar->indexBytes(); });
+    _memory->add(MemoryGovernor::Indexes, tr("Filter views"), [this]() -> qint64 {
+        qint64 bytes = 0;
+        for(const FilterView *view : _filterViews) {
+            bytes += view->indexBytes();
+        }
+        return bytes;
+    });
+    _memory->add(MemoryGovernor::Indexes, tr("Channels"), [this]() { return _channelView->indexBytes(); });
+    _memory->add(MemoryGovernor::RxQueues, tr("Receive buffer pool"), [this]() {
+        return _rxPool.blockCount() * _rxPool.blockSize();
+    });
+    _memory->add(MemoryGovernor::RxQueues, tr("Port read buffer"), [this]() { return _serial->bytesAvailable(); });
+    _memory->add(MemoryGovernor::TxQueues, tr("Port write buffer"), [this]() {
+        return _serial->bytesToWrite() + (_io ? _io->pendingTxBytes() : 0);
+    });
+    _memory->add(MemoryGovernor::Scrollback, tr("Console"), [this]() { return _console->lineStore().ownedBytes(); },
+                 [this](qint64 bytes) { Q_UNUSED(bytes); return spillScrollback(); });
+    _memory->add(MemoryGovernor::Scrollback, tr("Merged ports"), [this]() { return _mergedView->portBytes(); },
+                 [this](qint64 bytes) { Q_UNUSED(bytes); return _mergedView->spillPorts(spillDirectory()); });
+    updateMemoryStatus();
+}
+
+qint64
+MainWindow::spillScrollback() {
+    if(_session.isOpen()) {
+        syncSession();
+        return _session.isOpen() ? _console->spillToSession(_session) : 0;
+    }
+
+    //No session to hold the lines: an unnamed file takes them instead. It is
+    //caught up a step per call here and on the session timer, so the first
+    //spill does not write the whole scrollback at once.
+    if(!_spillFile.isOpen() && !_spillFile.createAnonymous(spillDirectory())) {
+        showStatusMessage(tr("Scrollback not spilled: %1").arg(_spillFile.errorString()));
+        return 0;
+    }
+    syncSpillFile();
+    return _spillFile.isOpen() ? _console->spillToSession(_spillFile) : 0;
+}
+
+void
+MainWindow::syncSpillFile() {
+    if(_spillFile.isOpen() && !_spillFile.sync(_console->lineStore(), SessionFile::SPILL_STEP)) {
+        showStatusMessage(tr("Scrollback not spilled: %1").arg(_spillFile.errorString()));
+        _spillFile.close();
+    }
+}
+
+void
+MainWindow::newFilterView() {
+    //Any number of these; each is an index into the console's lines.
+    FilterView *view = new FilterView(_console, QString());
+    view->setHighlightRules(_settings->settings().highlightRules);
+
+    QDockWidget *dock = new QDockWidget(view->title(), this);
+    dock->setObjectName(QStringLiteral("filterDock%1").arg(_filterViews.size()));
+    dock->setAttribute(Qt::WA_DeleteOnClose);
+    dock->setWidget(view);
+    addDockWidget(Qt::RightDockWidgetArea, dock);
+
+    _filterViews.append(view);
+    connect(view, &FilterView::titleChanged, dock, &QDockWidget::setWindowTitle);
+    connect(view, &QObject::destroyed, this, [this, view]() { _filterViews.removeOne(view); });
+}
+
+void
+MainWindow::openSession() {
+    const QString path = QFileDialog::getOpenFileName(this, tr("Open Session"),
+                                                      QFileInfo(defaultSessionPath()).absolutePath(),
+                                                      tr("Sessions (*.tsession);;All files (*)"));
+    if(path.isEmpty()) { return; }
+
+    //Check it before the current history is dropped for it.
+    SessionFile check;
+    if(!check.open(path)) {
+        QMessageBox::critical(this, tr("Error"), check.errorString());
+        return;
+    }
+    check.close();
+
+    syncSession();
+    _session.close();
+    _console->clear();
+    if(!_session.open(path)) {
+        QMessageBox::critical(this, tr("Error"), _session.errorString());
+        return;
+    }
+    if(!_session.profile().isEmpty() && !_settings->restoreProfile(_session.profile())) {
+        qWarning() << "Session: the connection profile in" << path << "cannot be read";
+    }
+    restoreSession();
+}
+
+void
+MainWindow::syncSession() {
+    if(_session.isOpen() && !_session.sync(_console->lineStore())) {
+        showStatusMessage(tr("Session not saved: %1").arg(_session.errorString()));
+        _session.close();
+    }
+}
+
+void
+MainWindow::sessionCleared() {
+    //The store is cleared next; the old file may still be mapped by it, so
+    //this is a new file rather than the old one truncated.
+    _spillFile.close();
+    if(!_session.isOpen()) { return; }
+    const QString path = _session.fileName();
+    if(_session.create(path)) {
+        _session.setProfile(_settings->profile());
+    }
+}
+
+void
+MainWindow::restoreSession() {
+    _console->restoreSession(_session);
+    for(FilterView *view : _filterViews) {
+        view->refresh();
+    }
+    _channelView->refresh();
+    _mergedView->refresh();
+    showStatusMessage(tr("Restored %1 lines from %2").arg(_session.lineCount()).arg(_session.fileName()));
+}
+
+void
+MainWindow::scheduledSend(int command, const QByteArray &data, quint64 dueNs) {
+    //QSerialPort path; the queued hop to this thread is part of the jitter.
+    if(!_serial->isOpen()) {
+        return;
+    }
+    const quint64 sentNs = monotonicNowNs();
+    writeData(data);
+    _scheduler->recordSend(command, dueNs, sentNs);
+}
+
+void
+MainWindow::scheduledSent(const QByteArray &data, quint64 timestampNs) {
+    dispatchTx(data, timestampNs);
+}
+
+void
+MainWindow::runScript() {
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Run Script"));
+    if(fileName.isEmpty()) {
+        return;
+    }
+
+    Script script;
+    if(!script.load(fileName)) {
+        QMessageBox::critical(this, tr("Error"), script.errorString());
+        return;
+    }
+    if(!_scripts->start()) {
+        QMessageBox::critical(this, tr("Error"), _scripts->errorString());
+        return;
+    }
+
+    //The script drives the open port alongside the console.
+    _scriptSession = _scripts->addSession(script, _settings->settings().name);
+    _ui->actionRunScript->setEnabled(false);
+    _ui->actionStopScript->setEnabled(true);
+    _scriptDock->show();
+    _scriptLog->appendPlainText(tr("Running %1").arg(script.name()));
+}
+
+void
+MainWindow::stopScript() {
+    if(_scriptSession) {
+        _scripts->cancel(_scriptSession);
+    }
+}
+
+void
+MainWindow::scriptSend(int session, const QByteArray &data) {
+    if(session == _scriptSession && !_console->isReadOnly()) {
+        writeData(data);
+    }
+}
+
+void
+MainWindow::scriptLine(int session, quint32 line, bool on) {
+    if(session == _scriptSession) {
+        setModemLine(line, on);
+    }
+}
+
+void
+MainWindow::scriptLogged(int session, const QString &text) {
+    Q_UNUSED(session);
+    _scriptLog->appendPlainText(text);
+}
+
+void
+MainWindow::scriptFinished(int session, bool passed, const QString &report) {
+    Q_UNUSED(passed);
+    _scriptLog->appendPlainText(report);
+    if(session == _scriptSession) {
+        _scriptSession = 0;
+        _ui->actionRunScript->setEnabled(!_console->isReadOnly());
+        _ui->actionStopScript->setEnabled(false);
+    }
 }
 
 void
 MainWindow::handleError(QSerialPort::SerialPortError error) {
+    _lineErrors.addPortError(error);
     if (error == QSerialPort::ResourceError) {
         QMessageBox::critical(this, tr("Critical Error"), _serial->errorString());
         closeSerialPort();
     }
 }
 
+void
+MainWindow::handleIoError(const QString &message) {
+    _lineErrors.add(UartCounters::ReadErrors);
+    QMessageBox::critical(this, tr("Critical Error"), message);
+    closeSerialPort();
+}
+
 void
 MainWindow::initActionsConnections() {
     connect(_ui->actionConnect, &QAction::triggered, this, &MainWindow::openSerialPort);
     connect(_ui->actionDisconnect, &QAction::triggered, this, &MainWindow::closeSerialPort);
     connect(_ui->actionQuit, &QAction::triggered, this, &MainWindow::close);
+    connect(_ui->actionOpenSession, &QAction::triggered, this, &MainWindow::openSession);
     connect(_ui->actionConfigure, &QAction::triggered, _settings, &SettingsDialog::show);
     connect(_ui->actionClear, &QAction::triggered, _console, &Console::clear);
+    connect(_ui->actionExport, &QAction::triggered, _console, &Console::exportLines);
+    connect(_ui->actionModbusAnalyzer, &QAction::toggled, _modbusDock, &QDockWidget::setVisible);
+    connect(_ui->actionFrames, &QAction::toggled, _frameDock, &QDockWidget::setVisible);
+    connect(_ui->actionStructs, &QAction::toggled, _structDock, &QDockWidget::setVisible);
+    connect(_ui->actionFind, &QAction::toggled, _searchDock, &QDockWidget::setVisible);
+    connect(_ui->actionNewFilter, &QAction::triggered, this, &MainWindow::newFilterView);
+    connect(_ui->actionScheduler, &QAction::toggled, _schedulerDock, &QDockWidget::setVisible);
+    connect(_ui->actionModemLines, &QAction::toggled, _modemDock, &QDockWidget::setVisible);
+    connect(_ui->actionLineErrors, &QAction::toggled, _lineErrorDock, &QDockWidget::setVisible);
+    connect(_ui->actionMemory, &QAction::toggled, _memoryDock, &QDockWidget::setVisible);
+    connect(_ui->actionJitter, &QAction::toggled, _jitterDock, &QDockWidget::setVisible);
+    connect(_ui->actionChannels, &QAction::toggled, _channelDock, &QDockWidget::setVisible);
+    connect(_ui->actionMergedView, &QAction::toggled, _mergedDock, &QDockWidget::setVisible);
+    connect(_ui->actionRunScript, &QAction::triggered, this, &MainWindow::runScript);
+    connect(_ui->actionStopScript, &QAction::triggered, this, &MainWindow::stopScript);
     connect(_ui->actionAbout, &QAction::triggered, this, &MainWindow::about);
     connect(_ui->actionAboutQt, &QAction::triggered, qApp, &QApplication::aboutQt);
 }
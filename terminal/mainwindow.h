@@ -52,12 +52,24 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "bufferpool.h"
+#include "framedecoder.h"
+#include "roundtripmeter.h"
+#include "sessionfile.h"
+#include "shmtap.h"
+#include "triggerengine.h"
+#include "uartcounters.h"
+
+#include <QFile>
 #include <QMainWindow>
 #include <QSerialPort>
 
 QT_BEGIN_NAMESPACE
 
+class QDockWidget;
 class QLabel;
+class QPlainTextEdit;
+class QTimer;
 
 namespace Ui {
 class MainWindow;
@@ -65,8 +77,26 @@ class MainWindow;
 
 QT_END_NAMESPACE
 
+class ChannelView;
+class CommandScheduler;
 class Console;
+class FilterView;
+class FrameView;
+class JitterView;
+class LineErrorView;
+class MemoryGovernor;
+class MemoryView;
+class MergedView;
+class ModbusView;
+class ModemLineMonitor;
+class ModemLineView;
+struct ModemLineEvent;
+class SchedulerView;
+class SearchBar;
+class ScriptRunner;
+class SerialIoThread;
 class SettingsDialog;
+class StructView;
 
 class MainWindow : public QMainWindow
 {
@@ -82,20 +112,120 @@ private slots:
     void about();
     void writeData(const QByteArray &data);
     void readData();
+    void readIoData();
+    void readTriggerHits();
+    void updateLatency();
+    void toggleModbusAnalyzer(bool visible);
+    void toggleFrameView(bool visible);
+    void toggleStructView(bool visible);
+    void toggleSchedulerView(bool visible);
+    void toggleSearchBar(bool visible);
+    void toggleModemLines(bool visible);
+    void toggleLineErrors(bool visible);
+    void toggleChannels(bool visible);
+    void toggleMergedView(bool visible);
+    void toggleMemoryView(bool visible);
+    void toggleJitterView(bool visible);
+    void updateMemoryStatus();
+    void updatePaintStatus();
+    void sampleLineErrors();
+    void readModemEdges();
+    void setModemLine(quint32 line, bool on);
+    void pulseModemLine(quint32 line, int widthMs);
+    void handleModemError(const QString &message);
+    void newFilterView();
+    void openSession();
+    void syncSession();
+    void syncSpillFile();
+    void sessionCleared();
+    void scheduledSend(int command, const QByteArray &data, quint64 dueNs);
+    void scheduledSent(const QByteArray &data, quint64 timestampNs);
+    void runScript();
+    void stopScript();
+    void scriptSend(int session, const QByteArray &data);
+    void scriptLine(int session, quint32 line, bool on);
+    void scriptLogged(int session, const QString &text);
+    void scriptFinished(int session, bool passed, const QString &report);
 
     void handleError(QSerialPort::SerialPortError error);
+    void handleIoError(const QString &message);
 
 private:
     void initActionsConnections();
 
 private:
     void showStatusMessage(const QString &message);
+    void dispatchRx(const ByteView &data, quint64 timestampNs);
+    void dispatchTx(const QByteArray &data, quint64 timestampNs);
+    void fireTriggers(const ByteView &data, quint64 timestampNs);
+    void handleTriggerHit(const TriggerHit &hit);
+    void startCapture(const QString &path);
+    void restoreSession();
+    void recordModemEdge(const ModemLineEvent &event);
+    void markOverrun(qint64 size, quint64 timestampNs);
+    void publishLineErrors(qint64 rxLength);
+    void openMemoryAccounts();
+    qint64 spillScrollback();
 
     Ui::MainWindow *_ui = nullptr;
     QLabel *_status = nullptr;
+    QLabel *_latency = nullptr;
+    QLabel *_triggerStatus = nullptr;
+    QLabel *_memoryStatus = nullptr;
+    QLabel *_paintStatus = nullptr;
+    QTimer *_latencyTimer = nullptr;
     Console *_console = nullptr;
+    ModbusView *_modbus = nullptr;
+    QDockWidget *_modbusDock = nullptr;
+    FrameView *_frameView = nullptr;
+    QDockWidget *_frameDock = nullptr;
+    CommandScheduler *_scheduler = nullptr;
+    SchedulerView *_schedulerView = nullptr;
+    QDockWidget *_schedulerDock = nullptr;
+    SearchBar *_searchBar = nullptr;
+    QDockWidget *_searchDock = nullptr;
+    ModemLineMonitor *_modemMonitor = nullptr;
+    ModemLineView *_modemView = nullptr;
+    QDockWidget *_modemDock = nullptr;
+    LineErrorView *_lineErrorView = nullptr;
+    QDockWidget *_lineErrorDock = nullptr;
+    ChannelView *_channelView = nullptr;
+    QDockWidget *_channelDock = nullptr;
+    MergedView *_mergedView = nullptr;
+    QDockWidget *_mergedDock = nullptr;
+    StructView *_structView = nullptr;
+    QDockWidget *_structDock = nullptr;
+    MemoryGovernor *_memory = nullptr;
+    MemoryView *_memoryView = nullptr;
+    QDockWidget *_memoryDock = nullptr;
+    JitterView *_jitterView = nullptr;
+    QDockWidget *_jitterDock = nullptr;
+    QList<FilterView *> _filterViews;
+    QPlainTextEdit *_scriptLog = nullptr;
+    QDockWidget *_scriptDock = nullptr;
+    ScriptRunner *_scripts = nullptr;
+    int _scriptSession = 0;
     SettingsDialog *_settings = nullptr;
     QSerialPort *_serial = nullptr;
+    SerialIoThread *_io = nullptr;
+    BufferPool _rxPool;
+    RoundTripMeter _roundTrip;
+    UartCounters _lineErrors;
+    //RX bytes since the port was opened, the offsets overruns are marked at.
+    quint64 _rxBytes = 0;
+    bool _markOverruns = false;
+    ShmTap _tap;
+    FrameDecoder *_framing = nullptr;
+    QVector<DecodedFrame> _frames;
+    TriggerEngine _triggers;
+    QVector<TriggerHit> _triggerHits;
+    QString _lastMark;
+    QFile _capture;
+    SessionFile _session;
+    //Scrollback spilled without a session, see spillScrollback().
+    SessionFile _spillFile;
+    QTimer *_sessionTimer = nullptr;
+    quint64 _connectedNs = 0;
 };
 
 #endif // MAINWINDOW_H
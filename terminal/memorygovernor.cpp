@@ -0,0 +1,158 @@
+#include "memorygovernor.h"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdio>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+static const char *const categoryNames[MemoryGovernor::CATEGORY_COUNT] = {
+    QT_TRANSLATE_NOOP("MemoryGovernor", "Caches"),
+    QT_TRANSLATE_NOOP("MemoryGovernor", "Indexes"),
+    QT_TRANSLATE_NOOP("MemoryGovernor", "RX queues"),
+    QT_TRANSLATE_NOOP("MemoryGovernor", "TX queues"),
+    QT_TRANSLATE_NOOP("MemoryGovernor", "Scrollback")
+};
+
+static const qint64 MIB = qint64(1) << 20;
+
+MemoryGovernor::MemoryGovernor(QObject *parent) :
+    QObject(parent),
+    _timer(new QTimer(this)),
+    _budget(defaultBudget())
+{
+    _timer->setInterval(SAMPLE_MS);
+    connect(_timer, &QTimer::timeout, this, &MemoryGovernor::sample);
+    _timer->start();
+}
+
+QString
+MemoryGovernor::categoryName(Category category) {
+    return QCoreApplication::translate("MemoryGovernor", categoryNames[category]);
+}
+
+QString
+MemoryGovernor::formatBytes(qint64 bytes) {
+    if (bytes >= MIB) {
+        return tr("%1 MiB").arg(static_cast<double>(bytes) / MIB, 0, 'f', 1);
+    }
+    if (bytes >= 1024) {
+        return tr("%1 KiB").arg(static_cast<double>(bytes) / 1024, 0, 'f', 1);
+    }
+    return tr("%1 B").arg(bytes);
+}
+
+#ifdef Q_OS_LINUX
+
+qint64
+MemoryGovernor::defaultBudget() {
+    const long pages = ::sysconf(_SC_PHYS_PAGES);
+    const long pageSize = ::sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) { return 512 * MIB; }
+    return static_cast<qint64>(pages) * pageSize / 4;
+}
+
+qint64
+MemoryGovernor::residentBytes() {
+    std::FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) { return 0; }
+    long size = 0;
+    long resident = 0;
+    const int fields = std::fscanf(statm, "%ld %ld", &size, &resident);
+    std::fclose(statm);
+    return fields == 2 ? static_cast<qint64>(resident) * ::sysconf(_SC_PAGESIZE) : 0;
+}
+
+#else
+
+qint64
+MemoryGovernor::defaultBudget() {
+    return 512 * MIB;
+}
+
+qint64
+MemoryGovernor::residentBytes() {
+    return 0;
+}
+
+#endif
+
+int
+MemoryGovernor::add(Category category, const QString &name, const UsageFunction &usage,
+                    const ShrinkFunction &shrink) {
+    Account account;
+    account.id = _nextId++;
+    account.category = category;
+    account.name = name;
+    account.usage = usage;
+    account.shrink = shrink;
+    account.bytes = usage();
+    account.peak = account.bytes;
+    _accounts.append(account);
+    return account.id;
+}
+
+void
+MemoryGovernor::remove(int id) {
+    for (int x = 0; x < _accounts.size(); x++) {
+        if (_accounts.at(x).id == id) {
+            _accounts.remove(x);
+            return;
+        }
+    }
+}
+
+void
+MemoryGovernor::sample() {
+    _measure();
+    if (_total > _budget) {
+        _pressure++;
+        if (_shrink(_total - _budget / 100 * LOW_WATER_PERCENT) > 0) {
+            _measure();
+        }
+    }
+    _resident = residentBytes();
+    emit sampled();
+}
+
+void
+MemoryGovernor::shrinkAll() {
+    _measure();
+    _shrink(_total);
+    sample();
+}
+
+void
+MemoryGovernor::_measure() {
+    std::fill(_categories, _categories + CATEGORY_COUNT, 0);
+    _total = 0;
+    for (Account &account : _accounts) {
+        account.bytes = account.usage();
+        account.peak = std::max(account.peak, account.bytes);
+        _categories[account.category] += account.bytes;
+        _total += account.bytes;
+    }
+}
+
+qint64
+MemoryGovernor::_shrink(qint64 bytes) {
+    qint64 freed = 0;
+    for (int category = 0; category < CATEGORY_COUNT && freed < bytes; category++) {
+        for (int x = 0; x < _accounts.size() && freed < bytes; x++) {
+            Account &account = _accounts[x];
+            if (account.category != category || !account.shrink || account.bytes == 0) { continue; }
+
+            const qint64 got = account.shrink(bytes - freed);
+            if (got > 0) {
+                account.shrinks++;
+                account.freed += got;
+                freed += got;
+            }
+        }
+    }
+    return freed;
+}
@@ -0,0 +1,107 @@
+#ifndef MEMORYGOVERNOR_H
+#define MEMORYGOVERNOR_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+QT_END_NAMESPACE
+
+//Process-wide memory budget. Everything whose memory grows with the data
+//opens an account under one of the categories, with a function that reports
+//what it holds and, when it can give memory back (by dropping a cache,
+//evicting old entries or spilling to disk), one that frees at least the
+//bytes asked for and returns what it freed.
+//
+//The accounts are sampled on the GUI thread. When their total is over the
+//budget the shrinkable ones are asked for the excess, category by category
+//in the order below, cheapest to rebuild first, until the total is down to
+//LOW_WATER_PERCENT of the budget. Shrink functions must not add or remove
+//accounts.
+class MemoryGovernor : public QObject
+{
+    Q_OBJECT
+
+signals:
+    //After every sample, for the views.
+    void sampled();
+
+public:
+    enum Category {
+        Caches,
+        Indexes,
+        RxQueues,
+        TxQueues,
+        Scrollback,
+        CATEGORY_COUNT
+    };
+
+    typedef std::function<qint64()> UsageFunction;
+    typedef std::function<qint64(qint64 bytes)> ShrinkFunction;
+
+    struct Account {
+        int id = 0;
+        Category category = Caches;
+        QString name;
+        UsageFunction usage;
+        ShrinkFunction shrink;
+        qint64 bytes = 0;
+        qint64 peak = 0;
+        quint64 shrinks = 0;
+        qint64 freed = 0;
+    };
+
+    static const int SAMPLE_MS = 500;
+    static const int LOW_WATER_PERCENT = 90;
+
+    explicit MemoryGovernor(QObject *parent = nullptr);
+
+    static QString categoryName(Category category);
+    static QString formatBytes(qint64 bytes);
+    //A quarter of the physical memory, 512 MiB where that is unknown.
+    static qint64 defaultBudget();
+    //Resident set of the whole process, 0 where unknown.
+    static qint64 residentBytes();
+
+    //Returns the account id for remove().
+    int add(Category category, const QString &name, const UsageFunction &usage,
+            const ShrinkFunction &shrink = ShrinkFunction());
+    void remove(int id);
+
+    void setBudget(qint64 bytes) { _budget = bytes; }
+    qint64 budget() const { return _budget; }
+
+    //As of the last sample.
+    const QVector<Account> &accounts() const { return _accounts; }
+    qint64 total() const { return _total; }
+    qint64 categoryTotal(Category category) const { return _categories[category]; }
+    qint64 resident() const { return _resident; }
+    //Samples that found the total over the budget.
+    quint64 pressureCount() const { return _pressure; }
+
+public slots:
+    void sample();
+    //Asks every shrinkable account for all it can give back.
+    void shrinkAll();
+
+private:
+    void _measure();
+    qint64 _shrink(qint64 bytes);
+
+    QTimer *_timer = nullptr;
+    QVector<Account> _accounts;
+    int _nextId = 1;
+    qint64 _budget = 0;
+    qint64 _total = 0;
+    qint64 _categories[CATEGORY_COUNT] = {};
+    qint64 _resident = 0;
+    quint64 _pressure = 0;
+};
+
+#endif // MEMORYGOVERNOR_H
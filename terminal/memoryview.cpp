@@ -0,0 +1,134 @@
+#include "memoryview.h"
+#include "memorygovernor.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+enum Column {
+    NameColumn,
+    UsedColumn,
+    PeakColumn,
+    ShrinksColumn,
+    FreedColumn,
+    ColumnCount
+};
+
+MemoryView::MemoryView(MemoryGovernor *governor, QWidget *parent) :
+    QWidget(parent),
+    _governor(governor),
+    _tree(new QTreeWidget),
+    _summary(new QLabel),
+    _budget(new QSpinBox)
+{
+    _tree->setColumnCount(ColumnCount);
+    _tree->setHeaderLabels(QStringList() << tr("Account") << tr("Used") << tr("Peak") << tr("Shrinks") << tr("Freed"));
+    _tree->header()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+    _tree->header()->setStretchLastSection(false);
+    _tree->setRootIsDecorated(true);
+
+    _budget->setRange(64, 1 << 20);
+    _budget->setSingleStep(64);
+    _budget->setSuffix(tr(" MiB"));
+    _budget->setValue(static_cast<int>(_governor->budget() >> 20));
+    _budget->setToolTip(tr("Above this the caches, then the scrollback, are asked to give memory back"));
+
+    QPushButton *shrink = new QPushButton(tr("Shrink Now"));
+    shrink->setToolTip(tr("Drop caches and spill the scrollback to disk"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_summary, 1);
+    bar->addWidget(new QLabel(tr("Budget:")));
+    bar->addWidget(_budget);
+    bar->addWidget(shrink);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_tree, 1);
+
+    connect(_budget, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &MemoryView::_slot_budget);
+    connect(shrink, &QPushButton::clicked, _governor, &MemoryGovernor::shrinkAll);
+    connect(_governor, &MemoryGovernor::sampled, this, &MemoryView::_slot_update);
+}
+
+void
+MemoryView::setActive(bool active) {
+    _active = active;
+    if (active) {
+        _slot_update();
+    }
+}
+
+void
+MemoryView::_slot_budget(int mib) {
+    _governor->setBudget(static_cast<qint64>(mib) << 20);
+    _slot_update();
+}
+
+void
+MemoryView::_slot_update() {
+    if (!_active) { return; }
+
+    const QVector<MemoryGovernor::Account> &accounts = _governor->accounts();
+    QVector<int> ids;
+    for (const MemoryGovernor::Account &account : accounts) {
+        ids.append(account.id);
+    }
+    if (ids != _ids) {
+        _ids = ids;
+        _rebuild();
+    }
+
+    for (int category = 0; category < MemoryGovernor::CATEGORY_COUNT; category++) {
+        QTreeWidgetItem *item = _tree->topLevelItem(category);
+        item->setText(UsedColumn, MemoryGovernor::formatBytes(
+                          _governor->categoryTotal(static_cast<MemoryGovernor::Category>(category))));
+
+        //Children are in account order within their category.
+        int child = 0;
+        for (const MemoryGovernor::Account &account : accounts) {
+            if (account.category != category) { continue; }
+            QTreeWidgetItem *row = item->child(child++);
+            row->setText(UsedColumn, MemoryGovernor::formatBytes(account.bytes));
+            row->setText(PeakColumn, MemoryGovernor::formatBytes(account.peak));
+            row->setText(ShrinksColumn, account.shrink ? QString::number(account.shrinks) : tr("-"));
+            row->setText(FreedColumn, account.shrink ? MemoryGovernor::formatBytes(account.freed) : tr("-"));
+        }
+    }
+
+    const qint64 total = _governor->total();
+    const qint64 budget = _governor->budget();
+    QString text = tr("%1 of %2 (%3%)").arg(MemoryGovernor::formatBytes(total), MemoryGovernor::formatBytes(budget))
+                   .arg(budget > 0 ? 100.0 * total / budget : 0, 0, 'f', 0);
+    if (_governor->resident() > 0) {
+        text += tr(", process resident %1").arg(MemoryGovernor::formatBytes(_governor->resident()));
+    }
+    if (_governor->pressureCount() > 0) {
+        text += tr(", over budget %1 times").arg(_governor->pressureCount());
+    }
+    _summary->setText(text);
+}
+
+void
+MemoryView::_rebuild() {
+    _tree->clear();
+    for (int category = 0; category < MemoryGovernor::CATEGORY_COUNT; category++) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(_tree);
+        item->setText(NameColumn, MemoryGovernor::categoryName(static_cast<MemoryGovernor::Category>(category)));
+        item->setExpanded(true);
+        for (const MemoryGovernor::Account &account : _governor->accounts()) {
+            if (account.category != category) { continue; }
+            QTreeWidgetItem *row = new QTreeWidgetItem(item);
+            row->setText(NameColumn, account.name);
+            for (int column = UsedColumn; column < ColumnCount; column++) {
+                row->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+            }
+        }
+        item->setTextAlignment(UsedColumn, Qt::AlignRight | Qt::AlignVCenter);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef MEMORYVIEW_H
+#define MEMORYVIEW_H
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QLabel;
+class QSpinBox;
+class QTreeWidget;
+
+QT_END_NAMESPACE
+
+class MemoryGovernor;
+
+//Dockable live view of the memory governor: the accounts by category with
+//their current and peak size and what shrinking gave back, the total against
+//the budget and the resident size of the process for comparison.
+class MemoryView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryView(MemoryGovernor *governor, QWidget *parent = nullptr);
+
+    void setActive(bool active);
+    bool isActive() const { return _active; }
+
+private slots:
+    void _slot_budget(int mib);
+    void _slot_update();
+
+private:
+    void _rebuild();
+
+    MemoryGovernor *_governor = nullptr;
+    QTreeWidget *_tree = nullptr;
+    QLabel *_summary = nullptr;
+    QSpinBox *_budget = nullptr;
+    QVector<int> _ids;
+    bool _active = false;
+};
+
+#endif // MEMORYVIEW_H
@@ -0,0 +1,138 @@
+#include "mergedlines.h"
+#include "linestore.h"
+
+#include <algorithm>
+
+qint64
+MergedLines::rowCount() const {
+    qint64 rows = 0;
+    for (const LineStore *store : _stores) {
+        rows += store->completedLineCount();
+    }
+    return rows;
+}
+
+void
+MergedLines::rows(qint64 first, int count, QVector<Row> &rows) const {
+    rows.resize(0);
+    const int sources = _sourceCount();
+    if (!sources || count <= 0) { return; }
+
+    //Lines completing meanwhile (on another thread) are left for the next call.
+    qint64 counts[MAX_SOURCES];
+    qint64 positions[MAX_SOURCES];
+    qint64 total = 0;
+    for (int s = 0; s < sources; s++) {
+        counts[s] = _stores.at(s)->completedLineCount();
+        total += counts[s];
+    }
+    if (first < 0 || first >= total) { return; }
+
+    _seek(first, counts, positions);
+    for (int x = 0; x < count; x++) {
+        const int s = _next(counts, positions);
+        if (s < 0) { break; }
+        Row row;
+        row.source = s;
+        row.line = positions[s]++;
+        rows.append(row);
+    }
+}
+
+qint64
+MergedLines::rowOf(int source, qint64 line) const {
+    const int sources = _sourceCount();
+    if (source < 0 || source >= sources) { return -1; }
+
+    //Everything ordered before it: earlier timestamps, and equal ones from
+    //sources before it.
+    const quint64 t = _stores.at(source)->timestamp(line);
+    qint64 row = line;
+    for (int s = 0; s < sources; s++) {
+        if (s == source) { continue; }
+        const LineStore &store = *_stores.at(s);
+        row += _below(store, store.completedLineCount(), s < source ? t + 1 : t);
+    }
+    return row;
+}
+
+qint64
+MergedLines::_below(const LineStore &store, qint64 count, quint64 t) {
+    qint64 low = 0;
+    qint64 high = count;
+    while (low < high) {
+        const qint64 mid = low + (high - low) / 2;
+        if (store.timestamp(mid) < t) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void
+MergedLines::_seek(qint64 row, const qint64 *counts, qint64 *positions) const {
+    const int sources = _sourceCount();
+
+    auto below = [&](quint64 t) {
+        qint64 lines = 0;
+        for (int s = 0; s < sources; s++) {
+            lines += _below(*_stores.at(s), counts[s], t);
+        }
+        return lines;
+    };
+
+    //The latest time with at most row lines before it; the row is at that
+    //time. Nothing is before time 0, everything before the last time + 1.
+    quint64 low = 0;
+    quint64 high = 1;
+    for (int s = 0; s < sources; s++) {
+        if (counts[s]) { high = std::max(high, _stores.at(s)->timestamp(counts[s] - 1) + 1); }
+    }
+    while (high - low > 1) {
+        const quint64 mid = low + (high - low) / 2;
+        if (below(mid) <= row) {
+            low = mid;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    //Lines at exactly that time go by source.
+    qint64 left = row;
+    for (int s = 0; s < sources; s++) {
+        positions[s] = _below(*_stores.at(s), counts[s], low);
+        left -= positions[s];
+    }
+    for (int s = 0; s < sources && left > 0; s++) {
+        const qint64 at = _below(*_stores.at(s), counts[s], low + 1) - positions[s];
+        const qint64 take = std::min(at, left);
+        positions[s] += take;
+        left -= take;
+    }
+    //Only when timestamps are out of order.
+    while (left-- > 0) {
+        const int s = _next(counts, positions);
+        if (s < 0) { break; }
+        positions[s]++;
+    }
+}
+
+int
+MergedLines::_next(const qint64 *counts, const qint64 *positions) const {
+    const int sources = _sourceCount();
+    int next = -1;
+    quint64 earliest = 0;
+    for (int s = 0; s < sources; s++) {
+        if (positions[s] >= counts[s]) { continue; }
+        const quint64 t = _stores.at(s)->timestamp(positions[s]);
+        if (next < 0 || t < earliest) {
+            next = s;
+            earliest = t;
+        }
+    }
+    return next;
+}
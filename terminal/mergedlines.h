@@ -0,0 +1,52 @@
+#ifndef MERGEDLINES_H
+#define MERGEDLINES_H
+
+#include <QVector>
+
+#include <algorithm>
+
+class LineStore;
+
+//The completed lines of several LineStores as one sequence ordered by receive
+//timestamp (ties by source, then line), without building it. Any row of the
+//merged sequence is found by a binary search on time over every source, and
+//the rows after it by stepping a k-way merge, so showing a window of rows
+//costs O(k log n + rows * k) whatever the length of the history.
+//
+//Each store's timestamps are expected to rise with the line number, which
+//holds for lines received in one run; lines out of order (a restored session
+//from before a reboot) are merged where the search happens to put them.
+class MergedLines
+{
+public:
+    struct Row {
+        int source = -1;
+        qint64 line = -1;
+    };
+
+    static const int MAX_SOURCES = 16;
+
+    //Stores are not owned and must outlive their use here.
+    void setSources(const QVector<const LineStore *> &stores) { _stores = stores; }
+    int sourceCount() const { return _stores.size(); }
+    const LineStore &store(int source) const { return *_stores.at(source); }
+
+    qint64 rowCount() const;
+    //Replaces rows with up to count rows starting at row first.
+    void rows(qint64 first, int count, QVector<Row> &rows) const;
+    //The row at which line of source is shown.
+    qint64 rowOf(int source, qint64 line) const;
+
+private:
+    int _sourceCount() const { return std::min(_stores.size(), int(MAX_SOURCES)); }
+    //Lines of store with a timestamp below t, among the first count.
+    static qint64 _below(const LineStore &store, qint64 count, quint64 t);
+    //For the merged row, the line of every source the merge is at.
+    void _seek(qint64 row, const qint64 *counts, qint64 *positions) const;
+    //The source the next row comes from, -1 after the last.
+    int _next(const qint64 *counts, const qint64 *positions) const;
+
+    QVector<const LineStore *> _stores;
+};
+
+#endif // MERGEDLINES_H
@@ -0,0 +1,342 @@
+#include "mergedview.h"
+#include "console.h"
+#include "portsource.h"
+
+#include <QComboBox>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QIntValidator>
+#include <QLabel>
+#include <QListWidget>
+#include <QPainter>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSerialPortInfo>
+#include <QSignalBlocker>
+#include <QVBoxLayout>
+
+static const int COLOR_BAR_WIDTH = 4;
+
+static const char *const sourceColors[] = {
+    "#1f77b4", "#d62728", "#2ca02c", "#9467bd", "#ff7f0e", "#8c564b", "#e377c2", "#17becf"
+};
+
+MergedCanvas::MergedCanvas(QWidget *parent) :
+    QAbstractScrollArea(parent)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+}
+
+void
+MergedCanvas::setSources(const QVector<const LineStore *> &stores, const QStringList &names, const QVector<QColor> &colors) {
+    _lines.setSources(stores);
+    _names = names;
+    _colors = colors;
+
+    const QFontMetrics metrics(font());
+    _nameWidth = 0;
+    for (const QString &name : names) {
+        _nameWidth = qMax(_nameWidth, metrics.horizontalAdvance(name));
+    }
+    _updateScrollBar();
+    verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    viewport()->update();
+}
+
+void
+MergedCanvas::refresh() {
+    QScrollBar *bar = verticalScrollBar();
+    const bool followTail = bar->value() >= bar->maximum();
+    _updateScrollBar();
+    if (followTail) {
+        bar->setValue(bar->maximum());
+    }
+    viewport()->update();
+}
+
+void
+MergedCanvas::paintEvent(QPaintEvent *e) {
+    Q_UNUSED(e);
+
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), palette().color(QPalette::Base));
+
+    //One row more above the first on screen, for its gap.
+    const qint64 top = verticalScrollBar()->value();
+    const qint64 first = qMax<qint64>(0, top - 1);
+    _lines.rows(first, _visibleRows() + static_cast<int>(top - first), _rows);
+    if (_rows.isEmpty()) { return; }
+
+    quint64 origin = 0;
+    bool hasOrigin = false;
+    for (int s = 0; s < _lines.sourceCount(); s++) {
+        const LineStore &store = _lines.store(s);
+        if (store.completedLineCount() && (!hasOrigin || store.timestamp(0) < origin)) {
+            origin = store.timestamp(0);
+            hasOrigin = true;
+        }
+    }
+
+    const QFontMetrics metrics(font());
+    const int lineHeight = metrics.height();
+    const int timeWidth = metrics.horizontalAdvance(QStringLiteral("00000.000000 "));
+    const int gapWidth = metrics.horizontalAdvance(QStringLiteral("+0.000000 "));
+    const int nameX = COLOR_BAR_WIDTH + 4 + timeWidth + gapWidth;
+    const int textX = nameX + _nameWidth + metrics.horizontalAdvance(QLatin1Char(' ')) * 2;
+    const int columns = qMax(1, (viewport()->width() - textX) / qMax(1, metrics.horizontalAdvance(QLatin1Char('M'))) + 1);
+    const QColor dim = palette().color(QPalette::Mid);
+
+    quint64 previous = 0;
+    int y = 0;
+    for (int x = 0; x < _rows.size(); x++) {
+        const MergedLines::Row &row = _rows.at(x);
+        const LineStore &store = _lines.store(row.source);
+        const quint64 timestampNs = store.timestamp(row.line);
+        const quint64 gapNs = x ? (timestampNs > previous ? timestampNs - previous : 0) : 0;
+        previous = timestampNs;
+        if (first + x < top) { continue; }
+
+        const QColor color = _colors.value(row.source, palette().color(QPalette::Text));
+        const int baseline = y + metrics.ascent();
+        painter.fillRect(0, y, COLOR_BAR_WIDTH, lineHeight, color);
+
+        painter.setPen(dim);
+        painter.drawText(COLOR_BAR_WIDTH + 4, baseline,
+                         QString::number((timestampNs - origin) / 1e9, 'f', 6));
+        if (first + x > 0) {
+            painter.drawText(COLOR_BAR_WIDTH + 4 + timeWidth, baseline,
+                             QStringLiteral("+%1").arg(gapNs / 1e9, 0, 'f', 6));
+        }
+
+        painter.setPen(color);
+        painter.drawText(nameX, baseline, _names.value(row.source));
+        const ByteView text = store.text(row.line);
+        painter.drawText(textX, baseline,
+                         QString::fromLocal8Bit(text.data, static_cast<int>(qMin<qint64>(text.size, columns))));
+        y += lineHeight;
+    }
+}
+
+void
+MergedCanvas::resizeEvent(QResizeEvent *e) {
+    QAbstractScrollArea::resizeEvent(e);
+    _updateScrollBar();
+}
+
+void
+MergedCanvas::scrollContentsBy(int dx, int dy) {
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+    viewport()->update();
+}
+
+int
+MergedCanvas::_visibleRows() const {
+    return qMax(1, viewport()->height() / qMax(1, QFontMetrics(font()).height()));
+}
+
+void
+MergedCanvas::_updateScrollBar() {
+    const int visible = _visibleRows();
+    verticalScrollBar()->setPageStep(visible);
+    verticalScrollBar()->setRange(0, static_cast<int>(qMax<qint64>(0, _lines.rowCount() - visible)));
+}
+
+MergedView::MergedView(Console *main, QWidget *parent) :
+    QWidget(parent),
+    _canvas(new MergedCanvas),
+    _list(new QListWidget),
+    _port(new QComboBox),
+    _baudRate(new QComboBox),
+    _status(new QLabel)
+{
+    _list->setMaximumHeight(_list->fontMetrics().height() * 4 + 8);
+    _list->setToolTip(tr("Sources in the merge; uncheck one to hide its lines"));
+    _baudRate->setEditable(true);
+    _baudRate->setValidator(new QIntValidator(1, 12000000, this));
+    for (const char *rate : { "9600", "19200", "38400", "57600", "115200", "230400", "460800", "921600" }) {
+        _baudRate->addItem(QLatin1String(rate));
+    }
+    _baudRate->setCurrentText(QStringLiteral("115200"));
+
+    QPushButton *add = new QPushButton(tr("Add Port"));
+    QPushButton *remove = new QPushButton(tr("Remove"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_port);
+    bar->addWidget(_baudRate);
+    bar->addWidget(add);
+    bar->addWidget(remove);
+    bar->addWidget(_status, 1);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_list);
+    layout->addWidget(_canvas, 1);
+
+    Source source;
+    source.name = tr("Main");
+    source.store = &main->lineStore();
+    source.color = QColor(QLatin1String(sourceColors[0]));
+    _sources.append(source);
+
+    connect(add, &QPushButton::clicked, this, &MergedView::_slot_add);
+    connect(remove, &QPushButton::clicked, this, &MergedView::_slot_remove);
+    connect(_list, &QListWidget::itemChanged, this, &MergedView::_slot_sourceChanged);
+    //Queued: the store is only empty once the clear has returned.
+    connect(main, &Console::aboutToClear, this, &MergedView::_slot_refresh, Qt::QueuedConnection);
+
+    _updateSources();
+}
+
+void
+MergedView::setActive(bool active) {
+    _active = active;
+    if (active) {
+        _updatePorts();
+        _canvas->refresh();
+    }
+}
+
+void
+MergedView::refresh() {
+    if (_active) {
+        _canvas->refresh();
+    }
+}
+
+void
+MergedView::setMainName(const QString &name) {
+    _sources[0].name = name;
+    _updateSources();
+}
+
+qint64
+MergedView::portBytes() const {
+    qint64 bytes = 0;
+    for (const Source &source : _sources) {
+        if (source.port) { bytes += source.store->ownedBytes(); }
+    }
+    return bytes;
+}
+
+qint64
+MergedView::spillPorts(const QString &directory) {
+    qint64 freed = 0;
+    for (const Source &source : _sources) {
+        if (source.port) { freed += source.port->spill(directory); }
+    }
+    return freed;
+}
+
+void
+MergedView::syncPorts() {
+    for (const Source &source : _sources) {
+        if (source.port) { source.port->syncSpill(); }
+    }
+}
+
+void
+MergedView::_slot_add() {
+    if (_sources.size() >= MergedLines::MAX_SOURCES) {
+        _status->setText(tr("At most %1 sources").arg(MergedLines::MAX_SOURCES));
+        return;
+    }
+    const QString name = _port->currentData().toString();
+    if (name.isEmpty()) { return; }
+
+    PortSource *port = new PortSource(this);
+    if (!port->open(name, _baudRate->currentText().toInt())) {
+        _status->setText(QStringLiteral("%1: %2").arg(name, port->errorString()));
+        delete port;
+        return;
+    }
+    connect(port, &PortSource::linesAdded, this, &MergedView::_slot_refresh);
+    connect(port, &PortSource::errorOccurred, _status, &QLabel::setText);
+    connect(port, &PortSource::errorOccurred, this, &MergedView::errorOccurred);
+
+    Source source;
+    source.name = name;
+    source.store = &port->lineStore();
+    source.port = port;
+    source.color = QColor(QLatin1String(sourceColors[_sources.size() % (sizeof(sourceColors) / sizeof(sourceColors[0]))]));
+    _sources.append(source);
+    _status->clear();
+    _updateSources();
+}
+
+void
+MergedView::_slot_remove() {
+    const int row = _list->currentRow();
+    //The main console stays.
+    if (row <= 0 || row >= _sources.size()) { return; }
+
+    PortSource *port = _sources.at(row).port;
+    _sources.remove(row);
+    {
+        const QSignalBlocker blocker(_list);
+        delete _list->takeItem(row);
+    }
+    //Out of the merge before its lines go away.
+    _updateSources();
+    delete port;
+}
+
+void
+MergedView::_slot_sourceChanged(QListWidgetItem *item) {
+    Q_UNUSED(item);
+    _updateSources();
+}
+
+void
+MergedView::_slot_refresh() {
+    refresh();
+}
+
+void
+MergedView::_updatePorts() {
+    const QString current = _port->currentData().toString();
+    _port->clear();
+    const auto infos = QSerialPortInfo::availablePorts();
+    for (const QSerialPortInfo &info : infos) {
+        _port->addItem(info.portName(), info.portName());
+    }
+    const int index = _port->findData(current);
+    if (index >= 0) {
+        _port->setCurrentIndex(index);
+    }
+}
+
+void
+MergedView::_updateSources() {
+    //Keeps what was checked; new sources start checked.
+    QVector<bool> shown;
+    for (int x = 0; x < _sources.size(); x++) {
+        const QListWidgetItem *item = _list->item(x);
+        shown.append(!item || item->checkState() == Qt::Checked);
+    }
+
+    {
+        const QSignalBlocker blocker(_list);
+        _list->clear();
+        for (int x = 0; x < _sources.size(); x++) {
+            QListWidgetItem *item = new QListWidgetItem(_sources.at(x).name, _list);
+            item->setForeground(_sources.at(x).color);
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(shown.at(x) ? Qt::Checked : Qt::Unchecked);
+        }
+    }
+
+    QVector<const LineStore *> stores;
+    QStringList names;
+    QVector<QColor> colors;
+    for (int x = 0; x < _sources.size(); x++) {
+        if (!shown.at(x)) { continue; }
+        stores.append(_sources.at(x).store);
+        names.append(_sources.at(x).name);
+        colors.append(_sources.at(x).color);
+    }
+    _canvas->setSources(stores, names, colors);
+}
@@ -0,0 +1,104 @@
+#ifndef MERGEDVIEW_H
+#define MERGEDVIEW_H
+
+#include "mergedlines.h"
+
+#include <QAbstractScrollArea>
+#include <QColor>
+#include <QStringList>
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QComboBox;
+class QLabel;
+class QListWidget;
+class QListWidgetItem;
+
+QT_END_NAMESPACE
+
+class Console;
+class PortSource;
+
+//Draws the rows of a MergedLines: receive time, the gap to the row above,
+//the source and the text, in the source's color. Only the rows on screen are
+//merged, on every paint.
+class MergedCanvas : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit MergedCanvas(QWidget *parent = nullptr);
+
+    void setSources(const QVector<const LineStore *> &stores, const QStringList &names, const QVector<QColor> &colors);
+    //After lines were added to a source; keeps following the end.
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent *e) override;
+    void resizeEvent(QResizeEvent *e) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    int _visibleRows() const;
+    void _updateScrollBar();
+
+    MergedLines _lines;
+    QStringList _names;
+    QVector<QColor> _colors;
+    QVector<MergedLines::Row> _rows;
+    int _nameWidth = 0;
+};
+
+//Dockable panel merging the main console's lines with those of further ports
+//opened here, by receive time, into one timeline colored by source. Sources
+//can be hidden from the merge; extra ports are only received from.
+class MergedView : public QWidget
+{
+    Q_OBJECT
+
+signals:
+    void errorOccurred(const QString &message);
+
+public:
+    explicit MergedView(Console *main, QWidget *parent = nullptr);
+
+    void setActive(bool active);
+    bool isActive() const { return _active; }
+
+    //After new data was shown in the main console.
+    void refresh();
+    void setMainName(const QString &name);
+    //Heap held by the lines of the added ports.
+    qint64 portBytes() const;
+    //PortSource::spill() and syncSpill() for every added port.
+    qint64 spillPorts(const QString &directory);
+    void syncPorts();
+
+private slots:
+    void _slot_add();
+    void _slot_remove();
+    void _slot_sourceChanged(QListWidgetItem *item);
+    void _slot_refresh();
+
+private:
+    struct Source {
+        QString name;
+        const LineStore *store = nullptr;
+        PortSource *port = nullptr;
+        QColor color;
+    };
+
+    void _updatePorts();
+    void _updateSources();
+
+    MergedCanvas *_canvas = nullptr;
+    QListWidget *_list = nullptr;
+    QComboBox *_port = nullptr;
+    QComboBox *_baudRate = nullptr;
+    QLabel *_status = nullptr;
+    QVector<Source> _sources;
+    bool _active = false;
+};
+
+#endif // MERGEDVIEW_H
@@ -0,0 +1,185 @@
+#include "modbusanalyzer.h"
+#include "crc16.h"
+
+#include <QStringList>
+
+void
+ModbusRtuAnalyzer::configure(qint32 baudRate, QSerialPort::DataBits dataBits,
+                             QSerialPort::Parity parity, QSerialPort::StopBits stopBits) {
+    //start bit + data bits + parity + stop bits, in half bits to allow 1.5 stop bits
+    int halfBits = 2 + 2 * (dataBits > 0 ? static_cast<int>(dataBits) : 8);
+    if (parity != QSerialPort::NoParity) { halfBits += 2; }
+    halfBits += stopBits == QSerialPort::TwoStop ? 4 : (stopBits == QSerialPort::OneAndHalfStop ? 3 : 2);
+
+    const quint64 baud = baudRate > 0 ? static_cast<quint64>(baudRate) : 9600;
+    _charNs = (static_cast<quint64>(halfBits) * 1000000000ull) / (2 * baud);
+
+    //The specification fixes t3.5 at 1.75 ms above 19200 baud.
+    _silenceNs = baud > 19200 ? 1750000 : (_charNs * 7) / 2;
+
+    for (Stream &stream : _stream) {
+        stream.bytes.reserve(MAX_FRAME);
+        stream.bytes.resize(0);
+        stream.lastByteNs = 0;
+    }
+}
+
+void
+ModbusRtuAnalyzer::feed(const ByteView &data, quint64 timestampNs, bool tx) {
+    if (data.isEmpty()) { return; }
+
+    Stream &stream = _stream[tx ? 1 : 0];
+
+    //The chunk was read when its last byte arrived; its first byte started
+    //roughly one character time per byte earlier.
+    const quint64 span = _charNs * static_cast<quint64>(data.size);
+    const quint64 firstNs = timestampNs > span ? timestampNs - span : 0;
+    const quint64 gapNs = (stream.lastByteNs && firstNs > stream.lastByteNs) ? firstNs - stream.lastByteNs : 0;
+
+    if (!stream.bytes.isEmpty() && gapNs >= _silenceNs) {
+        _complete(stream, tx);
+    }
+
+    const char *p = data.data;
+    qint64 remaining = data.size;
+    while (remaining > 0) {
+        if (stream.bytes.isEmpty()) {
+            stream.firstByteNs = firstNs + _charNs * static_cast<quint64>(data.size - remaining);
+            stream.gapNs = remaining == data.size ? gapNs : 0;
+        }
+
+        const qint64 room = MAX_FRAME - stream.bytes.size();
+        const qint64 count = remaining < room ? remaining : room;
+        stream.bytes.append(p, static_cast<int>(count));
+        p += count;
+        remaining -= count;
+
+        //No valid RTU frame is longer; cut it so a lost boundary cannot grow forever.
+        if (stream.bytes.size() >= MAX_FRAME) {
+            _complete(stream, tx);
+        }
+    }
+
+    stream.lastByteNs = timestampNs;
+}
+
+void
+ModbusRtuAnalyzer::poll(quint64 nowNs) {
+    for (int x = 0; x < 2; x++) {
+        Stream &stream = _stream[x];
+        if (!stream.bytes.isEmpty() && nowNs > stream.lastByteNs && nowNs - stream.lastByteNs >= _silenceNs) {
+            _complete(stream, x == 1);
+        }
+    }
+}
+
+void
+ModbusRtuAnalyzer::_complete(Stream &stream, bool tx) {
+    ModbusFrame frame;
+    frame.timestampNs = stream.firstByteNs;
+    frame.gapNs = stream.gapNs;
+    frame.tx = tx;
+    frame.bytes = QByteArray(stream.bytes.constData(), stream.bytes.size());
+    //Running the CRC over the message and its (little-endian) CRC leaves zero.
+    frame.crcOk = frame.bytes.size() >= 4 && Crc16::modbus(frame.bytes.constData(), frame.bytes.size()) == 0;
+
+    _frameCount++;
+    if (!frame.crcOk) { _crcErrors++; }
+    _frames.append(frame);
+
+    //resize() keeps the reserved capacity for the next frame.
+    stream.bytes.resize(0);
+}
+
+QString
+ModbusRtuAnalyzer::functionName(quint8 function) {
+    switch (function & 0x7F) {
+    case 1: return QStringLiteral("Read Coils");
+    case 2: return QStringLiteral("Read Discrete Inputs");
+    case 3: return QStringLiteral("Read Holding Registers");
+    case 4: return QStringLiteral("Read Input Registers");
+    case 5: return QStringLiteral("Write Single Coil");
+    case 6: return QStringLiteral("Write Single Register");
+    case 8: return QStringLiteral("Diagnostics");
+    case 15: return QStringLiteral("Write Multiple Coils");
+    case 16: return QStringLiteral("Write Multiple Registers");
+    case 17: return QStringLiteral("Report Server ID");
+    case 23: return QStringLiteral("Read/Write Multiple Registers");
+    default: return QStringLiteral("Function %1").arg(function & 0x7F);
+    }
+}
+
+static quint16
+word(const QByteArray &bytes, int pos) {
+    return static_cast<quint16>((static_cast<uchar>(bytes.at(pos)) << 8) | static_cast<uchar>(bytes.at(pos + 1)));
+}
+
+QString
+ModbusRtuAnalyzer::describe(const ModbusFrame &frame, bool response) {
+    const QByteArray &b = frame.bytes;
+    if (b.size() < 4) {
+        return QStringLiteral("short frame: %1").arg(QString::fromLatin1(b.toHex(' ')));
+    }
+
+    const quint8 function = static_cast<quint8>(b.at(1));
+    const int payload = b.size() - 4;   //between function code and CRC
+
+    if (function & 0x80) {
+        static const char *const reasons[] = {
+            "", "illegal function", "illegal data address", "illegal data value",
+            "server device failure", "acknowledge", "server device busy", "",
+            "memory parity error", "", "gateway path unavailable", "gateway target failed to respond"
+        };
+        const quint8 code = static_cast<quint8>(b.at(2));
+        return QStringLiteral("exception %1 %2").arg(code)
+                .arg(QLatin1String(code < 12 ? reasons[code] : ""));
+    }
+
+    switch (function) {
+    case 1: case 2: case 3: case 4:
+        if (payload == 4 && !response) {
+            return QStringLiteral("start %1, count %2").arg(word(b, 2)).arg(word(b, 4));
+        }
+        if (payload >= 1 && payload == 1 + static_cast<uchar>(b.at(2))) {
+            if (function >= 3) {
+                QStringList values;
+                const int end = 3 + payload - 1;
+                for (int pos = 3; pos + 1 < end; pos += 2) {
+                    values << QString::number(word(b, pos));
+                }
+                return QStringLiteral("%1 registers: %2").arg(values.size()).arg(values.join(QLatin1Char(' ')));
+            }
+            return QStringLiteral("%1 bytes: %2").arg(payload - 1)
+                    .arg(QString::fromLatin1(b.mid(3, payload - 1).toHex(' ')));
+        }
+        break;
+
+    case 5:
+        if (payload == 4) {
+            return QStringLiteral("coil %1 = %2").arg(word(b, 2))
+                    .arg(word(b, 4) == 0xFF00 ? QStringLiteral("ON") : QStringLiteral("OFF"));
+        }
+        break;
+
+    case 6:
+        if (payload == 4) {
+            return QStringLiteral("register %1 = %2").arg(word(b, 2)).arg(word(b, 4));
+        }
+        break;
+
+    case 15: case 16:
+        if (payload == 4) {
+            return QStringLiteral("start %1, count %2").arg(word(b, 2)).arg(word(b, 4));
+        }
+        if (payload >= 5) {
+            return QStringLiteral("start %1, count %2, data %3").arg(word(b, 2)).arg(word(b, 4))
+                    .arg(QString::fromLatin1(b.mid(7, payload - 5).toHex(' ')));
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return QString::fromLatin1(b.mid(2, payload).toHex(' '));
+}
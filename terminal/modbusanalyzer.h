@@ -0,0 +1,73 @@
+#ifndef MODBUSANALYZER_H
+#define MODBUSANALYZER_H
+
+#include "bufferpool.h"
+
+#include <QByteArray>
+#include <QSerialPort>
+#include <QString>
+#include <QVector>
+
+struct ModbusFrame
+{
+    quint64 timestampNs = 0;   //estimated arrival of the first byte
+    quint64 gapNs = 0;         //silence on the line before the frame
+    bool tx = false;
+    bool crcOk = false;
+    QByteArray bytes;          //including the CRC
+};
+
+//Splits a Modbus RTU byte stream into frames using the 3.5 character silence
+//rule. The arrival time of the first byte of a chunk is estimated by backing
+//off one character time per byte from the chunk timestamp, and every frame is
+//checked with CRC-16.
+//
+//The framing is only as good as the timestamps. In low latency mode they are
+//taken on the I/O thread right after read(), so silences are measured on the
+//line. With QSerialPort they are taken on the GUI thread after the event loop
+//dispatched readyRead: silences shorter than that delay go unseen and frames
+//merge, a late dispatch can split one. ModbusView says so.
+class ModbusRtuAnalyzer
+{
+public:
+    static const int MAX_FRAME = 256;
+
+    void configure(qint32 baudRate, QSerialPort::DataBits dataBits,
+                   QSerialPort::Parity parity, QSerialPort::StopBits stopBits);
+
+    void feed(const ByteView &data, quint64 timestampNs, bool tx);
+
+    //Completes frames whose trailing silence has expired by nowNs.
+    void poll(quint64 nowNs);
+
+    bool hasPending() const { return !_stream[0].bytes.isEmpty() || !_stream[1].bytes.isEmpty(); }
+    QVector<ModbusFrame> &frames() { return _frames; }
+
+    quint64 charNs() const { return _charNs; }
+    quint64 silenceNs() const { return _silenceNs; }
+    quint64 frameCount() const { return _frameCount; }
+    quint64 crcErrors() const { return _crcErrors; }
+
+    static QString functionName(quint8 function);
+    static QString describe(const ModbusFrame &frame, bool response);
+
+private:
+    struct Stream
+    {
+        QByteArray bytes;
+        quint64 firstByteNs = 0;
+        quint64 lastByteNs = 0;
+        quint64 gapNs = 0;
+    };
+
+    void _complete(Stream &stream, bool tx);
+
+    quint64 _charNs = 1041666;      //9600 8N1
+    quint64 _silenceNs = 3645833;
+    Stream _stream[2];
+    QVector<ModbusFrame> _frames;
+    quint64 _frameCount = 0;
+    quint64 _crcErrors = 0;
+};
+
+#endif // MODBUSANALYZER_H
@@ -0,0 +1,230 @@
+#include "modbusview.h"
+#include "monotonicclock.h"
+
+#include <QCheckBox>
+#include <QColor>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableView>
+#include <QTimer>
+#include <QVBoxLayout>
+
+ModbusModel::ModbusModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+}
+
+void
+ModbusModel::append(QVector<ModbusFrame> &frames) {
+    if (frames.isEmpty()) { return; }
+
+    //More than MAX_ROWS at once: only the last MAX_ROWS are kept, and a
+    //request among the skipped ones has no response to pair with.
+    const int first = qMax(0, frames.size() - MAX_ROWS);
+    const int count = frames.size() - first;
+    if (first > 0) {
+        _pendingRequest = -1;
+    }
+
+    if (_rows.size() + count > MAX_ROWS) {
+        //Drop a whole block at once rather than one row per frame.
+        const int drop = qMin(_rows.size(), _rows.size() + count - MAX_ROWS + MAX_ROWS / 10);
+        if (drop > 0) {
+            beginRemoveRows(QModelIndex(), 0, drop - 1);
+            _rows.remove(0, drop);
+            _pendingRequest = _pendingRequest >= drop ? _pendingRequest - drop : -1;
+            endRemoveRows();
+        }
+    }
+
+    if (_rows.isEmpty() && _originNs == 0) {
+        _originNs = frames.at(first).timestampNs;
+    }
+
+    beginInsertRows(QModelIndex(), _rows.size(), _rows.size() + count - 1);
+    for (int x = first; x < frames.size(); x++) {
+        const ModbusFrame &frame = frames.at(x);
+        Row row;
+        row.frame = frame;
+
+        //A valid frame from the same unit with the same function (or its
+        //exception) right after a request is taken as the response to it.
+        if (_pendingRequest >= 0 && frame.crcOk) {
+            const ModbusFrame &request = _rows.at(_pendingRequest).frame;
+            const quint8 function = static_cast<quint8>(frame.bytes.at(1));
+            if (request.bytes.at(0) == frame.bytes.at(0)
+                    && (function & 0x7F) == static_cast<quint8>(request.bytes.at(1))) {
+                const quint64 requestEnd = request.timestampNs + _charNs * static_cast<quint64>(request.bytes.size());
+                row.response = true;
+                row.responseNs = frame.timestampNs > requestEnd ? static_cast<qint64>(frame.timestampNs - requestEnd) : 0;
+            }
+        }
+
+        _pendingRequest = (!row.response && frame.crcOk) ? _rows.size() : -1;
+        _rows.append(row);
+    }
+    endInsertRows();
+
+    frames.clear();
+}
+
+void
+ModbusModel::clear() {
+    beginResetModel();
+    _rows.clear();
+    _originNs = 0;
+    _pendingRequest = -1;
+    endResetModel();
+}
+
+int
+ModbusModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : _rows.size();
+}
+
+int
+ModbusModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant
+ModbusModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= _rows.size()) { return QVariant(); }
+
+    const Row &row = _rows.at(index.row());
+    const ModbusFrame &frame = row.frame;
+
+    if (role == Qt::ForegroundRole && !frame.crcOk) {
+        return QColor(Qt::red);
+    }
+    if (role != Qt::DisplayRole) { return QVariant(); }
+
+    //Strings are only built for rows that are actually on screen.
+    switch (index.column()) {
+    case TimeColumn:
+        return QString::number((frame.timestampNs - _originNs) / 1e9, 'f', 6);
+    case DirectionColumn:
+        return frame.tx ? tr("TX") : (row.response ? tr("RX resp") : tr("RX"));
+    case AddressColumn:
+        return frame.bytes.size() > 0 ? QVariant(static_cast<int>(static_cast<uchar>(frame.bytes.at(0)))) : QVariant();
+    case FunctionColumn:
+        return frame.bytes.size() > 1 ? ModbusRtuAnalyzer::functionName(static_cast<quint8>(frame.bytes.at(1))) : QString();
+    case DetailsColumn:
+        return ModbusRtuAnalyzer::describe(frame, row.response);
+    case CrcColumn:
+        return frame.crcOk ? tr("OK") : tr("BAD");
+    case GapColumn:
+        return QString::number(frame.gapNs / 1e6, 'f', 3);
+    case ResponseColumn:
+        return row.responseNs >= 0 ? QString::number(row.responseNs / 1e6, 'f', 3) : QString();
+    default:
+        return QVariant();
+    }
+}
+
+QVariant
+ModbusModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) { return QVariant(); }
+
+    switch (section) {
+    case TimeColumn: return tr("Time (s)");
+    case DirectionColumn: return tr("Dir");
+    case AddressColumn: return tr("Unit");
+    case FunctionColumn: return tr("Function");
+    case DetailsColumn: return tr("Details");
+    case CrcColumn: return tr("CRC");
+    case GapColumn: return tr("Gap (ms)");
+    case ResponseColumn: return tr("Resp (ms)");
+    default: return QVariant();
+    }
+}
+
+ModbusView::ModbusView(QWidget *parent) :
+    QWidget(parent),
+    _model(new ModbusModel(this)),
+    _table(new QTableView),
+    _stats(new QLabel),
+    _timing(new QLabel),
+    _follow(new QCheckBox(tr("Follow"))),
+    _pollTimer(new QTimer(this))
+{
+    _table->setModel(_model);
+    _table->verticalHeader()->hide();
+    _table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    _table->verticalHeader()->setDefaultSectionSize(_table->fontMetrics().height() + 4);
+    _table->horizontalHeader()->setStretchLastSection(false);
+    _table->horizontalHeader()->setSectionResizeMode(ModbusModel::DetailsColumn, QHeaderView::Stretch);
+    _table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _follow->setChecked(true);
+
+    _timing->setText(tr("Frame boundaries are approximate: without low latency mode, bytes are timestamped "
+                        "on the GUI thread, so short silences between frames can be missed."));
+    _timing->setToolTip(tr("Turn on low latency mode in the settings to have the I/O thread timestamp every read."));
+    _timing->setWordWrap(true);
+    _timing->hide();
+
+    QPushButton *clear = new QPushButton(tr("Clear"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_stats, 1);
+    bar->addWidget(_follow);
+    bar->addWidget(clear);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_timing);
+    layout->addWidget(_table);
+
+    //Flushes frames whose trailing silence has expired. Boundaries come from
+    //the chunk timestamps, so the timer only bounds display latency.
+    _pollTimer->setInterval(5);
+    connect(_pollTimer, &QTimer::timeout, this, &ModbusView::_slot_poll);
+    connect(clear, &QPushButton::clicked, this, &ModbusView::_slot_clear);
+}
+
+void
+ModbusView::configure(const SettingsDialog::Settings &settings) {
+    _analyzer.configure(settings.baudRate, settings.dataBits, settings.parity, settings.stopBits);
+    _model->setCharNs(_analyzer.charNs());
+    _timing->setVisible(!settings.lowLatency);
+    _slot_poll();
+}
+
+void
+ModbusView::setActive(bool active) {
+    _active = active;
+    if (active) {
+        _pollTimer->start();
+    }
+    else {
+        _pollTimer->stop();
+    }
+}
+
+void
+ModbusView::feed(const ByteView &data, quint64 timestampNs, bool tx) {
+    _analyzer.feed(data, timestampNs, tx);
+}
+
+void
+ModbusView::_slot_poll() {
+    _analyzer.poll(monotonicNowNs());
+    if (!_analyzer.frames().isEmpty()) {
+        _model->append(_analyzer.frames());
+        if (_follow->isChecked()) {
+            _table->scrollToBottom();
+        }
+    }
+
+    _stats->setText(tr("Frames: %1  CRC errors: %2  t3.5: %3 ms")
+                    .arg(_analyzer.frameCount()).arg(_analyzer.crcErrors())
+                    .arg(_analyzer.silenceNs() / 1e6, 0, 'f', 3));
+}
+
+void
+ModbusView::_slot_clear() {
+    _model->clear();
+}
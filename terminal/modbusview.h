@@ -0,0 +1,94 @@
+#ifndef MODBUSVIEW_H
+#define MODBUSVIEW_H
+
+#include "modbusanalyzer.h"
+#include "settingsdialog.h"
+
+#include <QAbstractTableModel>
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QCheckBox;
+class QLabel;
+class QTableView;
+class QTimer;
+
+QT_END_NAMESPACE
+
+//Decoded Modbus frames. Rows are appended in batches and the oldest are
+//dropped in blocks, so the model keeps up with a saturated bus.
+class ModbusModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        TimeColumn,
+        DirectionColumn,
+        AddressColumn,
+        FunctionColumn,
+        DetailsColumn,
+        CrcColumn,
+        GapColumn,
+        ResponseColumn,
+        ColumnCount
+    };
+
+    static const int MAX_ROWS = 100000;
+
+    explicit ModbusModel(QObject *parent = nullptr);
+
+    void setCharNs(quint64 charNs) { _charNs = charNs; }
+    void append(QVector<ModbusFrame> &frames);
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    struct Row {
+        ModbusFrame frame;
+        bool response = false;
+        qint64 responseNs = -1;
+    };
+
+    QVector<Row> _rows;
+    quint64 _originNs = 0;
+    quint64 _charNs = 0;
+    int _pendingRequest = -1;
+};
+
+//Dockable Modbus RTU analyzer: frames the received (and sent) stream with the
+//3.5 character rule, checks CRCs and pairs requests with their responses.
+class ModbusView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ModbusView(QWidget *parent = nullptr);
+
+    void configure(const SettingsDialog::Settings &settings);
+    void setActive(bool active);
+    bool isActive() const { return _active; }
+
+    void feed(const ByteView &data, quint64 timestampNs, bool tx);
+
+private slots:
+    void _slot_poll();
+    void _slot_clear();
+
+private:
+    ModbusRtuAnalyzer _analyzer;
+    ModbusModel *_model = nullptr;
+    QTableView *_table = nullptr;
+    QLabel *_stats = nullptr;
+    QLabel *_timing = nullptr;
+    QCheckBox *_follow = nullptr;
+    QTimer *_pollTimer = nullptr;
+    bool _active = false;
+};
+
+#endif // MODBUSVIEW_H
@@ -0,0 +1,277 @@
+#include "modemlinemonitor.h"
+#include "monotonicclock.h"
+
+#include <chrono>
+#include <cstddef>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+//MainWindow creates it with plain new, which ignores extended alignment before
+//C++17; the event queue is padded, not aligned, for that reason.
+static_assert(alignof(ModemLineMonitor) <= alignof(std::max_align_t), "ModemLineMonitor is over-aligned");
+
+static const char *const lineNames[ModemLineMonitor::LINE_COUNT] = { "DTR", "RTS", "CTS", "DSR", "DCD", "RI" };
+
+QString
+ModemLineMonitor::lineName(Line line) {
+    for (int x = 0; x < LINE_COUNT; x++) {
+        if (line == (1u << x)) { return QLatin1String(lineNames[x]); }
+    }
+    return QString();
+}
+
+quint32
+ModemLineMonitor::lineFromName(const QString &name) {
+    for (int x = 0; x < LINE_COUNT; x++) {
+        if (name.compare(QLatin1String(lineNames[x]), Qt::CaseInsensitive) == 0) { return 1u << x; }
+    }
+    return 0;
+}
+
+ModemLineMonitor::ModemLineMonitor(QObject *parent) :
+    QObject(parent),
+    _running(false),
+    _stopping(false),
+    _notifyPending(false),
+    _dropped(0),
+    _events(QUEUE_SIZE)
+{
+}
+
+ModemLineMonitor::~ModemLineMonitor() {
+    stop();
+}
+
+bool
+ModemLineMonitor::takeEvent(ModemLineEvent &event) {
+    if (_events.pop(event)) {
+        return true;
+    }
+
+    //Re-arm the notification, then look again in case an edge was pushed
+    //after the pop above but before the flag was cleared.
+    _notifyPending.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return _events.pop(event);
+}
+
+#ifdef Q_OS_LINUX
+
+static QString
+errnoString(const char *what) {
+    return QStringLiteral("%1: %2").arg(QLatin1String(what), QString::fromLocal8Bit(strerror(errno)));
+}
+
+//Only there to interrupt TIOCMIWAIT; installed without SA_RESTART so the
+//ioctl fails with EINTR instead of being restarted.
+static void
+wakeHandler(int) {
+}
+
+static int
+wakeSignal() {
+    return SIGRTMIN + 1;
+}
+
+bool
+ModemLineMonitor::start(int fd) {
+    stop();
+
+    static const bool installed = []() {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = wakeHandler;
+        sigemptyset(&action.sa_mask);
+        return ::sigaction(wakeSignal(), &action, nullptr) == 0;
+    }();
+    if (!installed) {
+        _errorString = tr("Cannot install the modem line wake-up signal");
+        return false;
+    }
+
+    int bits = 0;
+    if (fd < 0 || ::ioctl(fd, TIOCMGET, &bits) != 0) {
+        _errorString = tr("The device has no modem control lines");
+        return false;
+    }
+    _fd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (_fd < 0) {
+        _errorString = errnoString("dup");
+        return false;
+    }
+
+    _stopping.store(false);
+    _notifyPending.store(false);
+    _dropped.store(0);
+    _running.store(true);
+    _thread = std::thread(&ModemLineMonitor::_run, this);
+    _errorString.clear();
+    return true;
+}
+
+void
+ModemLineMonitor::stop() {
+    if (_thread.joinable()) {
+        //TIOCMIWAIT only returns for an edge or a signal, and a signal that
+        //arrives just before the thread enters it is lost; keep sending until
+        //the thread is out.
+        _stopping.store(true, std::memory_order_release);
+        while (_running.load(std::memory_order_acquire)) {
+            ::pthread_kill(_thread.native_handle(), wakeSignal());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        _thread.join();
+    }
+
+    if (_fd >= 0) { ::close(_fd); }
+    _fd = -1;
+
+    ModemLineEvent event;
+    while (_events.pop(event)) {}
+}
+
+quint32
+ModemLineMonitor::lines() const {
+    return _fd >= 0 ? _read(_fd) : 0;
+}
+
+bool
+ModemLineMonitor::setLine(Line line, bool on, ModemLineEvent &event) {
+    if (_fd < 0) { return false; }
+
+    const quint32 before = _read(_fd);
+    if (!setLine(_fd, line, on)) {
+        _errorString = errnoString("TIOCMSET");
+        return false;
+    }
+    event.timestampNs = monotonicNowNs();
+    event.lines = _read(_fd);
+    event.changed = (before ^ event.lines) & line;
+    return true;
+}
+
+bool
+ModemLineMonitor::setLine(int fd, Line line, bool on) {
+    if (line != Dtr && line != Rts) {
+        errno = EINVAL;
+        return false;
+    }
+    int bits = line == Dtr ? TIOCM_DTR : TIOCM_RTS;
+    return ::ioctl(fd, on ? TIOCMBIS : TIOCMBIC, &bits) == 0;
+}
+
+quint32
+ModemLineMonitor::_read(int fd) {
+    int bits = 0;
+    if (::ioctl(fd, TIOCMGET, &bits) != 0) { return 0; }
+
+    quint32 lines = 0;
+    if (bits & TIOCM_DTR) { lines |= Dtr; }
+    if (bits & TIOCM_RTS) { lines |= Rts; }
+    if (bits & TIOCM_CTS) { lines |= Cts; }
+    if (bits & TIOCM_DSR) { lines |= Dsr; }
+    if (bits & TIOCM_CD) { lines |= Dcd; }
+    if (bits & TIOCM_RI) { lines |= Ri; }
+    return lines;
+}
+
+void
+ModemLineMonitor::_run() {
+    const quint32 inputs = Cts | Dsr | Dcd | Ri;
+
+    quint32 previous = _read(_fd);
+    serial_icounter_struct counts;
+    const bool counters = ::ioctl(_fd, TIOCGICOUNT, &counts) == 0;
+
+    while (!_stopping.load(std::memory_order_acquire)) {
+        //Sample first and only wait when nothing moved: TIOCMIWAIT waits for
+        //the next change after it is entered, edges in between would be missed.
+        ModemLineEvent event;
+        event.timestampNs = monotonicNowNs();
+        event.lines = _read(_fd);
+        event.changed = (event.lines ^ previous) & inputs;
+        serial_icounter_struct now;
+        if (counters && ::ioctl(_fd, TIOCGICOUNT, &now) == 0) {
+            if (now.cts != counts.cts) { event.changed |= Cts; }
+            if (now.dsr != counts.dsr) { event.changed |= Dsr; }
+            if (now.dcd != counts.dcd) { event.changed |= Dcd; }
+            if (now.rng != counts.rng) { event.changed |= Ri; }
+            counts = now;
+        }
+        previous = event.lines;
+
+        if (event.changed) {
+            if (!_events.push(event)) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!_notifyPending.exchange(true)) {
+                emit edgesReady();
+            }
+            continue;
+        }
+
+        if (::ioctl(_fd, TIOCMIWAIT, TIOCM_CTS | TIOCM_DSR | TIOCM_CD | TIOCM_RNG) != 0 && errno != EINTR) {
+            emit errorOccurred(errno == EINVAL || errno == ENOTTY
+                               ? tr("The driver cannot report modem line changes")
+                               : errnoString("TIOCMIWAIT"));
+            break;
+        }
+    }
+
+    _running.store(false, std::memory_order_release);
+}
+
+#else
+
+bool
+ModemLineMonitor::start(int fd) {
+    Q_UNUSED(fd);
+    _errorString = tr("The modem line monitor is only available on Linux");
+    return false;
+}
+
+void
+ModemLineMonitor::stop() {
+}
+
+quint32
+ModemLineMonitor::lines() const {
+    return 0;
+}
+
+bool
+ModemLineMonitor::setLine(Line line, bool on, ModemLineEvent &event) {
+    Q_UNUSED(line);
+    Q_UNUSED(on);
+    Q_UNUSED(event);
+    return false;
+}
+
+bool
+ModemLineMonitor::setLine(int fd, Line line, bool on) {
+    Q_UNUSED(fd);
+    Q_UNUSED(line);
+    Q_UNUSED(on);
+    return false;
+}
+
+quint32
+ModemLineMonitor::_read(int fd) {
+    Q_UNUSED(fd);
+    return 0;
+}
+
+void
+ModemLineMonitor::_run() {
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef MODEMLINEMONITOR_H
+#define MODEMLINEMONITOR_H
+
+#include "shmtaplayout.h"
+#include "spscqueue.h"
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <thread>
+
+//One change of the modem control lines.
+struct ModemLineEvent {
+    quint64 timestampNs = 0;
+    quint32 lines = 0;      //asserted lines after the edge, ModemLineMonitor::Line bits
+    quint32 changed = 0;    //lines that changed since the previous event
+};
+
+//Watches CTS, DSR, DCD and RI of an open serial device (Linux). A dedicated
+//thread sleeps in the TIOCMIWAIT ioctl, which only returns when one of the
+//lines changes, then timestamps the edge and queues it for the GUI thread;
+//nothing polls and the receive path is not involved. The driver's interrupt
+//counters (TIOCGICOUNT), where it has them, reveal pulses too short to still
+//be visible when the thread reads the line state.
+//
+//DTR and RTS are driven with setLine(), which reports the edge it made in the
+//same form.
+class ModemLineMonitor : public QObject
+{
+    Q_OBJECT
+
+signals:
+    //Once per batch; take the events with takeEvent().
+    void edgesReady();
+    void errorOccurred(const QString &message);
+
+public:
+    enum Line : quint32 {
+        Dtr = ShmTapLayout::Dtr,
+        Rts = ShmTapLayout::Rts,
+        Cts = ShmTapLayout::Cts,
+        Dsr = ShmTapLayout::Dsr,
+        Dcd = ShmTapLayout::Dcd,
+        Ri = ShmTapLayout::Ri
+    };
+    static const int LINE_COUNT = 6;
+    static const size_t QUEUE_SIZE = 4096;
+
+    static QString lineName(Line line);
+    //Line from a name such as "DTR" (any case); 0 when unknown.
+    static quint32 lineFromName(const QString &name);
+
+    explicit ModemLineMonitor(QObject *parent = nullptr);
+    ~ModemLineMonitor();
+
+    //Watches fd (which is duplicated, the caller keeps its own).
+    bool start(int fd);
+    void stop();
+    bool isRunning() const { return _fd >= 0; }
+    QString errorString() const { return _errorString; }
+
+    //Current state of all lines, read from the driver.
+    quint32 lines() const;
+    //GUI thread. Asserts or clears DTR or RTS and returns the edge in event.
+    bool setLine(Line line, bool on, ModemLineEvent &event);
+    //The same on any descriptor, for headless script sessions.
+    static bool setLine(int fd, Line line, bool on);
+
+    //GUI thread.
+    bool takeEvent(ModemLineEvent &event);
+    //Edges lost because the GUI thread did not keep up.
+    quint64 droppedEdges() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    static quint32 _read(int fd);
+    void _run();
+
+    int _fd = -1;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<bool> _stopping;
+    std::atomic<bool> _notifyPending;
+    std::atomic<quint64> _dropped;
+    SpscQueue<ModemLineEvent> _events;
+    QString _errorString;
+};
+
+#endif // MODEMLINEMONITOR_H
@@ -0,0 +1,246 @@
+#include "modemlineview.h"
+#include "monotonicclock.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QPushButton>
+#include <QSignalBlocker>
+#include <QSpinBox>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+static const int ROW_HEIGHT = 18;
+static const int LABEL_WIDTH = 40;
+
+ModemLineTimeline::ModemLineTimeline(QWidget *parent) :
+    QWidget(parent)
+{
+    setMinimumHeight(ModemLineMonitor::LINE_COUNT * ROW_HEIGHT + 4);
+}
+
+QSize
+ModemLineTimeline::sizeHint() const {
+    return QSize(400, ModemLineMonitor::LINE_COUNT * ROW_HEIGHT + 4);
+}
+
+void
+ModemLineTimeline::reset(quint32 lines, quint64 nowNs) {
+    _events.clear();
+    ModemLineEvent start;
+    start.timestampNs = nowNs;
+    start.lines = lines;
+    _initial = lines;
+    _events.append(start);
+    update();
+}
+
+void
+ModemLineTimeline::append(const ModemLineEvent &event) {
+    if (_events.size() >= MAX_EVENTS) {
+        //Drop the older half at once instead of shifting on every edge.
+        const int drop = MAX_EVENTS / 2;
+        _initial = _events.at(drop - 1).lines;
+        _events.remove(0, drop);
+    }
+    _events.append(event);
+}
+
+void
+ModemLineTimeline::paintEvent(QPaintEvent *e) {
+    Q_UNUSED(e);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+
+    const int width = qMax(1, this->width() - LABEL_WIDTH - 4);
+    const quint64 now = monotonicNowNs();
+    const quint64 start = now > _windowNs ? now - _windowNs : 0;
+    auto xOf = [&](quint64 t) {
+        if (t <= start) { return LABEL_WIDTH; }
+        return LABEL_WIDTH + static_cast<int>(static_cast<double>(t - start) * width / _windowNs);
+    };
+
+    //First event inside the window and the state left by the ones before it.
+    auto first = std::lower_bound(_events.constBegin(), _events.constEnd(), start,
+                                  [](const ModemLineEvent &event, quint64 t) { return event.timestampNs < t; });
+    const quint32 entry = first == _events.constBegin() ? _initial : (first - 1)->lines;
+
+    const QColor text = palette().color(QPalette::Text);
+    const QColor grid = palette().color(QPalette::Mid);
+    const QColor wave = palette().color(QPalette::Highlight);
+
+    for (int row = 0; row < ModemLineMonitor::LINE_COUNT; row++) {
+        const quint32 bit = 1u << row;
+        const int top = 2 + row * ROW_HEIGHT;
+        const int high = top + 3;
+        const int low = top + ROW_HEIGHT - 3;
+
+        painter.setPen(text);
+        painter.drawText(QRect(2, top, LABEL_WIDTH - 4, ROW_HEIGHT), Qt::AlignVCenter | Qt::AlignLeft,
+                         ModemLineMonitor::lineName(static_cast<ModemLineMonitor::Line>(bit)));
+        painter.setPen(grid);
+        painter.drawLine(LABEL_WIDTH, top + ROW_HEIGHT - 1, LABEL_WIDTH + width, top + ROW_HEIGHT - 1);
+
+        painter.setPen(wave);
+        bool level = (entry & bit) != 0;
+        int x = LABEL_WIDTH;
+        for (auto event = first; event != _events.constEnd(); ++event) {
+            if (!(event->changed & bit)) { continue; }
+            const int edge = xOf(event->timestampNs);
+            const bool next = (event->lines & bit) != 0;
+            painter.drawLine(x, level ? high : low, edge, level ? high : low);
+            //Also drawn when the level is the same on both sides, for pulses
+            //the monitor only saw in the interrupt counters.
+            painter.drawLine(edge, high, edge, low);
+            level = next;
+            x = edge;
+        }
+        painter.drawLine(x, level ? high : low, LABEL_WIDTH + width, level ? high : low);
+    }
+}
+
+ModemLineView::ModemLineView(QWidget *parent) :
+    QWidget(parent),
+    _timeline(new ModemLineTimeline),
+    _dtr(new QCheckBox(tr("DTR"))),
+    _rts(new QCheckBox(tr("RTS"))),
+    _pulseLine(new QComboBox),
+    _pulseWidth(new QSpinBox),
+    _window(new QComboBox),
+    _status(new QLabel),
+    _repaintTimer(new QTimer(this))
+{
+    _pulseLine->addItem(tr("DTR"), static_cast<quint32>(ModemLineMonitor::Dtr));
+    _pulseLine->addItem(tr("RTS"), static_cast<quint32>(ModemLineMonitor::Rts));
+    _pulseWidth->setRange(1, 10000);
+    _pulseWidth->setValue(100);
+    _pulseWidth->setSuffix(tr(" ms"));
+    _pulseWidth->setToolTip(tr("The line is switched to the opposite level for this long, then put back"));
+
+    _window->addItem(tr("1 s"), 1);
+    _window->addItem(tr("10 s"), 10);
+    _window->addItem(tr("60 s"), 60);
+    _window->setCurrentIndex(1);
+
+    QPushButton *pulse = new QPushButton(tr("Pulse"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_dtr);
+    bar->addWidget(_rts);
+    bar->addSpacing(12);
+    bar->addWidget(pulse);
+    bar->addWidget(_pulseLine);
+    bar->addWidget(_pulseWidth);
+    bar->addSpacing(12);
+    bar->addWidget(_status, 1);
+    bar->addWidget(_window);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_timeline, 1);
+
+    _repaintTimer->setInterval(50);
+    connect(_repaintTimer, &QTimer::timeout, this, &ModemLineView::_slot_repaint);
+    connect(_dtr, &QCheckBox::toggled, this, &ModemLineView::_slot_dtr);
+    connect(_rts, &QCheckBox::toggled, this, &ModemLineView::_slot_rts);
+    connect(pulse, &QPushButton::clicked, this, &ModemLineView::_slot_pulse);
+    connect(_window, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, &ModemLineView::_slot_window);
+
+    reset(false, 0);
+}
+
+void
+ModemLineView::setActive(bool active) {
+    _active = active;
+    if (active) {
+        _repaintTimer->start();
+        _updateStatus();
+    }
+    else {
+        _repaintTimer->stop();
+    }
+}
+
+void
+ModemLineView::reset(bool available, quint32 lines, const QString &status) {
+    std::fill(_edges, _edges + ModemLineMonitor::LINE_COUNT, 0);
+    _dropped = 0;
+    _error = status;
+    _timeline->reset(lines, monotonicNowNs());
+
+    const QSignalBlocker dtr(_dtr);
+    const QSignalBlocker rts(_rts);
+    _dtr->setChecked((lines & ModemLineMonitor::Dtr) != 0);
+    _rts->setChecked((lines & ModemLineMonitor::Rts) != 0);
+    _dtr->setEnabled(available);
+    _rts->setEnabled(available);
+    _pulseLine->setEnabled(available);
+    _pulseWidth->setEnabled(available);
+    _updateStatus();
+}
+
+void
+ModemLineView::append(const ModemLineEvent &event) {
+    _timeline->append(event);
+    for (int x = 0; x < ModemLineMonitor::LINE_COUNT; x++) {
+        if (event.changed & (1u << x)) { _edges[x]++; }
+    }
+
+    const QSignalBlocker dtr(_dtr);
+    const QSignalBlocker rts(_rts);
+    _dtr->setChecked((event.lines & ModemLineMonitor::Dtr) != 0);
+    _rts->setChecked((event.lines & ModemLineMonitor::Rts) != 0);
+}
+
+void
+ModemLineView::_slot_dtr(bool on) {
+    emit lineChangeRequested(ModemLineMonitor::Dtr, on);
+}
+
+void
+ModemLineView::_slot_rts(bool on) {
+    emit lineChangeRequested(ModemLineMonitor::Rts, on);
+}
+
+void
+ModemLineView::_slot_pulse() {
+    emit pulseRequested(_pulseLine->currentData().toUInt(), _pulseWidth->value());
+}
+
+void
+ModemLineView::_slot_window(int index) {
+    _timeline->setWindow(_window->itemData(index).toULongLong() * 1000000000ull);
+    _timeline->update();
+}
+
+void
+ModemLineView::_slot_repaint() {
+    _updateStatus();
+    _timeline->update();
+}
+
+void
+ModemLineView::_updateStatus() {
+    if (!_error.isEmpty()) {
+        _status->setText(_error);
+        return;
+    }
+
+    QStringList counts;
+    for (int x = 0; x < ModemLineMonitor::LINE_COUNT; x++) {
+        counts << QStringLiteral("%1 %2").arg(ModemLineMonitor::lineName(static_cast<ModemLineMonitor::Line>(1u << x)))
+                  .arg(_edges[x]);
+    }
+    QString text = tr("Edges: %1").arg(counts.join(QStringLiteral(", ")));
+    if (_dropped) {
+        text += tr(" (%1 lost)").arg(_dropped);
+    }
+    _status->setText(text);
+}
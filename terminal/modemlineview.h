@@ -0,0 +1,92 @@
+#ifndef MODEMLINEVIEW_H
+#define MODEMLINEVIEW_H
+
+#include "modemlinemonitor.h"
+
+#include <QVector>
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QSpinBox;
+class QTimer;
+
+QT_END_NAMESPACE
+
+//Logic-analyzer style strip of the six modem lines over a sliding window of
+//time, drawn from the recorded edges. Edges whose level did not change (a
+//pulse shorter than the monitor's wake-up) are drawn as ticks.
+class ModemLineTimeline : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static const int MAX_EVENTS = 100000;
+
+    explicit ModemLineTimeline(QWidget *parent = nullptr);
+
+    void reset(quint32 lines, quint64 nowNs);
+    void append(const ModemLineEvent &event);
+    void setWindow(quint64 windowNs) { _windowNs = windowNs; }
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *e) override;
+
+private:
+    QVector<ModemLineEvent> _events;
+    //State before the first event kept.
+    quint32 _initial = 0;
+    quint64 _windowNs = 10000000000ull;
+};
+
+//Dockable panel: the timeline, DTR/RTS switches, a pulse button for reset
+//sequences and the edge counts.
+class ModemLineView : public QWidget
+{
+    Q_OBJECT
+
+signals:
+    void lineChangeRequested(quint32 line, bool on);
+    void pulseRequested(quint32 line, int widthMs);
+
+public:
+    explicit ModemLineView(QWidget *parent = nullptr);
+
+    void setActive(bool active);
+    bool isActive() const { return _active; }
+
+    //When a port opens (available: the monitor is running) or closes.
+    void reset(bool available, quint32 lines, const QString &status = QString());
+    void append(const ModemLineEvent &event);
+    void setDropped(quint64 dropped) { _dropped = dropped; }
+
+private slots:
+    void _slot_dtr(bool on);
+    void _slot_rts(bool on);
+    void _slot_pulse();
+    void _slot_window(int index);
+    void _slot_repaint();
+
+private:
+    void _updateStatus();
+
+    ModemLineTimeline *_timeline = nullptr;
+    QCheckBox *_dtr = nullptr;
+    QCheckBox *_rts = nullptr;
+    QComboBox *_pulseLine = nullptr;
+    QSpinBox *_pulseWidth = nullptr;
+    QComboBox *_window = nullptr;
+    QLabel *_status = nullptr;
+    QTimer *_repaintTimer = nullptr;
+    quint64 _edges[ModemLineMonitor::LINE_COUNT] = {};
+    quint64 _dropped = 0;
+    QString _error;
+    bool _active = false;
+};
+
+#endif // MODEMLINEVIEW_H
@@ -0,0 +1,15 @@
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// Nanoseconds on the monotonic clock (CLOCK_MONOTONIC on Linux), the common
+// time base for every timestamp that leaves the I/O path.
+inline uint64_t
+monotonicNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#endif // MONOTONICCLOCK_H
@@ -0,0 +1,91 @@
+#include "portsource.h"
+#include "monotonicclock.h"
+
+PortSource::PortSource(QObject *parent) :
+    QObject(parent),
+    _serial(new QSerialPort(this))
+{
+    connect(_serial, &QSerialPort::readyRead, this, &PortSource::_slot_read);
+    connect(_serial, &QSerialPort::errorOccurred, this, &PortSource::_slot_error);
+}
+
+PortSource::~PortSource() {
+    close();
+}
+
+bool
+PortSource::open(const QString &portName, qint32 baudRate) {
+    close();
+    _serial->setPortName(portName);
+    _serial->setBaudRate(baudRate);
+    _serial->setDataBits(QSerialPort::Data8);
+    _serial->setParity(QSerialPort::NoParity);
+    _serial->setStopBits(QSerialPort::OneStop);
+    _serial->setFlowControl(QSerialPort::NoFlowControl);
+    return _serial->open(QIODevice::ReadOnly);
+}
+
+void
+PortSource::close() {
+    if (_serial->isOpen()) {
+        _serial->close();
+    }
+}
+
+bool
+PortSource::isOpen() const {
+    return _serial->isOpen();
+}
+
+QString
+PortSource::portName() const {
+    return _serial->portName();
+}
+
+QString
+PortSource::errorString() const {
+    return _serial->errorString();
+}
+
+qint64
+PortSource::spill(const QString &directory) {
+    if (!_spillFile.isOpen() && !_spillFile.createAnonymous(directory)) {
+        emit errorOccurred(QStringLiteral("%1: %2").arg(_serial->portName(), _spillFile.errorString()));
+        return 0;
+    }
+    syncSpill();
+    return _spillFile.isOpen() ? _spillFile.spill(_store) : 0;
+}
+
+void
+PortSource::syncSpill() {
+    if (_spillFile.isOpen() && !_spillFile.sync(_store, SessionFile::SPILL_STEP)) {
+        emit errorOccurred(QStringLiteral("%1: %2").arg(_serial->portName(), _spillFile.errorString()));
+        _spillFile.close();
+    }
+}
+
+void
+PortSource::_slot_read() {
+    const quint64 timestampNs = monotonicNowNs();
+    const qint64 available = _serial->bytesAvailable();
+    if (available <= 0) { return; }
+
+    //Reused, so reading does not allocate once it has grown.
+    _buffer.resize(static_cast<int>(available));
+    const qint64 read = _serial->read(_buffer.data(), available);
+    if (read <= 0) { return; }
+
+    if (_store.append(ByteView(_buffer.constData(), read), timestampNs)) {
+        emit linesAdded();
+    }
+}
+
+void
+PortSource::_slot_error(QSerialPort::SerialPortError error) {
+    if (error == QSerialPort::NoError) { return; }
+    emit errorOccurred(QStringLiteral("%1: %2").arg(_serial->portName(), _serial->errorString()));
+    if (error == QSerialPort::ResourceError) {
+        close();
+    }
+}
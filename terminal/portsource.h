@@ -0,0 +1,50 @@
+#ifndef PORTSOURCE_H
+#define PORTSOURCE_H
+
+#include "linestore.h"
+#include "sessionfile.h"
+
+#include <QObject>
+#include <QSerialPort>
+
+//Another serial port, only received from, whose lines are kept in a LineStore
+//of their own with the same clock as the main port's, for the merged view.
+class PortSource : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void linesAdded();
+    void errorOccurred(const QString &message);
+
+public:
+    explicit PortSource(QObject *parent = nullptr);
+    ~PortSource();
+
+    //8N1, no flow control.
+    bool open(const QString &portName, qint32 baudRate);
+    void close();
+    bool isOpen() const;
+    QString portName() const;
+    QString errorString() const;
+
+    const LineStore &lineStore() const { return _store; }
+    //Moves the lines onto an unnamed file in directory, see
+    //SessionFile::spill(); returns the heap freed. The file is caught up a
+    //step per call.
+    qint64 spill(const QString &directory);
+    //Keeps the file of an earlier spill() up with the lines, a step at a time.
+    void syncSpill();
+
+private slots:
+    void _slot_read();
+    void _slot_error(QSerialPort::SerialPortError error);
+
+private:
+    QSerialPort *_serial = nullptr;
+    LineStore _store;
+    SessionFile _spillFile;
+    QByteArray _buffer;
+};
+
+#endif // PORTSOURCE_H
@@ -0,0 +1,64 @@
+#ifndef ROUNDTRIPMETER_H
+#define ROUNDTRIPMETER_H
+
+#include "latencyhistogram.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtGlobal>
+
+#include <atomic>
+
+// Measures the time from a write to the first byte received after it, which for
+// an interactive device is the request/response round trip. Writes and reads
+// may happen on different threads. Every round trip goes into a histogram, so
+// the tail is visible and not only the last sample; the lock is only taken once
+// per round trip, not per read.
+class RoundTripMeter
+{
+public:
+    RoundTripMeter() : _sentAt(0), _last(0), _samples(0) {}
+
+    void reset() {
+        _sentAt.store(0, std::memory_order_relaxed);
+        _last.store(0, std::memory_order_relaxed);
+        _samples.store(0, std::memory_order_relaxed);
+        QMutexLocker lock(&_mutex);
+        _histogram.reset();
+    }
+
+    // Only the first write of a request arms the meter, so a burst of writes
+    // is timed from its start.
+    void markSent(quint64 timestampNs) {
+        quint64 expected = 0;
+        _sentAt.compare_exchange_strong(expected, timestampNs, std::memory_order_relaxed);
+    }
+
+    void markReceived(quint64 timestampNs) {
+        const quint64 sentAt = _sentAt.exchange(0, std::memory_order_relaxed);
+        if (sentAt != 0 && timestampNs >= sentAt) {
+            _last.store(timestampNs - sentAt, std::memory_order_relaxed);
+            _samples.fetch_add(1, std::memory_order_relaxed);
+            QMutexLocker lock(&_mutex);
+            _histogram.add(timestampNs - sentAt);
+        }
+    }
+
+    quint64 lastNsecs() const { return _last.load(std::memory_order_relaxed); }
+    quint64 samples() const { return _samples.load(std::memory_order_relaxed); }
+
+    // Every round trip since reset().
+    LatencyHistogram histogram() const {
+        QMutexLocker lock(&_mutex);
+        return _histogram;
+    }
+
+private:
+    std::atomic<quint64> _sentAt;
+    std::atomic<quint64> _last;
+    std::atomic<quint64> _samples;
+    mutable QMutex _mutex;
+    LatencyHistogram _histogram;
+};
+
+#endif // ROUNDTRIPMETER_H
@@ -0,0 +1,135 @@
+#include "schedulerview.h"
+#include "commandscheduler.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+SchedulerView::SchedulerView(CommandScheduler *scheduler, QWidget *parent) :
+    QWidget(parent),
+    _scheduler(scheduler),
+    _table(new QTableWidget(0, ColumnCount)),
+    _status(new QLabel),
+    _start(new QPushButton(tr("Start"))),
+    _refreshTimer(new QTimer(this))
+{
+    _table->setHorizontalHeaderLabels(QStringList()
+                                      << tr("Command") << tr("Interval")
+                                      << tr("Sent") << tr("Answered") << tr("Timeouts") << tr("Skipped")
+                                      << tr("Latency p50/p99/max (us)") << tr("Jitter p50/p99/max (us)"));
+    _table->verticalHeader()->hide();
+    _table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    _table->horizontalHeader()->setStretchLastSection(true);
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _table->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    _start->setCheckable(true);
+    _start->setEnabled(false);
+    QPushButton *reset = new QPushButton(tr("Reset"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_status, 1);
+    bar->addWidget(_start);
+    bar->addWidget(reset);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(_table);
+
+    //Only the display is on a timer; sends run on the scheduler's thread.
+    _refreshTimer->setInterval(500);
+    connect(_refreshTimer, &QTimer::timeout, this, &SchedulerView::_slot_refresh);
+    connect(_start, &QPushButton::toggled, this, &SchedulerView::_slot_startStop);
+    connect(reset, &QPushButton::clicked, this, &SchedulerView::_slot_reset);
+    connect(_scheduler, &CommandScheduler::runningChanged, this, &SchedulerView::_slot_running);
+
+    reload();
+}
+
+void
+SchedulerView::reload() {
+    const QVector<ScheduledCommand> &commands = _scheduler->commands();
+    _table->setRowCount(commands.size());
+    for (int row = 0; row < commands.size(); row++) {
+        const ScheduledCommand &command = commands.at(row);
+        for (int column = 0; column < ColumnCount; column++) {
+            if (!_table->item(row, column)) {
+                QTableWidgetItem *item = new QTableWidgetItem;
+                if (column != CommandColumn) {
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                }
+                _table->setItem(row, column, item);
+            }
+        }
+        _table->item(row, CommandColumn)->setText(command.name.isEmpty()
+                                                  ? QString::fromLatin1(command.payload).trimmed() : command.name);
+        _table->item(row, IntervalColumn)->setText(tr("%1 ms").arg(command.intervalMs));
+    }
+    _status->setText(commands.isEmpty() ? tr("No commands configured") : QString());
+    _slot_refresh();
+}
+
+void
+SchedulerView::setActive(bool active) {
+    if (active) {
+        _refreshTimer->start();
+        _slot_refresh();
+    }
+    else {
+        _refreshTimer->stop();
+    }
+}
+
+void
+SchedulerView::setStartEnabled(bool enabled) {
+    _start->setEnabled(enabled && !_scheduler->commands().isEmpty());
+}
+
+void
+SchedulerView::_slot_refresh() {
+    const QVector<ScheduledCommandStats> stats = _scheduler->stats();
+    for (int row = 0; row < stats.size() && row < _table->rowCount(); row++) {
+        const ScheduledCommandStats &s = stats.at(row);
+        _table->item(row, SentColumn)->setText(QString::number(s.sent));
+        _table->item(row, AnsweredColumn)->setText(QString::number(s.answered));
+        _table->item(row, TimeoutsColumn)->setText(QString::number(s.timeouts));
+        _table->item(row, SkippedColumn)->setText(QString::number(s.skipped));
+        _table->item(row, LatencyColumn)->setText(s.latency.summary());
+        _table->item(row, JitterColumn)->setText(s.jitter.summary());
+    }
+}
+
+void
+SchedulerView::_slot_startStop(bool start) {
+    if (start == _scheduler->isRunning()) { return; }
+
+    if (!start) {
+        _scheduler->stop();
+        return;
+    }
+    if (!_scheduler->start()) {
+        _status->setText(_scheduler->errorString());
+        _start->setChecked(false);
+    }
+}
+
+void
+SchedulerView::_slot_running(bool running) {
+    _start->setChecked(running);
+    _start->setText(running ? tr("Stop") : tr("Start"));
+    if (running) {
+        _status->clear();
+    }
+    _slot_refresh();
+}
+
+void
+SchedulerView::_slot_reset() {
+    _scheduler->resetStats();
+    _slot_refresh();
+}
@@ -0,0 +1,58 @@
+#ifndef SCHEDULERVIEW_H
+#define SCHEDULERVIEW_H
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QLabel;
+class QPushButton;
+class QTableWidget;
+class QTimer;
+
+QT_END_NAMESPACE
+
+class CommandScheduler;
+
+//Dockable per-command statistics of the command scheduler: counts and the
+//latency and send jitter percentiles, with start/stop.
+class SchedulerView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        CommandColumn,
+        IntervalColumn,
+        SentColumn,
+        AnsweredColumn,
+        TimeoutsColumn,
+        SkippedColumn,
+        LatencyColumn,
+        JitterColumn,
+        ColumnCount
+    };
+
+    explicit SchedulerView(CommandScheduler *scheduler, QWidget *parent = nullptr);
+
+    //Rebuilds the rows after the scheduler has been configured.
+    void reload();
+    void setActive(bool active);
+    //Whether there is a port to send to.
+    void setStartEnabled(bool enabled);
+
+private slots:
+    void _slot_refresh();
+    void _slot_startStop(bool start);
+    void _slot_running(bool running);
+    void _slot_reset();
+
+private:
+    CommandScheduler *_scheduler = nullptr;
+    QTableWidget *_table = nullptr;
+    QLabel *_status = nullptr;
+    QPushButton *_start = nullptr;
+    QTimer *_refreshTimer = nullptr;
+};
+
+#endif // SCHEDULERVIEW_H
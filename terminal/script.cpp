@@ -0,0 +1,229 @@
+#include "script.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+namespace {
+
+enum TokenKind {
+    Word,
+    String,
+    Regex
+};
+
+struct Token {
+    TokenKind kind;
+    QString text;
+};
+
+//Strings keep their backslash escapes; they are resolved when the command
+//runs, after variables have been substituted.
+bool
+tokenize(const QString &line, QVector<Token> &tokens, QString &error) {
+    int x = 0;
+    const int size = line.size();
+    while (x < size) {
+        const QChar c = line.at(x);
+        if (c.isSpace()) { x++; continue; }
+        if (c == QLatin1Char('#')) { break; }
+
+        //A slash only opens a regex as the pattern of expect, so paths stay words.
+        const bool regexAllowed = tokens.size() == 1 && tokens.first().text == QLatin1String("expect");
+
+        Token token;
+        if (c == QLatin1Char('"') || (c == QLatin1Char('/') && regexAllowed)) {
+            token.kind = c == QLatin1Char('"') ? String : Regex;
+            x++;
+            bool closed = false;
+            while (x < size) {
+                const QChar d = line.at(x++);
+                if (d == c) { closed = true; break; }
+                if (d == QLatin1Char('\\') && x < size) {
+                    const QChar e = line.at(x++);
+                    //In a regex only the delimiter escape is ours.
+                    if (token.kind == Regex && e == QLatin1Char('/')) {
+                        token.text += e;
+                    }
+                    else {
+                        token.text += d;
+                        token.text += e;
+                    }
+                    continue;
+                }
+                token.text += d;
+            }
+            if (!closed) {
+                error = QStringLiteral("unterminated %1").arg(QLatin1String(token.kind == String ? "string" : "regex"));
+                return false;
+            }
+        }
+        else {
+            token.kind = Word;
+            while (x < size && !line.at(x).isSpace()) {
+                token.text += line.at(x++);
+            }
+        }
+        tokens.append(token);
+    }
+    return true;
+}
+
+} // namespace
+
+bool
+Script::load(const QString &fileName) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        _errorString = QStringLiteral("%1: %2").arg(fileName, file.errorString());
+        return false;
+    }
+    if (!parse(QString::fromUtf8(file.readAll()))) {
+        _errorString = QStringLiteral("%1:%2").arg(fileName, _errorString);
+        return false;
+    }
+    _name = QFileInfo(fileName).fileName();
+    return true;
+}
+
+static QHash<QString, Script::Instruction::Op>
+commands() {
+    QHash<QString, Script::Instruction::Op> ops;
+    ops.insert(QStringLiteral("set"), Script::Instruction::Set);
+    ops.insert(QStringLiteral("incr"), Script::Instruction::Incr);
+    ops.insert(QStringLiteral("send"), Script::Instruction::Send);
+    ops.insert(QStringLiteral("expect"), Script::Instruction::Expect);
+    ops.insert(QStringLiteral("sleep"), Script::Instruction::Sleep);
+    ops.insert(QStringLiteral("line"), Script::Instruction::Line);
+    ops.insert(QStringLiteral("repeat"), Script::Instruction::Repeat);
+    ops.insert(QStringLiteral("end"), Script::Instruction::End);
+    ops.insert(QStringLiteral("label"), Script::Instruction::Label);
+    ops.insert(QStringLiteral("goto"), Script::Instruction::Goto);
+    ops.insert(QStringLiteral("if"), Script::Instruction::If);
+    ops.insert(QStringLiteral("log"), Script::Instruction::Log);
+    ops.insert(QStringLiteral("fail"), Script::Instruction::Fail);
+    ops.insert(QStringLiteral("exit"), Script::Instruction::Exit);
+    return ops;
+}
+
+bool
+Script::parse(const QString &source) {
+    static const QHash<QString, Instruction::Op> ops = commands();
+
+    _instructions.clear();
+    _errorString.clear();
+
+    QHash<QString, int> labels;
+    QVector<int> repeats;
+
+    const QStringList lines = source.split(QLatin1Char('\n'));
+    for (int number = 1; number <= lines.size(); number++) {
+        QVector<Token> tokens;
+        QString error;
+        if (!tokenize(lines.at(number - 1), tokens, error)) {
+            return _fail(number, error);
+        }
+        if (tokens.isEmpty()) { continue; }
+
+        const QString command = tokens.first().text;
+        if (tokens.first().kind != Word || !ops.contains(command)) {
+            return _fail(number, QStringLiteral("unknown command '%1'").arg(command));
+        }
+
+        Instruction instruction;
+        instruction.op = ops.value(command);
+        instruction.line = number;
+        for (int x = 1; x < tokens.size(); x++) {
+            instruction.args.append(tokens.at(x).text);
+        }
+        const int argc = instruction.args.size();
+
+        switch (instruction.op) {
+        case Instruction::Set:
+            if (argc != 2) { return _fail(number, QStringLiteral("usage: set NAME VALUE")); }
+            break;
+        case Instruction::Incr:
+            if (argc < 1 || argc > 2) { return _fail(number, QStringLiteral("usage: incr NAME [STEP]")); }
+            break;
+        case Instruction::Send:
+        case Instruction::Log:
+            if (argc != 1) { return _fail(number, QStringLiteral("usage: %1 \"TEXT\"").arg(command)); }
+            break;
+        case Instruction::Expect:
+            if (argc < 1 || argc > 2) { return _fail(number, QStringLiteral("usage: expect \"TEXT\"|/REGEX/ [MS]")); }
+            if (tokens.at(1).kind == Regex) {
+                //Compiled once here; regexes do not take variables.
+                instruction.regex = true;
+                instruction.pattern.setPattern(tokens.at(1).text);
+                if (!instruction.pattern.isValid()) {
+                    return _fail(number, instruction.pattern.errorString());
+                }
+                instruction.pattern.optimize();
+            }
+            break;
+        case Instruction::Sleep:
+            if (argc != 1) { return _fail(number, QStringLiteral("usage: sleep MS")); }
+            break;
+        case Instruction::Line:
+            if (argc != 2
+                || (instruction.args.at(0).compare(QLatin1String("DTR"), Qt::CaseInsensitive) != 0
+                    && instruction.args.at(0).compare(QLatin1String("RTS"), Qt::CaseInsensitive) != 0)
+                || (instruction.args.at(1) != QLatin1String("on") && instruction.args.at(1) != QLatin1String("off"))) {
+                return _fail(number, QStringLiteral("usage: line DTR|RTS on|off"));
+            }
+            break;
+        case Instruction::Repeat:
+            if (argc > 1) { return _fail(number, QStringLiteral("usage: repeat [COUNT]")); }
+            repeats.append(_instructions.size());
+            break;
+        case Instruction::End:
+            if (repeats.isEmpty()) { return _fail(number, QStringLiteral("end without repeat")); }
+            instruction.target = repeats.takeLast();
+            _instructions[instruction.target].target = _instructions.size();
+            break;
+        case Instruction::Label:
+            if (argc != 1) { return _fail(number, QStringLiteral("usage: label NAME")); }
+            if (labels.contains(instruction.args.first())) {
+                return _fail(number, QStringLiteral("duplicate label '%1'").arg(instruction.args.first()));
+            }
+            labels.insert(instruction.args.first(), _instructions.size());
+            break;
+        case Instruction::Goto:
+            if (argc != 1) { return _fail(number, QStringLiteral("usage: goto LABEL")); }
+            break;
+        case Instruction::If:
+            if ((argc != 3 && argc != 5) || instruction.args.at(argc - 2) != QLatin1String("goto")) {
+                return _fail(number, QStringLiteral("usage: if timeout|matched|A OP B goto LABEL"));
+            }
+            break;
+        case Instruction::Fail:
+            if (argc > 1) { return _fail(number, QStringLiteral("usage: fail [\"TEXT\"]")); }
+            break;
+        case Instruction::Exit:
+            break;
+        }
+
+        _instructions.append(instruction);
+    }
+
+    if (!repeats.isEmpty()) {
+        return _fail(_instructions.at(repeats.last()).line, QStringLiteral("repeat without end"));
+    }
+
+    for (Instruction &instruction : _instructions) {
+        if (instruction.op != Instruction::Goto && instruction.op != Instruction::If) { continue; }
+        const QString label = instruction.args.last();
+        if (!labels.contains(label)) {
+            return _fail(instruction.line, QStringLiteral("unknown label '%1'").arg(label));
+        }
+        instruction.target = labels.value(label);
+    }
+    return true;
+}
+
+bool
+Script::_fail(int line, const QString &message) {
+    _errorString = QStringLiteral("%1: %2").arg(line).arg(message);
+    _instructions.clear();
+    return false;
+}
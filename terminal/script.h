@@ -0,0 +1,72 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//An expect-style device script, one command per line:
+//
+//  set NAME VALUE          variables are referenced as $NAME or ${NAME}
+//  incr NAME [STEP]
+//  send "TEXT"             C escapes: \r \n \t \\ \" \xNN
+//  expect "TEXT" [MS]      or /REGEX/; captures land in $0..$9, the timeout
+//                          defaults to $timeout_ms or 10000 ms
+//  sleep MS
+//  line DTR|RTS on|off     drives a modem control line; a reset pulse is
+//                          line DTR off / sleep 100 / line DTR on
+//  repeat [COUNT] ... end  no count repeats forever
+//  label NAME / goto NAME
+//  if timeout goto NAME    also: if matched, if A OP B (== != < > <= >=)
+//  log "TEXT"
+//  fail "TEXT" / exit
+//
+//After an expect, $timeout is 1 if it timed out and 0 if it matched.
+class Script
+{
+public:
+    struct Instruction {
+        enum Op {
+            Set,
+            Incr,
+            Send,
+            Expect,
+            Sleep,
+            Line,
+            Repeat,
+            End,
+            Label,
+            Goto,
+            If,
+            Log,
+            Fail,
+            Exit
+        };
+
+        Op op = Exit;
+        int line = 0;
+        QStringList args;
+        bool regex = false;
+        QRegularExpression pattern;
+        int target = -1;    //jump target: goto/if label, repeat's end, end's repeat
+    };
+
+    //Returns false and sets errorString (with the line) when the source does not parse.
+    bool parse(const QString &source);
+    bool load(const QString &fileName);
+
+    QString name() const { return _name; }
+    QString errorString() const { return _errorString; }
+    const QVector<Instruction> &instructions() const { return _instructions; }
+    bool isEmpty() const { return _instructions.isEmpty(); }
+
+private:
+    bool _fail(int line, const QString &message);
+
+    QString _name;
+    QString _errorString;
+    QVector<Instruction> _instructions;
+};
+
+#endif // SCRIPT_H
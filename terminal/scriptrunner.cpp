@@ -0,0 +1,433 @@
+#include "scriptrunner.h"
+#include "modemlinemonitor.h"
+#include "monotonicclock.h"
+#include "scriptsession.h"
+
+#include <QMutexLocker>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+struct ScriptRunner::Entry : public ScriptSession::Output
+{
+    Entry(ScriptRunner &runner, int id, const Script &script, const QString &name, int fd) :
+        runner(runner),
+        id(id),
+        fd(fd),
+        session(script, name, *this)
+    {}
+
+    void send(ScriptSession &, const QByteArray &data) override;
+    void setLine(ScriptSession &, const QString &line, bool on) override;
+    void log(ScriptSession &, const QString &text) override {
+        emit runner.logged(id, text);
+    }
+
+    ScriptRunner &runner;
+    const int id;
+    int fd;
+    ScriptSession session;
+    //Headless only: bytes the device has not taken yet, and when they must
+    //be gone.
+    QByteArray pending;
+    quint64 writeDeadlineNs = 0;
+    bool watchingWrites = false;
+};
+
+static const int FEED_RESERVE = 65536;
+
+ScriptRunner::ScriptRunner(QObject *parent) :
+    QObject(parent),
+    _running(false),
+    _nextId(1),
+    _active(0)
+{
+    //Reserved, so resize(0) keeps them.
+    _feedBytes.reserve(FEED_RESERVE);
+    _handlingBytes.reserve(FEED_RESERVE);
+}
+
+ScriptRunner::~ScriptRunner() {
+    stop();
+}
+
+int
+ScriptRunner::addSession(const Script &script, const QString &name) {
+    return addSession(script, name, -1);
+}
+
+int
+ScriptRunner::addSession(const Script &script, const QString &name, int fd) {
+    Request request;
+    request.type = Request::Add;
+    request.session = _nextId.fetch_add(1);
+    request.entry = new Entry(*this, request.session, script, name, fd);
+    _active.fetch_add(1);
+    _post(request);
+    return request.session;
+}
+
+void
+ScriptRunner::feed(int session, const ByteView &data) {
+    Request request;
+    request.type = Request::Feed;
+    request.session = session;
+    request.size = static_cast<int>(data.size);
+    {
+        QMutexLocker lock(&_requestMutex);
+        request.offset = _feedBytes.size();
+        _feedBytes.append(data.data, request.size);
+        _requests.append(request);
+    }
+    _wake();
+}
+
+void
+ScriptRunner::cancel(int session) {
+    Request request;
+    request.type = Request::Cancel;
+    request.session = session;
+    _post(request);
+}
+
+void
+ScriptRunner::_post(const Request &request) {
+    {
+        QMutexLocker lock(&_requestMutex);
+        _requests.append(request);
+    }
+    _wake();
+}
+
+#ifdef Q_OS_LINUX
+
+void
+ScriptRunner::Entry::send(ScriptSession &, const QByteArray &data) {
+    if (fd < 0) {
+        emit runner.sendRequested(id, data);
+        return;
+    }
+
+    //Never wait for the device here, the thread is shared: whatever it does
+    //not take now (flow control, a stalled adapter) is queued behind earlier
+    //bytes and flushed by the runner.
+    const quint64 nowNs = monotonicNowNs();
+    if (pending.isEmpty()) {
+        pending = data;
+        writeDeadlineNs = nowNs + session.expectTimeoutNs();
+        runner._writeDevice(this, nowNs);
+    }
+    else {
+        pending.append(data);
+    }
+}
+
+void
+ScriptRunner::Entry::setLine(ScriptSession &, const QString &line, bool on) {
+    const ModemLineMonitor::Line bit = static_cast<ModemLineMonitor::Line>(ModemLineMonitor::lineFromName(line));
+    if (fd < 0) {
+        emit runner.lineRequested(id, bit, on);
+        return;
+    }
+    if (!ModemLineMonitor::setLine(fd, bit, on)) {
+        session.cancel(QStringLiteral("%1: %2").arg(line, QString::fromLocal8Bit(strerror(errno))), monotonicNowNs());
+    }
+}
+
+bool
+ScriptRunner::start() {
+    if (_thread.joinable()) { return true; }
+
+    _epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    _wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    _timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (_epollFd < 0 || _wakeFd < 0 || _timerFd < 0) {
+        _errorString = QStringLiteral("epoll: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        stop();
+        return false;
+    }
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = &_wakeFd;
+    ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &event);
+    event.data.ptr = &_timerFd;
+    ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _timerFd, &event);
+
+    _armedNs = 0;
+    _running.store(true);
+    _thread = std::thread(&ScriptRunner::_run, this);
+    return true;
+}
+
+void
+ScriptRunner::stop() {
+    if (_thread.joinable()) {
+        _running.store(false);
+        _wake();
+        _thread.join();
+    }
+
+    for (Entry *entry : _entries) {
+        if (entry->fd >= 0) { ::close(entry->fd); }
+        delete entry;
+    }
+    _entries.clear();
+
+    QMutexLocker lock(&_requestMutex);
+    for (const Request &request : _requests) {
+        if (request.entry) {
+            if (request.entry->fd >= 0) { ::close(request.entry->fd); }
+            delete request.entry;
+        }
+    }
+    _requests.clear();
+    _feedBytes.resize(0);
+    lock.unlock();
+    _active.store(0);
+
+    if (_epollFd >= 0) { ::close(_epollFd); }
+    if (_wakeFd >= 0) { ::close(_wakeFd); }
+    if (_timerFd >= 0) { ::close(_timerFd); }
+    _epollFd = -1;
+    _wakeFd = -1;
+    _timerFd = -1;
+}
+
+void
+ScriptRunner::_run() {
+    epoll_event events[64];
+
+    while (_running.load(std::memory_order_relaxed)) {
+        const int count = ::epoll_wait(_epollFd, events, 64, -1);
+        if (count < 0) {
+            if (errno == EINTR) { continue; }
+            qWarning("ScriptRunner: epoll_wait: %s", strerror(errno));
+            return;
+        }
+
+        const quint64 nowNs = monotonicNowNs();
+        for (int x = 0; x < count; x++) {
+            void *tag = events[x].data.ptr;
+            if (tag == &_wakeFd) {
+                eventfd_t value;
+                ::eventfd_read(_wakeFd, &value);
+                _handleRequests(nowNs);
+            }
+            else if (tag == &_timerFd) {
+                quint64 expirations;
+                if (::read(_timerFd, &expirations, sizeof(expirations)) < 0) { continue; }
+                _armedNs = 0;
+            }
+            else {
+                Entry *entry = static_cast<Entry *>(tag);
+                if (events[x].events & EPOLLIN) {
+                    _readDevice(entry, nowNs);
+                }
+                if (events[x].events & EPOLLOUT) {
+                    _writeDevice(entry, nowNs);
+                }
+                if (events[x].events & (EPOLLERR | EPOLLHUP)) {
+                    entry->session.cancel(QStringLiteral("device closed"), nowNs);
+                    entry->pending.clear();
+                }
+            }
+        }
+
+        const quint64 afterNs = monotonicNowNs();
+        for (Entry *entry : _entries) {
+            if (!entry->pending.isEmpty() && entry->writeDeadlineNs <= afterNs) {
+                const QString reason = QStringLiteral("write: %1 bytes not taken by the device in time")
+                        .arg(entry->pending.size());
+                emit logged(entry->id, reason);
+                entry->session.cancel(reason, afterNs);
+                entry->pending.clear();
+                _watchWrites(entry, false);
+            }
+            const quint64 deadlineNs = entry->session.deadlineNs();
+            if (deadlineNs != 0 && deadlineNs <= afterNs) {
+                entry->session.advance(afterNs);
+            }
+        }
+
+        _reap();
+        _armTimer();
+    }
+}
+
+void
+ScriptRunner::_handleRequests(quint64 nowNs) {
+    {
+        QMutexLocker lock(&_requestMutex);
+        _handling.swap(_requests);
+        _handlingBytes.swap(_feedBytes);
+    }
+
+    for (const Request &request : _handling) {
+        if (request.type == Request::Add) {
+            Entry *entry = request.entry;
+            _entries.append(entry);
+            if (entry->fd >= 0) {
+                epoll_event event;
+                std::memset(&event, 0, sizeof(event));
+                event.events = EPOLLIN;
+                event.data.ptr = entry;
+                if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, entry->fd, &event) != 0) {
+                    entry->session.cancel(QStringLiteral("epoll_ctl: %1").arg(QString::fromLocal8Bit(strerror(errno))), nowNs);
+                    continue;
+                }
+            }
+            entry->session.start(nowNs);
+            continue;
+        }
+
+        for (Entry *entry : _entries) {
+            if (entry->id != request.session) { continue; }
+            if (request.type == Request::Feed) {
+                entry->session.feed(_handlingBytes.constData() + request.offset, request.size, nowNs);
+            }
+            else {
+                entry->session.cancel(QStringLiteral("cancelled"), nowNs);
+            }
+            break;
+        }
+    }
+    _handling.resize(0);
+    _handlingBytes.resize(0);
+}
+
+void
+ScriptRunner::_readDevice(Entry *entry, quint64 nowNs) {
+    char buffer[4096];
+    for (;;) {
+        const ssize_t count = ::read(entry->fd, buffer, sizeof(buffer));
+        if (count > 0) {
+            entry->session.feed(buffer, count, nowNs);
+            if (count < static_cast<ssize_t>(sizeof(buffer))) { return; }
+            continue;
+        }
+        if (count == 0 || (errno != EAGAIN && errno != EINTR)) {
+            entry->session.cancel(count == 0 ? QStringLiteral("device closed")
+                                             : QStringLiteral("read: %1").arg(QString::fromLocal8Bit(strerror(errno))),
+                                  nowNs);
+        }
+        return;
+    }
+}
+
+void
+ScriptRunner::_writeDevice(Entry *entry, quint64 nowNs) {
+    while (!entry->pending.isEmpty()) {
+        const ssize_t written = ::write(entry->fd, entry->pending.constData(),
+                                        static_cast<size_t>(entry->pending.size()));
+        if (written > 0) {
+            entry->pending.remove(0, static_cast<int>(written));
+            continue;
+        }
+        if (written < 0 && errno != EAGAIN && errno != EINTR) {
+            entry->session.cancel(QStringLiteral("write: %1").arg(QString::fromLocal8Bit(strerror(errno))), nowNs);
+            entry->pending.clear();
+        }
+        break;
+    }
+    _watchWrites(entry, !entry->pending.isEmpty());
+}
+
+void
+ScriptRunner::_watchWrites(Entry *entry, bool on) {
+    if (entry->watchingWrites == on) { return; }
+    entry->watchingWrites = on;
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = on ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.ptr = entry;
+    ::epoll_ctl(_epollFd, EPOLL_CTL_MOD, entry->fd, &event);
+}
+
+void
+ScriptRunner::_reap() {
+    for (int x = 0; x < _entries.size();) {
+        Entry *entry = _entries.at(x);
+        //A finished session's last bytes still go out, until the write deadline.
+        if (!entry->session.isFinished() || !entry->pending.isEmpty()) {
+            x++;
+            continue;
+        }
+
+        emit finished(entry->id, entry->session.state() == ScriptSession::Passed, entry->session.report());
+        if (entry->fd >= 0) {
+            ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, entry->fd, nullptr);
+            ::close(entry->fd);
+        }
+        delete entry;
+        _entries.remove(x);
+        _active.fetch_sub(1);
+    }
+}
+
+void
+ScriptRunner::_armTimer() {
+    quint64 nextNs = 0;
+    for (Entry *entry : _entries) {
+        quint64 deadlineNs = entry->session.deadlineNs();
+        if (!entry->pending.isEmpty() && (deadlineNs == 0 || entry->writeDeadlineNs < deadlineNs)) {
+            deadlineNs = entry->writeDeadlineNs;
+        }
+        if (deadlineNs != 0 && (nextNs == 0 || deadlineNs < nextNs)) {
+            nextNs = deadlineNs;
+        }
+    }
+    if (nextNs == _armedNs) { return; }
+
+    //monotonicNowNs() is CLOCK_MONOTONIC, so deadlines can be armed as absolute times.
+    itimerspec spec;
+    std::memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = static_cast<time_t>(nextNs / 1000000000ull);
+    spec.it_value.tv_nsec = static_cast<long>(nextNs % 1000000000ull);
+    ::timerfd_settime(_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    _armedNs = nextNs;
+}
+
+void
+ScriptRunner::_wake() {
+    if (_wakeFd >= 0) {
+        ::eventfd_write(_wakeFd, 1);
+    }
+}
+
+#else
+
+void
+ScriptRunner::Entry::send(ScriptSession &, const QByteArray &data) {
+    Q_UNUSED(data);
+}
+
+void
+ScriptRunner::Entry::setLine(ScriptSession &, const QString &line, bool on) {
+    Q_UNUSED(line);
+    Q_UNUSED(on);
+}
+
+bool
+ScriptRunner::start() {
+    _errorString = tr("Scripts are only available on Linux");
+    return false;
+}
+
+void
+ScriptRunner::stop() {
+}
+
+void
+ScriptRunner::_wake() {
+}
+
+#endif
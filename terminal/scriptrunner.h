@@ -0,0 +1,102 @@
+#ifndef SCRIPTRUNNER_H
+#define SCRIPTRUNNER_H
+
+#include "bufferpool.h"
+#include "script.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <thread>
+
+class ScriptSession;
+
+//Runs script sessions on one dedicated thread (Linux). The thread sleeps in
+//epoll_wait() on the devices of headless sessions, a timerfd armed for the
+//nearest expect/sleep deadline and an eventfd for requests from other
+//threads, so a session reacts to its input as soon as it is read and nothing
+//is polled. Sessions never block, which is what lets hundreds of them share
+//the thread: what a device does not take at once is queued per session and
+//flushed on EPOLLOUT, bounded by the session's expect timeout.
+//
+//Headless sessions own a configured descriptor that the runner reads and
+//writes itself. Attached sessions drive a port owned by someone else: input
+//is handed in with feed() and output comes back through sendRequested() and
+//lineRequested().
+class ScriptRunner : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void sendRequested(int session, const QByteArray &data);
+    //line is a ModemLineMonitor::Line.
+    void lineRequested(int session, quint32 line, bool on);
+    void logged(int session, const QString &text);
+    void finished(int session, bool passed, const QString &report);
+
+public:
+    explicit ScriptRunner(QObject *parent = nullptr);
+    ~ScriptRunner();
+
+    bool start();
+    void stop();
+    QString errorString() const { return _errorString; }
+
+    //Any thread. Returns the session id. The runner closes fd when done.
+    int addSession(const Script &script, const QString &name, int fd);
+    int addSession(const Script &script, const QString &name);
+    //Copies data into a buffer the runner reuses, so feeding every received
+    //chunk costs no allocation.
+    void feed(int session, const ByteView &data);
+    void cancel(int session);
+
+    int activeSessions() const { return _active.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry;
+    struct Request {
+        enum Type { Add, Feed, Cancel } type = Add;
+        int session = 0;
+        Entry *entry = nullptr;
+        //Feed: the bytes in _feedBytes.
+        int offset = 0;
+        int size = 0;
+    };
+
+    void _post(const Request &request);
+    void _run();
+    void _handleRequests(quint64 nowNs);
+    void _readDevice(Entry *entry, quint64 nowNs);
+    void _writeDevice(Entry *entry, quint64 nowNs);
+    void _watchWrites(Entry *entry, bool on);
+    void _reap();
+    void _armTimer();
+    void _wake();
+
+    int _epollFd = -1;
+    int _wakeFd = -1;
+    int _timerFd = -1;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<int> _nextId;
+    std::atomic<int> _active;
+
+    QMutex _requestMutex;
+    QVector<Request> _requests;
+    QByteArray _feedBytes;
+
+    //Runner thread only. Swapped with the two above, so both pairs keep
+    //their capacity.
+    QVector<Request> _handling;
+    QByteArray _handlingBytes;
+    QVector<Entry *> _entries;
+    quint64 _armedNs = 0;
+
+    QString _errorString;
+};
+
+#endif // SCRIPTRUNNER_H
@@ -0,0 +1,341 @@
+#include "scriptsession.h"
+#include "triggerengine.h"
+
+//A script that runs this many commands without waiting is assumed to spin.
+static const int MAX_COMMANDS_PER_RUN = 100000;
+
+ScriptSession::ScriptSession(const Script &script, const QString &name, Output &output) :
+    _script(script),
+    _name(name),
+    _output(output)
+{
+}
+
+void
+ScriptSession::start(quint64 nowNs) {
+    _state = Running;
+    _pc = 0;
+    _startNs = nowNs;
+    _endNs = nowNs;
+    _run(nowNs);
+}
+
+void
+ScriptSession::feed(const char *data, qint64 size, quint64 nowNs) {
+    if (isFinished() || size <= 0) { return; }
+
+    _buffer.append(data, static_cast<int>(size));
+    if (_buffer.size() > MAX_BUFFER) {
+        const int drop = _buffer.size() - MAX_BUFFER;
+        _buffer.remove(0, drop);
+        _searchFrom = qMax(0, _searchFrom - drop);
+    }
+
+    if (_state == Waiting && _match(nowNs)) {
+        _run(nowNs);
+    }
+}
+
+void
+ScriptSession::advance(quint64 nowNs) {
+    if (_state != Waiting || nowNs < _deadlineNs) { return; }
+
+    const Script::Instruction &instruction = _script.instructions().at(_pc - 1);
+    if (instruction.op == Script::Instruction::Expect) {
+        Step step;
+        step.line = instruction.line;
+        step.waitedNs = nowNs - _waitStartNs;
+        _steps.append(step);
+        _variables.insert(QStringLiteral("timeout"), QStringLiteral("1"));
+        _output.log(*this, QStringLiteral("line %1: timeout").arg(instruction.line));
+    }
+
+    _state = Running;
+    _run(nowNs);
+}
+
+quint64
+ScriptSession::expectTimeoutNs() const {
+    bool ok = false;
+    qint64 ms = _number(_variables.value(QStringLiteral("timeout_ms")), &ok);
+    if (!ok) { ms = static_cast<qint64>(DEFAULT_TIMEOUT_MS); }
+    return static_cast<quint64>(qMax<qint64>(ms, 0)) * 1000000ull;
+}
+
+void
+ScriptSession::cancel(const QString &reason, quint64 nowNs) {
+    if (!isFinished()) {
+        _finish(Failed, nowNs, reason);
+    }
+}
+
+void
+ScriptSession::_run(quint64 nowNs) {
+    typedef Script::Instruction Instruction;
+    const QVector<Instruction> &code = _script.instructions();
+
+    int budget = MAX_COMMANDS_PER_RUN;
+    while (_state == Running) {
+        if (_pc >= code.size()) {
+            _finish(Passed, nowNs);
+            return;
+        }
+        if (--budget == 0) {
+            _finish(Failed, nowNs, QStringLiteral("line %1: %2 commands without waiting")
+                    .arg(code.at(_pc).line).arg(MAX_COMMANDS_PER_RUN));
+            return;
+        }
+
+        const Instruction &instruction = code.at(_pc++);
+        const QStringList &args = instruction.args;
+
+        switch (instruction.op) {
+        case Instruction::Set:
+            _variables.insert(args.at(0), _expand(args.at(1)));
+            break;
+
+        case Instruction::Incr: {
+            const qint64 step = args.size() > 1 ? _number(_expand(args.at(1))) : 1;
+            _variables.insert(args.at(0), QString::number(_number(_variables.value(args.at(0))) + step));
+            break;
+        }
+
+        case Instruction::Send:
+            _output.send(*this, TriggerEngine::unescape(_expand(args.at(0))));
+            break;
+
+        case Instruction::Line:
+            _output.setLine(*this, args.at(0), args.at(1) == QLatin1String("on"));
+            break;
+
+        case Instruction::Log:
+            _output.log(*this, QString::fromUtf8(TriggerEngine::unescape(_expand(args.at(0)))));
+            break;
+
+        case Instruction::Expect:
+        case Instruction::Sleep: {
+            qint64 ms;
+            if (instruction.op == Instruction::Sleep) {
+                ms = _number(_expand(args.at(0)));
+            }
+            else {
+                bool ok = false;
+                ms = args.size() > 1 ? _number(_expand(args.at(1)), &ok)
+                                     : _number(_variables.value(QStringLiteral("timeout_ms")), &ok);
+                if (!ok) { ms = static_cast<qint64>(DEFAULT_TIMEOUT_MS); }
+                _literal = instruction.regex ? QByteArray() : TriggerEngine::unescape(_expand(args.at(0)));
+                _searchFrom = 0;
+            }
+            _waitStartNs = nowNs;
+            _deadlineNs = nowNs + static_cast<quint64>(qMax<qint64>(ms, 0)) * 1000000ull;
+            _state = Waiting;
+            //Data that arrived before the expect counts.
+            if (instruction.op == Instruction::Expect && _match(nowNs)) {
+                break;
+            }
+            return;
+        }
+
+        case Instruction::Repeat: {
+            const qint64 count = args.isEmpty() ? -1 : _number(_expand(args.at(0)));
+            if (count == 0) {
+                _pc = instruction.target + 1;
+                break;
+            }
+            Loop loop;
+            loop.start = _pc - 1;
+            loop.end = instruction.target;
+            loop.remaining = count;
+            _loops.append(loop);
+            break;
+        }
+
+        case Instruction::End:
+            //Only the loop we are in; an end reached by jumping in is a no-op.
+            if (_loops.isEmpty() || _loops.last().end != _pc - 1) { break; }
+            if (_loops.last().remaining > 0 && --_loops.last().remaining == 0) {
+                _loops.removeLast();
+            }
+            else {
+                _pc = _loops.last().start + 1;
+            }
+            break;
+
+        case Instruction::Label:
+            break;
+
+        case Instruction::Goto:
+            _jump(instruction.target);
+            break;
+
+        case Instruction::If:
+            if (_condition(args)) {
+                _jump(instruction.target);
+            }
+            break;
+
+        case Instruction::Fail:
+            _finish(Failed, nowNs, QStringLiteral("line %1: %2").arg(instruction.line)
+                    .arg(args.isEmpty() ? QStringLiteral("fail")
+                                        : QString::fromUtf8(TriggerEngine::unescape(_expand(args.at(0))))));
+            return;
+
+        case Instruction::Exit:
+            _finish(Passed, nowNs);
+            return;
+        }
+    }
+}
+
+bool
+ScriptSession::_match(quint64 nowNs) {
+    const Script::Instruction &instruction = _script.instructions().at(_pc - 1);
+    if (instruction.op != Script::Instruction::Expect) { return false; }
+
+    int end = -1;
+    if (instruction.regex) {
+        const QRegularExpressionMatch match = instruction.pattern.match(QString::fromLatin1(_buffer));
+        if (match.hasMatch()) {
+            end = match.capturedEnd();
+            for (int x = 0; x <= qMin(9, match.lastCapturedIndex()); x++) {
+                _variables.insert(QString::number(x), match.captured(x));
+            }
+        }
+    }
+    else {
+        const int at = _buffer.indexOf(_literal, _searchFrom);
+        if (at >= 0) {
+            end = at + _literal.size();
+            _variables.insert(QStringLiteral("0"), QString::fromLatin1(_literal));
+        }
+        else {
+            //Resume where a match could still start once more data arrives.
+            _searchFrom = qMax(0, _buffer.size() - _literal.size() + 1);
+        }
+    }
+    if (end < 0) { return false; }
+
+    //Like expect(1), everything up to the end of the match is consumed.
+    _buffer.remove(0, end);
+
+    Step step;
+    step.line = instruction.line;
+    step.waitedNs = nowNs - _waitStartNs;
+    step.matched = true;
+    _steps.append(step);
+
+    _variables.insert(QStringLiteral("timeout"), QStringLiteral("0"));
+    _state = Running;
+    return true;
+}
+
+void
+ScriptSession::_finish(State state, quint64 nowNs, const QString &failure) {
+    _state = state;
+    _endNs = nowNs;
+    _failure = failure;
+}
+
+void
+ScriptSession::_jump(int target) {
+    //Leave every loop whose body does not contain the target.
+    while (!_loops.isEmpty() && (target <= _loops.last().start || target > _loops.last().end)) {
+        _loops.removeLast();
+    }
+    _pc = target;
+}
+
+bool
+ScriptSession::_condition(const QStringList &args) const {
+    if (args.size() == 3) {
+        QString condition = args.at(0);
+        const bool negate = condition.startsWith(QLatin1Char('!'));
+        if (negate) { condition.remove(0, 1); }
+        const bool timedOut = _variables.value(QStringLiteral("timeout")) == QLatin1String("1");
+        const bool result = condition == QLatin1String("timeout") ? timedOut
+                          : condition == QLatin1String("matched") ? !timedOut
+                          : _number(_expand(condition)) != 0;
+        return result != negate;
+    }
+
+    const QString a = _expand(args.at(0));
+    const QString op = args.at(1);
+    const QString b = _expand(args.at(2));
+
+    bool aNumber = false;
+    bool bNumber = false;
+    const qint64 x = _number(a, &aNumber);
+    const qint64 y = _number(b, &bNumber);
+    const int compare = (aNumber && bNumber) ? (x < y ? -1 : (x > y ? 1 : 0)) : QString::compare(a, b);
+
+    if (op == QLatin1String("==")) { return compare == 0; }
+    if (op == QLatin1String("!=")) { return compare != 0; }
+    if (op == QLatin1String("<")) { return compare < 0; }
+    if (op == QLatin1String(">")) { return compare > 0; }
+    if (op == QLatin1String("<=")) { return compare <= 0; }
+    if (op == QLatin1String(">=")) { return compare >= 0; }
+    return false;
+}
+
+QString
+ScriptSession::_expand(const QString &text) const {
+    if (!text.contains(QLatin1Char('$'))) { return text; }
+
+    QString out;
+    out.reserve(text.size());
+    for (int x = 0; x < text.size(); x++) {
+        if (text.at(x) != QLatin1Char('$') || x + 1 == text.size()) {
+            out += text.at(x);
+            continue;
+        }
+
+        int start = x + 1;
+        int end = start;
+        if (text.at(start) == QLatin1Char('{')) {
+            end = text.indexOf(QLatin1Char('}'), start);
+            if (end < 0) {
+                out += text.at(x);
+                continue;
+            }
+            out += _variables.value(text.mid(start + 1, end - start - 1));
+            x = end;
+            continue;
+        }
+
+        while (end < text.size() && (text.at(end).isLetterOrNumber() || text.at(end) == QLatin1Char('_'))) {
+            end++;
+        }
+        if (end == start) {
+            out += text.at(x);
+            continue;
+        }
+        out += _variables.value(text.mid(start, end - start));
+        x = end - 1;
+    }
+    return out;
+}
+
+qint64
+ScriptSession::_number(const QString &text, bool *ok) const {
+    return text.trimmed().toLongLong(ok, 0);
+}
+
+QString
+ScriptSession::report() const {
+    QString out = QStringLiteral("%1: %2 in %3 ms")
+            .arg(_name)
+            .arg(_state == Passed ? QStringLiteral("PASSED")
+                                  : (_state == Failed ? QStringLiteral("FAILED") : QStringLiteral("RUNNING")))
+            .arg(elapsedNs() / 1e6, 0, 'f', 3);
+    if (!_failure.isEmpty()) {
+        out += QStringLiteral(" (%1)").arg(_failure);
+    }
+
+    for (const Step &step : _steps) {
+        out += QStringLiteral("\n  line %1 expect: %2 %3 ms")
+                .arg(step.line, 4)
+                .arg(step.matched ? QStringLiteral("matched") : QStringLiteral("TIMEOUT"))
+                .arg(step.waitedNs / 1e6, 0, 'f', 3);
+    }
+    return out;
+}
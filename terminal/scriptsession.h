@@ -0,0 +1,105 @@
+#ifndef SCRIPTSESSION_H
+#define SCRIPTSESSION_H
+
+#include "script.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+//One running instance of a Script against one device. The session never
+//blocks: it runs until it has to wait for data or time and then returns, so a
+//single thread can drive any number of sessions. Input is pushed in with
+//feed() as it arrives and timeouts are delivered with advance().
+class ScriptSession
+{
+public:
+    enum State {
+        Idle,
+        Running,
+        Waiting,
+        Passed,
+        Failed
+    };
+
+    class Output
+    {
+    public:
+        virtual ~Output() {}
+        virtual void send(ScriptSession &session, const QByteArray &data) = 0;
+        virtual void log(ScriptSession &session, const QString &text) = 0;
+        //line is "DTR" or "RTS" in any case.
+        virtual void setLine(ScriptSession &session, const QString &line, bool on) = 0;
+    };
+
+    struct Step {
+        int line = 0;
+        quint64 waitedNs = 0;
+        bool matched = false;
+    };
+
+    static const int MAX_BUFFER = 64 * 1024;
+    static const quint64 DEFAULT_TIMEOUT_MS = 10000;
+
+    ScriptSession(const Script &script, const QString &name, Output &output);
+
+    QString name() const { return _name; }
+    State state() const { return _state; }
+    bool isFinished() const { return _state == Passed || _state == Failed; }
+
+    void start(quint64 nowNs);
+    void feed(const char *data, qint64 size, quint64 nowNs);
+    //Resumes a wait whose deadline has passed.
+    void advance(quint64 nowNs);
+    void cancel(const QString &reason, quint64 nowNs);
+
+    //0 while not waiting on a deadline.
+    quint64 deadlineNs() const { return _state == Waiting ? _deadlineNs : 0; }
+    //What an expect without its own timeout would wait now; the runner
+    //bounds device writes with it.
+    quint64 expectTimeoutNs() const;
+
+    const QVector<Step> &steps() const { return _steps; }
+    quint64 elapsedNs() const { return _endNs - _startNs; }
+    QString failure() const { return _failure; }
+    QString report() const;
+
+private:
+    struct Loop {
+        int start;
+        int end;
+        qint64 remaining;   //-1 forever
+    };
+
+    void _run(quint64 nowNs);
+    bool _match(quint64 nowNs);
+    void _finish(State state, quint64 nowNs, const QString &failure = QString());
+    void _jump(int target);
+    bool _condition(const QStringList &args) const;
+    QString _expand(const QString &text) const;
+    qint64 _number(const QString &text, bool *ok = nullptr) const;
+
+    const Script _script;
+    const QString _name;
+    Output &_output;
+
+    State _state = Idle;
+    int _pc = 0;
+    QHash<QString, QString> _variables;
+    QVector<Loop> _loops;
+    QByteArray _buffer;
+
+    //Current wait
+    QByteArray _literal;
+    int _searchFrom = 0;
+    quint64 _waitStartNs = 0;
+    quint64 _deadlineNs = 0;
+
+    QVector<Step> _steps;
+    quint64 _startNs = 0;
+    quint64 _endNs = 0;
+    QString _failure;
+};
+
+#endif // SCRIPTSESSION_H
@@ -0,0 +1,148 @@
+#include "searchbar.h"
+#include "console.h"
+
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTimer>
+
+SearchBar::SearchBar(Console *console, QWidget *parent) :
+    QWidget(parent),
+    _console(console),
+    _search(new LineSearch(console->lineStore(), this)),
+    _pattern(new QLineEdit),
+    _regex(new QCheckBox(tr("Regex"))),
+    _caseSensitive(new QCheckBox(tr("Match case"))),
+    _status(new QLabel),
+    _debounce(new QTimer(this))
+{
+    _pattern->setPlaceholderText(tr("Search scrollback"));
+    _pattern->setClearButtonEnabled(true);
+
+    QPushButton *previous = new QPushButton(tr("Previous"));
+    QPushButton *next = new QPushButton(tr("Next"));
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(_pattern, 1);
+    layout->addWidget(_regex);
+    layout->addWidget(_caseSensitive);
+    layout->addWidget(previous);
+    layout->addWidget(next);
+    layout->addWidget(_status);
+
+    //Restarting on every keystroke would only cancel searches that just began.
+    _debounce->setSingleShot(true);
+    _debounce->setInterval(150);
+    connect(_debounce, &QTimer::timeout, this, &SearchBar::_slot_search);
+    connect(_pattern, &QLineEdit::textChanged, _debounce, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(_regex, &QCheckBox::toggled, this, &SearchBar::_slot_search);
+    connect(_caseSensitive, &QCheckBox::toggled, this, &SearchBar::_slot_search);
+    connect(_pattern, &QLineEdit::returnPressed, this, &SearchBar::_slot_next);
+    connect(next, &QPushButton::clicked, this, &SearchBar::_slot_next);
+    connect(previous, &QPushButton::clicked, this, &SearchBar::_slot_previous);
+
+    connect(_search, &LineSearch::hitsReady, this, &SearchBar::_slot_hits);
+    connect(_search, &LineSearch::finished, this, &SearchBar::_slot_finished);
+    //Direct: the worker has to let go of the store before it is cleared.
+    connect(_console, &Console::aboutToClear, this, &SearchBar::_slot_cleared, Qt::DirectConnection);
+}
+
+void
+SearchBar::activate() {
+    _pattern->setFocus();
+    _pattern->selectAll();
+}
+
+void
+SearchBar::_slot_search() {
+    _debounce->stop();
+    _hits.resize(0);
+    _current = -1;
+    _done.clear();
+
+    LineSearch::Query query;
+    query.pattern = _pattern->text();
+    query.regex = _regex->isChecked();
+    query.caseSensitive = _caseSensitive->isChecked();
+    if (!_search->start(query)) {
+        _searching = false;
+        _status->setText(_search->errorString());
+        return;
+    }
+    _searching = !query.pattern.isEmpty();
+    _updateStatus();
+}
+
+void
+SearchBar::_slot_hits() {
+    const bool first = _hits.isEmpty();
+    _search->takeHits(_hits);
+    if (first && !_hits.isEmpty()) {
+        _show(0);
+    }
+    _updateStatus();
+}
+
+void
+SearchBar::_slot_finished(quint64 generation, qint64 lines, qint64 elapsedNs) {
+    if (generation != _search->generation()) { return; }
+
+    _slot_hits();
+    _searching = false;
+    _done = tr("in %1 lines, %2 ms").arg(lines).arg(elapsedNs / 1e6, 0, 'f', 1);
+    _updateStatus();
+}
+
+void
+SearchBar::_slot_next() {
+    if (_hits.isEmpty()) { return; }
+    _show(_current + 1 < _hits.size() ? _current + 1 : 0);
+}
+
+void
+SearchBar::_slot_previous() {
+    if (_hits.isEmpty()) { return; }
+    _show(_current > 0 ? _current - 1 : _hits.size() - 1);
+}
+
+void
+SearchBar::_slot_cleared() {
+    _search->cancel();
+    _hits.resize(0);
+    _current = -1;
+    _searching = false;
+    _done.clear();
+    _updateStatus();
+}
+
+void
+SearchBar::_show(int index) {
+    _current = index;
+    const SearchHit &hit = _hits.at(index);
+    _console->showLine(hit.line, hit.column);
+    _updateStatus();
+}
+
+void
+SearchBar::_updateStatus() {
+    if (_pattern->text().isEmpty()) {
+        _status->clear();
+        return;
+    }
+
+    QString text = _current >= 0 ? tr("%1 of %2").arg(_current + 1).arg(_hits.size())
+                                 : tr("%1 matches").arg(_hits.size());
+    if (_hits.size() >= LineSearch::MAX_HITS) {
+        text += QLatin1Char('+');
+    }
+    if (_searching) {
+        text += tr(", searching...");
+    }
+    else if (!_done.isEmpty()) {
+        text += QLatin1Char(' ') + _done;
+    }
+    _status->setText(text);
+}
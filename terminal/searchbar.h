@@ -0,0 +1,59 @@
+#ifndef SEARCHBAR_H
+#define SEARCHBAR_H
+
+#include "linesearch.h"
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QTimer;
+
+QT_END_NAMESPACE
+
+class Console;
+
+//Find bar for the console scrollback. The search runs on a LineSearch worker
+//while the user types; the match count grows as hits stream in and every
+//edit restarts the search.
+class SearchBar : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SearchBar(Console *console, QWidget *parent = nullptr);
+
+    void activate();
+    //Heap held by the hits of the last search.
+    qint64 indexBytes() const { return _hits.capacity() * qint64(sizeof(SearchHit)); }
+
+private slots:
+    void _slot_search();
+    void _slot_hits();
+    void _slot_finished(quint64 generation, qint64 lines, qint64 elapsedNs);
+    void _slot_next();
+    void _slot_previous();
+    void _slot_cleared();
+
+private:
+    void _show(int index);
+    void _updateStatus();
+
+    Console *_console = nullptr;
+    LineSearch *_search = nullptr;
+    QLineEdit *_pattern = nullptr;
+    QCheckBox *_regex = nullptr;
+    QCheckBox *_caseSensitive = nullptr;
+    QLabel *_status = nullptr;
+    QTimer *_debounce = nullptr;
+
+    QVector<SearchHit> _hits;
+    int _current = -1;
+    bool _searching = false;
+    QString _done;
+};
+
+#endif // SEARCHBAR_H
@@ -0,0 +1,128 @@
+#ifndef SEGMENTEDVECTOR_H
+#define SEGMENTEDVECTOR_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Append-only vector made of fixed-size segments. Elements never move once
+// written and the segment directory is reserved up front, so a single writer
+// can keep appending while other threads read any index below a size() they
+// have observed, without locks.
+//
+// Segments are normally allocated here, but adopt() can start the vector on
+// segments that live elsewhere, e.g. in a mapped session file.
+template <typename T, int SegmentBits = 16, int MaxSegments = 65536>
+class SegmentedVector
+{
+public:
+    static const qint64 SegmentSize = qint64(1) << SegmentBits;
+
+    SegmentedVector() : _size(0) {
+        _segments.reserve(MaxSegments);
+    }
+
+    SegmentedVector(const SegmentedVector &) = delete;
+    SegmentedVector &operator=(const SegmentedVector &) = delete;
+
+    qint64 size() const { return _size.load(std::memory_order_acquire); }
+
+    static qint64 capacity() { return SegmentSize * MaxSegments; }
+
+    const T &at(qint64 index) const {
+        return _segments[static_cast<size_t>(index >> SegmentBits)][index & (SegmentSize - 1)];
+    }
+
+    T &at(qint64 index) {
+        return _segments[static_cast<size_t>(index >> SegmentBits)][index & (SegmentSize - 1)];
+    }
+
+    // Writer only. Returns false once MaxSegments are in use.
+    bool append(const T &value) {
+        const qint64 index = _size.load(std::memory_order_relaxed);
+        if ((index & (SegmentSize - 1)) == 0) {
+            if (static_cast<size_t>(index >> SegmentBits) >= static_cast<size_t>(MaxSegments)) {
+                return false;
+            }
+            _allocateSegment();
+        }
+        at(index) = value;
+        _size.store(index + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Writer only. Appends count elements that are guaranteed to be contiguous
+    // in memory, skipping to the next segment if they do not fit in the current
+    // one. Returns the index of the first element, or -1 when full.
+    qint64 appendRange(const T *values, int count) {
+        qint64 index = _size.load(std::memory_order_relaxed);
+        if (count <= 0 || count > SegmentSize) {
+            return count == 0 ? index : -1;
+        }
+        const qint64 room = (index & (SegmentSize - 1)) ? SegmentSize - (index & (SegmentSize - 1)) : 0;
+        if (room < count) {
+            index += room;
+            if (static_cast<size_t>(index >> SegmentBits) >= static_cast<size_t>(MaxSegments)) {
+                return -1;
+            }
+            _allocateSegment();
+        }
+        T *first = &at(index);
+        for (int x = 0; x < count; x++) {
+            first[x] = values[x];
+        }
+        _size.store(index + count, std::memory_order_release);
+        return index;
+    }
+
+    // Writer only, with no concurrent readers.
+    void clear() {
+        _segments.clear();
+        _owned.clear();
+        _size.store(0, std::memory_order_release);
+    }
+
+    // Writer only, on an empty vector. The first size elements are already in
+    // segments, which the caller keeps alive and writable until clear(); later
+    // appends go to the last of them until it is full.
+    void adopt(const std::vector<T *> &segments, qint64 size) {
+        _segments.assign(segments.begin(), segments.end());
+        _size.store(size, std::memory_order_release);
+    }
+
+    // Writer only, with no concurrent readers. Replaces the leading segments,
+    // which must be full, with copies of them that the caller keeps alive
+    // until clear(), and frees the ones allocated here. Returns the bytes freed.
+    qint64 relocate(const std::vector<T *> &segments) {
+        qint64 freed = 0;
+        for (size_t x = 0; x < segments.size() && x < _segments.size(); x++) {
+            T *const old = _segments[x];
+            _segments[x] = segments[x];
+            for (auto owned = _owned.begin(); owned != _owned.end(); ++owned) {
+                if (owned->get() == old) {
+                    _owned.erase(owned);
+                    freed += SegmentSize * qint64(sizeof(T));
+                    break;
+                }
+            }
+        }
+        return freed;
+    }
+
+    // Heap held by segments allocated here.
+    qint64 ownedBytes() const { return qint64(_owned.size()) * SegmentSize * qint64(sizeof(T)); }
+
+private:
+    void _allocateSegment() {
+        _owned.emplace_back(new T[SegmentSize]);
+        _segments.push_back(_owned.back().get());
+    }
+
+    std::vector<T *> _segments;
+    std::vector<std::unique_ptr<T[]>> _owned;
+    std::atomic<qint64> _size;
+};
+
+#endif // SEGMENTEDVECTOR_H
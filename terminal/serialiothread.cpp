@@ -0,0 +1,615 @@
+#include "serialiothread.h"
+#include "baudrate.h"
+#include "monotonicclock.h"
+#include "uartcounters.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSerialPortInfo>
+
+#include <cstddef>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+static const size_t TRIGGER_QUEUE_SIZE = 256;
+
+//MainWindow creates it with plain new, which ignores extended alignment before C++17.
+static_assert(alignof(SerialIoThread) <= alignof(std::max_align_t), "SerialIoThread is over-aligned");
+
+SerialIoThread::SerialIoThread(BufferPool &pool, RoundTripMeter &roundTrip, TriggerEngine &triggers,
+                               QObject *parent) :
+    QObject(parent),
+    _pool(pool),
+    _roundTrip(roundTrip),
+    _triggers(triggers),
+    _chunks(static_cast<size_t>(pool.blockCount())),
+    _triggerHits(TRIGGER_QUEUE_SIZE),
+    _running(false),
+    _notifyPending(false),
+    _triggerPending(false),
+    _probePeriodNs(0)
+{
+}
+
+SerialIoThread::~SerialIoThread() {
+    close();
+}
+
+qint64
+SerialIoThread::pendingTxBytes() {
+    QMutexLocker lock(&_txMutex);
+    return _txPending.size();
+}
+
+void
+SerialIoThread::setProbePeriod(quint64 periodNs) {
+    _probePeriodNs.store(periodNs);
+    _wake();
+}
+
+#ifdef Q_OS_LINUX
+
+static QString
+errnoString(const char *what) {
+    return QStringLiteral("%1: %2").arg(QLatin1String(what), QString::fromLocal8Bit(strerror(errno)));
+}
+
+static bool
+speedFor(qint32 baudRate, speed_t &speed) {
+    switch (baudRate) {
+    case 1200: speed = B1200; return true;
+    case 2400: speed = B2400; return true;
+    case 4800: speed = B4800; return true;
+    case 9600: speed = B9600; return true;
+    case 19200: speed = B19200; return true;
+    case 38400: speed = B38400; return true;
+    case 57600: speed = B57600; return true;
+    case 115200: speed = B115200; return true;
+    case 230400: speed = B230400; return true;
+    case 460800: speed = B460800; return true;
+    case 500000: speed = B500000; return true;
+    case 576000: speed = B576000; return true;
+    case 921600: speed = B921600; return true;
+    case 1000000: speed = B1000000; return true;
+    case 1152000: speed = B1152000; return true;
+    case 1500000: speed = B1500000; return true;
+    case 2000000: speed = B2000000; return true;
+    case 2500000: speed = B2500000; return true;
+    case 3000000: speed = B3000000; return true;
+    case 3500000: speed = B3500000; return true;
+    case 4000000: speed = B4000000; return true;
+    default: return false;
+    }
+}
+
+QString
+SerialIoThread::_devicePath(const QString &name) {
+    const QString path = QSerialPortInfo(name).systemLocation();
+    return (path.isEmpty() || !QFileInfo::exists(path)) ? name : path;
+}
+
+int
+SerialIoThread::openDevice(const SettingsDialog::Settings &settings, QString &errorString) {
+    const QString path = _devicePath(settings.name);
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        errorString = errnoString("open");
+        return -1;
+    }
+
+    if (::ioctl(fd, TIOCEXCL) != 0 && errno != ENOTTY) {
+        errorString = errnoString("TIOCEXCL");
+        ::close(fd);
+        return -1;
+    }
+
+    if (!_configure(fd, settings, errorString)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool
+SerialIoThread::open(const SettingsDialog::Settings &settings) {
+    close();
+
+    const QString path = _devicePath(settings.name);
+    _fd = openDevice(settings, _errorString);
+    if (_fd < 0) {
+        return false;
+    }
+    _lowLatencyApplied = _setLowLatency(path);
+    ::tcflush(_fd, TCIOFLUSH);
+
+    _epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    _wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_epollFd < 0 || _wakeFd < 0) {
+        _errorString = errnoString("epoll");
+        close();
+        return false;
+    }
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = _wakeFd;
+    ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &event);
+    _interest = EPOLLIN;
+    event.events = _interest;
+    event.data.fd = _fd;
+    if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _fd, &event) != 0) {
+        _errorString = errnoString("epoll_ctl");
+        close();
+        return false;
+    }
+
+    _poolStarved = false;
+    _markOverruns = settings.markOverruns && UartCounters::readOverruns(_fd, _overruns);
+    _notifyPending.store(false);
+    _triggerPending.store(false);
+    _probe.reset();
+    _running.store(true);
+    //Wait for the scheduling: it is applied on the thread itself, since a nice
+    //value can only be given to a thread by its id.
+    std::promise<ThreadScheduling::Result> scheduled;
+    std::future<ThreadScheduling::Result> result = scheduled.get_future();
+    _thread = std::thread(&SerialIoThread::_run, this, std::move(scheduled), settings.realTime, settings.ioCpu);
+    _scheduling = result.get();
+
+    qDebug() << "Low latency I/O on" << path << "ASYNC_LOW_LATENCY:" << _lowLatencyApplied
+             << "baud rate:" << actualBaudRate(_fd) << "scheduling:" << _scheduling.describe()
+             << _scheduling.error;
+    return true;
+}
+
+void
+SerialIoThread::close() {
+    if (_thread.joinable()) {
+        _running.store(false);
+        _wake();
+        _thread.join();
+    }
+
+    _probe.close();
+    _probeArmedNs = 0;
+    if (_epollFd >= 0) { ::close(_epollFd); }
+    if (_wakeFd >= 0) { ::close(_wakeFd); }
+    _restoreLowLatency();
+    if (_fd >= 0) { ::close(_fd); }
+    _epollFd = -1;
+    _wakeFd = -1;
+    _fd = -1;
+
+    Chunk chunk;
+    while (_chunks.pop(chunk)) {
+        _pool.release(chunk.block);
+    }
+    TriggerHit hit;
+    while (_triggerHits.pop(hit)) {}
+
+    QMutexLocker lock(&_txMutex);
+    _txPending.clear();
+}
+
+qint64
+SerialIoThread::write(const QByteArray &data) {
+    if (_fd < 0) { return -1; }
+
+    _roundTrip.markSent(monotonicNowNs());
+    return _write(data.constData(), data.size());
+}
+
+qint64
+SerialIoThread::_write(const char *data, qint64 size) {
+    QMutexLocker lock(&_txMutex);
+    qint64 written = 0;
+    if (_txPending.isEmpty()) {
+        written = ::write(_fd, data, static_cast<size_t>(size));
+        if (written < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                _errorString = errnoString("write");
+                return -1;
+            }
+            written = 0;
+        }
+        if (written == size) {
+            return written;
+        }
+    }
+
+    //The driver's buffer is full; the I/O thread finishes the write.
+    _txPending.append(data + written, static_cast<int>(size - written));
+    lock.unlock();
+    _wake();
+    return size;
+}
+
+bool
+SerialIoThread::takeChunk(Chunk &chunk) {
+    if (_chunks.pop(chunk)) {
+        return true;
+    }
+
+    //Re-arm the notification, then look again in case a chunk was pushed
+    //after the pop above but before the flag was cleared.
+    _notifyPending.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return _chunks.pop(chunk);
+}
+
+bool
+SerialIoThread::takeTriggerHit(TriggerHit &hit) {
+    if (_triggerHits.pop(hit)) {
+        return true;
+    }
+
+    _triggerPending.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return _triggerHits.pop(hit);
+}
+
+bool
+SerialIoThread::_configure(int fd, const SettingsDialog::Settings &settings, QString &errorString) {
+    termios tio;
+    if (::tcgetattr(fd, &tio) != 0) {
+        errorString = errnoString("tcgetattr");
+        return false;
+    }
+
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+
+    //Rates without a B* constant are set with termios2 afterwards.
+    speed_t speed;
+    const bool standard = speedFor(settings.baudRate, speed);
+    if (!standard) {
+        speed = B38400;
+    }
+    ::cfsetispeed(&tio, speed);
+    ::cfsetospeed(&tio, speed);
+
+    tio.c_cflag &= ~CSIZE;
+    switch (settings.dataBits) {
+    case QSerialPort::Data5: tio.c_cflag |= CS5; break;
+    case QSerialPort::Data6: tio.c_cflag |= CS6; break;
+    case QSerialPort::Data7: tio.c_cflag |= CS7; break;
+    default: tio.c_cflag |= CS8; break;
+    }
+
+    tio.c_cflag &= ~(PARENB | PARODD | CMSPAR);
+    switch (settings.parity) {
+    case QSerialPort::EvenParity: tio.c_cflag |= PARENB; break;
+    case QSerialPort::OddParity: tio.c_cflag |= PARENB | PARODD; break;
+    case QSerialPort::MarkParity: tio.c_cflag |= PARENB | CMSPAR | PARODD; break;
+    case QSerialPort::SpaceParity: tio.c_cflag |= PARENB | CMSPAR; break;
+    default: break;
+    }
+
+    if (settings.stopBits == QSerialPort::TwoStop) {
+        tio.c_cflag |= CSTOPB;
+    }
+    else {
+        tio.c_cflag &= ~CSTOPB;
+    }
+
+    tio.c_cflag &= ~CRTSCTS;
+    tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+    if (settings.flowControl == QSerialPort::HardwareControl) {
+        tio.c_cflag |= CRTSCTS;
+    }
+    else if (settings.flowControl == QSerialPort::SoftwareControl) {
+        tio.c_iflag |= IXON | IXOFF;
+    }
+
+    //Wake the reader on the first byte, never wait for an inter-byte timer.
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+
+    if (::tcsetattr(fd, TCSANOW, &tio) != 0) {
+        errorString = errnoString("tcsetattr");
+        return false;
+    }
+    if (!standard && !setCustomBaudRate(fd, settings.baudRate)) {
+        errorString = tr("Baud rate %1: %2").arg(settings.baudRate).arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+bool
+SerialIoThread::_setLowLatency(const QString &path) {
+    //USB adapters batch received bytes for up to their latency timer (16 ms
+    //by default on FTDI); drop it to 1 ms where the driver exposes it.
+    //The old values are kept for close(); nothing is kept for what was
+    //already set.
+    const QString timerPath = QStringLiteral("/sys/class/tty/%1/device/latency_timer")
+            .arg(QFileInfo(path).canonicalFilePath().section(QLatin1Char('/'), -1));
+    QFile timer(timerPath);
+    if (timer.open(QIODevice::ReadOnly)) {
+        const QByteArray old = timer.readAll().trimmed();
+        timer.close();
+        if (!old.isEmpty() && old != "1" && timer.open(QIODevice::WriteOnly) && timer.write("1") == 1) {
+            _latencyTimerPath = timerPath;
+            _savedLatencyTimer = old;
+        }
+    }
+
+    serial_struct serial;
+    if (::ioctl(_fd, TIOCGSERIAL, &serial) != 0) {
+        return false;
+    }
+    if (serial.flags & ASYNC_LOW_LATENCY) {
+        return true;
+    }
+    const int flags = serial.flags;
+    serial.flags |= ASYNC_LOW_LATENCY;
+    if (::ioctl(_fd, TIOCSSERIAL, &serial) != 0) {
+        return false;
+    }
+    _restoreSerialFlags = true;
+    _savedSerialFlags = flags;
+    return true;
+}
+
+void
+SerialIoThread::_restoreLowLatency() {
+    if (_fd >= 0 && _restoreSerialFlags) {
+        //Only the bit set here; the rest may have been changed since.
+        serial_struct serial;
+        if (::ioctl(_fd, TIOCGSERIAL, &serial) == 0) {
+            serial.flags = (serial.flags & ~ASYNC_LOW_LATENCY) | (_savedSerialFlags & ASYNC_LOW_LATENCY);
+            if (::ioctl(_fd, TIOCSSERIAL, &serial) != 0) {
+                qWarning() << "Low latency I/O:" << errnoString("TIOCSSERIAL");
+            }
+        }
+    }
+    _restoreSerialFlags = false;
+
+    if (!_latencyTimerPath.isEmpty()) {
+        QFile timer(_latencyTimerPath);
+        if (!timer.open(QIODevice::WriteOnly) || timer.write(_savedLatencyTimer) != _savedLatencyTimer.size()) {
+            qWarning() << "Low latency I/O: cannot restore" << _latencyTimerPath << timer.errorString();
+        }
+    }
+    _latencyTimerPath.clear();
+    _savedLatencyTimer.clear();
+}
+
+void
+SerialIoThread::_run(std::promise<ThreadScheduling::Result> scheduled, bool realTime, int cpu) {
+    scheduled.set_value(ThreadScheduling::apply(realTime, cpu));
+
+    epoll_event events[4];
+
+    while (_running.load(std::memory_order_relaxed)) {
+        _updateProbe();
+
+        //While the pool is exhausted the port is taken out of the interest set
+        //and retried every millisecond; the kernel buffers data meanwhile.
+        const int count = ::epoll_wait(_epollFd, events, 4, _poolStarved ? 1 : -1);
+        if (count < 0) {
+            if (errno == EINTR) { continue; }
+            _fail(errnoString("epoll_wait"));
+            return;
+        }
+
+        for (int x = 0; x < count; x++) {
+            if (events[x].data.fd == _wakeFd) {
+                eventfd_t value;
+                ::eventfd_read(_wakeFd, &value);
+                continue;
+            }
+            if (events[x].data.fd == _probe.handle()) {
+                _probe.expired();
+                continue;
+            }
+
+            if (events[x].events & (EPOLLERR | EPOLLHUP)) {
+                _fail(tr("The serial device was removed or reported an error"));
+                return;
+            }
+            if (events[x].events & EPOLLIN) {
+                _readAvailable();
+            }
+            if (events[x].events & EPOLLOUT) {
+                _flushTx();
+            }
+        }
+
+        if (_poolStarved) {
+            _readAvailable();
+        }
+        _updateInterest();
+    }
+}
+
+void
+SerialIoThread::_updateProbe() {
+    const quint64 periodNs = _probePeriodNs.load(std::memory_order_relaxed);
+    if (periodNs == _probeArmedNs) { return; }
+
+    if (_probe.isOpen()) {
+        ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, _probe.handle(), nullptr);
+        _probe.close();
+    }
+    //One that cannot be armed is not retried until the period changes.
+    _probeArmedNs = periodNs;
+    if (periodNs == 0 || !_probe.open(periodNs)) { return; }
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = _probe.handle();
+    if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _probe.handle(), &event) != 0) {
+        _probe.close();
+    }
+}
+
+void
+SerialIoThread::_readAvailable() {
+    for (;;) {
+        BufferPool::Block *block = _pool.acquire();
+        _poolStarved = block == nullptr;
+        if (_poolStarved) { return; }
+
+        const ssize_t count = ::read(_fd, block->data(), static_cast<size_t>(block->capacity()));
+        if (count <= 0) {
+            _pool.release(block);
+            if (count == 0 || (errno != EAGAIN && errno != EINTR)) {
+                _fail(count == 0 ? tr("The serial device was closed") : errnoString("read"));
+            }
+            return;
+        }
+
+        Chunk chunk;
+        chunk.block = block;
+        chunk.size = count;
+        chunk.timestampNs = monotonicNowNs();
+        _roundTrip.markReceived(chunk.timestampNs);
+
+        quint64 overruns;
+        if (_markOverruns && UartCounters::readOverruns(_fd, overruns) && overruns != _overruns) {
+            _overruns = overruns;
+            chunk.overrun = true;
+        }
+
+        if (!_triggers.isEmpty()) {
+            _fireTriggers(block->view(count), chunk.timestampNs);
+        }
+
+        //The queue holds as many chunks as the pool has blocks, so it cannot
+        //be full while a block was available.
+        _chunks.push(chunk);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!_notifyPending.exchange(true)) {
+            emit readyRead();
+        }
+
+        if (count < block->capacity()) { return; }
+    }
+}
+
+void
+SerialIoThread::_fireTriggers(const ByteView &data, quint64 timestampNs) {
+    _hits.resize(0);
+    if (_triggers.scan(data, timestampNs, _hits) == 0) { return; }
+
+    for (TriggerHit &hit : _hits) {
+        const TriggerRule &rule = _triggers.rule(hit.rule);
+        if (rule.action == TriggerRule::Send && !rule.payload.isEmpty()) {
+            _write(rule.payload.constData(), rule.payload.size());
+            _triggers.recordSend(hit, monotonicNowNs());
+        }
+        //A full queue only costs the GUI the notification, the action itself is done.
+        _triggerHits.push(hit);
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!_triggerPending.exchange(true)) {
+        emit triggered();
+    }
+}
+
+void
+SerialIoThread::_flushTx() {
+    QMutexLocker lock(&_txMutex);
+    if (_txPending.isEmpty()) { return; }
+
+    const ssize_t written = ::write(_fd, _txPending.constData(), static_cast<size_t>(_txPending.size()));
+    if (written > 0) {
+        _txPending.remove(0, static_cast<int>(written));
+    }
+    else if (written < 0 && errno != EAGAIN && errno != EINTR) {
+        _txPending.clear();
+        lock.unlock();
+        _fail(errnoString("write"));
+    }
+}
+
+void
+SerialIoThread::_updateInterest() {
+    quint32 interest = _poolStarved ? 0 : EPOLLIN;
+    {
+        QMutexLocker lock(&_txMutex);
+        if (!_txPending.isEmpty()) { interest |= EPOLLOUT; }
+    }
+
+    if (interest != _interest) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = interest;
+        event.data.fd = _fd;
+        ::epoll_ctl(_epollFd, EPOLL_CTL_MOD, _fd, &event);
+        _interest = interest;
+    }
+}
+
+void
+SerialIoThread::_wake() {
+    if (_wakeFd >= 0) {
+        ::eventfd_write(_wakeFd, 1);
+    }
+}
+
+void
+SerialIoThread::_fail(const QString &message) {
+    _running.store(false);
+    emit errorOccurred(message);
+}
+
+#else
+
+bool
+SerialIoThread::open(const SettingsDialog::Settings &settings) {
+    Q_UNUSED(settings);
+    _errorString = tr("Low latency mode is only available on Linux");
+    return false;
+}
+
+void
+SerialIoThread::close() {
+}
+
+qint64
+SerialIoThread::write(const QByteArray &data) {
+    Q_UNUSED(data);
+    return -1;
+}
+
+int
+SerialIoThread::openDevice(const SettingsDialog::Settings &settings, QString &errorString) {
+    Q_UNUSED(settings);
+    errorString = tr("Direct device access is only available on Linux");
+    return -1;
+}
+
+bool
+SerialIoThread::takeChunk(Chunk &chunk) {
+    Q_UNUSED(chunk);
+    return false;
+}
+
+bool
+SerialIoThread::takeTriggerHit(TriggerHit &hit) {
+    Q_UNUSED(hit);
+    return false;
+}
+
+void
+SerialIoThread::_wake() {
+}
+
+#endif
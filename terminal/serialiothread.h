@@ -0,0 +1,145 @@
+#ifndef SERIALIOTHREAD_H
+#define SERIALIOTHREAD_H
+
+#include "bufferpool.h"
+#include "jitterprobe.h"
+#include "roundtripmeter.h"
+#include "settingsdialog.h"
+#include "spscqueue.h"
+#include "triggerengine.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+//Low-latency serial backend (Linux). The port is opened and configured with
+//termios directly: raw mode, VMIN=1/VTIME=0, ASYNC_LOW_LATENCY through
+//TIOCSSERIAL and, for USB adapters that have one, a 1 ms latency timer. A
+//dedicated thread blocks in epoll_wait() on the descriptor and reads straight
+//into BufferPool blocks the moment data arrives, instead of waiting for the
+//GUI event loop to service a QSocketNotifier. Chunks are handed to the GUI
+//thread through a lock-free queue; readyRead() is emitted once per batch.
+//
+//Triggers are matched on this thread before a chunk is queued, and Send
+//actions are written from here, so their latency does not depend on the GUI.
+//Hits are passed on to the GUI thread for the other actions and reporting.
+//
+//In real-time mode the thread asks for SCHED_FIFO (or a nice boost) and can be
+//pinned to a CPU. A JitterProbe in the same epoll set measures the wake-up
+//latency the thread actually gets, while it is switched on.
+class SerialIoThread : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void readyRead();
+    void triggered();
+    void errorOccurred(const QString &message);
+
+public:
+    struct Chunk {
+        BufferPool::Block *block = nullptr;
+        qint64 size = 0;
+        quint64 timestampNs = 0;
+        //The driver counted an overrun since the previous read (overrun
+        //marking only): the lost bytes belong somewhere in this chunk.
+        bool overrun = false;
+    };
+
+    SerialIoThread(BufferPool &pool, RoundTripMeter &roundTrip, TriggerEngine &triggers,
+                   QObject *parent = nullptr);
+    ~SerialIoThread();
+
+    bool open(const SettingsDialog::Settings &settings);
+    void close();
+    bool isOpen() const { return _fd >= 0; }
+    //The device descriptor, for ioctls such as the modem lines; -1 when closed.
+    int handle() const { return _fd; }
+
+    QString errorString() const { return _errorString; }
+    bool lowLatencyApplied() const { return _lowLatencyApplied; }
+    //What the real-time options got for the I/O thread.
+    ThreadScheduling::Result scheduling() const { return _scheduling; }
+
+    //Any thread; 0 switches the probe off. The histogram starts over with
+    //every open().
+    void setProbePeriod(quint64 periodNs);
+    //For histogram(), missed() and reset() only, the timer belongs to the
+    //I/O thread.
+    JitterProbe &probe() { return _probe; }
+
+    //Writes immediately from the calling thread; whatever the driver does not
+    //take right away is queued and flushed by the I/O thread.
+    qint64 write(const QByteArray &data);
+    //Bytes written but not yet taken by the driver.
+    qint64 pendingTxBytes();
+
+    //Opens and configures the device (raw mode, exclusive) without starting
+    //a reader; returns a non-blocking descriptor or -1. Used for headless
+    //script sessions.
+    static int openDevice(const SettingsDialog::Settings &settings, QString &errorString);
+
+    //GUI thread. The caller owns chunk.block and releases it to the pool.
+    bool takeChunk(Chunk &chunk);
+    //GUI thread.
+    bool takeTriggerHit(TriggerHit &hit);
+
+private:
+    static QString _devicePath(const QString &name);
+    static bool _configure(int fd, const SettingsDialog::Settings &settings, QString &errorString);
+    bool _setLowLatency(const QString &path);
+    void _restoreLowLatency();
+    void _run(std::promise<ThreadScheduling::Result> scheduled, bool realTime, int cpu);
+    void _updateProbe();
+    void _readAvailable();
+    void _fireTriggers(const ByteView &data, quint64 timestampNs);
+    qint64 _write(const char *data, qint64 size);
+    void _flushTx();
+    void _updateInterest();
+    void _wake();
+    void _fail(const QString &message);
+
+    BufferPool &_pool;
+    RoundTripMeter &_roundTrip;
+    TriggerEngine &_triggers;
+    SpscQueue<Chunk> _chunks;
+    SpscQueue<TriggerHit> _triggerHits;
+
+    int _fd = -1;
+    int _epollFd = -1;
+    int _wakeFd = -1;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<bool> _notifyPending;
+    std::atomic<bool> _triggerPending;
+    std::atomic<quint64> _probePeriodNs;
+
+    //I/O thread only
+    bool _poolStarved = false;
+    bool _markOverruns = false;
+    quint64 _overruns = 0;
+    quint32 _interest = 0;
+    QVector<TriggerHit> _hits;
+    JitterProbe _probe;
+    quint64 _probeArmedNs = 0;
+
+    QMutex _txMutex;
+    QByteArray _txPending;
+
+    QString _errorString;
+    bool _lowLatencyApplied = false;
+    //What _setLowLatency() changed, put back by close() so the port is left
+    //the way other programs expect it.
+    QString _latencyTimerPath;
+    QByteArray _savedLatencyTimer;
+    bool _restoreSerialFlags = false;
+    int _savedSerialFlags = 0;
+    ThreadScheduling::Result _scheduling;
+};
+
+#endif // SERIALIOTHREAD_H
@@ -0,0 +1,472 @@
+#include "sessionfile.h"
+#include "linestore.h"
+
+#include <QDebug>
+#include <QFile>
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char MAGIC[8] = { 'T', 'S', 'E', 'S', 'S', 'I', 'O', 'N' };
+static const quint32 VERSION = 1;
+
+//Layout: the header page, the profile, the slot directory (one quint32
+//kind << 28 | index per slot), then the slots from HEADER_SIZE on.
+static const quint64 SLOT_SIZE = quint64(1) << 20;
+static const quint64 HEADER_SIZE = quint64(1) << 20;
+static const quint64 PROFILE_OFFSET = 4096;
+static const quint64 DIRECTORY_OFFSET = 65536;
+static const quint64 MAX_PROFILE_SIZE = DIRECTORY_OFFSET - PROFILE_OFFSET;
+static const quint64 MAX_SLOTS = (HEADER_SIZE - DIRECTORY_OFFSET) / sizeof(quint32);
+static const int KIND_SHIFT = 28;
+static const quint32 INDEX_MASK = (quint32(1) << KIND_SHIFT) - 1;
+
+static quint64
+chunks(quint64 size, quint64 chunkSize) {
+    return (size + chunkSize - 1) / chunkSize;
+}
+
+SessionFile::~SessionFile() {
+    close();
+}
+
+bool
+SessionFile::create(const QString &path) {
+    close();
+
+#ifdef __linux__
+    const QByteArray name = QFile::encodeName(path);
+    //A new file rather than truncating the old one: a store may still be
+    //reading a mapping of it.
+    if (::unlink(name.constData()) != 0 && errno != ENOENT) {
+        return _fail(QStringLiteral("unlink(%1)").arg(path));
+    }
+    _fd = ::open(name.constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        return _fail(QStringLiteral("open(%1)").arg(path));
+    }
+    _path = path;
+    if (!_start()) { return false; }
+    qDebug() << "Session file created:" << path;
+    return true;
+#else
+    Q_UNUSED(path);
+    _errorString = QStringLiteral("Session files are only available on Linux");
+    return false;
+#endif
+}
+
+bool
+SessionFile::createAnonymous(const QString &directory) {
+    close();
+
+#ifdef __linux__
+    const QByteArray name = QFile::encodeName(directory);
+    _fd = ::open(name.constData(), O_RDWR | O_TMPFILE | O_CLOEXEC, 0600);
+    if (_fd < 0 && (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL)) {
+        //No O_TMPFILE on this file system: a named file, unlinked at once.
+        QByteArray path = name + "/spill-XXXXXX";
+        _fd = ::mkostemp(path.data(), O_CLOEXEC);
+        if (_fd >= 0) {
+            ::unlink(path.constData());
+        }
+    }
+    if (_fd < 0) {
+        return _fail(QStringLiteral("open(%1)").arg(directory));
+    }
+    _path = directory;
+    _anonymous = true;
+    return _start();
+#else
+    Q_UNUSED(directory);
+    _errorString = QStringLiteral("Session files are only available on Linux");
+    return false;
+#endif
+}
+
+bool
+SessionFile::open(const QString &path) {
+    close();
+
+#ifdef __linux__
+    const QByteArray name = QFile::encodeName(path);
+    _fd = ::open(name.constData(), O_RDWR | O_CLOEXEC);
+    if (_fd < 0) {
+        return _fail(QStringLiteral("open(%1)").arg(path));
+    }
+    _path = path;
+
+    struct stat status;
+    if (::fstat(_fd, &status) != 0 || static_cast<quint64>(status.st_size) < HEADER_SIZE) {
+        _errorString = QStringLiteral("%1 is not a session file").arg(path);
+        close();
+        return false;
+    }
+
+    Header header;
+    if (::pread(_fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+            || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        _errorString = QStringLiteral("%1 is not a session file").arg(path);
+        close();
+        return false;
+    }
+    if (header.version != VERSION || header.slotSize != SLOT_SIZE
+            || header.recordSize != sizeof(LineStore::Record) || header.spanSize != sizeof(FormatSpan)) {
+        _errorString = QStringLiteral("%1 was written by an incompatible version").arg(path);
+        close();
+        return false;
+    }
+    if (header.slotCount > MAX_SLOTS || header.profileSize > MAX_PROFILE_SIZE) {
+        _errorString = QStringLiteral("%1 is damaged").arg(path);
+        close();
+        return false;
+    }
+
+    //The last slot may only be written in part; the store appends into it
+    //through the mapping, and pages past the end of the file would fault.
+    const quint64 size = HEADER_SIZE + header.slotCount * SLOT_SIZE;
+    if (static_cast<quint64>(status.st_size) < size && ::ftruncate(_fd, static_cast<off_t>(size)) != 0) {
+        const bool failed = _fail(QStringLiteral("ftruncate(%1)").arg(path));
+        close();
+        return failed;
+    }
+
+    //Private and writable: the store's appends to the last block and segments
+    //stay in memory, sync() writes them to the file.
+    void *mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, _fd, 0);
+    if (mapping == MAP_FAILED) {
+        const bool failed = _fail(QStringLiteral("mmap(%1)").arg(path));
+        close();
+        return failed;
+    }
+    _mapping.reset(mapping, [size](void *address) { ::munmap(address, size); });
+    char *base = static_cast<char *>(mapping);
+
+    const quint32 *directory = reinterpret_cast<const quint32 *>(base + DIRECTORY_OFFSET);
+    for (quint64 slot = 0; slot < header.slotCount; slot++) {
+        const quint32 kind = directory[slot] >> KIND_SHIFT;
+        const int index = static_cast<int>(directory[slot] & INDEX_MASK);
+        if (kind == Unused || kind >= KIND_COUNT || static_cast<quint64>(index) >= MAX_SLOTS) {
+            _errorString = QStringLiteral("%1 is damaged").arg(path);
+            close();
+            return false;
+        }
+        QVector<qint32> &slots = _slots[kind];
+        if (index >= slots.size()) {
+            slots.resize(index + 1);
+        }
+        slots[index] = static_cast<qint32>(slot) + 1;
+    }
+
+    //Every chunk the header covers has to be there, and the last line has to
+    //end where the text does.
+    const quint64 needed[KIND_COUNT] = {
+        0,
+        chunks(header.textEnd, SLOT_SIZE),
+        chunks(header.lines, decltype(LineStore::_records)::SegmentSize),
+        chunks(header.spans, decltype(LineStore::_spans)::SegmentSize),
+    };
+    for (int kind = Text; kind < KIND_COUNT; kind++) {
+        for (quint64 index = 0; index < needed[kind]; index++) {
+            if (index >= static_cast<quint64>(_slots[kind].size()) || _slots[kind].at(static_cast<int>(index)) == 0) {
+                _errorString = QStringLiteral("%1 is damaged").arg(path);
+                close();
+                return false;
+            }
+        }
+    }
+    if (header.lines > 0) {
+        const quint64 last = header.lines - 1;
+        const quint64 perSegment = decltype(LineStore::_records)::SegmentSize;
+        const LineStore::Record &record = reinterpret_cast<const LineStore::Record *>(
+                    _chunk(base, Records, static_cast<qint64>(last / perSegment)))[last % perSegment];
+        if (record.offset + record.length != header.textEnd
+                || record.spanBegin + record.spanCount > header.spans) {
+            _errorString = QStringLiteral("%1 is damaged").arg(path);
+            close();
+            return false;
+        }
+    }
+
+    _header = header;
+    _profile = QByteArray(base + PROFILE_OFFSET, static_cast<int>(header.profileSize));
+    _errorString.clear();
+    qDebug() << "Session file opened:" << path << header.lines << "lines";
+    return true;
+#else
+    Q_UNUSED(path);
+    _errorString = QStringLiteral("Session files are only available on Linux");
+    return false;
+#endif
+}
+
+void
+SessionFile::close() {
+#ifdef __linux__
+    if (_fd >= 0) {
+        if (!_anonymous) {
+            ::fdatasync(_fd);
+        }
+        ::close(_fd);
+    }
+#endif
+    _fd = -1;
+    _anonymous = false;
+    _header = Header();
+    _profile.clear();
+    for (QVector<qint32> &slots : _slots) {
+        slots.clear();
+    }
+    //A store it was restored into keeps its own reference.
+    _mapping.reset();
+    _path.clear();
+}
+
+bool
+SessionFile::setProfile(const QByteArray &profile) {
+    if (_fd < 0) { return false; }
+    if (static_cast<quint64>(profile.size()) > MAX_PROFILE_SIZE) {
+        _errorString = QStringLiteral("The connection profile is too large for the session file");
+        return false;
+    }
+    _header.profileSize = static_cast<quint64>(profile.size());
+    if (!_write(profile.constData(), profile.size(), PROFILE_OFFSET) || !_write(&_header, sizeof(_header), 0)) {
+        return false;
+    }
+    _profile = profile;
+    return true;
+}
+
+void
+SessionFile::restore(LineStore &store) {
+    if (!_mapping || store.lineCount() != 0) { return; }
+
+    char *base = static_cast<char *>(_mapping.get());
+    LineStore::Storage storage;
+    for (quint64 x = 0; x < chunks(_header.textEnd, SLOT_SIZE); x++) {
+        storage.textBlocks.push_back(_chunk(base, Text, static_cast<qint64>(x)));
+    }
+    for (quint64 x = 0; x < chunks(_header.lines, decltype(LineStore::_records)::SegmentSize); x++) {
+        storage.records.push_back(reinterpret_cast<LineStore::Record *>(_chunk(base, Records, static_cast<qint64>(x))));
+    }
+    for (quint64 x = 0; x < chunks(_header.spans, decltype(LineStore::_spans)::SegmentSize); x++) {
+        storage.spans.push_back(reinterpret_cast<FormatSpan *>(_chunk(base, Spans, static_cast<qint64>(x))));
+    }
+    storage.lineCount = static_cast<qint64>(_header.lines);
+    storage.spanCount = static_cast<qint64>(_header.spans);
+    storage.textEnd = _header.textEnd;
+    storage.textBytes = static_cast<qint64>(_header.textBytes);
+    storage.longestLine = static_cast<qint64>(_header.longestLine);
+    storage.owner = _mapping;
+    _mapping.reset();
+
+    store._adopt(storage);
+}
+
+bool
+SessionFile::sync(const LineStore &store, qint64 maxBytes) {
+    Q_STATIC_ASSERT(decltype(LineStore::_records)::SegmentSize * sizeof(LineStore::Record) == SLOT_SIZE);
+    Q_STATIC_ASSERT(decltype(LineStore::_spans)::SegmentSize * sizeof(FormatSpan) <= SLOT_SIZE);
+    Q_STATIC_ASSERT(LineStore::BLOCK_SIZE == SLOT_SIZE);
+    if (_fd < 0) { return false; }
+
+    const qint64 saved = lineCount();
+    qint64 completed = store.completedLineCount();
+    if (completed <= saved) { return true; }
+
+    if (maxBytes >= 0) {
+        //Line ends only grow, so the lines that fit are a prefix.
+        const quint64 limit = _header.textEnd + static_cast<quint64>(maxBytes);
+        qint64 low = saved + 1;
+        qint64 high = completed;
+        while (low < high) {
+            const qint64 middle = low + (high - low + 1) / 2;
+            const LineStore::Record &record = store._records.at(middle - 1);
+            if (record.offset + record.length <= limit) { low = middle; }
+            else { high = middle - 1; }
+        }
+        completed = low;
+    }
+
+    //Text of the new lines. Gaps left where an open line moved to the next
+    //block are written too; they are never read back.
+    const LineStore::Record &last = store._records.at(completed - 1);
+    const quint64 textEnd = last.offset + last.length;
+    quint64 from = _header.textEnd;
+    while (from < textEnd) {
+        const quint64 block = from >> LineStore::BLOCK_BITS;
+        const quint64 to = qMin(textEnd, (block + 1) << LineStore::BLOCK_BITS);
+        const quint64 offset = _offset(Text, static_cast<qint64>(block), from & (LineStore::BLOCK_SIZE - 1));
+        if (!offset || !_write(store._textAt(from), static_cast<qint64>(to - from), offset)) {
+            return false;
+        }
+        from = to;
+    }
+
+    //Spans are added as a line completes, so the saved lines' end where the
+    //last of them with any does.
+    qint64 spans = static_cast<qint64>(_header.spans);
+    quint64 textBytes = 0;
+    quint64 longestLine = _header.longestLine;
+    for (qint64 line = saved; line < completed; line++) {
+        const LineStore::Record &record = store._records.at(line);
+        textBytes += record.length;
+        longestLine = qMax<quint64>(longestLine, record.length);
+        if (record.spanCount) {
+            spans = qMax(spans, record.spanBegin + static_cast<qint64>(record.spanCount));
+        }
+    }
+
+    if (!_writeRange(Records, store._records, saved, completed)
+            || !_writeRange(Spans, store._spans, static_cast<qint64>(_header.spans), spans)) {
+        return false;
+    }
+
+    _header.textBytes += textBytes;
+    _header.longestLine = longestLine;
+    _header.lines = static_cast<quint64>(completed);
+    _header.textEnd = textEnd;
+    _header.spans = static_cast<quint64>(spans);
+    return _write(&_header, sizeof(_header), 0);
+}
+
+qint64
+SessionFile::spill(LineStore &store) {
+#ifdef __linux__
+    if (_fd < 0 || store.hasReaders()) { return 0; }
+
+    //Whole chunks only; the store may still append to the one the saved
+    //lines end in.
+    const quint64 perRecords = decltype(LineStore::_records)::SegmentSize;
+    const quint64 perSpans = decltype(LineStore::_spans)::SegmentSize;
+    const quint64 textBlocks = _header.textEnd / SLOT_SIZE;
+    const quint64 recordSegments = _header.lines / perRecords;
+    const quint64 spanSegments = _header.spans / perSpans;
+    if (textBlocks + recordSegments + spanSegments == 0) { return 0; }
+
+    const quint64 size = HEADER_SIZE + _header.slotCount * SLOT_SIZE;
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (mapping == MAP_FAILED) {
+        _fail(QStringLiteral("mmap(%1)").arg(_path));
+        return 0;
+    }
+    char *base = static_cast<char *>(mapping);
+
+    LineStore::Storage storage;
+    for (quint64 x = 0; x < textBlocks; x++) {
+        storage.textBlocks.push_back(_chunk(base, Text, static_cast<qint64>(x)));
+    }
+    for (quint64 x = 0; x < recordSegments; x++) {
+        storage.records.push_back(reinterpret_cast<LineStore::Record *>(_chunk(base, Records, static_cast<qint64>(x))));
+    }
+    for (quint64 x = 0; x < spanSegments; x++) {
+        storage.spans.push_back(reinterpret_cast<FormatSpan *>(_chunk(base, Spans, static_cast<qint64>(x))));
+    }
+    storage.owner.reset(mapping, [size](void *address) { ::munmap(address, size); });
+    return store._relocate(storage);
+#else
+    Q_UNUSED(store);
+    return 0;
+#endif
+}
+
+bool
+SessionFile::_fail(const QString &what) {
+    _errorString = QStringLiteral("%1: %2").arg(what, QString::fromLocal8Bit(strerror(errno)));
+    qWarning() << "Session file:" << _errorString;
+    return false;
+}
+
+bool
+SessionFile::_start() {
+#ifdef __linux__
+    std::memcpy(_header.magic, MAGIC, sizeof(MAGIC));
+    _header.version = VERSION;
+    _header.slotSize = SLOT_SIZE;
+    _header.recordSize = sizeof(LineStore::Record);
+    _header.spanSize = sizeof(FormatSpan);
+    if (::ftruncate(_fd, static_cast<off_t>(HEADER_SIZE)) != 0 || !_write(&_header, sizeof(_header), 0)) {
+        const bool failed = _fail(QStringLiteral("write(%1)").arg(_path));
+        close();
+        return failed;
+    }
+    _errorString.clear();
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool
+SessionFile::_write(const void *data, qint64 size, quint64 offset) {
+#ifdef __linux__
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        const ssize_t n = ::pwrite(_fd, p, static_cast<size_t>(size), static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            return _fail(QStringLiteral("write(%1)").arg(_path));
+        }
+        p += n;
+        size -= n;
+        offset += static_cast<quint64>(n);
+    }
+    return true;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    Q_UNUSED(offset);
+    return false;
+#endif
+}
+
+quint64
+SessionFile::_offset(Kind kind, qint64 index, quint64 offset) {
+    QVector<qint32> &slots = _slots[kind];
+    if (index >= slots.size()) {
+        slots.resize(static_cast<int>(index) + 1);
+    }
+    //Slots are stored one based, 0 is none yet.
+    if (slots.at(static_cast<int>(index)) == 0) {
+        if (_header.slotCount >= MAX_SLOTS) {
+            _errorString = QStringLiteral("%1 is full").arg(_path);
+            return 0;
+        }
+        const quint32 entry = (quint32(kind) << KIND_SHIFT) | static_cast<quint32>(index);
+        if (!_write(&entry, sizeof(entry), DIRECTORY_OFFSET + _header.slotCount * sizeof(entry))) {
+            return 0;
+        }
+        slots[static_cast<int>(index)] = static_cast<qint32>(++_header.slotCount);
+    }
+    return HEADER_SIZE + static_cast<quint64>(slots.at(static_cast<int>(index)) - 1) * SLOT_SIZE + offset;
+}
+
+template <typename Vector>
+bool
+SessionFile::_writeRange(Kind kind, const Vector &vector, qint64 from, qint64 to) {
+    const qint64 segmentSize = Vector::SegmentSize;
+
+    while (from < to) {
+        const qint64 segment = from / segmentSize;
+        const qint64 end = qMin(to, (segment + 1) * segmentSize);
+        const qint64 elementSize = sizeof(vector.at(from));
+        const quint64 offset = _offset(kind, segment, static_cast<quint64>((from % segmentSize) * elementSize));
+        if (!offset || !_write(&vector.at(from), (end - from) * elementSize, offset)) {
+            return false;
+        }
+        from = end;
+    }
+    return true;
+}
+
+char *
+SessionFile::_chunk(char *base, Kind kind, qint64 index) const {
+    return base + HEADER_SIZE + static_cast<quint64>(_slots[kind].at(static_cast<int>(index)) - 1) * SLOT_SIZE;
+}
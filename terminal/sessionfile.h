@@ -0,0 +1,115 @@
+#ifndef SESSIONFILE_H
+#define SESSIONFILE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class LineStore;
+
+// Snapshot of a session on disk: the scrollback, its line index, timestamps
+// and highlight spans, plus the connection profile. The file is laid out in
+// 1 MiB slots that hold the LineStore's text blocks and index segments byte
+// for byte, so sync() only appends what completed since the last call and
+// open() maps the file and hands the slots to the store without parsing
+// anything; restoring a multi-GB session costs what touching the visible
+// rows costs.
+//
+// The header is rewritten after the data it describes, so a crash of the
+// application loses at most the lines since the last sync(). Nothing is
+// forced to disk before close(). The open last line is not saved.
+class SessionFile
+{
+public:
+    // What a spill file is caught up by per sync() on the GUI thread.
+    static const qint64 SPILL_STEP = qint64(16) << 20;
+
+    SessionFile() = default;
+    ~SessionFile();
+
+    SessionFile(const SessionFile &) = delete;
+    SessionFile &operator=(const SessionFile &) = delete;
+
+    // Starts an empty session file at path, replacing any file there.
+    bool create(const QString &path);
+    // Starts an unnamed session file in directory, for spill() when the user
+    // keeps no session: it disappears with the last mapping of it, and close()
+    // does not flush it.
+    bool createAnonymous(const QString &directory);
+    // Opens an existing session file to restore() and continue it.
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return _fd >= 0; }
+
+    QString fileName() const { return _path; }
+    QString errorString() const { return _errorString; }
+
+    // Lines saved so far.
+    qint64 lineCount() const { return static_cast<qint64>(_header.lines); }
+
+    // The connection profile, as SettingsDialog::profile() returns it.
+    QByteArray profile() const { return _profile; }
+    bool setProfile(const QByteArray &profile);
+
+    // Makes the lines of an open()ed file the start of store, which must be
+    // empty. New lines are appended after them and written by sync().
+    void restore(LineStore &store);
+
+    // Writes the lines store completed since the last call. store must be
+    // the one restore()d into, or have been empty when the file was created.
+    // With maxBytes, stops at the last line whose text fits in that much (but
+    // writes at least one), so a file far behind its store is caught up over
+    // several calls instead of in one long write.
+    bool sync(const LineStore &store, qint64 maxBytes = -1);
+
+    // Frees the heap copies of what sync() saved: the whole chunks before the
+    // one the store is appending to are pointed at a read-only mapping of the
+    // file instead, which the kernel can page out. Does nothing while store
+    // has readers on other threads. Returns the bytes freed.
+    qint64 spill(LineStore &store);
+
+private:
+    enum Kind { Unused, Text, Records, Spans, KIND_COUNT };
+
+    struct Header
+    {
+        char magic[8];
+        quint32 version;
+        quint32 slotSize;
+        quint32 recordSize;
+        quint32 spanSize;
+        quint64 slotCount;
+        quint64 lines;
+        quint64 textEnd;
+        quint64 spans;
+        quint64 textBytes;
+        quint64 longestLine;
+        quint64 profileSize;
+    };
+
+    bool _fail(const QString &what);
+    // Writes the header of a new file to _fd.
+    bool _start();
+    bool _write(const void *data, qint64 size, quint64 offset);
+    // File offset of byte offset in chunk index of kind; allocates a slot on
+    // first use. Returns 0 when the slot directory is full.
+    quint64 _offset(Kind kind, qint64 index, quint64 offset);
+    // Writes elements [from, to) of a LineStore index, segment by segment.
+    template <typename Vector>
+    bool _writeRange(Kind kind, const Vector &vector, qint64 from, qint64 to);
+    // Start of chunk index of kind in a mapping of the file.
+    char *_chunk(char *base, Kind kind, qint64 index) const;
+
+    QString _path;
+    QString _errorString;
+    int _fd = -1;
+    bool _anonymous = false;
+    Header _header = {};
+    QByteArray _profile;
+    QVector<qint32> _slots[KIND_COUNT];
+    std::shared_ptr<void> _mapping;
+};
+
+#endif // SESSIONFILE_H
@@ -51,11 +51,14 @@
 
 #include "settingsdialog.h"
 #include "ui_settingsdialog.h"
+#include "bauddetector.h"
+#include "threadscheduling.h"
 
 #include <QIntValidator>
 #include <QLineEdit>
 #include <QSerialPortInfo>
 #include <QSettings>
+#include <QTemporaryFile>
 #include <QDebug>
 
 static const char blankString[] = QT_TRANSLATE_NOOP("SettingsDialog", "N/A");
@@ -70,30 +73,68 @@ const QString SettingsDialog::SETTINGS_PARITY = "parity";
 const QString SettingsDialog::SETTINGS_STOP_BITS = "stopBits";
 const QString SettingsDialog::SETTINGS_FLOW_CONTROL = "flowControl";
 const QString SettingsDialog::SETTINGS_LOCAL_ECHO = "localEcho";
+const QString SettingsDialog::SETTINGS_SHM_TAP = "shmTap";
+const QString SettingsDialog::SETTINGS_LOW_LATENCY = "lowLatency";
+const QString SettingsDialog::SETTINGS_REAL_TIME = "realTime";
+const QString SettingsDialog::SETTINGS_IO_CPU = "ioCpu";
+const QString SettingsDialog::SETTINGS_MARK_OVERRUNS = "markOverruns";
+const QString SettingsDialog::SETTINGS_KEEP_SESSION = "keepSession";
+const QString SettingsDialog::SETTINGS_FRAMING = "framing";
+const QString SettingsDialog::SETTINGS_FRAMING_CRC = "framingCrc";
+const QString SettingsDialog::SETTINGS_HIGHLIGHTING = "highlighting";
+const QString SettingsDialog::SETTINGS_HIGHLIGHT_RULES = "rules";
+const QString SettingsDialog::SETTINGS_RULE_PATTERN = "pattern";
+const QString SettingsDialog::SETTINGS_RULE_COLOR = "color";
+const QString SettingsDialog::SETTINGS_RULE_WHOLE_LINE = "wholeLine";
+const QString SettingsDialog::SETTINGS_TRIGGERS = "triggers";
+const QString SettingsDialog::SETTINGS_TRIGGER_RULES = "rules";
+const QString SettingsDialog::SETTINGS_TRIGGER_PATTERN = "pattern";
+const QString SettingsDialog::SETTINGS_TRIGGER_REGEX = "regex";
+const QString SettingsDialog::SETTINGS_TRIGGER_ACTION = "action";
+const QString SettingsDialog::SETTINGS_TRIGGER_PAYLOAD = "payload";
+const QString SettingsDialog::SETTINGS_SCHEDULER = "scheduler";
+const QString SettingsDialog::SETTINGS_SCHEDULED_COMMANDS = "commands";
+const QString SettingsDialog::SETTINGS_COMMAND_NAME = "name";
+const QString SettingsDialog::SETTINGS_COMMAND_PAYLOAD = "payload";
+const QString SettingsDialog::SETTINGS_COMMAND_INTERVAL = "intervalMs";
+const QString SettingsDialog::SETTINGS_COMMAND_RESPONSE = "response";
+const QString SettingsDialog::SETTINGS_COMMAND_REGEX = "regex";
+const QString SettingsDialog::SETTINGS_COMMAND_TIMEOUT = "timeoutMs";
+
+static const char *const triggerActions[] = { "send", "capture", "mark", "beep" };
+
+static const qint32 MAX_BAUD_RATE = 12000000;
+static const qint32 baudRates[] = { 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400, 460800,
+                                    921600, 1000000, 1500000, 2000000, 3000000, 4000000 };
 
 
 SettingsDialog::SettingsDialog(QWidget *parent) :
     QDialog(parent),
     _ui(new Ui::SettingsDialog),
-    _intValidator(new QIntValidator(0, 4000000, this))
+    //termios2 takes any rate; 12 Mbaud is where USB adapters stop.
+    _intValidator(new QIntValidator(1, MAX_BAUD_RATE, this)),
+    _baudDetector(new BaudDetector(this))
 {
     _ui->setupUi(this);
 
     _ui->baudRateBox->setInsertPolicy(QComboBox::NoInsert);
+    _ui->ioCpuSpinBox->setMaximum(ThreadScheduling::cpuCount() - 1);
 
     _initialConnections();
 
     _fillPortsParameters();
     _fillPortsInfo();
 
-    _readSettings();
+    QSettings settings(SETTINGS_ORG, SETTINGS_APP);
+    _readSettings(settings);
     _applySavedSettings();
 
     _updateSettings();
 }
 
 SettingsDialog::~SettingsDialog() {
-    _writeSettings();
+    QSettings settings(SETTINGS_ORG, SETTINGS_APP);
+    _writeSettings(settings);
     delete _ui;
 }
 
@@ -102,6 +143,39 @@ SettingsDialog::settings() const {
     return _currentSettings;
 }
 
+QByteArray
+SettingsDialog::profile() const {
+    //QSettings only reads and writes files, so the profile goes through one.
+    QTemporaryFile file;
+    if(!file.open()) {
+        return QByteArray();
+    }
+    {
+        QSettings settings(file.fileName(), QSettings::IniFormat);
+        _writeSettings(settings);
+    }
+    QFile written(file.fileName());
+    return written.open(QIODevice::ReadOnly) ? written.readAll() : QByteArray();
+}
+
+bool
+SettingsDialog::restoreProfile(const QByteArray &profile) {
+    QTemporaryFile file;
+    if(!file.open() || file.write(profile) != profile.size()) {
+        return false;
+    }
+    file.close();
+
+    QSettings settings(file.fileName(), QSettings::IniFormat);
+    if(settings.status() != QSettings::NoError) {
+        return false;
+    }
+    _readSettings(settings);
+    _applySavedSettings();
+    _updateSettings();
+    return true;
+}
+
 void
 SettingsDialog::_slot_showPortInfo(int idx) {
     if (idx == -1) { return; }
@@ -141,6 +215,58 @@ SettingsDialog::_slot_checkCustomDevicePathPolicy(int idx) {
     }
 }
 
+void
+SettingsDialog::_slot_detectBaudRate() {
+    if (_baudDetector->isRunning()) {
+        _baudDetector->cancel();
+        _ui->detectBaudButton->setText(tr("Detect"));
+        _ui->detectBaudLabel->clear();
+        return;
+    }
+
+    //The line format as selected, not yet applied.
+    Settings listen = _currentSettings;
+    listen.name = _ui->serialPortInfoListBox->currentText();
+    listen.dataBits = static_cast<QSerialPort::DataBits>(_ui->dataBitsBox->currentData().toInt());
+    listen.parity = static_cast<QSerialPort::Parity>(_ui->parityBox->currentData().toInt());
+    listen.stopBits = static_cast<QSerialPort::StopBits>(_ui->stopBitsBox->currentData().toInt());
+    if (!_baudDetector->start(listen)) {
+        _ui->detectBaudLabel->setText(_baudDetector->errorString());
+        return;
+    }
+    _ui->detectBaudButton->setText(tr("Stop"));
+    _ui->detectBaudLabel->setText(tr("Listening on %1...").arg(listen.name));
+}
+
+void
+SettingsDialog::_slot_baudRateDetected(qint32 baudRate) {
+    _ui->detectBaudButton->setText(tr("Detect"));
+
+    const BaudDetector::Result best = _baudDetector->best();
+    if (baudRate == 0) {
+        _ui->detectBaudLabel->setText(best.characters == 0
+                                      ? tr("Nothing received, is the device sending?")
+                                      : tr("No rate fits what was received"));
+        return;
+    }
+    _selectBaudRate(baudRate);
+    _ui->detectBaudLabel->setText(tr("Detected %1 baud: %2 characters, %3 errors, %4% printable")
+                                  .arg(baudRate).arg(best.characters).arg(best.errors)
+                                  .arg(100 * best.printable / best.characters));
+}
+
+void
+SettingsDialog::_selectBaudRate(qint32 baudRate) {
+    const int index = _ui->baudRateBox->findData(baudRate);
+    if (index >= 0) {
+        _ui->baudRateBox->setCurrentIndex(index);
+        return;
+    }
+    //Custom is the last entry; selecting it clears the text.
+    _ui->baudRateBox->setCurrentIndex(_ui->baudRateBox->count() - 1);
+    _ui->baudRateBox->setEditText(QString::number(baudRate));
+}
+
 void
 SettingsDialog::_initialConnections() {
     connect(_ui->applyButton, &QPushButton::clicked,
@@ -151,15 +277,24 @@ SettingsDialog::_initialConnections() {
             this, &SettingsDialog::_slot_checkCustomBaudRatePolicy);
     connect(_ui->serialPortInfoListBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &SettingsDialog::_slot_checkCustomDevicePathPolicy);
+    connect(_ui->detectBaudButton, &QPushButton::clicked,
+            this, &SettingsDialog::_slot_detectBaudRate);
+    connect(_baudDetector, &BaudDetector::finished,
+            this, &SettingsDialog::_slot_baudRateDetected);
+    //The real-time options apply to the low latency I/O thread only.
+    connect(_ui->lowLatencyCheckBox, &QCheckBox::toggled,
+            _ui->realTimeCheckBox, &QWidget::setEnabled);
+    connect(_ui->lowLatencyCheckBox, &QCheckBox::toggled,
+            _ui->ioCpuSpinBox, &QWidget::setEnabled);
 }
 
 void
 SettingsDialog::_fillPortsParameters() {
-    _ui->baudRateBox->addItem(QStringLiteral("9600"), QSerialPort::Baud9600);
-    _ui->baudRateBox->addItem(QStringLiteral("19200"), QSerialPort::Baud19200);
-    _ui->baudRateBox->addItem(QStringLiteral("38400"), QSerialPort::Baud38400);
-    _ui->baudRateBox->addItem(QStringLiteral("115200"), QSerialPort::Baud115200);
+    for (qint32 baudRate : baudRates) {
+        _ui->baudRateBox->addItem(QString::number(baudRate), baudRate);
+    }
     _ui->baudRateBox->addItem(tr("Custom"));
+    _ui->baudRateBox->setCurrentIndex(_ui->baudRateBox->findData(QSerialPort::Baud9600));
 
     _ui->dataBitsBox->addItem(QStringLiteral("5"), QSerialPort::Data5);
     _ui->dataBitsBox->addItem(QStringLiteral("6"), QSerialPort::Data6);
@@ -182,6 +317,11 @@ SettingsDialog::_fillPortsParameters() {
     _ui->flowControlBox->addItem(tr("None"), QSerialPort::NoFlowControl);
     _ui->flowControlBox->addItem(tr("RTS/CTS"), QSerialPort::HardwareControl);
     _ui->flowControlBox->addItem(tr("XON/XOFF"), QSerialPort::SoftwareControl);
+
+    _ui->framingBox->addItem(FrameDecoder::typeName(FrameDecoder::None), FrameDecoder::None);
+    _ui->framingBox->addItem(FrameDecoder::typeName(FrameDecoder::Slip), FrameDecoder::Slip);
+    _ui->framingBox->addItem(FrameDecoder::typeName(FrameDecoder::Cobs), FrameDecoder::Cobs);
+    _ui->framingBox->addItem(FrameDecoder::typeName(FrameDecoder::LengthPrefixed), FrameDecoder::LengthPrefixed);
 }
 
 void
@@ -226,18 +366,11 @@ void SettingsDialog::_applySavedSettings() {
 
 
     //Baud
-    if(_savedSettings.baudRate != QSerialPort::BaudRate::UnknownBaud) {
-        //-1 for custom.
-        for(auto x = 0; x < _ui->baudRateBox->count() - 1; x++) {
-            if(_savedSettings.baudRate == _ui->baudRateBox->itemText(x).toInt()) {
-                _ui->baudRateBox->setCurrentIndex(x);
-                _currentSettings.baudRate = _savedSettings.baudRate;
-                _currentSettings.stringBaudRate = QString::number(_savedSettings.baudRate);
-                qDebug() << "Found Baud Settings";
-                break;
-            }
-        }
-        //TODO: Update GUI to show customer baud.
+    if(_savedSettings.baudRate > 0) {
+        _selectBaudRate(_savedSettings.baudRate);
+        _currentSettings.baudRate = _savedSettings.baudRate;
+        _currentSettings.stringBaudRate = QString::number(_savedSettings.baudRate);
+        qDebug() << "Found Baud Settings";
     }
 
 
@@ -300,6 +433,43 @@ void SettingsDialog::_applySavedSettings() {
     //Local Echo
     _currentSettings.localEchoEnabled = _savedSettings.localEchoEnabled;
 
+    //Shared Memory Tap
+    _ui->shmTapCheckBox->setChecked(_savedSettings.shmTapEnabled);
+    _currentSettings.shmTapEnabled = _savedSettings.shmTapEnabled;
+
+    //Low Latency
+    _ui->lowLatencyCheckBox->setChecked(_savedSettings.lowLatency);
+    _currentSettings.lowLatency = _savedSettings.lowLatency;
+    _ui->realTimeCheckBox->setChecked(_savedSettings.realTime);
+    _currentSettings.realTime = _savedSettings.realTime;
+    _ui->ioCpuSpinBox->setValue(_savedSettings.ioCpu);
+    _currentSettings.ioCpu = _ui->ioCpuSpinBox->value();
+    _ui->realTimeCheckBox->setEnabled(_savedSettings.lowLatency);
+    _ui->ioCpuSpinBox->setEnabled(_savedSettings.lowLatency);
+
+    //Overrun marking
+    _ui->markOverrunsCheckBox->setChecked(_savedSettings.markOverruns);
+    _currentSettings.markOverruns = _savedSettings.markOverruns;
+
+    //Session
+    _ui->keepSessionCheckBox->setChecked(_savedSettings.keepSession);
+    _currentSettings.keepSession = _savedSettings.keepSession;
+
+    //Framing
+    const int framingIndex = _ui->framingBox->findData(_savedSettings.framing);
+    _ui->framingBox->setCurrentIndex(framingIndex < 0 ? 0 : framingIndex);
+    _currentSettings.framing = _savedSettings.framing;
+    _ui->framingCrcCheckBox->setChecked(_savedSettings.framingCrc);
+    _currentSettings.framingCrc = _savedSettings.framingCrc;
+
+    //Highlighting (edited in the settings file, no GUI yet)
+    _currentSettings.highlightRules = _savedSettings.highlightRules;
+
+    //Triggers (edited in the settings file, no GUI yet)
+    _currentSettings.triggerRules = _savedSettings.triggerRules;
+
+    //Scheduled commands (edited in the settings file, no GUI yet)
+    _currentSettings.scheduledCommands = _savedSettings.scheduledCommands;
 
 }
 
@@ -307,7 +477,7 @@ void SettingsDialog::_updateSettings()
 {
     _currentSettings.name = _ui->serialPortInfoListBox->currentText();
 
-    if (_ui->baudRateBox->currentIndex() == 4) {
+    if (!_ui->baudRateBox->currentData().isValid()) {
         _currentSettings.baudRate = _ui->baudRateBox->currentText().toInt();
     }
     else {
@@ -333,14 +503,22 @@ void SettingsDialog::_updateSettings()
     _currentSettings.stringFlowControl = _ui->flowControlBox->currentText();
 
     _currentSettings.localEchoEnabled = _ui->localEchoCheckBox->isChecked();
+    _currentSettings.shmTapEnabled = _ui->shmTapCheckBox->isChecked();
+    _currentSettings.lowLatency = _ui->lowLatencyCheckBox->isChecked();
+    _currentSettings.realTime = _ui->realTimeCheckBox->isChecked();
+    _currentSettings.ioCpu = _ui->ioCpuSpinBox->value();
+    _currentSettings.markOverruns = _ui->markOverrunsCheckBox->isChecked();
+    _currentSettings.keepSession = _ui->keepSessionCheckBox->isChecked();
+    _currentSettings.framing = static_cast<FrameDecoder::Type>(
+                _ui->framingBox->itemData(_ui->framingBox->currentIndex()).toInt());
+    _currentSettings.framingCrc = _ui->framingCrcCheckBox->isChecked();
 }
 
 
 
 void
-SettingsDialog::_readSettings() {
+SettingsDialog::_readSettings(QSettings &settings) {
 
-    QSettings settings(SETTINGS_ORG, SETTINGS_APP);
     qDebug() << "Read Settings";
 
     settings.beginGroup(SETTINGS_CONNECTION);
@@ -363,17 +541,90 @@ SettingsDialog::_readSettings() {
                 settings.value(SETTINGS_FLOW_CONTROL, QSerialPort::FlowControl::UnknownFlowControl).toInt());
     qDebug() << "Read: flowControl: " << _savedSettings.flowControl;
     _savedSettings.localEchoEnabled = settings.value(SETTINGS_LOCAL_ECHO, false).toBool();
+    _savedSettings.shmTapEnabled = settings.value(SETTINGS_SHM_TAP, false).toBool();
+    _savedSettings.lowLatency = settings.value(SETTINGS_LOW_LATENCY, false).toBool();
+    _savedSettings.realTime = settings.value(SETTINGS_REAL_TIME, false).toBool();
+    _savedSettings.ioCpu = settings.value(SETTINGS_IO_CPU, -1).toInt();
+    _savedSettings.markOverruns = settings.value(SETTINGS_MARK_OVERRUNS, false).toBool();
+    _savedSettings.keepSession = settings.value(SETTINGS_KEEP_SESSION, true).toBool();
+    _savedSettings.framing = static_cast<FrameDecoder::Type>(
+                settings.value(SETTINGS_FRAMING, FrameDecoder::None).toInt());
+    _savedSettings.framingCrc = settings.value(SETTINGS_FRAMING_CRC, false).toBool();
+
+    settings.endGroup();
+
+    settings.beginGroup(SETTINGS_HIGHLIGHTING);
+    if(settings.contains(SETTINGS_HIGHLIGHT_RULES + "/size")) {
+        const int count = settings.beginReadArray(SETTINGS_HIGHLIGHT_RULES);
+        for(int x = 0; x < count; x++) {
+            settings.setArrayIndex(x);
+            HighlightRule rule;
+            rule.pattern = settings.value(SETTINGS_RULE_PATTERN).toString();
+            rule.color = QColor(settings.value(SETTINGS_RULE_COLOR).toString());
+            rule.wholeLine = settings.value(SETTINGS_RULE_WHOLE_LINE, false).toBool();
+            if(!rule.pattern.isEmpty() && rule.color.isValid()) {
+                _savedSettings.highlightRules.append(rule);
+            }
+        }
+        settings.endArray();
+    }
+    else {
+        _savedSettings.highlightRules = LineHighlighter::defaultRules();
+    }
+    qDebug() << "Read: highlightRules: " << _savedSettings.highlightRules.size();
+    settings.endGroup();
+
+    settings.beginGroup(SETTINGS_TRIGGERS);
+    const int triggerCount = settings.beginReadArray(SETTINGS_TRIGGER_RULES);
+    for(int x = 0; x < triggerCount; x++) {
+        settings.setArrayIndex(x);
+        TriggerRule rule;
+        rule.pattern = settings.value(SETTINGS_TRIGGER_PATTERN).toString();
+        rule.regex = settings.value(SETTINGS_TRIGGER_REGEX, false).toBool();
+        const QString action = settings.value(SETTINGS_TRIGGER_ACTION, triggerActions[TriggerRule::Mark]).toString();
+        for(int a = 0; a < 4; a++) {
+            if(action == QLatin1String(triggerActions[a])) {
+                rule.action = static_cast<TriggerRule::Action>(a);
+            }
+        }
+        rule.payload = TriggerEngine::unescape(settings.value(SETTINGS_TRIGGER_PAYLOAD).toString());
+        if(!rule.pattern.isEmpty()) {
+            _savedSettings.triggerRules.append(rule);
+        }
+    }
+    settings.endArray();
+    qDebug() << "Read: triggerRules: " << _savedSettings.triggerRules.size();
+    settings.endGroup();
 
+    settings.beginGroup(SETTINGS_SCHEDULER);
+    const int commandCount = settings.beginReadArray(SETTINGS_SCHEDULED_COMMANDS);
+    for(int x = 0; x < commandCount; x++) {
+        settings.setArrayIndex(x);
+        ScheduledCommand command;
+        command.name = settings.value(SETTINGS_COMMAND_NAME).toString();
+        command.payload = TriggerEngine::unescape(settings.value(SETTINGS_COMMAND_PAYLOAD).toString());
+        command.intervalMs = settings.value(SETTINGS_COMMAND_INTERVAL, 1000).toUInt();
+        command.response = settings.value(SETTINGS_COMMAND_RESPONSE).toString();
+        command.regex = settings.value(SETTINGS_COMMAND_REGEX, false).toBool();
+        command.timeoutMs = settings.value(SETTINGS_COMMAND_TIMEOUT, 0).toUInt();
+        if(command.regex && !QRegularExpression(command.response).isValid()) {
+            qDebug() << "Read: scheduled command" << x << "has an invalid response pattern";
+            continue;
+        }
+        if(!command.payload.isEmpty() && command.intervalMs > 0) {
+            _savedSettings.scheduledCommands.append(command);
+        }
+    }
+    settings.endArray();
+    qDebug() << "Read: scheduledCommands: " << _savedSettings.scheduledCommands.size();
     settings.endGroup();
 
 }
 
 void
-SettingsDialog::_writeSettings() {
+SettingsDialog::_writeSettings(QSettings &settings) const {
     qDebug() << "Write Settings";
 
-    QSettings settings(SETTINGS_ORG, SETTINGS_APP);
-
     settings.beginGroup(SETTINGS_CONNECTION);
 
     qDebug() << "Write: Name: " << _currentSettings.name;
@@ -390,6 +641,61 @@ SettingsDialog::_writeSettings() {
     settings.setValue(SETTINGS_FLOW_CONTROL, _currentSettings.flowControl);
     qDebug() << "Write: localEchoEnabled: " << _currentSettings.localEchoEnabled;
     settings.setValue(SETTINGS_LOCAL_ECHO, _currentSettings.localEchoEnabled);
+    qDebug() << "Write: shmTapEnabled: " << _currentSettings.shmTapEnabled;
+    settings.setValue(SETTINGS_SHM_TAP, _currentSettings.shmTapEnabled);
+    qDebug() << "Write: lowLatency: " << _currentSettings.lowLatency;
+    settings.setValue(SETTINGS_LOW_LATENCY, _currentSettings.lowLatency);
+    settings.setValue(SETTINGS_REAL_TIME, _currentSettings.realTime);
+    settings.setValue(SETTINGS_IO_CPU, _currentSettings.ioCpu);
+    settings.setValue(SETTINGS_MARK_OVERRUNS, _currentSettings.markOverruns);
+    settings.setValue(SETTINGS_KEEP_SESSION, _currentSettings.keepSession);
+    qDebug() << "Write: framing: " << _currentSettings.framing;
+    settings.setValue(SETTINGS_FRAMING, _currentSettings.framing);
+    settings.setValue(SETTINGS_FRAMING_CRC, _currentSettings.framingCrc);
 
     settings.endGroup();
+
+    //Written back so the rules can be edited in the settings file.
+    settings.beginGroup(SETTINGS_HIGHLIGHTING);
+    qDebug() << "Write: highlightRules: " << _currentSettings.highlightRules.size();
+    settings.beginWriteArray(SETTINGS_HIGHLIGHT_RULES, _currentSettings.highlightRules.size());
+    for(int x = 0; x < _currentSettings.highlightRules.size(); x++) {
+        const HighlightRule &rule = _currentSettings.highlightRules.at(x);
+        settings.setArrayIndex(x);
+        settings.setValue(SETTINGS_RULE_PATTERN, rule.pattern);
+        settings.setValue(SETTINGS_RULE_COLOR, rule.color.name());
+        settings.setValue(SETTINGS_RULE_WHOLE_LINE, rule.wholeLine);
+    }
+    settings.endArray();
+    settings.endGroup();
+
+    settings.beginGroup(SETTINGS_TRIGGERS);
+    qDebug() << "Write: triggerRules: " << _currentSettings.triggerRules.size();
+    settings.beginWriteArray(SETTINGS_TRIGGER_RULES, _currentSettings.triggerRules.size());
+    for(int x = 0; x < _currentSettings.triggerRules.size(); x++) {
+        const TriggerRule &rule = _currentSettings.triggerRules.at(x);
+        settings.setArrayIndex(x);
+        settings.setValue(SETTINGS_TRIGGER_PATTERN, rule.pattern);
+        settings.setValue(SETTINGS_TRIGGER_REGEX, rule.regex);
+        settings.setValue(SETTINGS_TRIGGER_ACTION, QLatin1String(triggerActions[rule.action]));
+        settings.setValue(SETTINGS_TRIGGER_PAYLOAD, TriggerEngine::escape(rule.payload));
+    }
+    settings.endArray();
+    settings.endGroup();
+
+    settings.beginGroup(SETTINGS_SCHEDULER);
+    qDebug() << "Write: scheduledCommands: " << _currentSettings.scheduledCommands.size();
+    settings.beginWriteArray(SETTINGS_SCHEDULED_COMMANDS, _currentSettings.scheduledCommands.size());
+    for(int x = 0; x < _currentSettings.scheduledCommands.size(); x++) {
+        const ScheduledCommand &command = _currentSettings.scheduledCommands.at(x);
+        settings.setArrayIndex(x);
+        settings.setValue(SETTINGS_COMMAND_NAME, command.name);
+        settings.setValue(SETTINGS_COMMAND_PAYLOAD, TriggerEngine::escape(command.payload));
+        settings.setValue(SETTINGS_COMMAND_INTERVAL, command.intervalMs);
+        settings.setValue(SETTINGS_COMMAND_RESPONSE, command.response);
+        settings.setValue(SETTINGS_COMMAND_REGEX, command.regex);
+        settings.setValue(SETTINGS_COMMAND_TIMEOUT, command.timeoutMs);
+    }
+    settings.endArray();
+    settings.endGroup();
 }
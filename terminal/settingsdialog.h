@@ -52,6 +52,11 @@
 #ifndef SETTINGSDIALOG_H
 #define SETTINGSDIALOG_H
 
+#include "commandscheduler.h"
+#include "framedecoder.h"
+#include "highlighter.h"
+#include "triggerengine.h"
+
 #include <QDialog>
 #include <QSerialPort>
 
@@ -62,9 +67,12 @@ class SettingsDialog;
 }
 
 class QIntValidator;
+class QSettings;
 
 QT_END_NAMESPACE
 
+class BaudDetector;
+
 class SettingsDialog : public QDialog
 {
     Q_OBJECT
@@ -83,6 +91,19 @@ public:
         QSerialPort::FlowControl flowControl;
         QString stringFlowControl;
         bool localEchoEnabled;
+        bool shmTapEnabled;
+        bool lowLatency;
+        //Low latency mode only: SCHED_FIFO or a nice boost for the I/O
+        //thread, and the CPU it is pinned to, -1 for any.
+        bool realTime;
+        int ioCpu;
+        bool markOverruns;
+        bool keepSession;
+        FrameDecoder::Type framing;
+        bool framingCrc;
+        QVector<HighlightRule> highlightRules;
+        QVector<TriggerRule> triggerRules;
+        QVector<ScheduledCommand> scheduledCommands;
     };
 
     explicit SettingsDialog(QWidget *parent = nullptr);
@@ -90,20 +111,30 @@ public:
 
     Settings settings() const;
 
+    //The current settings as the contents of a settings file, for a session
+    //snapshot.
+    QByteArray profile() const;
+    //Loads a profile() as if it had been saved. False if it cannot be read.
+    bool restoreProfile(const QByteArray &profile);
+
 private slots:
     void _slot_showPortInfo(int idx);
     void _slot_apply();
     void _slot_checkCustomBaudRatePolicy(int idx);
     void _slot_checkCustomDevicePathPolicy(int idx);
+    void _slot_detectBaudRate();
+    void _slot_baudRateDetected(qint32 baudRate);
 
 private:
     void _initialConnections();
     void _fillPortsParameters();
     void _fillPortsInfo();
     void _updateSettings();
+    //Selects baudRate in the list, or as a custom rate.
+    void _selectBaudRate(qint32 baudRate);
 
-    void _readSettings();
-    void _writeSettings();
+    void _readSettings(QSettings &settings);
+    void _writeSettings(QSettings &settings) const;
     void _applySavedSettings();
 
 private:
@@ -117,12 +148,40 @@ private:
     static const QString SETTINGS_STOP_BITS;
     static const QString SETTINGS_FLOW_CONTROL;
     static const QString SETTINGS_LOCAL_ECHO;
+    static const QString SETTINGS_SHM_TAP;
+    static const QString SETTINGS_LOW_LATENCY;
+    static const QString SETTINGS_REAL_TIME;
+    static const QString SETTINGS_IO_CPU;
+    static const QString SETTINGS_MARK_OVERRUNS;
+    static const QString SETTINGS_KEEP_SESSION;
+    static const QString SETTINGS_FRAMING;
+    static const QString SETTINGS_FRAMING_CRC;
+    static const QString SETTINGS_HIGHLIGHTING;
+    static const QString SETTINGS_HIGHLIGHT_RULES;
+    static const QString SETTINGS_RULE_PATTERN;
+    static const QString SETTINGS_RULE_COLOR;
+    static const QString SETTINGS_RULE_WHOLE_LINE;
+    static const QString SETTINGS_TRIGGERS;
+    static const QString SETTINGS_TRIGGER_RULES;
+    static const QString SETTINGS_TRIGGER_PATTERN;
+    static const QString SETTINGS_TRIGGER_REGEX;
+    static const QString SETTINGS_TRIGGER_ACTION;
+    static const QString SETTINGS_TRIGGER_PAYLOAD;
+    static const QString SETTINGS_SCHEDULER;
+    static const QString SETTINGS_SCHEDULED_COMMANDS;
+    static const QString SETTINGS_COMMAND_NAME;
+    static const QString SETTINGS_COMMAND_PAYLOAD;
+    static const QString SETTINGS_COMMAND_INTERVAL;
+    static const QString SETTINGS_COMMAND_RESPONSE;
+    static const QString SETTINGS_COMMAND_REGEX;
+    static const QString SETTINGS_COMMAND_TIMEOUT;
 
 
     Ui::SettingsDialog *_ui = nullptr;
     Settings _currentSettings;
     Settings _savedSettings;
     QIntValidator *_intValidator = nullptr;
+    BaudDetector *_baudDetector = nullptr;
 };
 
 #endif // SETTINGSDIALOG_H
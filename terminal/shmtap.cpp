@@ -0,0 +1,176 @@
+#include "shmtap.h"
+#include "monotonicclock.h"
+
+#include <QDebug>
+
+#include <climits>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace ShmTapLayout;
+
+ShmTap::~ShmTap() {
+    close();
+}
+
+QString
+ShmTap::nameForPort(const QString &portName) {
+    QString name = portName.section(QLatin1Char('/'), -1);
+    for (QChar &c : name) {
+        if (!c.isLetterOrNumber() && c != QLatin1Char('-') && c != QLatin1Char('_')) {
+            c = QLatin1Char('_');
+        }
+    }
+    return QStringLiteral("/terminal-") + name;
+}
+
+bool
+ShmTap::open(const QString &name, quint64 capacity) {
+    close();
+
+#ifdef __linux__
+    if (capacity < 4096 || (capacity & (capacity - 1)) != 0) {
+        _errorString = QStringLiteral("Tap capacity must be a power of two of at least 4096 bytes");
+        return false;
+    }
+
+    const QByteArray path = name.toLocal8Bit();
+    const int fd = ::shm_open(path.constData(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        _errorString = QStringLiteral("shm_open(%1): %2").arg(name, QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    const quint64 mappedSize = DataOffset + capacity;
+    if (::ftruncate(fd, static_cast<off_t>(mappedSize)) != 0) {
+        _errorString = QStringLiteral("ftruncate(%1): %2").arg(name, QString::fromLocal8Bit(strerror(errno)));
+        ::close(fd);
+        ::shm_unlink(path.constData());
+        return false;
+    }
+
+    void *mapping = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        _errorString = QStringLiteral("mmap(%1): %2").arg(name, QString::fromLocal8Bit(strerror(errno)));
+        ::shm_unlink(path.constData());
+        return false;
+    }
+
+    // A stale segment from a previous run may still be mapped by readers; clear
+    // the magic first so they stop trusting it while it is reinitialised.
+    _header = static_cast<Header *>(mapping);
+    __atomic_store_n(&_header->magic, 0, __ATOMIC_RELEASE);
+    _header->version = Version;
+    _header->capacity = capacity;
+    _header->reserved.store(0, std::memory_order_relaxed);
+    _header->committed.store(0, std::memory_order_relaxed);
+    _header->sequence.store(0, std::memory_order_relaxed);
+    _header->futexWord.store(0, std::memory_order_relaxed);
+    _header->waiters.store(0, std::memory_order_relaxed);
+    __atomic_store_n(&_header->magic, Magic, __ATOMIC_RELEASE);
+
+    _data = static_cast<char *>(mapping) + DataOffset;
+    _mappedSize = mappedSize;
+    _name = name;
+    _head = 0;
+    _sequence = 0;
+    _errorString.clear();
+    qDebug() << "Shared memory tap open:" << _name << "capacity" << capacity;
+    return true;
+#else
+    Q_UNUSED(name);
+    Q_UNUSED(capacity);
+    _errorString = QStringLiteral("The shared memory tap is only available on Linux");
+    return false;
+#endif
+}
+
+void
+ShmTap::close() {
+#ifdef __linux__
+    if (_header) {
+        // Wake blocked readers so they notice the segment going away.
+        __atomic_store_n(&_header->magic, 0, __ATOMIC_RELEASE);
+        _wakeReaders();
+        ::munmap(_header, _mappedSize);
+        ::shm_unlink(_name.toLocal8Bit().constData());
+    }
+#endif
+    _header = nullptr;
+    _data = nullptr;
+    _mappedSize = 0;
+    _name.clear();
+}
+
+void
+ShmTap::publish(Direction direction, const char *data, qint64 size, quint64 timestampNs) {
+    if (!_header || size <= 0) { return; }
+
+    // Chunks larger than a quarter of the ring are split, so that a reader
+    // always has a fair chance of seeing a record before it is overwritten.
+    const quint64 maxPayload = _header->capacity / 4 - sizeof(RecordHeader);
+    if (timestampNs == 0) {
+        timestampNs = monotonicNowNs();
+    }
+    quint64 remaining = static_cast<quint64>(size);
+    while (remaining > 0) {
+        const quint64 n = remaining < maxPayload ? remaining : maxPayload;
+        _writeRecord(direction, data, n, timestampNs);
+        data += n;
+        remaining -= n;
+    }
+
+    _header->futexWord.fetch_add(1, std::memory_order_seq_cst);
+    if (_header->waiters.load(std::memory_order_seq_cst) != 0) {
+        _wakeReaders();
+    }
+}
+
+void
+ShmTap::_writeRecord(Direction direction, const char *data, quint64 size, quint64 timestampNs) {
+    const quint64 capacity = _header->capacity;
+    const quint64 recordSize = alignedRecordSize(size);
+    const quint64 offset = _head & (capacity - 1);
+    const quint64 padding = (capacity - offset) < recordSize ? capacity - offset : 0;
+
+    // Announce the region about to be overwritten before touching it; readers
+    // compare against this after copying (seqlock style).
+    _header->reserved.store(_head + padding + recordSize, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (padding) {
+        RecordHeader *pad = reinterpret_cast<RecordHeader *>(_data + offset);
+        pad->size = static_cast<uint32_t>(padding);
+        pad->direction = Padding;
+        pad->sequence = 0;
+        pad->timestampNs = 0;
+        _head += padding;
+    }
+
+    RecordHeader *record = reinterpret_cast<RecordHeader *>(_data + (_head & (capacity - 1)));
+    record->size = static_cast<uint32_t>(size);
+    record->direction = direction;
+    record->sequence = ++_sequence;
+    record->timestampNs = timestampNs;
+    std::memcpy(record + 1, data, size);
+    _head += recordSize;
+
+    _header->sequence.store(_sequence, std::memory_order_relaxed);
+    _header->committed.store(_head, std::memory_order_release);
+}
+
+void
+ShmTap::_wakeReaders() {
+#ifdef __linux__
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&_header->futexWord), FUTEX_WAKE, INT_MAX,
+              nullptr, nullptr, 0);
+#endif
+}
@@ -0,0 +1,50 @@
+#ifndef SHMTAP_H
+#define SHMTAP_H
+
+#include "shmtaplayout.h"
+
+#include <QString>
+
+// Producer side of the shared-memory tap. Every RX/TX chunk is copied once
+// into a named POSIX shared-memory ring, where ShmTapReader consumers in other
+// processes pick it up. Publishing never blocks: a slow reader simply gets
+// overwritten and detects the overrun on its side.
+class ShmTap
+{
+public:
+    static const quint64 DEFAULT_CAPACITY = 4 * 1024 * 1024;
+
+    ShmTap() = default;
+    ~ShmTap();
+
+    ShmTap(const ShmTap &) = delete;
+    ShmTap &operator=(const ShmTap &) = delete;
+
+    bool open(const QString &name, quint64 capacity = DEFAULT_CAPACITY);
+    void close();
+    bool isOpen() const { return _header != nullptr; }
+
+    QString name() const { return _name; }
+    QString errorString() const { return _errorString; }
+
+    // timestampNs 0 stamps the record with the current time.
+    void publish(ShmTapLayout::Direction direction, const char *data, qint64 size, quint64 timestampNs = 0);
+
+    // Tap name derived from a port name, e.g. "ttyUSB0" -> "/terminal-ttyUSB0".
+    static QString nameForPort(const QString &portName);
+
+private:
+    void _writeRecord(ShmTapLayout::Direction direction, const char *data, quint64 size,
+                      quint64 timestampNs);
+    void _wakeReaders();
+
+    QString _name;
+    QString _errorString;
+    ShmTapLayout::Header *_header = nullptr;
+    char *_data = nullptr;
+    quint64 _mappedSize = 0;
+    quint64 _head = 0;
+    quint64 _sequence = 0;
+};
+
+#endif // SHMTAP_H
@@ -0,0 +1,100 @@
+#ifndef SHMTAPLAYOUT_H
+#define SHMTAPLAYOUT_H
+
+// Memory layout of the shared-memory tap. This header is shared between the
+// producer inside the terminal (ShmTap) and the standalone reader library
+// (ShmTapReader), so it must stay free of Qt.
+//
+// The segment is a header followed by a power-of-two data area used as a byte
+// ring. Records are 32-byte aligned and never wrap: when a record does not fit
+// in front of the end of the ring the producer writes a padding record first,
+// so every payload is contiguous and can be read in place.
+//
+// The producer never waits for readers. It announces the bytes it is about to
+// overwrite in `reserved`, copies the record, then publishes it in `committed`.
+// A reader validates a record after using it by checking that `reserved` has
+// not advanced more than `capacity` past the record's start.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if ATOMIC_LLONG_LOCK_FREE != 2 || ATOMIC_INT_LOCK_FREE != 2
+#error "The shared-memory tap requires lock-free 32 and 64-bit atomics"
+#endif
+
+namespace ShmTapLayout {
+
+static const uint32_t Magic = 0x31504154; // "TAP1"
+static const uint32_t Version = 1;
+static const uint64_t RecordAlignment = 32;
+static const uint64_t DataOffset = 128;
+
+enum Direction : uint32_t {
+    Rx = 0,
+    Tx = 1,
+    Frame = 2, // one decoded RX frame per record, payload only
+    ModemLines = 3, // ModemLinesPayload, timestamped with the edge
+    LineErrors = 4, // LineErrorsPayload, when the driver's error counters move
+    Padding = 0xFFFFFFFF
+};
+
+// Modem control line bits.
+enum ModemLine : uint32_t {
+    Dtr = 1 << 0,
+    Rts = 1 << 1,
+    Cts = 1 << 2,
+    Dsr = 1 << 3,
+    Dcd = 1 << 4,
+    Ri = 1 << 5
+};
+
+struct ModemLinesPayload {
+    uint32_t lines;   // ModemLine bits that are asserted after the edge
+    uint32_t changed; // lines that changed since the previous record; a line
+                      // can be set here and unchanged in lines after a pulse
+};
+
+// Driver error counters since the port was opened. Sent when a periodic
+// sample finds them moved (rxLength 0), or for a marked overrun, where
+// [rxOffset, rxOffset + rxLength) is the read that holds the gap.
+struct LineErrorsPayload {
+    uint64_t rxOffset; // RX stream offset
+    uint32_t rxLength;
+    uint32_t frame;
+    uint32_t parity;
+    uint32_t breaks;
+    uint32_t overrun;
+    uint32_t bufferOverrun;
+};
+
+struct Header {
+    uint32_t magic;                  // written last by the producer, after initialisation
+    uint32_t version;
+    uint64_t capacity;               // size of the data area, power of two
+    std::atomic<uint64_t> reserved;  // end of the region the producer may be writing
+    std::atomic<uint64_t> committed; // end of the last fully written record
+    std::atomic<uint64_t> sequence;  // sequence number of the last published record
+    std::atomic<uint32_t> futexWord; // bumped on every publish, readers futex-wait on it
+    std::atomic<uint32_t> waiters;   // readers currently blocked on futexWord
+};
+
+struct RecordHeader {
+    uint32_t size;        // payload bytes, or total bytes for a padding record
+    uint32_t direction;   // Direction
+    uint64_t sequence;
+    uint64_t timestampNs; // CLOCK_MONOTONIC
+    uint64_t reserved;
+};
+
+static_assert(sizeof(Header) <= DataOffset, "Tap header does not fit in front of the data area");
+static_assert(sizeof(RecordHeader) == RecordAlignment, "Tap record header must be one alignment unit");
+
+inline uint64_t
+alignedRecordSize(uint64_t payload) {
+    return (sizeof(RecordHeader) + payload + RecordAlignment - 1) & ~(RecordAlignment - 1);
+}
+
+} // namespace ShmTapLayout
+
+#endif // SHMTAPLAYOUT_H
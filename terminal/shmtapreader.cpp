@@ -0,0 +1,202 @@
+#include "shmtapreader.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace ShmTapLayout;
+
+ShmTapReader::~ShmTapReader() {
+    close();
+}
+
+bool
+ShmTapReader::open(const std::string &name, bool fromOldest) {
+    close();
+
+#ifdef __linux__
+    // Read-write because blocked readers register themselves in the header.
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        _errorString = "shm_open(" + name + "): " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) <= DataOffset) {
+        _errorString = name + ": not a terminal tap";
+        ::close(fd);
+        return false;
+    }
+
+    const uint64_t mappedSize = static_cast<uint64_t>(st.st_size);
+    void *mapping = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        _errorString = "mmap(" + name + "): " + std::strerror(errno);
+        return false;
+    }
+
+    Header *header = static_cast<Header *>(mapping);
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != Magic
+            || header->version != Version
+            || header->capacity + DataOffset != mappedSize) {
+        _errorString = name + ": not a terminal tap, or an incompatible version";
+        ::munmap(mapping, mappedSize);
+        return false;
+    }
+
+    _header = header;
+    _data = static_cast<const char *>(mapping) + DataOffset;
+    _mappedSize = mappedSize;
+    _capacity = header->capacity;
+
+    // Record boundaries are only known from the start of the ring, so old data
+    // can be replayed only as long as the producer has not wrapped yet.
+    const uint64_t committed = _header->committed.load(std::memory_order_acquire);
+    _readPosition = (fromOldest && committed <= _capacity) ? 0 : committed;
+    _lastSequence = 0;
+    _overruns = 0;
+    _lostRecords = 0;
+    _errorString.clear();
+    return true;
+#else
+    (void)name;
+    (void)fromOldest;
+    _errorString = "The shared memory tap is only available on Linux";
+    return false;
+#endif
+}
+
+void
+ShmTapReader::close() {
+#ifdef __linux__
+    if (_header) {
+        ::munmap(_header, _mappedSize);
+    }
+#endif
+    _header = nullptr;
+    _data = nullptr;
+    _mappedSize = 0;
+    _capacity = 0;
+}
+
+ShmTapReader::Status
+ShmTapReader::next(Record &record) {
+    if (!_header || __atomic_load_n(&_header->magic, __ATOMIC_ACQUIRE) != Magic) {
+        return Closed;
+    }
+
+    for (;;) {
+        const uint64_t committed = _header->committed.load(std::memory_order_acquire);
+        if (_readPosition == committed) {
+            return Empty;
+        }
+        if (committed - _readPosition > _capacity) {
+            _resync();
+            return Overrun;
+        }
+
+        const RecordHeader *header = reinterpret_cast<const RecordHeader *>(
+                    _data + (_readPosition & (_capacity - 1)));
+        const uint32_t size = header->size;
+        const uint32_t direction = header->direction;
+        const uint64_t sequence = header->sequence;
+        const uint64_t timestampNs = header->timestampNs;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!_isIntact(_readPosition)) {
+            _resync();
+            return Overrun;
+        }
+
+        if (direction == Padding) {
+            _readPosition += size;
+            continue;
+        }
+
+        if (_lastSequence != 0 && sequence != _lastSequence + 1) {
+            _lostRecords += sequence - _lastSequence - 1;
+        }
+        _lastSequence = sequence;
+
+        record.sequence = sequence;
+        record.timestampNs = timestampNs;
+        record.direction = static_cast<Direction>(direction);
+        record.data = reinterpret_cast<const char *>(header + 1);
+        record.size = size;
+        record.position = _readPosition;
+
+        _readPosition += alignedRecordSize(size);
+        return Ok;
+    }
+}
+
+bool
+ShmTapReader::isValid(const Record &record) const {
+    if (!_header) { return false; }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _isIntact(record.position);
+}
+
+ShmTapReader::Status
+ShmTapReader::copyNext(Record &record, std::string &buffer) {
+    const Status status = next(record);
+    if (status != Ok) {
+        return status;
+    }
+
+    buffer.assign(record.data, record.size);
+    if (!isValid(record)) {
+        _resync();
+        return Overrun;
+    }
+
+    record.data = buffer.data();
+    return Ok;
+}
+
+bool
+ShmTapReader::wait(int timeoutMs) {
+    if (!_header) { return false; }
+
+#ifdef __linux__
+    _header->waiters.fetch_add(1, std::memory_order_seq_cst);
+    const uint32_t expected = _header->futexWord.load(std::memory_order_seq_cst);
+
+    if (_header->committed.load(std::memory_order_seq_cst) == _readPosition
+            && __atomic_load_n(&_header->magic, __ATOMIC_ACQUIRE) == Magic) {
+        struct timespec timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&_header->futexWord), FUTEX_WAIT,
+                  expected, timeoutMs < 0 ? nullptr : &timeout, nullptr, 0);
+    }
+
+    _header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+#else
+    (void)timeoutMs;
+#endif
+
+    return _header->committed.load(std::memory_order_acquire) != _readPosition;
+}
+
+bool
+ShmTapReader::_isIntact(uint64_t position) const {
+    return _header->reserved.load(std::memory_order_relaxed) - position <= _capacity;
+}
+
+void
+ShmTapReader::_resync() {
+    ++_overruns;
+    _readPosition = _header->committed.load(std::memory_order_acquire);
+}
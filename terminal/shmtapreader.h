@@ -0,0 +1,87 @@
+#ifndef SHMTAPREADER_H
+#define SHMTAPREADER_H
+
+#include "shmtaplayout.h"
+
+#include <cstdint>
+#include <string>
+
+// Consumer side of the shared-memory tap published by the terminal. This is a
+// small standalone library (no Qt) for test automation that wants the raw
+// serial stream with as little latency as possible.
+//
+//     ShmTapReader reader;
+//     reader.open("/terminal-ttyUSB0");
+//     ShmTapReader::Record record;
+//     for (;;) {
+//         ShmTapReader::Status status = reader.next(record);
+//         if (status == ShmTapReader::Empty) { reader.wait(100); continue; }
+//         if (status == ShmTapReader::Overrun) { /* records were lost */ continue; }
+//         consume(record.data, record.size);  // zero copy, points into the segment
+//         if (!reader.isValid(record)) { /* overwritten while consuming */ }
+//     }
+class ShmTapReader
+{
+public:
+    enum Status {
+        Ok,
+        Empty,
+        Overrun,
+        Closed
+    };
+
+    struct Record {
+        uint64_t sequence = 0;
+        uint64_t timestampNs = 0;
+        ShmTapLayout::Direction direction = ShmTapLayout::Rx;
+        const char *data = nullptr;
+        uint32_t size = 0;
+        uint64_t position = 0;
+    };
+
+    ShmTapReader() = default;
+    ~ShmTapReader();
+
+    ShmTapReader(const ShmTapReader &) = delete;
+    ShmTapReader &operator=(const ShmTapReader &) = delete;
+
+    // Attaches to an existing tap. Reading starts at the newest data unless
+    // fromOldest is set, in which case whatever is still in the ring is replayed.
+    bool open(const std::string &name, bool fromOldest = false);
+    void close();
+    bool isOpen() const { return _header != nullptr; }
+    const std::string &errorString() const { return _errorString; }
+
+    // Returns the next record as a view into the shared segment. The view stays
+    // readable, but the producer may overwrite it at any time: call isValid()
+    // after consuming it to know whether what was read is trustworthy.
+    Status next(Record &record);
+    bool isValid(const Record &record) const;
+
+    // Copies the next record out of the ring, validating it. Convenient when the
+    // consumer needs the data beyond the lifetime of the ring slot.
+    Status copyNext(Record &record, std::string &buffer);
+
+    // Blocks until new data is published, the timeout expires (-1 waits
+    // forever) or the tap is closed. Returns true if data is available.
+    bool wait(int timeoutMs);
+
+    uint64_t overruns() const { return _overruns; }
+    uint64_t lostRecords() const { return _lostRecords; }
+
+private:
+    bool _isIntact(uint64_t position) const;
+    void _resync();
+
+    std::string _errorString;
+    ShmTapLayout::Header *_header = nullptr;
+    const char *_data = nullptr;
+    uint64_t _mappedSize = 0;
+    uint64_t _capacity = 0;
+    uint64_t _readPosition = 0;
+    uint64_t _lastSequence = 0;
+    uint64_t _overruns = 0;
+    uint64_t _lostRecords = 0;
+};
+
+#endif // SHMTAPREADER_H
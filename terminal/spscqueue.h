@@ -0,0 +1,77 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded single-producer/single-consumer queue. Both ends are wait free and
+// nothing is allocated after construction; used to hand work between an I/O
+// thread and the GUI thread.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) :
+        _capacity(_roundUp(capacity)),
+        _items(new T[_capacity])
+    {
+        _head.value.store(0);
+        _tail.value.store(0);
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer only. Returns false when the queue is full.
+    bool push(const T &item) {
+        const size_t tail = _tail.value.load(std::memory_order_relaxed);
+        if (tail - _head.value.load(std::memory_order_acquire) == _capacity) {
+            return false;
+        }
+        _items[tail & (_capacity - 1)] = item;
+        _tail.value.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false when the queue is empty.
+    bool pop(T &item) {
+        const size_t head = _head.value.load(std::memory_order_relaxed);
+        if (head == _tail.value.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[head & (_capacity - 1)];
+        _head.value.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const {
+        return _head.value.load(std::memory_order_acquire) == _tail.value.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t _roundUp(size_t value) {
+        size_t capacity = 1;
+        while (capacity < value) { capacity <<= 1; }
+        return capacity;
+    }
+
+    static const size_t CACHE_LINE = 64;
+
+    // Padded to a cache line, so the producer and the consumer do not
+    // invalidate each other's line on every push and pop, nor the one with
+    // _capacity that both read. Padding rather than alignas(64): an
+    // over-aligned member makes every class holding a queue over-aligned,
+    // which plain new only honours from C++17 on.
+    struct Index {
+        std::atomic<size_t> value;
+        char pad[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    };
+
+    Index _head;
+    Index _tail;
+    const size_t _capacity;
+    std::unique_ptr<T[]> _items;
+};
+
+#endif // SPSCQUEUE_H
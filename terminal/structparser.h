@@ -0,0 +1,98 @@
+#ifndef STRUCTPARSER_H
+#define STRUCTPARSER_H
+
+#include "structschema.h"
+
+#include <type_traits>
+
+//Compile-time struct layouts. A layout is a list of Field types; its parse()
+//is the reads and shifts of those fields inlined one after the other, with
+//offsets, byte order, bit ranges and scales as constants, and its describe()
+//gives the same fields as a StructSchema for the table and the generic path.
+namespace StructParser {
+
+enum ByteOrder { Little, Big };
+
+template <typename T> struct Storage;
+template <> struct Storage<quint8>  { typedef quint8 Raw;  static const StructField::Type type = StructField::U8; };
+template <> struct Storage<qint8>   { typedef quint8 Raw;  static const StructField::Type type = StructField::I8; };
+template <> struct Storage<quint16> { typedef quint16 Raw; static const StructField::Type type = StructField::U16; };
+template <> struct Storage<qint16>  { typedef quint16 Raw; static const StructField::Type type = StructField::I16; };
+template <> struct Storage<quint32> { typedef quint32 Raw; static const StructField::Type type = StructField::U32; };
+template <> struct Storage<qint32>  { typedef quint32 Raw; static const StructField::Type type = StructField::I32; };
+template <> struct Storage<quint64> { typedef quint64 Raw; static const StructField::Type type = StructField::U64; };
+template <> struct Storage<qint64>  { typedef quint64 Raw; static const StructField::Type type = StructField::I64; };
+template <> struct Storage<float>   { typedef quint32 Raw; static const StructField::Type type = StructField::F32; };
+template <> struct Storage<double>  { typedef quint64 Raw; static const StructField::Type type = StructField::F64; };
+
+//A T at byte Offset; with Width, bits Bit to Bit + Width - 1 of it. The value
+//is multiplied by ScaleNum / ScaleDen.
+template <typename T, int Offset, ByteOrder Order = Little, int Bit = 0, int Width = 0,
+          long ScaleNum = 1, long ScaleDen = 1>
+struct Field
+{
+    typedef typename Storage<T>::Raw Raw;
+
+    static_assert(Width == 0 || !std::is_floating_point<T>::value, "bit ranges of floats");
+    static_assert(Bit >= 0 && Width >= 0 && Bit + Width <= int(sizeof(T) * 8), "bits outside the field");
+    static_assert(ScaleDen != 0, "scale");
+
+    static const int END = Offset + int(sizeof(T));
+
+    static double read(const char *data) {
+        const Raw raw = structLoad<Raw>(data + Offset, Order == Big);
+        if (Width) {
+            return structBits(raw, Bit, Width, std::is_signed<T>::value) * scale();
+        }
+        T value;
+        std::memcpy(&value, &raw, sizeof(value));
+        return static_cast<double>(value) * scale();
+    }
+
+    static void describe(StructField &field) {
+        field.type = Storage<T>::type;
+        field.offset = Offset;
+        field.bigEndian = Order == Big;
+        field.bit = Bit;
+        field.width = Width;
+        field.scale = scale();
+    }
+
+private:
+    static constexpr double scale() { return double(ScaleNum) / double(ScaleDen); }
+};
+
+template <typename... Fields> struct Layout;
+
+template <>
+struct Layout<>
+{
+    static const int COUNT = 0;
+    static const int END = 0;
+
+    static void parse(const char *data, double *values) { Q_UNUSED(data); Q_UNUSED(values); }
+    static void describe(QVector<StructField> &fields) { Q_UNUSED(fields); }
+};
+
+template <typename First, typename... Rest>
+struct Layout<First, Rest...>
+{
+    static const int COUNT = 1 + Layout<Rest...>::COUNT;
+    static const int END = First::END > Layout<Rest...>::END ? First::END : Layout<Rest...>::END;
+
+    static void parse(const char *data, double *values) {
+        values[0] = First::read(data);
+        Layout<Rest...>::parse(data, values + 1);
+    }
+
+    static void describe(QVector<StructField> &fields) {
+        StructField field;
+        First::describe(field);
+        fields.append(field);
+        Layout<Rest...>::describe(fields);
+    }
+};
+
+} // namespace StructParser
+
+#endif // STRUCTPARSER_H
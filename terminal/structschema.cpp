@@ -0,0 +1,187 @@
+#include "structschema.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <algorithm>
+
+static const char *const typeNames[] = { "u8", "i8", "u16", "i16", "u32", "i32", "u64", "i64", "f32", "f64" };
+
+int
+StructField::size(Type type) {
+    switch (type) {
+    case U8:
+    case I8:
+        return 1;
+    case U16:
+    case I16:
+        return 2;
+    case U32:
+    case I32:
+    case F32:
+        return 4;
+    default:
+        return 8;
+    }
+}
+
+bool
+StructField::isSigned(Type type) {
+    return type == I8 || type == I16 || type == I32 || type == I64;
+}
+
+QString
+StructField::typeName(Type type, bool bigEndian) {
+    QString name = QLatin1String(typeNames[type]);
+    if (bigEndian && size(type) > 1) {
+        name += QStringLiteral("be");
+    }
+    return name;
+}
+
+bool
+StructField::typeFromName(const QString &name, Type &type, bool &bigEndian) {
+    QString base = name.toLower();
+    bigEndian = false;
+    if (base.endsWith(QLatin1String("be"))) {
+        bigEndian = true;
+        base.chop(2);
+    }
+    else if (base.endsWith(QLatin1String("le"))) {
+        base.chop(2);
+    }
+    for (int x = 0; x <= F64; x++) {
+        if (base == QLatin1String(typeNames[x])) {
+            type = static_cast<Type>(x);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+StructSchema::parse(const QString &text, QString &errorString) {
+    static const QRegularExpression bits(QStringLiteral("^(\\d+):(\\d+)$"));
+
+    QVector<StructField> parsed;
+    int declaredSize = 0;
+    const QStringList lines = text.split(QLatin1Char('\n'));
+    for (int number = 0; number < lines.size(); number++) {
+        QString line = lines.at(number);
+        const int comment = line.indexOf(QLatin1Char('#'));
+        if (comment >= 0) { line.truncate(comment); }
+        line = line.simplified();
+        if (line.isEmpty()) { continue; }
+        const QStringList tokens = line.split(QLatin1Char(' '));
+
+        auto fail = [&](const QString &message) {
+            errorString = QStringLiteral("line %1: %2").arg(number + 1).arg(message);
+            return false;
+        };
+
+        bool ok = false;
+        if (tokens.at(0) == QLatin1String("size")) {
+            declaredSize = tokens.size() == 2 ? tokens.at(1).toInt(&ok) : 0;
+            if (!ok || declaredSize <= 0) { return fail(QStringLiteral("size takes a number of bytes")); }
+            continue;
+        }
+        if (tokens.size() < 3) { return fail(QStringLiteral("expected name, type and offset")); }
+
+        StructField field;
+        field.name = tokens.at(0);
+        if (!StructField::typeFromName(tokens.at(1), field.type, field.bigEndian)) {
+            return fail(QStringLiteral("unknown type '%1'").arg(tokens.at(1)));
+        }
+        field.offset = tokens.at(2).toInt(&ok);
+        if (!ok || field.offset < 0) { return fail(QStringLiteral("bad offset '%1'").arg(tokens.at(2))); }
+
+        for (int x = 3; x < tokens.size(); x++) {
+            const QString &token = tokens.at(x);
+            const QRegularExpressionMatch match = bits.match(token);
+            if (match.hasMatch()) {
+                field.bit = match.captured(1).toInt();
+                field.width = match.captured(2).toInt();
+                if (StructField::isFloat(field.type) || field.width <= 0
+                    || field.bit + field.width > StructField::size(field.type) * 8) {
+                    return fail(QStringLiteral("bits %1 do not fit the field").arg(token));
+                }
+            }
+            else if (token.startsWith(QLatin1Char('*'))) {
+                field.scale = token.mid(1).toDouble(&ok);
+                if (!ok) { return fail(QStringLiteral("bad scale '%1'").arg(token)); }
+            }
+            else {
+                return fail(QStringLiteral("unexpected '%1'").arg(token));
+            }
+        }
+        parsed.append(field);
+    }
+
+    if (parsed.isEmpty()) {
+        errorString = QStringLiteral("no fields");
+        return false;
+    }
+    fields = parsed;
+    size = std::max(declaredSize, fieldsEnd());
+    errorString.clear();
+    return true;
+}
+
+QString
+StructSchema::toText() const {
+    QStringList lines;
+    lines << QStringLiteral("size %1").arg(size);
+    for (const StructField &field : fields) {
+        QString line = QStringLiteral("%1 %2 %3").arg(field.name, StructField::typeName(field.type, field.bigEndian))
+                       .arg(field.offset);
+        if (field.width) {
+            line += QStringLiteral(" %1:%2").arg(field.bit).arg(field.width);
+        }
+        if (field.scale != 1) {
+            line += QStringLiteral(" *%1").arg(field.scale, 0, 'g', 12);
+        }
+        lines << line;
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+int
+StructSchema::fieldsEnd() const {
+    int end = 0;
+    for (const StructField &field : fields) {
+        end = std::max(end, field.offset + StructField::size(field.type));
+    }
+    return end;
+}
+
+template <typename Raw, typename Value>
+static inline double
+decodeField(const StructField &field, const char *p) {
+    const Raw raw = structLoad<Raw>(p, field.bigEndian);
+    if (field.width) {
+        return structBits(raw, field.bit, field.width, StructField::isSigned(field.type)) * field.scale;
+    }
+    Value value;
+    std::memcpy(&value, &raw, sizeof(value));
+    return static_cast<double>(value) * field.scale;
+}
+
+void
+StructSchema::decode(const char *data, double *values) const {
+    for (int x = 0; x < fields.size(); x++) {
+        const StructField &field = fields.at(x);
+        const char *p = data + field.offset;
+        switch (field.type) {
+        case StructField::U8:  values[x] = decodeField<quint8, quint8>(field, p); break;
+        case StructField::I8:  values[x] = decodeField<quint8, qint8>(field, p); break;
+        case StructField::U16: values[x] = decodeField<quint16, quint16>(field, p); break;
+        case StructField::I16: values[x] = decodeField<quint16, qint16>(field, p); break;
+        case StructField::U32: values[x] = decodeField<quint32, quint32>(field, p); break;
+        case StructField::I32: values[x] = decodeField<quint32, qint32>(field, p); break;
+        case StructField::U64: values[x] = decodeField<quint64, quint64>(field, p); break;
+        case StructField::I64: values[x] = decodeField<quint64, qint64>(field, p); break;
+        case StructField::F32: values[x] = decodeField<quint32, float>(field, p); break;
+        case StructField::F64: values[x] = decodeField<quint64, double>(field, p); break;
+        }
+    }
+}
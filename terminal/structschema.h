@@ -0,0 +1,82 @@
+#ifndef STRUCTSCHEMA_H
+#define STRUCTSCHEMA_H
+
+#include <QString>
+#include <QVector>
+#include <QtEndian>
+
+#include <cstring>
+
+//One field of a packed binary struct: a little or big endian integer or float
+//at a byte offset, optionally a bit range of it, times a scale.
+struct StructField
+{
+    enum Type { U8, I8, U16, I16, U32, I32, U64, I64, F32, F64 };
+
+    QString name;
+    Type type = U8;
+    int offset = 0;
+    bool bigEndian = false;
+    int bit = 0;
+    int width = 0;          //bits; 0 is the whole value
+    double scale = 1;
+
+    static int size(Type type);
+    static bool isSigned(Type type);
+    static bool isFloat(Type type) { return type == F32 || type == F64; }
+    static QString typeName(Type type, bool bigEndian);
+    //"u16be" and the like.
+    static bool typeFromName(const QString &name, Type &type, bool &bigEndian);
+};
+
+//Reads an unsigned value of Raw's size at p in the given byte order; shared
+//by the generic path and the compiled parsers of structparser.h.
+template <typename Raw>
+inline Raw
+structLoad(const char *p, bool bigEndian) {
+    Raw raw;
+    std::memcpy(&raw, p, sizeof(raw));
+    return bigEndian ? qFromBigEndian(raw) : qFromLittleEndian(raw);
+}
+
+//Bits bit to bit + width - 1 of raw, sign extended for signed fields.
+template <typename Raw>
+inline double
+structBits(Raw raw, int bit, int width, bool isSigned) {
+    const quint64 mask = width >= 64 ? ~quint64(0) : (quint64(1) << width) - 1;
+    const quint64 bits = (static_cast<quint64>(raw) >> bit) & mask;
+    if (isSigned && width < 64 && (bits >> (width - 1)) & 1) {
+        return static_cast<double>(static_cast<qint64>(bits | ~mask));
+    }
+    return static_cast<double>(bits);
+}
+
+//A struct layout, compiled in (see KnownStructs) or loaded at run time from
+//text with one field per line:
+//
+//  # comment
+//  size 21                 bytes a frame needs; default: the end of the last field
+//  seq     u16be   0       name, type, byte offset
+//  temp    i16     6  *0.01
+//  mode    u8      10 0:3  bits 0 to 2 of the byte
+//
+//Types are u8..u64, i8..i64, f32 and f64, little endian unless followed by
+//"be". decode() interprets the fields one by one, which is the generic path;
+//a KnownStructs parser does the same with everything resolved at compile time.
+class StructSchema
+{
+public:
+    QString name;
+    int size = 0;
+    QVector<StructField> fields;
+
+    bool parse(const QString &text, QString &errorString);
+    QString toText() const;
+    //The end of the last field.
+    int fieldsEnd() const;
+
+    //values holds one double per field; data at least size bytes.
+    void decode(const char *data, double *values) const;
+};
+
+#endif // STRUCTSCHEMA_H
@@ -0,0 +1,464 @@
+#include "structview.h"
+
+#include <QComboBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QFont>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QItemSelectionModel>
+#include <QLabel>
+#include <QPainter>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QSignalBlocker>
+#include <QSplitter>
+#include <QTableView>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include <algorithm>
+#include <limits>
+
+static QString
+formatValue(const StructField &field, double value) {
+    if (value != value) { return QStringLiteral("NaN"); }
+    if (StructField::isFloat(field.type) || field.scale != 1) {
+        return QString::number(value, 'g', 8);
+    }
+    return QString::number(static_cast<qint64>(value));
+}
+
+StructModel::StructModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{
+}
+
+void
+StructModel::setSchema(const StructSchema &schema) {
+    beginResetModel();
+    _fields = schema.fields;
+    _values.clear();
+    _min.clear();
+    _max.clear();
+    endResetModel();
+}
+
+void
+StructModel::setValues(const QVector<double> &values, const QVector<double> &min, const QVector<double> &max) {
+    _values = values;
+    _min = min;
+    _max = max;
+    if (!_fields.isEmpty()) {
+        emit dataChanged(index(0, ValueColumn), index(_fields.size() - 1, MaxColumn));
+    }
+}
+
+int
+StructModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : _fields.size();
+}
+
+int
+StructModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant
+StructModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= _fields.size()) { return QVariant(); }
+    if (role == Qt::TextAlignmentRole && index.column() >= ValueColumn) {
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) { return QVariant(); }
+
+    const StructField &field = _fields.at(index.row());
+    const bool decoded = index.row() < _values.size();
+    switch (index.column()) {
+    case NameColumn:
+        return field.name;
+    case TypeColumn: {
+        QString type = QStringLiteral("%1 @%2").arg(StructField::typeName(field.type, field.bigEndian)).arg(field.offset);
+        if (field.width) {
+            type += QStringLiteral(" [%1:%2]").arg(field.bit).arg(field.width);
+        }
+        return type;
+    }
+    case ValueColumn:
+        return decoded ? formatValue(field, _values.at(index.row())) : QString();
+    case MinColumn:
+        return decoded ? formatValue(field, _min.at(index.row())) : QString();
+    case MaxColumn:
+        return decoded ? formatValue(field, _max.at(index.row())) : QString();
+    default:
+        return QVariant();
+    }
+}
+
+QVariant
+StructModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) { return QVariant(); }
+
+    switch (section) {
+    case NameColumn: return tr("Field");
+    case TypeColumn: return tr("Type");
+    case ValueColumn: return tr("Value");
+    case MinColumn: return tr("Min");
+    case MaxColumn: return tr("Max");
+    default: return QVariant();
+    }
+}
+
+StructTrend::StructTrend(QWidget *parent) :
+    QWidget(parent)
+{
+    setMinimumHeight(60);
+}
+
+QSize
+StructTrend::sizeHint() const {
+    return QSize(400, 120);
+}
+
+void
+StructTrend::clear(const QString &label) {
+    _points.clear();
+    _next = 0;
+    _label = label;
+    update();
+}
+
+void
+StructTrend::append(double value) {
+    if (_points.size() < MAX_POINTS) {
+        _points.append(value);
+        return;
+    }
+    _points[_next] = value;
+    _next = (_next + 1) % MAX_POINTS;
+}
+
+void
+StructTrend::paintEvent(QPaintEvent *e) {
+    Q_UNUSED(e);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+    painter.setPen(palette().color(QPalette::Text));
+    if (_label.isEmpty()) {
+        painter.drawText(rect(), Qt::AlignCenter, tr("Select a field to plot it"));
+        return;
+    }
+
+    double low = std::numeric_limits<double>::max();
+    double high = -std::numeric_limits<double>::max();
+    for (double value : _points) {
+        if (value != value) { continue; }
+        low = std::min(low, value);
+        high = std::max(high, value);
+    }
+
+    const QRect text = rect().adjusted(4, 2, -4, -2);
+    if (low > high) {
+        painter.drawText(text, Qt::AlignTop | Qt::AlignLeft, _label);
+        return;
+    }
+    painter.drawText(text, Qt::AlignTop | Qt::AlignLeft,
+                     QStringLiteral("%1  %2").arg(_label).arg(_points.at((_next + _points.size() - 1) % _points.size()), 0, 'g', 8));
+    painter.drawText(text, Qt::AlignTop | Qt::AlignRight, QString::number(high, 'g', 8));
+    painter.drawText(text, Qt::AlignBottom | Qt::AlignRight, QString::number(low, 'g', 8));
+
+    const int top = fontMetrics().height() + 4;
+    const int bottom = height() - fontMetrics().height() - 4;
+    const int width = this->width() - 8;
+    if (bottom <= top || width <= 0) { return; }
+    const double span = high > low ? high - low : 1;
+
+    //One vertex per pixel column at most; the last point of a column wins.
+    QPolygonF line;
+    const int count = _points.size();
+    const int step = std::max(1, count / width);
+    for (int x = 0; x < count; x += step) {
+        const double value = _points.at((_next + x) % count);
+        if (value != value) { continue; }
+        const double px = 4 + static_cast<double>(x) * width / MAX_POINTS;
+        const double py = bottom - (value - low) / span * (bottom - top);
+        line.append(QPointF(px, py));
+    }
+    painter.setPen(palette().color(QPalette::Highlight));
+    painter.drawPolyline(line);
+}
+
+StructView::StructView(QWidget *parent) :
+    QWidget(parent),
+    _schemas(new QComboBox),
+    _editor(new QPlainTextEdit),
+    _model(new StructModel(this)),
+    _table(new QTableView),
+    _trend(new StructTrend),
+    _status(new QLabel),
+    _benchmarkButton(new QPushButton(tr("Benchmark"))),
+    _refreshTimer(new QTimer(this))
+{
+    for (int x = 0; x < KnownStructs::count(); x++) {
+        _schemas->addItem(KnownStructs::entry(x).schema().name, x);
+    }
+    _schemas->addItem(tr("Custom"), -1);
+
+    _editor->setFont(QFont(QStringLiteral("Monospace")));
+    _editor->setLineWrapMode(QPlainTextEdit::NoWrap);
+    _editor->setToolTip(tr("One field per line: name, type (u8..u64, i8..i64, f32, f64, \"be\" suffix for big endian), "
+                           "byte offset, optional bit:width and *scale. \"size N\" sets the frame size."));
+
+    _table->setModel(_model);
+    _table->verticalHeader()->hide();
+    _table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    _table->verticalHeader()->setDefaultSectionSize(_table->fontMetrics().height() + 4);
+    _table->horizontalHeader()->setStretchLastSection(true);
+    _table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _table->setSelectionMode(QAbstractItemView::SingleSelection);
+
+    QPushButton *apply = new QPushButton(tr("Apply"));
+    QPushButton *load = new QPushButton(tr("Load..."));
+    _benchmarkButton->setToolTip(tr("Time the compiled and the generic decoder of this schema on synthetic frames"));
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(_schemas);
+    bar->addWidget(apply);
+    bar->addWidget(load);
+    bar->addWidget(_benchmarkButton);
+    bar->addWidget(_status, 1);
+
+    QSplitter *values = new QSplitter(Qt::Vertical);
+    values->addWidget(_table);
+    values->addWidget(_trend);
+    QSplitter *split = new QSplitter;
+    split->addWidget(_editor);
+    split->addWidget(values);
+    split->setStretchFactor(1, 1);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(split, 1);
+
+    _refreshTimer->setInterval(100);
+    connect(_refreshTimer, &QTimer::timeout, this, &StructView::_slot_refresh);
+    connect(_schemas, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, &StructView::_slot_schemaSelected);
+    connect(apply, &QPushButton::clicked, this, &StructView::_slot_apply);
+    connect(load, &QPushButton::clicked, this, &StructView::_slot_load);
+    connect(_benchmarkButton, &QPushButton::clicked, this, &StructView::_slot_benchmark);
+    connect(this, &StructView::benchmarkFinished, this, &StructView::_slot_benchmarkFinished);
+    connect(_table->selectionModel(), &QItemSelectionModel::selectionChanged, this, &StructView::_slot_fieldSelected);
+
+    _slot_schemaSelected(0);
+}
+
+StructView::~StructView() {
+    if (_benchmarkThread.joinable()) {
+        _benchmarkThread.join();
+    }
+}
+
+void
+StructView::setActive(bool active) {
+    _active = active;
+    if (active) {
+        _refreshTimer->start();
+        _updateStatus();
+    }
+    else {
+        _refreshTimer->stop();
+    }
+}
+
+void
+StructView::append(const QVector<DecodedFrame> &frames) {
+    if (_schema.fields.isEmpty()) { return; }
+
+    const int count = _schema.fields.size();
+    for (const DecodedFrame &frame : frames) {
+        if (!frame.crcOk) {
+            _badCrc++;
+            continue;
+        }
+        if (frame.payload.size < _schema.size) {
+            _short++;
+            continue;
+        }
+
+        double *values = _values.data();
+        if (_parse) {
+            _parse(frame.payload.data, values);
+        }
+        else {
+            _schema.decode(frame.payload.data, values);
+        }
+        for (int x = 0; x < count; x++) {
+            _min[x] = std::min(_min[x], values[x]);
+            _max[x] = std::max(_max[x], values[x]);
+        }
+        if (_trendField >= 0) {
+            _trend->append(values[_trendField]);
+        }
+        _decoded++;
+        _changed = true;
+    }
+}
+
+void
+StructView::_slot_schemaSelected(int index) {
+    const int known = _schemas->itemData(index).toInt();
+    if (known < 0) {
+        //Custom: start from whatever is in the editor.
+        _editor->setFocus();
+        return;
+    }
+
+    const KnownStructs::Entry &entry = KnownStructs::entry(known);
+    const StructSchema schema = entry.schema();
+    _editor->setPlainText(schema.toText());
+    _setSchema(schema, entry.parse);
+}
+
+void
+StructView::_slot_apply() {
+    StructSchema schema;
+    if (!schema.parse(_editor->toPlainText(), _error)) {
+        _updateStatus();
+        return;
+    }
+
+    //The text of a compiled schema, unchanged, keeps its parser.
+    for (int x = 0; x < KnownStructs::count(); x++) {
+        const KnownStructs::Entry &entry = KnownStructs::entry(x);
+        const StructSchema known = entry.schema();
+        if (known.toText() == schema.toText()) {
+            const QSignalBlocker blocker(_schemas);
+            _schemas->setCurrentIndex(_schemas->findData(x));
+            _setSchema(known, entry.parse);
+            return;
+        }
+    }
+
+    schema.name = tr("Custom");
+    const QSignalBlocker blocker(_schemas);
+    _schemas->setCurrentIndex(_schemas->findData(-1));
+    _setSchema(schema, nullptr);
+}
+
+void
+StructView::_slot_load() {
+    const QString path = QFileDialog::getOpenFileName(this, tr("Load Struct Schema"), QString(),
+                                                      tr("Struct schemas (*.struct *.txt);;All files (*)"));
+    if (path.isEmpty()) { return; }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        _error = file.errorString();
+        _updateStatus();
+        return;
+    }
+    _editor->setPlainText(QString::fromUtf8(file.readAll()));
+    _slot_apply();
+}
+
+void
+StructView::_slot_benchmark() {
+    if (_benchmarkThread.joinable()) { return; }
+
+    _benchmarkButton->setEnabled(false);
+    _benchmarkSchema = _schema;
+    _benchmarkSerial = _schemaSerial;
+    _benchmark = tr("benchmark running...");
+    _updateStatus();
+
+    const StructSchema schema = _schema;
+    const KnownStructs::ParseFunction parse = _parse;
+    _benchmarkThread = std::thread([this, schema, parse]() {
+        _benchmarkResult = KnownStructs::benchmark(schema, parse, BENCHMARK_FRAMES);
+        emit benchmarkFinished();
+    });
+}
+
+void
+StructView::_slot_benchmarkFinished() {
+    _benchmarkThread.join();
+    _benchmarkButton->setEnabled(true);
+    if (_benchmarkSerial != _schemaSerial) { return; }
+
+    const KnownStructs::Benchmark &result = _benchmarkResult;
+    if (!result.frames) {
+        _benchmark.clear();
+    }
+    else if (!result.agree) {
+        _benchmark = tr("NOT TIMED: the compiled and generic decoders differ in %1 of synthetic frame %2")
+                     .arg(_benchmarkSchema.fields.at(result.mismatchField).name)
+                     .arg(result.mismatchFrame);
+    }
+    else if (result.specializedPerSecond > 0) {
+        _benchmark = tr("compiled %1 M frames/s, generic %2 M frames/s (x%3)")
+                     .arg(result.specializedPerSecond / 1e6, 0, 'f', 1)
+                     .arg(result.genericPerSecond / 1e6, 0, 'f', 1)
+                     .arg(result.genericPerSecond > 0 ? result.specializedPerSecond / result.genericPerSecond : 0, 0, 'f', 1);
+    }
+    else {
+        _benchmark = tr("generic %1 M frames/s").arg(result.genericPerSecond / 1e6, 0, 'f', 1);
+    }
+    _updateStatus();
+}
+
+void
+StructView::_slot_fieldSelected() {
+    const QModelIndexList rows = _table->selectionModel()->selectedRows();
+    _trendField = rows.isEmpty() ? -1 : rows.first().row();
+    _trend->clear(_trendField >= 0 ? _schema.fields.at(_trendField).name : QString());
+}
+
+void
+StructView::_slot_refresh() {
+    if (_changed) {
+        _changed = false;
+        _model->setValues(_values, _min, _max);
+        _trend->update();
+    }
+    _updateStatus();
+}
+
+void
+StructView::_setSchema(const StructSchema &schema, KnownStructs::ParseFunction parse) {
+    _schema = schema;
+    _parse = parse;
+    _schemaSerial++;
+    _values.fill(0, schema.fields.size());
+    _min.fill(std::numeric_limits<double>::max(), schema.fields.size());
+    _max.fill(-std::numeric_limits<double>::max(), schema.fields.size());
+    _decoded = 0;
+    _short = 0;
+    _badCrc = 0;
+    _changed = false;
+    _error.clear();
+    _benchmark.clear();
+
+    _model->setSchema(schema);
+    _trendField = -1;
+    _trend->clear();
+    _updateStatus();
+}
+
+void
+StructView::_updateStatus() {
+    if (!_error.isEmpty()) {
+        _status->setText(_error);
+        return;
+    }
+
+    QString text = tr("%1 bytes, %2 decoder  decoded: %3  short: %4  CRC errors: %5")
+                   .arg(_schema.size).arg(_parse ? tr("compiled") : tr("generic"))
+                   .arg(_decoded).arg(_short).arg(_badCrc);
+    if (!_benchmark.isEmpty()) {
+        text += QStringLiteral("  ") + _benchmark;
+    }
+    _status->setText(text);
+}
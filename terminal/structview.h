@@ -0,0 +1,151 @@
+#ifndef STRUCTVIEW_H
+#define STRUCTVIEW_H
+
+#include "framedecoder.h"
+#include "knownstructs.h"
+
+#include <QAbstractTableModel>
+#include <QWidget>
+
+#include <thread>
+
+QT_BEGIN_NAMESPACE
+
+class QComboBox;
+class QLabel;
+class QPlainTextEdit;
+class QPushButton;
+class QTableView;
+class QTimer;
+
+QT_END_NAMESPACE
+
+//The fields of the struct schema with the latest decoded value and the range
+//seen since the schema was applied.
+class StructModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        NameColumn,
+        TypeColumn,
+        ValueColumn,
+        MinColumn,
+        MaxColumn,
+        ColumnCount
+    };
+
+    explicit StructModel(QObject *parent = nullptr);
+
+    void setSchema(const StructSchema &schema);
+    //One value per field each.
+    void setValues(const QVector<double> &values, const QVector<double> &min, const QVector<double> &max);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    QVector<StructField> _fields;
+    QVector<double> _values;
+    QVector<double> _min;
+    QVector<double> _max;
+};
+
+//Line plot of the latest values of one field, scaled to their range.
+class StructTrend : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static const int MAX_POINTS = 2000;
+
+    explicit StructTrend(QWidget *parent = nullptr);
+
+    void clear(const QString &label = QString());
+    void append(double value);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *e) override;
+
+private:
+    //Ring of the last MAX_POINTS values, _next is the oldest once full.
+    QVector<double> _points;
+    int _next = 0;
+    QString _label;
+};
+
+//Dockable decoder of frame payloads as packed binary structs. A compiled
+//schema from KnownStructs is decoded by its specialized parser; a schema
+//edited or loaded at run time goes through StructSchema::decode().
+class StructView : public QWidget
+{
+    Q_OBJECT
+
+signals:
+    //From the benchmark thread, queued to this one.
+    void benchmarkFinished();
+
+public:
+    static const quint64 BENCHMARK_FRAMES = 5000000;
+
+    explicit StructView(QWidget *parent = nullptr);
+    //Waits for a running benchmark, which cannot be interrupted.
+    ~StructView();
+
+    void setActive(bool active);
+    bool isActive() const { return _active; }
+
+    //Frames with a bad CRC or shorter than the schema are counted and skipped.
+    void append(const QVector<DecodedFrame> &frames);
+
+private slots:
+    void _slot_schemaSelected(int index);
+    void _slot_apply();
+    void _slot_load();
+    void _slot_benchmark();
+    void _slot_benchmarkFinished();
+    void _slot_fieldSelected();
+    void _slot_refresh();
+
+private:
+    void _setSchema(const StructSchema &schema, KnownStructs::ParseFunction parse);
+    void _updateStatus();
+
+    QComboBox *_schemas = nullptr;
+    QPlainTextEdit *_editor = nullptr;
+    StructModel *_model = nullptr;
+    QTableView *_table = nullptr;
+    StructTrend *_trend = nullptr;
+    QLabel *_status = nullptr;
+    QPushButton *_benchmarkButton = nullptr;
+    QTimer *_refreshTimer = nullptr;
+
+    StructSchema _schema;
+    KnownStructs::ParseFunction _parse = nullptr;
+    QVector<double> _values;
+    QVector<double> _min;
+    QVector<double> _max;
+    int _trendField = -1;
+    quint64 _decoded = 0;
+    quint64 _short = 0;
+    quint64 _badCrc = 0;
+    bool _changed = false;
+    QString _error;
+    QString _benchmark;
+    //The benchmark runs on its own copy of the schema; _benchmarkResult is
+    //the thread's until benchmarkFinished(). A result for a schema that has
+    //been replaced since is dropped.
+    std::thread _benchmarkThread;
+    KnownStructs::Benchmark _benchmarkResult;
+    StructSchema _benchmarkSchema;
+    int _schemaSerial = 0;
+    int _benchmarkSerial = -1;
+    bool _active = false;
+};
+
+#endif // STRUCTVIEW_H
@@ -7,13 +7,111 @@ TEMPLATE = app
 SOURCES += \
     main.cpp \
     mainwindow.cpp \
+    bufferpool.cpp \
     settingsdialog.cpp \
-    console.cpp
+    console.cpp \
+    glyphatlas.cpp \
+    highlighter.cpp \
+    linestore.cpp \
+    shmtap.cpp \
+    serialiothread.cpp \
+    crc16.cpp \
+    modbusanalyzer.cpp \
+    modbusview.cpp \
+    framedecoder.cpp \
+    frameview.cpp \
+    triggerengine.cpp \
+    script.cpp \
+    scriptsession.cpp \
+    scriptrunner.cpp \
+    latencyhistogram.cpp \
+    commandscheduler.cpp \
+    schedulerview.cpp \
+    linesearch.cpp \
+    searchbar.cpp \
+    linefilter.cpp \
+    filterview.cpp \
+    sessionfile.cpp \
+    modemlinemonitor.cpp \
+    modemlineview.cpp \
+    uartcounters.cpp \
+    lineerrorview.cpp \
+    baudrate.cpp \
+    bauddetector.cpp \
+    lineindex.cpp \
+    channeldemux.cpp \
+    channelview.cpp \
+    portsource.cpp \
+    mergedlines.cpp \
+    mergedview.cpp \
+    lineexport.cpp \
+    structschema.cpp \
+    knownstructs.cpp \
+    structview.cpp \
+    memorygovernor.cpp \
+    memoryview.cpp \
+    threadscheduling.cpp \
+    jitterprobe.cpp \
+    jitterview.cpp
 
 HEADERS += \
     mainwindow.h \
+    bufferpool.h \
     settingsdialog.h \
-    console.h
+    console.h \
+    formatspan.h \
+    glyphatlas.h \
+    highlighter.h \
+    linestore.h \
+    monotonicclock.h \
+    segmentedvector.h \
+    shmtap.h \
+    shmtaplayout.h \
+    roundtripmeter.h \
+    serialiothread.h \
+    spscqueue.h \
+    crc16.h \
+    modbusanalyzer.h \
+    modbusview.h \
+    bytescan.h \
+    framedecoder.h \
+    frameview.h \
+    triggerengine.h \
+    script.h \
+    scriptsession.h \
+    scriptrunner.h \
+    latencyhistogram.h \
+    commandscheduler.h \
+    schedulerview.h \
+    linesearch.h \
+    searchbar.h \
+    linefilter.h \
+    filterview.h \
+    sessionfile.h \
+    modemlinemonitor.h \
+    modemlineview.h \
+    uartcounters.h \
+    lineerrorview.h \
+    baudrate.h \
+    bauddetector.h \
+    lineindex.h \
+    channeldemux.h \
+    channelview.h \
+    portsource.h \
+    mergedlines.h \
+    mergedview.h \
+    lineexport.h \
+    structschema.h \
+    structparser.h \
+    knownstructs.h \
+    structview.h \
+    memorygovernor.h \
+    memoryview.h \
+    threadscheduling.h \
+    jitterprobe.h \
+    jitterview.h
+
+linux: LIBS += -lrt
 
 FORMS += \
     mainwindow.ui \
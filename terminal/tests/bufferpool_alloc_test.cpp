@@ -0,0 +1,205 @@
+// Counts heap allocations on the receive path: read() from a file descriptor
+// into BufferPool blocks and the views handed to the consumers that
+// MainWindow::dispatchRx() feeds on every chunk, as they are used there: the
+// LineStore behind the console, a SLIP FrameDecoder and a TriggerEngine with
+// literal rules. Frames and trigger matches straddle chunks. After a warm-up
+// nothing may allocate per chunk; only the store growing by a text block or
+// an index segment is allowed, a few allocations per MiB it takes on.
+//
+// Not covered: the widgets (console repaint, filter views) and regex
+// highlight or trigger rules, whose QRegularExpression matches allocate.
+
+#include "bufferpool.h"
+#include "framedecoder.h"
+#include "linestore.h"
+#include "triggerengine.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include <unistd.h>
+
+static std::atomic<quint64> allocations(0);
+
+//Qt's containers allocate with malloc(), not operator new, so the C allocator
+//is what gets counted: these replace glibc's and forward to its internal
+//entry points. operator new ends up here as well.
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *p);
+
+void *
+malloc(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *
+calloc(size_t count, size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *
+realloc(void *p, size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void *
+memalign(size_t alignment, size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int
+posix_memalign(void **p, size_t alignment, size_t size) {
+    *p = memalign(alignment, size);
+    return *p ? 0 : ENOMEM;
+}
+
+void *
+aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+void
+free(void *p) {
+    __libc_free(p);
+}
+
+}
+
+static const int BLOCKS = 16;
+static const qint64 BLOCK_SIZE = 4096;
+static const int WARMUP_CHUNKS = 1000;
+static const int CHUNKS = 100000;
+//Allocations allowed per MiB the store grows by: the block or segment itself
+//and the occasional growth of the vectors that index them.
+static const quint64 ALLOCATIONS_PER_MIB = 2;
+
+// The consumers dispatchRx() feeds, with their scratch vectors reused per
+// chunk the way MainWindow keeps them as members.
+struct Consumers
+{
+    Consumers() : decoder(FrameDecoder::create(FrameDecoder::Slip)) {
+        TriggerRule fix;
+        fix.pattern = QStringLiteral("$GPGGA");
+        TriggerRule checksum;
+        checksum.pattern = QStringLiteral("*47");
+        triggers.setRules(QVector<TriggerRule>() << fix << checksum);
+    }
+
+    void consume(const ByteView &view, quint64 timestampNs) {
+        lines += static_cast<quint64>(store.append(view, timestampNs));
+        frames.resize(0);
+        decoder->feed(view, timestampNs, frames);
+        for (const DecodedFrame &frame : frames) {
+            frameBytes += static_cast<quint64>(frame.payload.size);
+        }
+        hits.resize(0);
+        triggered += static_cast<quint64>(triggers.scan(view, timestampNs, hits));
+    }
+
+    LineStore store;
+    std::unique_ptr<FrameDecoder> decoder;
+    QVector<DecodedFrame> frames;
+    TriggerEngine triggers;
+    QVector<TriggerHit> hits;
+    quint64 lines = 0;
+    quint64 frameBytes = 0;
+    quint64 triggered = 0;
+};
+
+// One SLIP frame holding an NMEA sentence, written in two pieces split at a
+// different place every time, so each is read as a chunk of its own.
+static bool
+receive(int n, int readFd, int writeFd, BufferPool &pool, Consumers &consumers) {
+    static const char data[] = "\xC0$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n\xC0";
+    static const int size = sizeof(data) - 1;
+    const int split = 1 + n % (size - 1);
+    const int pieces[2][2] = { { 0, split }, { split, size - split } };
+
+    for (const auto &piece : pieces) {
+        if (::write(writeFd, data + piece[0], static_cast<size_t>(piece[1])) != piece[1]) { return false; }
+
+        BufferPool::Block *block = pool.acquire();
+        if (!block) { return false; }
+        const ssize_t count = ::read(readFd, block->data(), static_cast<size_t>(block->capacity()));
+        if (count > 0) {
+            consumers.consume(block->view(count), static_cast<quint64>(n));
+        }
+        pool.release(block);
+        if (count != piece[1]) { return false; }
+    }
+    return true;
+}
+
+int
+main() {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        std::perror("pipe");
+        return 1;
+    }
+
+    //The pool allocates its storage up front; without the replacement
+    //allocator in effect that goes uncounted and the test would prove nothing.
+    const quint64 probe = allocations.load();
+    BufferPool pool(BLOCKS, BLOCK_SIZE);
+    if (allocations.load() == probe) {
+        std::fprintf(stderr, "operator new is not counted\n");
+        return 1;
+    }
+
+    Consumers consumers;
+    for (int n = 0; n < WARMUP_CHUNKS; n++) {
+        if (!receive(n, fds[0], fds[1], pool, consumers)) {
+            std::fprintf(stderr, "warm-up chunk %d failed\n", n);
+            return 1;
+        }
+    }
+
+    const qint64 ownedBefore = consumers.store.ownedBytes();
+    const quint64 before = allocations.load();
+    for (int n = 0; n < CHUNKS; n++) {
+        if (!receive(n, fds[0], fds[1], pool, consumers)) {
+            std::fprintf(stderr, "chunk %d failed\n", n);
+            return 1;
+        }
+    }
+    const quint64 allocated = allocations.load() - before;
+    const quint64 grownMiB = static_cast<quint64>(consumers.store.ownedBytes() - ownedBefore) >> 20;
+    const quint64 allowed = (grownMiB + 1) * ALLOCATIONS_PER_MIB;
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    const FrameDecoder::Stats &stats = consumers.decoder->stats();
+    std::printf("%d chunks: %llu lines, %llu frames (%llu assembled), %llu trigger hits, store grew %llu MiB, "
+                "%llu heap allocations (%llu allowed), %d blocks still in use\n",
+                CHUNKS * 2, static_cast<unsigned long long>(consumers.lines),
+                static_cast<unsigned long long>(stats.frames), static_cast<unsigned long long>(stats.copied),
+                static_cast<unsigned long long>(consumers.triggered), static_cast<unsigned long long>(grownMiB),
+                static_cast<unsigned long long>(allocated), static_cast<unsigned long long>(allowed),
+                pool.blocksInUse());
+    //Every sentence is a line, a frame and two trigger hits.
+    const quint64 expected = static_cast<quint64>(WARMUP_CHUNKS + CHUNKS);
+    if (consumers.lines != expected || stats.frames != expected || consumers.triggered != 2 * expected) {
+        std::fprintf(stderr, "FAIL: the consumers did not see every sentence\n");
+        return 1;
+    }
+    if (allocated > allowed || pool.blocksInUse() != 0 || pool.exhaustedCount() != 0) {
+        std::fprintf(stderr, "FAIL: the receive path is not allocation free\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+// Round trips through a pseudo terminal: an echo thread on the master side
+// stands in for the device and the slave side is opened by name, the way the
+// application opens a port. Run once through a QSerialPort with the defaults
+// (the GUI thread reads on readyRead) and once through SerialIoThread::open()
+// as low latency mode does (termios, its own epoll thread), and reports p50/p99
+// of both from RoundTripMeter, timed where MainWindow times them. Real-time
+// scheduling of the I/O thread is a separate option and left off here. Only
+// losing a round trip fails; the numbers depend on the machine and are for
+// reading.
+
+#include "bufferpool.h"
+#include "monotonicclock.h"
+#include "roundtripmeter.h"
+#include "serialiothread.h"
+#include "triggerengine.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QSerialPort>
+#include <QTimer>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const int ROUND_TRIPS = 2000;
+static const int TIMEOUT_MS = 1000;
+static const char REQUEST[] = "AT+CSQ\r";
+static const int REQUEST_SIZE = sizeof(REQUEST) - 1;
+static const int POOL_BLOCKS = 16;
+static const qint64 POOL_BLOCK_SIZE = 4096;
+
+// The device: echoes whatever arrives until the slave side is closed.
+static void
+echo(int master) {
+    char buffer[256];
+    for (;;) {
+        const ssize_t n = ::read(master, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return; }
+        for (ssize_t done = 0; done < n;) {
+            const ssize_t written = ::write(master, buffer + done, static_cast<size_t>(n - done));
+            if (written < 0 && errno == EINTR) { continue; }
+            if (written <= 0) { return; }
+            done += written;
+        }
+    }
+}
+
+// A master with nothing on the slave side yet; the echo thread starts once a
+// port has it open, since reading the master before that fails.
+static int
+openMaster(QString &slaveName) {
+    const int master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0) {
+        std::perror("posix_openpt");
+        if (master >= 0) { ::close(master); }
+        return -1;
+    }
+    slaveName = QString::fromLocal8Bit(::ptsname(master));
+    termios attributes;
+    ::tcgetattr(master, &attributes);
+    ::cfmakeraw(&attributes);
+    ::tcsetattr(master, TCSANOW, &attributes);
+    return master;
+}
+
+static SettingsDialog::Settings
+portSettings(const QString &name) {
+    SettingsDialog::Settings settings;
+    settings.name = name;
+    settings.baudRate = QSerialPort::Baud115200;
+    settings.dataBits = QSerialPort::Data8;
+    settings.parity = QSerialPort::NoParity;
+    settings.stopBits = QSerialPort::OneStop;
+    settings.flowControl = QSerialPort::NoFlowControl;
+    settings.localEchoEnabled = false;
+    settings.shmTapEnabled = false;
+    settings.lowLatency = true;
+    settings.realTime = false;
+    settings.ioCpu = -1;
+    settings.markOverruns = false;
+    settings.keepSession = false;
+    settings.framing = FrameDecoder::None;
+    settings.framingCrc = false;
+    return settings;
+}
+
+// Request/response on the GUI thread's event loop: send() writes the next
+// request, received() is fed every read and answers when the echo is complete.
+// False when an echo does not come back within TIMEOUT_MS.
+class Exchange
+{
+public:
+    explicit Exchange(const std::function<void()> &send) : _send(send) {}
+
+    bool run() {
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        timeout.setInterval(TIMEOUT_MS);
+        QObject::connect(&timeout, &QTimer::timeout, &_loop, [this]() {
+            std::fprintf(stderr, "round trip %d: no echo within %d ms\n", _done, TIMEOUT_MS);
+            _loop.exit(1);
+        });
+        _timeout = &timeout;
+        _next();
+        const bool ok = _loop.exec() == 0;
+        _timeout = nullptr;
+        return ok;
+    }
+
+    void received(qint64 count) {
+        _received += count;
+        if (_received < REQUEST_SIZE) { return; }
+        if (++_done == ROUND_TRIPS) {
+            _loop.exit(0);
+            return;
+        }
+        _next();
+    }
+
+private:
+    void _next() {
+        _received = 0;
+        _timeout->start();
+        _send();
+    }
+
+    std::function<void()> _send;
+    QEventLoop _loop;
+    QTimer *_timeout = nullptr;
+    qint64 _received = 0;
+    int _done = 0;
+};
+
+static bool
+report(const char *mode, const RoundTripMeter &meter, const QString &note) {
+    const LatencyHistogram rtt = meter.histogram();
+    std::printf("%-29s %6llu round trips  p50 %7.1f us  p99 %7.1f us  max %7.1f us  %s\n", mode,
+                static_cast<unsigned long long>(rtt.count()), rtt.percentileNs(50) / 1e3,
+                rtt.percentileNs(99) / 1e3, rtt.maxNs() / 1e3, note.toLocal8Bit().constData());
+    if (rtt.count() != static_cast<quint64>(ROUND_TRIPS)) {
+        std::fprintf(stderr, "%s: %llu of %d round trips recorded\n", mode,
+                     static_cast<unsigned long long>(rtt.count()), ROUND_TRIPS);
+        return false;
+    }
+    return true;
+}
+
+// As MainWindow::writeData() and readData() do without low latency mode.
+static bool
+runSerialPort(int master, const QString &slaveName) {
+    const SettingsDialog::Settings settings = portSettings(slaveName);
+    QSerialPort port;
+    port.setPortName(settings.name);
+    port.setBaudRate(settings.baudRate);
+    port.setDataBits(settings.dataBits);
+    port.setParity(settings.parity);
+    port.setStopBits(settings.stopBits);
+    port.setFlowControl(settings.flowControl);
+    if (!port.open(QIODevice::ReadWrite)) {
+        std::fprintf(stderr, "QSerialPort: %s\n", port.errorString().toLocal8Bit().constData());
+        return false;
+    }
+    std::thread device(echo, master);
+
+    RoundTripMeter meter;
+    BufferPool pool(POOL_BLOCKS, POOL_BLOCK_SIZE);
+    Exchange exchange([&]() {
+        meter.markSent(monotonicNowNs());
+        port.write(REQUEST, REQUEST_SIZE);
+    });
+    QObject::connect(&port, &QSerialPort::readyRead, &port, [&]() {
+        while (port.bytesAvailable() > 0) {
+            BufferPool::Block *block = pool.acquire();
+            if (!block) { return; }
+            const qint64 count = port.read(block->data(), block->capacity());
+            if (count > 0) {
+                meter.markReceived(monotonicNowNs());
+            }
+            pool.release(block);
+            if (count <= 0) { return; }
+            exchange.received(count);
+        }
+    });
+    const bool ok = exchange.run();
+
+    //Closing the only slave descriptor hangs the master up and ends the echo.
+    port.close();
+    device.join();
+    return report("QSerialPort (default)", meter, QString()) && ok;
+}
+
+// As MainWindow::writeData() and readIoData() do in low latency mode.
+static bool
+runIoThread(int master, const QString &slaveName) {
+    RoundTripMeter meter;
+    BufferPool pool(POOL_BLOCKS, POOL_BLOCK_SIZE);
+    TriggerEngine triggers;
+    SerialIoThread io(pool, meter, triggers);
+    if (!io.open(portSettings(slaveName))) {
+        std::fprintf(stderr, "SerialIoThread: %s\n", io.errorString().toLocal8Bit().constData());
+        return false;
+    }
+    std::thread device(echo, master);
+
+    const QByteArray request(REQUEST, REQUEST_SIZE);
+    Exchange exchange([&]() { io.write(request); });
+    //Emitted on the I/O thread; the context object queues it to this one.
+    QObject::connect(&io, &SerialIoThread::readyRead, &io, [&]() {
+        SerialIoThread::Chunk chunk;
+        while (io.takeChunk(chunk)) {
+            pool.release(chunk.block);
+            exchange.received(chunk.size);
+        }
+    });
+    const bool ok = exchange.run();
+
+    const QString note = io.lowLatencyApplied() ? QStringLiteral("ASYNC_LOW_LATENCY")
+                                                : QStringLiteral("no ASYNC_LOW_LATENCY on a pty");
+    io.close();
+    device.join();
+    return report("SerialIoThread (low latency)", meter, note) && ok;
+}
+
+int
+main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    //A fresh pty per run: both backends open the port exclusively.
+    bool ok = true;
+    for (int run = 0; run < 2; run++) {
+        QString slaveName;
+        const int master = openMaster(slaveName);
+        if (master < 0) { return 1; }
+        ok = (run == 0 ? runSerialPort(master, slaveName) : runIoThread(master, slaveName)) && ok;
+        ::close(master);
+    }
+    return ok ? 0 : 1;
+}
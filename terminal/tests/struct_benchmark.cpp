@@ -0,0 +1,41 @@
+// Times every compiled struct layout of KnownStructs (Sensor telemetry among
+// them) through its specialized parser against StructSchema::decode() on the
+// same synthetic frames, as the Benchmark button of the struct view does.
+// Fails only when the two decoders disagree; the rates depend on the machine
+// and are for reading. An optional argument sets the number of frames.
+
+#include "knownstructs.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+static const quint64 DEFAULT_FRAMES = 5000000;
+
+int
+main(int argc, char *argv[]) {
+    const quint64 frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_FRAMES;
+    if (frames == 0) {
+        std::fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    for (int x = 0; x < KnownStructs::count(); x++) {
+        const KnownStructs::Entry &entry = KnownStructs::entry(x);
+        const StructSchema schema = entry.schema();
+        const KnownStructs::Benchmark result = KnownStructs::benchmark(schema, entry.parse, frames);
+        const QByteArray name = schema.name.toLocal8Bit();
+        if (!result.agree) {
+            std::fprintf(stderr, "%s: the compiled and generic decoders differ in %s of synthetic frame %d\n",
+                         name.constData(), schema.fields.at(result.mismatchField).name.toLocal8Bit().constData(),
+                         result.mismatchFrame);
+            ok = false;
+            continue;
+        }
+        std::printf("%-24s %3d bytes %3d fields  compiled %7.1f M frames/s  generic %7.1f M frames/s  x%.1f\n",
+                    name.constData(), schema.size, schema.fields.size(), result.specializedPerSecond / 1e6,
+                    result.genericPerSecond / 1e6,
+                    result.genericPerSecond > 0 ? result.specializedPerSecond / result.genericPerSecond : 0);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include "threadscheduling.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+QString
+ThreadScheduling::Result::describe() const {
+    QString text;
+    switch (policy) {
+    case Fifo:
+        text = QStringLiteral("SCHED_FIFO %1").arg(priority);
+        break;
+    case Nice:
+        text = QStringLiteral("nice %1").arg(priority);
+        break;
+    default:
+        text = QCoreApplication::translate("ThreadScheduling", "default scheduling");
+        break;
+    }
+    if (cpu >= 0) {
+        text += QCoreApplication::translate("ThreadScheduling", ", CPU %1").arg(cpu);
+    }
+    return text;
+}
+
+int
+ThreadScheduling::cpuCount() {
+    return QThread::idealThreadCount();
+}
+
+#ifdef Q_OS_LINUX
+
+static QString
+errorString(const char *what, int error) {
+    return QStringLiteral("%1: %2").arg(QLatin1String(what), QString::fromLocal8Bit(strerror(error)));
+}
+
+//Returns the error, 0 on success.
+static int
+setFifo(int priority) {
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    return ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param);
+}
+
+ThreadScheduling::Result
+ThreadScheduling::apply(bool realTime, int cpu) {
+    Result result;
+    QStringList errors;
+
+    if (realTime) {
+        //Without CAP_SYS_NICE, RLIMIT_RTPRIO may still allow a lower priority.
+        rlimit limit;
+        int priority = FIFO_PRIORITY;
+        int error = setFifo(priority);
+        if (error == EPERM && ::getrlimit(RLIMIT_RTPRIO, &limit) == 0
+            && limit.rlim_cur > 0 && limit.rlim_cur < static_cast<rlim_t>(priority)) {
+            priority = static_cast<int>(limit.rlim_cur);
+            error = setFifo(priority);
+        }
+
+        if (error == 0) {
+            result.policy = Fifo;
+            result.priority = priority;
+        }
+        else {
+            errors << errorString("SCHED_FIFO", error);
+
+            //With a thread id, setpriority() only changes that thread. Take the
+            //strongest boost RLIMIT_NICE allows, if any.
+            const id_t tid = static_cast<id_t>(::syscall(SYS_gettid));
+            errno = 0;
+            const int current = ::getpriority(PRIO_PROCESS, tid);
+            if (errno == 0) {
+                for (int nice = NICE_BOOST; nice < current; nice++) {
+                    if (::setpriority(PRIO_PROCESS, tid, nice) == 0) {
+                        result.policy = Nice;
+                        result.priority = nice;
+                        break;
+                    }
+                }
+            }
+            if (result.policy != Nice) {
+                errors << QCoreApplication::translate("ThreadScheduling", "no nice boost allowed");
+            }
+        }
+    }
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        int error = EINVAL;
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+            error = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+        }
+        if (error == 0) {
+            result.cpu = cpu;
+        }
+        else {
+            errors << errorString("CPU affinity", error);
+        }
+    }
+
+    result.error = errors.join(QStringLiteral("; "));
+    return result;
+}
+
+#else
+
+ThreadScheduling::Result
+ThreadScheduling::apply(bool realTime, int cpu) {
+    Result result;
+    if (realTime || cpu >= 0) {
+        result.error = QCoreApplication::translate("ThreadScheduling",
+                                                   "Real-time scheduling is only available on Linux");
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef THREADSCHEDULING_H
+#define THREADSCHEDULING_H
+
+#include <QString>
+
+//Scheduling for a latency-sensitive thread (Linux). Real-time asks for
+//SCHED_FIFO; without the privilege for it (root, CAP_SYS_NICE or an
+//RLIMIT_RTPRIO) it falls back to the strongest nice boost RLIMIT_NICE
+//allows, and otherwise leaves the thread as it is. The thread can also be
+//pinned to one CPU. Nothing here is fatal: the result says what was applied.
+class ThreadScheduling
+{
+public:
+    enum Policy {
+        Default,
+        Nice,
+        Fifo
+    };
+
+    struct Result {
+        Policy policy = Default;
+        int priority = 0;   //SCHED_FIFO priority, or the nice value
+        int cpu = -1;       //pinned CPU, -1 when not pinned
+        //What was asked for but could not be applied.
+        QString error;
+
+        //"SCHED_FIFO 50, CPU 2" and the like.
+        QString describe() const;
+    };
+
+    static const int FIFO_PRIORITY = 50;
+    static const int NICE_BOOST = -10;
+
+    //Applies to the calling thread; cpu -1 leaves the affinity alone.
+    static Result apply(bool realTime, int cpu);
+    static int cpuCount();
+};
+
+#endif // THREADSCHEDULING_H
@@ -0,0 +1,239 @@
+#include "triggerengine.h"
+
+#include <algorithm>
+
+void
+TriggerEngine::setRules(const QVector<TriggerRule> &rules) {
+    _rules = rules;
+    _regexRules.clear();
+    _regex.clear();
+
+    for (int x = 0; x < _rules.size(); x++) {
+        if (_rules.at(x).regex) {
+            QRegularExpression regex(_rules.at(x).pattern);
+            if (!regex.isValid()) { continue; }
+            regex.optimize();
+            _regexRules.append(x);
+            _regex.append(regex);
+        }
+    }
+
+    _buildAutomaton();
+    reset();
+}
+
+void
+TriggerEngine::reset() {
+    _state = 0;
+    _window.clear();
+    _windowStart = 0;
+    _reportedEnd.fill(0, _regex.size());
+    _fired.store(0, std::memory_order_relaxed);
+    _sent.store(0, std::memory_order_relaxed);
+    _lastLatencyNs.store(0, std::memory_order_relaxed);
+    _maxLatencyNs.store(0, std::memory_order_relaxed);
+    _totalLatencyNs.store(0, std::memory_order_relaxed);
+}
+
+void
+TriggerEngine::_buildAutomaton() {
+    _delta.fill(-1, 256);
+    _output.clear();
+    _output.resize(1);
+
+    //Trie of all literal patterns.
+    for (int x = 0; x < _rules.size(); x++) {
+        if (_rules.at(x).regex) { continue; }
+        const QByteArray literal = _rules.at(x).pattern.toUtf8();
+        if (literal.isEmpty()) { continue; }
+
+        qint32 state = 0;
+        for (const char c : literal) {
+            const int index = (state << 8) | static_cast<uchar>(c);
+            if (_delta.at(index) < 0) {
+                _delta[index] = _output.size();
+                _output.resize(_output.size() + 1);
+                _delta.resize(_delta.size() + 256);
+                std::fill(_delta.end() - 256, _delta.end(), -1);
+            }
+            state = _delta.at(index);
+        }
+        _output[state].append(x);
+    }
+
+    //Breadth first: failure links, then missing transitions are filled in
+    //from the failure state so scanning is a single table lookup per byte.
+    const int states = _output.size();
+    QVector<qint32> fail(states, 0);
+    _outputLink.fill(-1, states);
+    _accepting.fill(0, states);
+
+    QVector<qint32> queue;
+    queue.reserve(states);
+    for (int c = 0; c < 256; c++) {
+        qint32 &next = _delta[c];
+        if (next < 0) {
+            next = 0;
+        }
+        else {
+            fail[next] = 0;
+            queue.append(next);
+        }
+    }
+
+    for (int head = 0; head < queue.size(); head++) {
+        const qint32 state = queue.at(head);
+        _accepting[state] = !_output.at(state).isEmpty() || _outputLink.at(state) >= 0;
+
+        for (int c = 0; c < 256; c++) {
+            const int index = (state << 8) | c;
+            const qint32 next = _delta.at(index);
+            const qint32 fallback = _delta.at((fail.at(state) << 8) | c);
+            if (next < 0) {
+                _delta[index] = fallback;
+                continue;
+            }
+            fail[next] = fallback;
+            _outputLink[next] = !_output.at(fallback).isEmpty() ? fallback : _outputLink.at(fallback);
+            queue.append(next);
+        }
+    }
+}
+
+int
+TriggerEngine::scan(const ByteView &data, quint64 timestampNs, QVector<TriggerHit> &hits) {
+    const int before = hits.size();
+
+    if (_output.size() > 1) {
+        const qint32 *delta = _delta.constData();
+        const char *accepting = _accepting.constData();
+        qint32 state = _state;
+        for (qint64 x = 0; x < data.size; x++) {
+            state = delta[(state << 8) | static_cast<uchar>(data.data[x])];
+            if (!accepting[state]) { continue; }
+
+            for (qint32 s = _output.at(state).isEmpty() ? _outputLink.at(state) : state; s >= 0; s = _outputLink.at(s)) {
+                for (const int rule : _output.at(s)) {
+                    TriggerHit hit;
+                    hit.rule = rule;
+                    hit.offset = x + 1;
+                    hit.timestampNs = timestampNs;
+                    hits.append(hit);
+                }
+            }
+        }
+        _state = state;
+    }
+
+    if (!_regex.isEmpty()) {
+        //Only matches that end in the new data count; the rest were
+        //reported with an earlier chunk.
+        const int carried = _window.size();
+        _window.append(data.data, static_cast<int>(data.size));
+        _text.resize(_window.size());
+        QChar *out = _text.data();
+        for (int x = 0; x < _window.size(); x++) {
+            out[x] = QChar(static_cast<uchar>(_window.at(x)));
+        }
+        for (int x = 0; x < _regex.size(); x++) {
+            QRegularExpressionMatchIterator it = _regex.at(x).globalMatch(_text);
+            while (it.hasNext()) {
+                const QRegularExpressionMatch match = it.next();
+                if (match.capturedEnd() <= carried || match.capturedLength() == 0) { continue; }
+                //The same bytes, grown by this chunk, were reported already.
+                if (_windowStart + match.capturedStart() < _reportedEnd.at(x)) { continue; }
+                _reportedEnd[x] = _windowStart + match.capturedEnd();
+                TriggerHit hit;
+                hit.rule = _regexRules.at(x);
+                hit.offset = match.capturedEnd() - carried;
+                hit.timestampNs = timestampNs;
+                hits.append(hit);
+            }
+        }
+        if (_window.size() > MAX_REGEX_SPAN) {
+            _windowStart += _window.size() - MAX_REGEX_SPAN;
+            _window.remove(0, _window.size() - MAX_REGEX_SPAN);
+        }
+    }
+
+    const int added = hits.size() - before;
+    if (added) {
+        _fired.fetch_add(static_cast<quint64>(added), std::memory_order_relaxed);
+    }
+    return added;
+}
+
+void
+TriggerEngine::recordSend(TriggerHit &hit, quint64 writtenNs) {
+    hit.latencyNs = writtenNs > hit.timestampNs ? writtenNs - hit.timestampNs : 0;
+    _sent.fetch_add(1, std::memory_order_relaxed);
+    _lastLatencyNs.store(hit.latencyNs, std::memory_order_relaxed);
+    _totalLatencyNs.fetch_add(hit.latencyNs, std::memory_order_relaxed);
+    //Single writer, so a plain compare is enough.
+    if (hit.latencyNs > _maxLatencyNs.load(std::memory_order_relaxed)) {
+        _maxLatencyNs.store(hit.latencyNs, std::memory_order_relaxed);
+    }
+}
+
+quint64
+TriggerEngine::averageLatencyNs() const {
+    const quint64 sent = _sent.load(std::memory_order_relaxed);
+    return sent ? _totalLatencyNs.load(std::memory_order_relaxed) / sent : 0;
+}
+
+QByteArray
+TriggerEngine::unescape(const QString &text) {
+    const QByteArray in = text.toUtf8();
+    QByteArray out;
+    out.reserve(in.size());
+    for (int x = 0; x < in.size(); x++) {
+        const char c = in.at(x);
+        if (c != '\\' || x + 1 == in.size()) {
+            out.append(c);
+            continue;
+        }
+        const char e = in.at(++x);
+        switch (e) {
+        case 'r': out.append('\r'); break;
+        case 'n': out.append('\n'); break;
+        case 't': out.append('\t'); break;
+        case '0': out.append('\0'); break;
+        case 'x': {
+            bool ok = false;
+            const QByteArray digits = in.mid(x + 1, 2);
+            const int value = digits.toInt(&ok, 16);
+            if (ok && digits.size() == 2) {
+                out.append(static_cast<char>(value));
+                x += 2;
+            }
+            else {
+                out.append("\\x");
+            }
+            break;
+        }
+        default: out.append(e); break;
+        }
+    }
+    return out;
+}
+
+QString
+TriggerEngine::escape(const QByteArray &bytes) {
+    QString out;
+    for (const char c : bytes) {
+        switch (c) {
+        case '\r': out += QStringLiteral("\\r"); break;
+        case '\n': out += QStringLiteral("\\n"); break;
+        case '\t': out += QStringLiteral("\\t"); break;
+        case '\\': out += QStringLiteral("\\\\"); break;
+        default:
+            if (static_cast<uchar>(c) < 0x20 || static_cast<uchar>(c) >= 0x7F) {
+                out += QStringLiteral("\\x%1").arg(static_cast<uchar>(c), 2, 16, QLatin1Char('0'));
+            }
+            else {
+                out += QLatin1Char(c);
+            }
+        }
+    }
+    return out;
+}
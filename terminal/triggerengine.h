@@ -0,0 +1,102 @@
+#ifndef TRIGGERENGINE_H
+#define TRIGGERENGINE_H
+
+#include "bufferpool.h"
+
+#include <QByteArray>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+struct TriggerRule
+{
+    enum Action {
+        Send,       //write payload to the port
+        Capture,    //start capturing RX to the file named by payload
+        Mark,       //record the time of the match
+        Beep
+    };
+
+    QString pattern;
+    bool regex = false;
+    Action action = Mark;
+    QByteArray payload;
+};
+
+struct TriggerHit
+{
+    int rule = -1;
+    qint64 offset = 0;          //end of the match in the chunk
+    quint64 timestampNs = 0;    //of the chunk
+    quint64 latencyNs = 0;      //chunk read to write completed, Send only
+};
+
+//Matches many patterns at once against the received stream. Literal patterns
+//are compiled into one Aho-Corasick automaton whose state carries over from
+//chunk to chunk, so a match may straddle any number of reads. Regex patterns
+//run over the new chunk plus the tail of the previous ones, which limits a
+//regex match to MAX_REGEX_SPAN bytes. A regex match that starts before the
+//end of one already reported is not reported again, so a greedy match that
+//grows with the next chunk ("OK1", then "OK12") fires once.
+//
+//The engine is used by whichever thread reads the port (the I/O thread in low
+//latency mode), so Send actions go out without a trip through the GUI event
+//loop. Only the statistics may be read from other threads.
+class TriggerEngine
+{
+public:
+    static const int MAX_REGEX_SPAN = 256;
+
+    TriggerEngine() : _fired(0), _sent(0), _lastLatencyNs(0), _maxLatencyNs(0), _totalLatencyNs(0) {}
+
+    //Only while the port is closed.
+    void setRules(const QVector<TriggerRule> &rules);
+    bool isEmpty() const { return _rules.isEmpty(); }
+    int ruleCount() const { return _rules.size(); }
+    const TriggerRule &rule(int index) const { return _rules.at(index); }
+
+    //Appends a hit for every match ending in data; returns the number added.
+    int scan(const ByteView &data, quint64 timestampNs, QVector<TriggerHit> &hits);
+    void reset();
+
+    void recordSend(TriggerHit &hit, quint64 writtenNs);
+
+    quint64 fired() const { return _fired.load(std::memory_order_relaxed); }
+    quint64 sent() const { return _sent.load(std::memory_order_relaxed); }
+    quint64 lastLatencyNs() const { return _lastLatencyNs.load(std::memory_order_relaxed); }
+    quint64 maxLatencyNs() const { return _maxLatencyNs.load(std::memory_order_relaxed); }
+    quint64 averageLatencyNs() const;
+
+    //Payloads are written with C escapes in the settings (\r, \n, \t, \\, \xNN).
+    static QByteArray unescape(const QString &text);
+    static QString escape(const QByteArray &bytes);
+
+private:
+    void _buildAutomaton();
+
+    QVector<TriggerRule> _rules;
+
+    //Aho-Corasick over bytes: dense transition table, 256 entries per state.
+    QVector<qint32> _delta;
+    QVector<QVector<int> > _output;     //rules whose literal ends in the state
+    QVector<qint32> _outputLink;        //nearest suffix state with output, or -1
+    QVector<char> _accepting;           //state or one of its suffixes has output
+    qint32 _state = 0;
+
+    QVector<int> _regexRules;
+    QVector<QRegularExpression> _regex;
+    QByteArray _window;
+    qint64 _windowStart = 0;            //stream offset of _window[0]
+    QVector<qint64> _reportedEnd;       //per regex, stream offset of the last match's end
+    QString _text;                      //_window as text, reused rather than allocated per chunk
+
+    std::atomic<quint64> _fired;
+    std::atomic<quint64> _sent;
+    std::atomic<quint64> _lastLatencyNs;
+    std::atomic<quint64> _maxLatencyNs;
+    std::atomic<quint64> _totalLatencyNs;
+};
+
+#endif // TRIGGERENGINE_H
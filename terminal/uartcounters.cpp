@@ -0,0 +1,208 @@
+#include "uartcounters.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#endif
+
+struct CounterName {
+    const char *name;
+    const char *key;
+};
+
+static const CounterName counterNames[UartCounters::COUNTER_COUNT] = {
+    { QT_TRANSLATE_NOOP("UartCounters", "Received bytes"), "rx" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Transmitted bytes"), "tx" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Framing errors"), "frame" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Parity errors"), "parity" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Breaks"), "brk" },
+    { QT_TRANSLATE_NOOP("UartCounters", "UART overruns"), "overrun" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Buffer overruns"), "bufOverrun" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Parity errors (port)"), "parity" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Framing errors (port)"), "framing" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Breaks (port)"), "break" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Read errors"), "read" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Write errors"), "write" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Resource errors"), "resource" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Timeouts"), "timeout" },
+    { QT_TRANSLATE_NOOP("UartCounters", "Other errors"), "other" }
+};
+
+QString
+UartCounters::name(Counter counter) {
+    return QCoreApplication::translate("UartCounters", counterNames[counter].name);
+}
+
+QString
+UartCounters::key(Counter counter) {
+    return QLatin1String(counterNames[counter].key);
+}
+
+#ifdef Q_OS_LINUX
+
+static bool
+readDriver(int fd, quint32 *values) {
+    serial_icounter_struct counts;
+    if (fd < 0 || ::ioctl(fd, TIOCGICOUNT, &counts) != 0) { return false; }
+
+    values[UartCounters::RxBytes] = static_cast<quint32>(counts.rx);
+    values[UartCounters::TxBytes] = static_cast<quint32>(counts.tx);
+    values[UartCounters::FrameErrors] = static_cast<quint32>(counts.frame);
+    values[UartCounters::ParityErrors] = static_cast<quint32>(counts.parity);
+    values[UartCounters::Breaks] = static_cast<quint32>(counts.brk);
+    values[UartCounters::Overruns] = static_cast<quint32>(counts.overrun);
+    values[UartCounters::BufferOverruns] = static_cast<quint32>(counts.buf_overrun);
+    return true;
+}
+
+bool
+UartCounters::readOverruns(int fd, quint64 &count) {
+    serial_icounter_struct counts;
+    if (fd < 0 || ::ioctl(fd, TIOCGICOUNT, &counts) != 0) { return false; }
+
+    count = static_cast<quint32>(counts.overrun) + static_cast<quint64>(static_cast<quint32>(counts.buf_overrun));
+    return true;
+}
+
+#else
+
+static bool
+readDriver(int fd, quint32 *values) {
+    Q_UNUSED(fd);
+    Q_UNUSED(values);
+    return false;
+}
+
+bool
+UartCounters::readOverruns(int fd, quint64 &count) {
+    Q_UNUSED(fd);
+    Q_UNUSED(count);
+    return false;
+}
+
+#endif
+
+bool
+UartCounters::start(int fd) {
+    std::fill(_values, _values + COUNTER_COUNT, 0);
+    _overruns.clear();
+
+    _driver = readDriver(fd, _base);
+    _fd = _driver ? fd : -1;
+    readOverruns(_fd, _lastOverruns);
+    return _driver;
+}
+
+void
+UartCounters::stop() {
+    //One last look before the descriptor goes away; the values stay.
+    sample();
+    _fd = -1;
+}
+
+bool
+UartCounters::sample() {
+    quint32 now[DRIVER_COUNTERS];
+    if (!readDriver(_fd, now)) { return false; }
+
+    bool moved = false;
+    for (int x = 0; x < DRIVER_COUNTERS; x++) {
+        //The driver counters are 32 bit and wrap.
+        const quint64 value = static_cast<quint32>(now[x] - _base[x]);
+        if (x >= FrameErrors && value != _values[x]) { moved = true; }
+        _values[x] = value;
+    }
+    return moved;
+}
+
+bool
+UartCounters::checkOverrun() {
+    quint64 count;
+    if (!readOverruns(_fd, count) || count == _lastOverruns) { return false; }
+    _lastOverruns = count;
+    return true;
+}
+
+void
+UartCounters::addPortError(QSerialPort::SerialPortError error) {
+    switch (error) {
+    case QSerialPort::NoError:
+        return;
+    case QSerialPort::ParityError:
+        add(PortParityErrors);
+        return;
+    case QSerialPort::FramingError:
+        add(PortFramingErrors);
+        return;
+    case QSerialPort::BreakConditionError:
+        add(PortBreaks);
+        return;
+    case QSerialPort::ReadError:
+        add(ReadErrors);
+        return;
+    case QSerialPort::WriteError:
+        add(WriteErrors);
+        return;
+    case QSerialPort::ResourceError:
+        add(ResourceErrors);
+        return;
+    case QSerialPort::TimeoutError:
+        add(TimeoutErrors);
+        return;
+    default:
+        add(OtherErrors);
+        return;
+    }
+}
+
+void
+UartCounters::addOverrun(quint64 offset, qint64 size, quint64 timestampNs) {
+    if (_overruns.size() >= MAX_OVERRUNS) {
+        _overruns.remove(0);
+    }
+    Overrun overrun;
+    overrun.offset = offset;
+    overrun.size = size;
+    overrun.timestampNs = timestampNs;
+    _overruns.append(overrun);
+}
+
+QByteArray
+UartCounters::toJson() const {
+    QJsonObject port;
+    for (int x = DRIVER_COUNTERS; x < COUNTER_COUNT; x++) {
+        port.insert(key(static_cast<Counter>(x)), static_cast<double>(_values[x]));
+    }
+
+    QJsonObject root;
+    if (hasDriverCounters()) {
+        QJsonObject driver;
+        for (int x = 0; x < DRIVER_COUNTERS; x++) {
+            driver.insert(key(static_cast<Counter>(x)), static_cast<double>(_values[x]));
+        }
+        root.insert(QStringLiteral("driver"), driver);
+    }
+    else {
+        root.insert(QStringLiteral("driver"), QJsonValue());
+    }
+    root.insert(QStringLiteral("port"), port);
+
+    QJsonArray overruns;
+    for (const Overrun &overrun : _overruns) {
+        QJsonObject entry;
+        entry.insert(QStringLiteral("offset"), static_cast<double>(overrun.offset));
+        entry.insert(QStringLiteral("size"), static_cast<double>(overrun.size));
+        entry.insert(QStringLiteral("timestampNs"), QString::number(overrun.timestampNs));
+        overruns.append(entry);
+    }
+    root.insert(QStringLiteral("overruns"), overruns);
+
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
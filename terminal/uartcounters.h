@@ -0,0 +1,91 @@
+#ifndef UARTCOUNTERS_H
+#define UARTCOUNTERS_H
+
+#include <QByteArray>
+#include <QSerialPort>
+#include <QString>
+#include <QVector>
+
+//Line error statistics of the open port. The driver's own counters
+//(TIOCGICOUNT, Linux, not every driver keeps them) are sampled from the GUI
+//thread a few times a second, relative to when the port was opened; that is
+//one ioctl per sample and nothing on the receive path. The errors QSerialPort
+//and the low latency reader report are counted alongside.
+//
+//With overrun marking on, the receive path also reads the overrun counters
+//after every read(), and an overrun is recorded with the stream offset and
+//size of the read that holds the gap.
+class UartCounters
+{
+public:
+    enum Counter {
+        //Driver
+        RxBytes,
+        TxBytes,
+        FrameErrors,
+        ParityErrors,
+        Breaks,
+        Overruns,
+        BufferOverruns,
+        //Port
+        PortParityErrors,
+        PortFramingErrors,
+        PortBreaks,
+        ReadErrors,
+        WriteErrors,
+        ResourceErrors,
+        TimeoutErrors,
+        OtherErrors,
+        COUNTER_COUNT
+    };
+    static const int DRIVER_COUNTERS = PortParityErrors;
+
+    struct Overrun {
+        quint64 offset = 0;         //RX stream offset of the read holding the gap
+        qint64 size = 0;            //bytes that read returned
+        quint64 timestampNs = 0;
+    };
+    static const int MAX_OVERRUNS = 1000;
+
+    static QString name(Counter counter);
+    //Stable name for machine-readable output.
+    static QString key(Counter counter);
+
+    //Starts counting for a newly opened port, fd -1 when there is no
+    //descriptor. Returns whether the driver has counters.
+    bool start(int fd);
+    //Before the port is closed.
+    void stop();
+    bool isRunning() const { return _fd >= 0; }
+    bool hasDriverCounters() const { return _driver; }
+
+    //Reads the driver counters; true when an error counter moved.
+    bool sample();
+    //Reads the overrun counters only; true when they moved since the last
+    //call. For overrun marking on the GUI thread receive path.
+    bool checkOverrun();
+
+    void addPortError(QSerialPort::SerialPortError error);
+    void add(Counter counter) { _values[counter]++; }
+    void addOverrun(quint64 offset, qint64 size, quint64 timestampNs);
+
+    quint64 value(Counter counter) const { return _values[counter]; }
+    //The latest MAX_OVERRUNS, oldest first.
+    const QVector<Overrun> &overruns() const { return _overruns; }
+
+    //All counters and the marked overruns as one JSON object.
+    QByteArray toJson() const;
+
+    //Overruns plus buffer overruns the driver has counted on fd.
+    static bool readOverruns(int fd, quint64 &count);
+
+private:
+    int _fd = -1;
+    bool _driver = false;
+    quint32 _base[DRIVER_COUNTERS] = {};
+    quint64 _values[COUNTER_COUNT] = {};
+    quint64 _lastOverruns = 0;
+    QVector<Overrun> _overruns;
+};
+
+#endif // UARTCOUNTERS_H